@@ -26,6 +26,7 @@
 #include <unordered_map>
 #include <deque>
 #include <memory>
+#include <thread>
 
 #if _MSC_VER >= 1400
 #    define REI_ASSUME(x) __assume(x)
@@ -112,6 +113,12 @@ typedef volatile REI_ALIGNAS(REI_PTRSIZE) uintptr_t REI_atomicptr_t;
 
 #    define REI_popcnt(x) __popcnt(x)
 
+#    if defined(_M_ARM) || defined(_M_ARM64)
+#        define REI_cpu_pause() __yield()
+#    else
+#        define REI_cpu_pause() _mm_pause()
+#    endif
+
 static inline void REI_ctz32(uint32_t* pOut, uint32_t mask32) 
 { 
     unsigned long out;
@@ -142,6 +149,14 @@ static inline void REI_ctz64(uint32_t* pOut, uint64_t mask64)
 
 #    define REI_popcnt(x) __builtin_popcount(x)
 
+#    if defined(__i386__) || defined(__x86_64__)
+#        define REI_cpu_pause() __builtin_ia32_pause()
+#    elif defined(__arm__) || defined(__aarch64__)
+#        define REI_cpu_pause() __asm__ __volatile__("yield")
+#    else
+#        define REI_cpu_pause() ((void)0)
+#    endif
+
 static inline void REI_ctz32(uint32_t* pOut, uint32_t mask32)
 {
     *pOut = mask32 ? __builtin_ctz(mask32) : *pOut = 32;
@@ -969,6 +984,542 @@ struct REI_StackAllocator
     }
 };
 
+// Packs a pool block index (low REI_POOL_HANDLE_INDEX_BITS bits) and the generation of the block.
+// The generation changes every time the block is released, so a handle kept past the lifetime
+// of its object no longer resolves, even after the block has been reused.
+typedef uint32_t REI_PoolHandle;
+
+#define REI_POOL_INVALID_HANDLE 0u
+#define REI_POOL_HANDLE_INDEX_BITS 20
+#define REI_POOL_HANDLE_INDEX_MASK ((1u << REI_POOL_HANDLE_INDEX_BITS) - 1u)
+#define REI_POOL_HANDLE_GENERATION_MASK (~0u >> REI_POOL_HANDLE_INDEX_BITS)
+#define REI_POOL_PAGE_BLOCK_COUNT 64
+
+// Validates that objects passed to REI_cmd* functions are still alive in their pools, and that the objects a
+// command buffer was recorded with weren't released before it is submitted
+#ifndef REI_POOL_VALIDATION
+#    if defined(_DEBUG)
+#        define REI_POOL_VALIDATION 1
+#    else
+#        define REI_POOL_VALIDATION 0
+#    endif
+#endif
+
+#if REI_POOL_VALIDATION
+#    define REI_POOL_VALIDATE(pool, pObject) \
+        REI_ASSERT((pool).isValid(pObject), "Use of a released or unknown " #pObject)
+#    define REI_POOL_VALIDATE_ARRAY(pool, ppObjects, count)                         \
+        for (uint32_t poolValidateIndex = 0; poolValidateIndex < (count); ++poolValidateIndex) \
+            REI_POOL_VALIDATE(pool, (ppObjects)[poolValidateIndex])
+#    define REI_POOL_VALIDATE_CMD(pCmd, pool, pObject)   \
+        do                                               \
+        {                                                \
+            REI_POOL_VALIDATE(pool, pObject);            \
+            (pCmd)->poolRefs.add(pool, pObject);         \
+        } while (0)
+#    define REI_POOL_VALIDATE_CMD_ARRAY(pCmd, pool, ppObjects, count)                          \
+        for (uint32_t poolValidateIndex = 0; poolValidateIndex < (count); ++poolValidateIndex) \
+            REI_POOL_VALIDATE_CMD(pCmd, pool, (ppObjects)[poolValidateIndex])
+#    define REI_POOL_VALIDATE_SUBMIT(ppCmds, count)                                                     \
+        for (uint32_t poolValidateIndex = 0; poolValidateIndex < (count); ++poolValidateIndex)          \
+            REI_ASSERT(                                                                                 \
+                (ppCmds)[poolValidateIndex]->poolRefs.isValid(),                                        \
+                "Submitting a command buffer that uses an object released after it was recorded")
+#else
+#    define REI_POOL_VALIDATE(pool, pObject) ((void)0)
+#    define REI_POOL_VALIDATE_ARRAY(pool, ppObjects, count) ((void)0)
+#    define REI_POOL_VALIDATE_CMD(pCmd, pool, pObject) ((void)0)
+#    define REI_POOL_VALIDATE_CMD_ARRAY(pCmd, pool, ppObjects, count) ((void)0)
+#    define REI_POOL_VALIDATE_SUBMIT(ppCmds, count) ((void)0)
+#endif
+
+// Fixed block pool for one kind of renderer object.
+// Blocks are carved out of pages of REI_POOL_PAGE_BLOCK_COUNT entries and recycled through a FIFO free list,
+// so released blocks stay mapped until destroy() and are reused as late as possible.
+// Objects are returned zeroed and are not constructed, same as REI_calloc.
+template<typename T>
+struct REI_Pool
+{
+    struct Block
+    {
+        // Must stay first, T* and Block* are interchangeable
+        alignas(T) uint8_t storage[sizeof(T)];
+        uint32_t           index;
+        uint32_t           generation;
+        uint32_t           nextFree;
+        uint32_t           alive;
+    };
+
+    static const uint32_t INVALID_INDEX = ~0u;
+
+    REI_AllocatorCallbacks allocator;
+    Block**                ppPages;
+    Block**                ppSortedPages;    // same pages by address, for ownsBlock
+    uint32_t               pageCount;
+    uint32_t               pageCapacity;
+    uint32_t               freeHead;
+    uint32_t               freeTail;
+    uint32_t               liveCount;
+    mutable REI_atomic32_t lock;
+
+    void init(const REI_AllocatorCallbacks& inAllocator)
+    {
+        allocator = inAllocator;
+        ppPages = nullptr;
+        ppSortedPages = nullptr;
+        pageCount = 0;
+        pageCapacity = 0;
+        freeHead = INVALID_INDEX;
+        freeTail = INVALID_INDEX;
+        liveCount = 0;
+        lock = 0;
+    }
+
+    void destroy()
+    {
+        for (uint32_t i = 0; i < pageCount; ++i)
+            allocator.pFree(allocator.pUserData, ppPages[i]);
+        if (ppPages)
+            allocator.pFree(allocator.pUserData, ppPages);
+        init(allocator);
+    }
+
+    T* allocate()
+    {
+        acquireLock();
+        if (freeHead == INVALID_INDEX && !addPage())
+        {
+            releaseLock();
+            return nullptr;
+        }
+
+        Block* pBlock = getBlock(freeHead);
+        freeHead = pBlock->nextFree;
+        if (freeHead == INVALID_INDEX)
+            freeTail = INVALID_INDEX;
+        pBlock->nextFree = INVALID_INDEX;
+        pBlock->alive = 1;
+        ++liveCount;
+        releaseLock();
+
+        memset(pBlock->storage, 0, sizeof(pBlock->storage));
+        return (T*)pBlock->storage;
+    }
+
+    void release(T* pObject)
+    {
+        if (!pObject)
+            return;
+
+        acquireLock();
+        Block* pBlock = (Block*)pObject;
+        if (!ownsBlock(pBlock) || !pBlock->alive)
+        {
+            REI_ASSERT(false, "Releasing an object that is not alive in this pool");
+            releaseLock();
+            return;
+        }
+        pBlock->alive = 0;
+        pBlock->generation = (pBlock->generation + 1) & REI_POOL_HANDLE_GENERATION_MASK;
+        if (pBlock->generation == 0)
+            pBlock->generation = 1;
+        if (freeTail == INVALID_INDEX)
+            freeHead = pBlock->index;
+        else
+            getBlock(freeTail)->nextFree = pBlock->index;
+        freeTail = pBlock->index;
+        --liveCount;
+        releaseLock();
+    }
+
+    REI_PoolHandle getHandle(const T* pObject) const
+    {
+        if (!pObject)
+            return REI_POOL_INVALID_HANDLE;
+
+        const Block* pBlock = (const Block*)pObject;
+        return pBlock->index | (pBlock->generation << REI_POOL_HANDLE_INDEX_BITS);
+    }
+
+    // Returns nullptr if the object referenced by the handle has been released
+    T* resolve(REI_PoolHandle handle) const
+    {
+        uint32_t index = handle & REI_POOL_HANDLE_INDEX_MASK;
+        uint32_t generation = handle >> REI_POOL_HANDLE_INDEX_BITS;
+
+        T* pResult = nullptr;
+        acquireLock();
+        if (index < pageCount * REI_POOL_PAGE_BLOCK_COUNT)
+        {
+            Block* pBlock = getBlock(index);
+            if (pBlock->alive && pBlock->generation == generation)
+                pResult = (T*)pBlock->storage;
+        }
+        releaseLock();
+        return pResult;
+    }
+
+    // Used by REI_PoolRefList, which keeps references to pools of different types
+    static bool isHandleAlive(const void* pPool, REI_PoolHandle handle)
+    {
+        return ((const REI_Pool<T>*)pPool)->resolve(handle) != nullptr;
+    }
+
+    // True if pObject is a live object of this pool. Released blocks stay mapped until destroy(),
+    // so testing a dangling pointer is safe. A pointer to a block that was released and reused since is
+    // live again, keep the handle of the object to tell them apart (REI_get*Handle in Renderer.h).
+    bool isValid(const T* pObject) const
+    {
+        if (!pObject)
+            return false;
+
+        acquireLock();
+        const Block* pBlock = (const Block*)pObject;
+        bool         result = ownsBlock(pBlock) && pBlock->alive;
+        releaseLock();
+        return result;
+    }
+
+    uint32_t getLiveCount() const { return liveCount; }
+
+    private:
+    Block* getBlock(uint32_t index) const
+    {
+        return ppPages[index / REI_POOL_PAGE_BLOCK_COUNT] + index % REI_POOL_PAGE_BLOCK_COUNT;
+    }
+
+    bool ownsBlock(const Block* pBlock) const
+    {
+        // Last page starting at or before pBlock
+        uint32_t first = 0;
+        uint32_t count = pageCount;
+        while (count > 0)
+        {
+            uint32_t half = count / 2;
+            if (ppSortedPages[first + half] <= pBlock)
+            {
+                first += half + 1;
+                count -= half + 1;
+            }
+            else
+            {
+                count = half;
+            }
+        }
+        if (first == 0)
+            return false;
+
+        const Block* pPage = ppSortedPages[first - 1];
+        return pBlock < pPage + REI_POOL_PAGE_BLOCK_COUNT &&
+               (size_t)((const uint8_t*)pBlock - (const uint8_t*)pPage) % sizeof(Block) == 0;
+    }
+
+    bool addPage()
+    {
+        if ((pageCount + 1) * REI_POOL_PAGE_BLOCK_COUNT > REI_POOL_HANDLE_INDEX_MASK + 1)
+        {
+            REI_ASSERT(false, "REI_Pool is out of handle indices");
+            return false;
+        }
+
+        if (pageCount == pageCapacity)
+        {
+            uint32_t newCapacity = pageCapacity ? pageCapacity * 2 : 8;
+            Block**  ppNewPages =
+                (Block**)allocator.pMalloc(allocator.pUserData, sizeof(Block*) * newCapacity * 2, alignof(Block*));
+            if (!ppNewPages)
+                return false;
+            if (ppPages)
+            {
+                memcpy(ppNewPages, ppPages, sizeof(Block*) * pageCount);
+                memcpy(ppNewPages + newCapacity, ppSortedPages, sizeof(Block*) * pageCount);
+                allocator.pFree(allocator.pUserData, ppPages);
+            }
+            // Both arrays share one allocation
+            ppPages = ppNewPages;
+            ppSortedPages = ppNewPages + newCapacity;
+            pageCapacity = newCapacity;
+        }
+
+        Block* pPage =
+            (Block*)allocator.pMalloc(allocator.pUserData, sizeof(Block) * REI_POOL_PAGE_BLOCK_COUNT, alignof(Block));
+        if (!pPage)
+            return false;
+
+        uint32_t firstIndex = pageCount * REI_POOL_PAGE_BLOCK_COUNT;
+        for (uint32_t i = 0; i < REI_POOL_PAGE_BLOCK_COUNT; ++i)
+        {
+            pPage[i].index = firstIndex + i;
+            pPage[i].generation = 1;
+            pPage[i].nextFree = i + 1 < REI_POOL_PAGE_BLOCK_COUNT ? firstIndex + i + 1 : INVALID_INDEX;
+            pPage[i].alive = 0;
+        }
+        uint32_t sortedIndex = pageCount;
+        while (sortedIndex > 0 && ppSortedPages[sortedIndex - 1] > pPage)
+        {
+            ppSortedPages[sortedIndex] = ppSortedPages[sortedIndex - 1];
+            --sortedIndex;
+        }
+        ppSortedPages[sortedIndex] = pPage;
+        ppPages[pageCount++] = pPage;
+
+        // Free list is empty when a page is added
+        freeHead = firstIndex;
+        freeTail = firstIndex + REI_POOL_PAGE_BLOCK_COUNT - 1;
+        return true;
+    }
+
+    void acquireLock() const
+    {
+        uint32_t spin = 0;
+        while (REI_atomic32_cas_relaxed(&lock, 0, 1) != 0)
+        {
+            // Wait for the lock to look free before trying again, give the time slice away if it stays taken
+            while (REI_atomic32_load_relaxed(&lock) != 0)
+            {
+                if (++spin < 64)
+                    REI_cpu_pause();
+                else
+                    std::this_thread::yield();
+            }
+        }
+    }
+
+    void releaseLock() const { REI_atomic32_store_release(&lock, 0); }
+};
+
+// Handles of the pool objects a command buffer was recorded with, resolved again when it is submitted.
+// Unlike REI_Pool::isValid this catches objects released in between even when their block was reused since.
+struct REI_PoolRefList
+{
+    struct Ref
+    {
+        const void*    pPool;
+        bool           (*pIsAlive)(const void* pPool, REI_PoolHandle handle);
+        REI_PoolHandle handle;
+    };
+
+    REI_AllocatorCallbacks allocator;
+    Ref*                   pRefs;
+    uint32_t               count;
+    uint32_t               capacity;
+
+    void init(const REI_AllocatorCallbacks& inAllocator)
+    {
+        allocator = inAllocator;
+        pRefs = nullptr;
+        count = 0;
+        capacity = 0;
+    }
+
+    void destroy()
+    {
+        if (pRefs)
+            allocator.pFree(allocator.pUserData, pRefs);
+        init(allocator);
+    }
+
+    void reset() { count = 0; }
+
+    template<typename T>
+    void add(const REI_Pool<T>& pool, const T* pObject)
+    {
+        if (!pObject)
+            return;
+
+        REI_PoolHandle handle = pool.getHandle(pObject);
+        // Draws bind the same objects over and over
+        if (count && pRefs[count - 1].pPool == &pool && pRefs[count - 1].handle == handle)
+            return;
+
+        if (count == capacity)
+        {
+            uint32_t newCapacity = capacity ? capacity * 2 : 64;
+            Ref*     pNewRefs = (Ref*)allocator.pMalloc(allocator.pUserData, sizeof(Ref) * newCapacity, alignof(Ref));
+            if (!pNewRefs)
+                return;
+            if (pRefs)
+            {
+                memcpy(pNewRefs, pRefs, sizeof(Ref) * count);
+                allocator.pFree(allocator.pUserData, pRefs);
+            }
+            pRefs = pNewRefs;
+            capacity = newCapacity;
+        }
+
+        pRefs[count++] = { &pool, &REI_Pool<T>::isHandleAlive, handle };
+    }
+
+    bool isValid() const
+    {
+        for (uint32_t i = 0; i < count; ++i)
+        {
+            if (!pRefs[i].pIsAlive(pRefs[i].pPool, pRefs[i].handle))
+                return false;
+        }
+        return true;
+    }
+};
+
+// Chained linear allocator for short lived scratch data.
+// Allocations are bumped out of pages obtained from REI_AllocatorCallbacks; when the current page is exhausted
+// another one is chained, so requests never fail for lack of space. Pages are kept until reset(), which merges
+// a chain into a single page large enough for everything that was used, so steady state runs from one block.
+struct REI_LinearArena
+{
+    struct Page
+    {
+        Page*  pNext;
+        size_t size;
+    };
+
+    struct Marker
+    {
+        Page*  pPage;
+        size_t offset;
+        size_t usedBytes;
+    };
+
+    static const size_t PAGE_HEADER_SIZE = (sizeof(Page) + 15) & ~size_t(15);
+
+    REI_AllocatorCallbacks allocator;
+    Page*                  pFirstPage;
+    Page*                  pCurrentPage;
+    size_t                 offset;
+    size_t                 defaultPageSize;
+    size_t                 usedBytes;
+    size_t                 highWaterMark;
+
+    void init(const REI_AllocatorCallbacks& inAllocator, size_t pageSize)
+    {
+        allocator = inAllocator;
+        pFirstPage = nullptr;
+        pCurrentPage = nullptr;
+        offset = 0;
+        defaultPageSize = pageSize;
+        usedBytes = 0;
+        highWaterMark = 0;
+    }
+
+    void destroy()
+    {
+        freePages(pFirstPage);
+        pFirstPage = nullptr;
+        pCurrentPage = nullptr;
+        offset = 0;
+        usedBytes = 0;
+    }
+
+    void* alloc(size_t size, size_t alignment = REI_DEFAULT_MALLOC_ALIGNMENT)
+    {
+        REI_ASSERT(REI_isPowerOf2(alignment) && alignment <= 16);
+
+        size_t alignedOffset = REI_align_up(offset, alignment);
+        if (!pCurrentPage || alignedOffset + size > pCurrentPage->size)
+        {
+            Page* pNextPage = pCurrentPage ? pCurrentPage->pNext : pFirstPage;
+            if (!pNextPage || size > pNextPage->size)
+            {
+                Page* pNewPage = addPage(REI_max(defaultPageSize, size));
+                if (!pNewPage)
+                    return nullptr;
+                pNewPage->pNext = pNextPage;
+                if (pCurrentPage)
+                    pCurrentPage->pNext = pNewPage;
+                else
+                    pFirstPage = pNewPage;
+                pNextPage = pNewPage;
+            }
+            pCurrentPage = pNextPage;
+            offset = 0;
+            alignedOffset = 0;
+        }
+
+        usedBytes += alignedOffset + size - offset;
+        highWaterMark = REI_max(highWaterMark, usedBytes);
+        offset = alignedOffset + size;
+        return (uint8_t*)pCurrentPage + PAGE_HEADER_SIZE + alignedOffset;
+    }
+
+    template<typename T>
+    T* alloc(size_t count = 1)
+    {
+        return (T*)alloc(sizeof(T) * count, alignof(T));
+    }
+
+    template<typename T>
+    T* allocZeroed(size_t count = 1)
+    {
+        T* result = alloc<T>(count);
+        if (result)
+            memset(result, 0, sizeof(T) * count);
+        return result;
+    }
+
+    Marker getMarker() const { return { pCurrentPage, offset, usedBytes }; }
+
+    // Releases everything allocated after the marker was taken, pages stay chained for reuse
+    void rewind(const Marker& marker)
+    {
+        pCurrentPage = marker.pPage;
+        offset = marker.offset;
+        usedBytes = marker.usedBytes;
+    }
+
+    void reset()
+    {
+        if (pFirstPage && pFirstPage->pNext)
+        {
+            size_t totalSize = 0;
+            for (Page* pPage = pFirstPage; pPage; pPage = pPage->pNext)
+                totalSize += pPage->size;
+            freePages(pFirstPage);
+            pFirstPage = addPage(totalSize);
+            if (pFirstPage)
+                pFirstPage->pNext = nullptr;
+        }
+        pCurrentPage = nullptr;
+        offset = 0;
+        usedBytes = 0;
+    }
+
+    /// Largest amount of memory that was in use at once since init(), including alignment padding
+    size_t getHighWaterMark() const { return highWaterMark; }
+
+    private:
+    Page* addPage(size_t size)
+    {
+        Page* pPage = (Page*)allocator.pMalloc(allocator.pUserData, PAGE_HEADER_SIZE + size, 16);
+        REI_ASSERT(pPage, "REI_LinearArena wasn't able to allocate a page");
+        if (pPage)
+        {
+            pPage->pNext = nullptr;
+            pPage->size = size;
+        }
+        return pPage;
+    }
+
+    void freePages(Page* pPage)
+    {
+        while (pPage)
+        {
+            Page* pNext = pPage->pNext;
+            allocator.pFree(allocator.pUserData, pPage);
+            pPage = pNext;
+        }
+    }
+};
+
+// Rewinds the arena to where it was when the scope was entered
+struct REI_LinearArenaScope
+{
+    REI_LinearArenaScope(REI_LinearArena& inArena): arena(inArena), marker(inArena.getMarker()) {}
+    ~REI_LinearArenaScope() { arena.rewind(marker); }
+
+    REI_LinearArena&        arena;
+    REI_LinearArena::Marker marker;
+};
+
 struct REI_string: public std::basic_string<char, std::char_traits<char>, REI_allocator<char>>
 {
     using Base = std::basic_string<char, std::char_traits<char>, REI_allocator<char>>;
@@ -1370,6 +1370,20 @@ void REI_removeIndirectCommandSignature(REI_Renderer* pRenderer, REI_CommandSign
 void REI_addQueryPool(REI_Renderer* pRenderer, const REI_QueryPoolDesc* pDesc, REI_QueryPool** ppQueryPool);
 void REI_removeQueryPool(REI_Renderer* pRenderer, REI_QueryPool* pQueryPool);
 
+// Index and generation handles of fences, samplers, buffers, textures and query pools. The memory of a removed object
+// is reused for new ones, so a kept pointer may silently refer to a different object. A handle taken when the object
+// was added stops resolving once it is removed, resolve returns NULL then
+REI_PoolHandle REI_getFenceHandle(REI_Renderer* pRenderer, REI_Fence* pFence);
+REI_Fence*     REI_resolveFence(REI_Renderer* pRenderer, REI_PoolHandle handle);
+REI_PoolHandle REI_getSamplerHandle(REI_Renderer* pRenderer, REI_Sampler* pSampler);
+REI_Sampler*   REI_resolveSampler(REI_Renderer* pRenderer, REI_PoolHandle handle);
+REI_PoolHandle REI_getBufferHandle(REI_Renderer* pRenderer, REI_Buffer* pBuffer);
+REI_Buffer*    REI_resolveBuffer(REI_Renderer* pRenderer, REI_PoolHandle handle);
+REI_PoolHandle REI_getTextureHandle(REI_Renderer* pRenderer, REI_Texture* pTexture);
+REI_Texture*   REI_resolveTexture(REI_Renderer* pRenderer, REI_PoolHandle handle);
+REI_PoolHandle REI_getQueryPoolHandle(REI_Renderer* pRenderer, REI_QueryPool* pQueryPool);
+REI_QueryPool* REI_resolveQueryPool(REI_Renderer* pRenderer, REI_PoolHandle handle);
+
 void REI_addCmdPool(REI_Renderer* pRenderer, REI_Queue* p_queue, bool transient, REI_CmdPool** pp_CmdPool);
 void REI_resetCmdPool(REI_Renderer* pRenderer, REI_CmdPool* pCmdPool);
 void REI_removeCmdPool(REI_Renderer* pRenderer, REI_CmdPool* p_CmdPool);
@@ -1199,6 +1199,12 @@ void REI_initRendererD3D12(const REI_RendererDescD3D12* pDescD3D12, REI_Renderer
 
     REI_Renderer* pRenderer = *ppRenderer;
 
+    pRenderer->mBufferPool.init(allocatorCallbacks);
+    pRenderer->mTexturePool.init(allocatorCallbacks);
+    pRenderer->mSamplerPool.init(allocatorCallbacks);
+    pRenderer->mFencePool.init(allocatorCallbacks);
+    pRenderer->mQueryPoolPool.init(allocatorCallbacks);
+
     pRenderer->pLog = pDescD3D12->desc.pLog ? pDescD3D12->desc.pLog : REI_Log;
 
     const REI_AllocatorCallbacks& allocator = pRenderer->allocator;
@@ -1336,6 +1342,11 @@ void REI_removeRenderer(REI_Renderer* pRenderer)
     d3d12_platform_remove_device(pRenderer);
 
     // Free all the renderer components
+    pRenderer->mBufferPool.destroy();
+    pRenderer->mTexturePool.destroy();
+    pRenderer->mSamplerPool.destroy();
+    pRenderer->mFencePool.destroy();
+    pRenderer->mQueryPoolPool.destroy();
     allocator.pFree(allocator.pUserData, pRenderer->pCPUDescriptorHeaps);
     allocator.pFree(allocator.pUserData, pRenderer->pActiveGpuSettings);
     allocator.pFree(allocator.pUserData, pRenderer->pName);
@@ -1355,7 +1366,7 @@ void REI_addFence(REI_Renderer* pRenderer, REI_Fence** pp_fence)
     REI_ASSERT(pp_fence);
 
     //create a Fence and ASSERT that it is valid
-    REI_Fence* pFence = (REI_Fence*)pRenderer->allocator.pMalloc(pRenderer->allocator.pUserData, sizeof(REI_Fence), 0);
+    REI_Fence* pFence = pRenderer->mFencePool.allocate();
     REI_ASSERT(pFence);
 
     CHECK_HRESULT(pRenderer->pDxDevice->CreateFence(0, D3D12_FENCE_FLAG_NONE, IID_PPV_ARGS(&pFence->pDxFence)));
@@ -1376,11 +1387,23 @@ void REI_removeFence(REI_Renderer* pRenderer, REI_Fence* p_fence)
     SAFE_RELEASE(p_fence->pDxFence);
     CloseHandle(p_fence->pDxWaitIdleFenceEvent);
 
-    pRenderer->allocator.pFree(pRenderer->allocator.pUserData, p_fence);
+    pRenderer->mFencePool.release(p_fence);
+}
+
+REI_PoolHandle REI_getFenceHandle(REI_Renderer* pRenderer, REI_Fence* pFence)
+{
+    REI_POOL_VALIDATE(pRenderer->mFencePool, pFence);
+    return pRenderer->mFencePool.getHandle(pFence);
+}
+
+REI_Fence* REI_resolveFence(REI_Renderer* pRenderer, REI_PoolHandle handle)
+{
+    return pRenderer->mFencePool.resolve(handle);
 }
 
 void REI_getFenceStatus(REI_Renderer* pRenderer, REI_Fence* p_fence, REI_FenceStatus* p_fence_status)
 {
+    REI_POOL_VALIDATE(pRenderer->mFencePool, p_fence);
     UINT64 completedValue = p_fence->pDxFence->GetCompletedValue();
     if (completedValue < p_fence->mFenceValue - 1)
         *p_fence_status = REI_FENCE_STATUS_INCOMPLETE;
@@ -1497,6 +1520,11 @@ void REI_queueSubmit(
 
     //execute given command list
     REI_ASSERT(p_queue->pDxQueue);
+    if (pFence)
+        REI_POOL_VALIDATE(p_queue->pRenderer->mFencePool, pFence);
+    REI_POOL_VALIDATE_ARRAY(p_queue->pRenderer->mFencePool, (REI_Fence**)pp_wait_semaphores, wait_semaphore_count);
+    REI_POOL_VALIDATE_ARRAY(p_queue->pRenderer->mFencePool, (REI_Fence**)pp_signal_semaphores, signal_semaphore_count);
+    REI_POOL_VALIDATE_SUBMIT(pp_cmds, cmd_count);
 
     ID3D12CommandList** cmds = (ID3D12CommandList**)alloca(cmd_count * sizeof(ID3D12CommandList*));
     for (uint32_t i = 0; i < cmd_count; ++i)
@@ -1551,7 +1579,7 @@ void REI_addSampler(REI_Renderer* pRenderer, const REI_SamplerDesc* pDesc, REI_S
     REI_ASSERT(pDesc->compareFunc < REI_MAX_COMPARE_MODES);
 
     // initialize to zero
-    REI_Sampler* pSampler = REI_new<REI_Sampler>(pRenderer->allocator);
+    REI_Sampler* pSampler = pRenderer->mSamplerPool.allocate();
     pSampler->mDescriptor = D3D12_DESCRIPTOR_ID_NONE;
     REI_ASSERT(pSampler);
 
@@ -1588,7 +1616,18 @@ void REI_removeSampler(REI_Renderer* pRenderer, REI_Sampler* p_sampler)
     return_descriptor_handles(
         pRenderer->pCPUDescriptorHeaps[D3D12_DESCRIPTOR_HEAP_TYPE_SAMPLER], p_sampler->mDescriptor, 1);
 
-    pRenderer->allocator.pFree(pRenderer->allocator.pUserData, p_sampler);
+    pRenderer->mSamplerPool.release(p_sampler);
+}
+
+REI_PoolHandle REI_getSamplerHandle(REI_Renderer* pRenderer, REI_Sampler* pSampler)
+{
+    REI_POOL_VALIDATE(pRenderer->mSamplerPool, pSampler);
+    return pRenderer->mSamplerPool.getHandle(pSampler);
+}
+
+REI_Sampler* REI_resolveSampler(REI_Renderer* pRenderer, REI_PoolHandle handle)
+{
+    return pRenderer->mSamplerPool.resolve(handle);
 }
 
 void REI_addBuffer(REI_Renderer* pRenderer, const REI_BufferDesc* pDesc, REI_Buffer** pp_buffer)
@@ -1601,7 +1640,7 @@ void REI_addBuffer(REI_Renderer* pRenderer, const REI_BufferDesc* pDesc, REI_Buf
     REI_ASSERT(pDesc->size > 0);
 
     // initialize to zero
-    REI_Buffer* pBuffer = REI_new<REI_Buffer>(pRenderer->allocator);
+    REI_Buffer* pBuffer = pRenderer->mBufferPool.allocate();
     REI_ASSERT(pBuffer);
     pBuffer->mDescriptors = D3D12_DESCRIPTOR_ID_NONE;
 
@@ -1824,7 +1863,18 @@ void REI_removeBuffer(REI_Renderer* pRenderer, REI_Buffer* p_buffer)
     SAFE_RELEASE(p_buffer->pDxAllocation);
     SAFE_RELEASE(p_buffer->pDxResource);
 
-    pRenderer->allocator.pFree(pRenderer->allocator.pUserData, p_buffer);
+    pRenderer->mBufferPool.release(p_buffer);
+}
+
+REI_PoolHandle REI_getBufferHandle(REI_Renderer* pRenderer, REI_Buffer* pBuffer)
+{
+    REI_POOL_VALIDATE(pRenderer->mBufferPool, pBuffer);
+    return pRenderer->mBufferPool.getHandle(pBuffer);
+}
+
+REI_Buffer* REI_resolveBuffer(REI_Renderer* pRenderer, REI_PoolHandle handle)
+{
+    return pRenderer->mBufferPool.resolve(handle);
 }
 
 void REI_mapBuffer(REI_Renderer* pRenderer, REI_Buffer* pBuffer, void** pMappedMem)
@@ -1907,7 +1957,7 @@ void REI_addTexture(REI_Renderer* pRenderer, const REI_TextureDesc* in_pDesc, RE
     }
 
     //allocate new texture
-    REI_Texture* pTexture = REI_new<REI_Texture>(pRenderer->allocator);
+    REI_Texture* pTexture = pRenderer->mTexturePool.allocate();
     REI_ASSERT(pTexture);
 
     pTexture->mDescriptors = D3D12_DESCRIPTOR_ID_NONE;
@@ -2400,7 +2450,18 @@ void REI_removeTexture(REI_Renderer* pRenderer, REI_Texture* p_texture)
         SAFE_RELEASE(p_texture->pDxResource);
     }
 
-    pRenderer->allocator.pFree(pRenderer->allocator.pUserData, p_texture);
+    pRenderer->mTexturePool.release(p_texture);
+}
+
+REI_PoolHandle REI_getTextureHandle(REI_Renderer* pRenderer, REI_Texture* pTexture)
+{
+    REI_POOL_VALIDATE(pRenderer->mTexturePool, pTexture);
+    return pRenderer->mTexturePool.getHandle(pTexture);
+}
+
+REI_Texture* REI_resolveTexture(REI_Renderer* pRenderer, REI_PoolHandle handle)
+{
+    return pRenderer->mTexturePool.resolve(handle);
 }
 
 void REI_setTextureName(REI_Renderer* pRenderer, REI_Texture* pTexture, const char* pName)
@@ -3578,8 +3639,7 @@ void REI_addQueryPool(REI_Renderer* pRenderer, const REI_QueryPoolDesc* pDesc, R
     REI_ASSERT(pDesc);
     REI_ASSERT(ppQueryPool);
 
-    REI_QueryPool* pQueryPool =
-        (REI_QueryPool*)pRenderer->allocator.pMalloc(pRenderer->allocator.pUserData, sizeof(REI_QueryPool), 0);
+    REI_QueryPool* pQueryPool = pRenderer->mQueryPoolPool.allocate();
     REI_ASSERT(pQueryPool);
 
     pQueryPool->mType = util_to_dx12_query_type(pDesc->type);
@@ -3596,7 +3656,18 @@ void REI_addQueryPool(REI_Renderer* pRenderer, const REI_QueryPoolDesc* pDesc, R
 void REI_removeQueryPool(REI_Renderer* pRenderer, REI_QueryPool* pQueryPool)
 {
     SAFE_RELEASE(pQueryPool->pDxQueryHeap);
-    pRenderer->allocator.pFree(pRenderer->allocator.pUserData, pQueryPool);
+    pRenderer->mQueryPoolPool.release(pQueryPool);
+}
+
+REI_PoolHandle REI_getQueryPoolHandle(REI_Renderer* pRenderer, REI_QueryPool* pQueryPool)
+{
+    REI_POOL_VALIDATE(pRenderer->mQueryPoolPool, pQueryPool);
+    return pRenderer->mQueryPoolPool.getHandle(pQueryPool);
+}
+
+REI_QueryPool* REI_resolveQueryPool(REI_Renderer* pRenderer, REI_PoolHandle handle)
+{
+    return pRenderer->mQueryPoolPool.resolve(handle);
 }
 
 void REI_addCmdPool(REI_Renderer* pRenderer, REI_Queue* p_queue, bool transient, REI_CmdPool** pp_CmdPool)
@@ -3662,6 +3733,9 @@ void REI_addCmd(REI_Renderer* pRenderer, REI_CmdPool* p_CmdPool, bool secondary,
     pCmd->pBoundHeaps[1] = pRenderer->pSamplerHeaps;
 
     pCmd->pCmdPool = p_CmdPool;
+#if REI_POOL_VALIDATION
+    pCmd->poolRefs.init(pRenderer->allocator);
+#endif
 
     if (REI_CMD_POOL_COPY == p_CmdPool->pQueue->mType)
     {
@@ -3689,6 +3763,9 @@ void REI_removeCmd(REI_Renderer* pRenderer, REI_CmdPool* p_CmdPool, REI_Cmd* p_c
     REI_ASSERT(pRenderer);
     REI_ASSERT(p_cmd);
     SAFE_RELEASE(p_cmd->pDxCmdList);
+#if REI_POOL_VALIDATION
+    p_cmd->poolRefs.destroy();
+#endif
 
     REI_delete(pRenderer->allocator, p_cmd);
 }
@@ -3714,6 +3791,9 @@ void REI_beginCmd(REI_Cmd* p_cmd)
 
     // Reset CPU side data
     p_cmd->pBoundRootSignature = NULL;
+#if REI_POOL_VALIDATION
+    p_cmd->poolRefs.reset();
+#endif
 }
 
 void REI_endCmd(REI_Cmd* p_cmd)
@@ -3731,6 +3811,9 @@ void REI_cmdBindRenderTargets(
     REI_ASSERT(p_cmd);
     REI_ASSERT(p_cmd->pDxCmdList);
     REI_ASSERT(p_cmd->mType == REI_CMD_POOL_DIRECT);
+    REI_POOL_VALIDATE_CMD_ARRAY(p_cmd, p_cmd->pRenderer->mTexturePool, pp_render_targets, render_target_count);
+    if (p_depth_stencil)
+        REI_POOL_VALIDATE_CMD(p_cmd, p_cmd->pRenderer->mTexturePool, p_depth_stencil);
     ID3D12GraphicsCommandList* pDxCmdList = (ID3D12GraphicsCommandList*)p_cmd->pDxCmdList;
     if (!render_target_count && !p_depth_stencil)
         return;
@@ -4004,6 +4087,7 @@ void REI_cmdBindIndexBuffer(REI_Cmd* p_cmd, REI_Buffer* p_buffer, uint64_t offse
     REI_ASSERT(p_cmd);
     REI_ASSERT(p_buffer);
     REI_ASSERT(p_cmd->pDxCmdList);
+    REI_POOL_VALIDATE_CMD(p_cmd, p_cmd->pRenderer->mBufferPool, p_buffer);
     REI_ASSERT(D3D12_GPU_VIRTUAL_ADDRESS_NULL != p_buffer->mDxGpuAddress);
 
     D3D12_INDEX_BUFFER_VIEW ibView = {};
@@ -4022,6 +4106,7 @@ void REI_cmdBindVertexBuffer(REI_Cmd* p_cmd, uint32_t buffer_count, REI_Buffer**
     REI_ASSERT(0 != buffer_count);
     REI_ASSERT(pp_buffers);
     REI_ASSERT(p_cmd->pDxCmdList);
+    REI_POOL_VALIDATE_CMD_ARRAY(p_cmd, p_cmd->pRenderer->mBufferPool, pp_buffers, buffer_count);
     //bind given vertex buffer
 
     DECLARE_ZERO(D3D12_VERTEX_BUFFER_VIEW, views[REI_MAX_VERTEX_ATTRIBS]);
@@ -4105,6 +4190,8 @@ void REI_cmdResolveTexture(
     REI_ASSERT(pSrcTexture);
     REI_ASSERT(pSrcTexture->pDxResource);
     REI_ASSERT(pCmd->mType == REI_CMD_POOL_DIRECT);
+    REI_POOL_VALIDATE_CMD(pCmd, pCmd->pRenderer->mTexturePool, pDstTexture);
+    REI_POOL_VALIDATE_CMD(pCmd, pCmd->pRenderer->mTexturePool, pSrcTexture);
 
     ((ID3D12GraphicsCommandList*)pCmd->pDxCmdList)
         ->ResolveSubresource(
@@ -4128,6 +4215,7 @@ void REI_cmdResourceBarrier(
         REI_BufferBarrier*      pTransBarrier = &p_buffer_barriers[i];
         D3D12_RESOURCE_BARRIER* pBarrier = &barriers[transitionCount];
         REI_Buffer*             pBuffer = pTransBarrier->pBuffer;
+        REI_POOL_VALIDATE_CMD(p_cmd, p_cmd->pRenderer->mBufferPool, pBuffer);
 
         // Only transition GPU visible resources.
         // Note: General CPU_TO_GPU resources have to stay in generic read state. They are created in upload heap.
@@ -4165,6 +4253,7 @@ void REI_cmdResourceBarrier(
         REI_TextureBarrier*     pTrans = &p_texture_barriers[i];
         D3D12_RESOURCE_BARRIER* pBarrier = &barriers[transitionCount];
         REI_Texture*            pTexture = pTrans->pTexture;
+        REI_POOL_VALIDATE_CMD(p_cmd, p_cmd->pRenderer->mTexturePool, pTexture);
 
         if (REI_RESOURCE_STATE_UNORDERED_ACCESS == pTrans->startState &&
             REI_RESOURCE_STATE_UNORDERED_ACCESS == pTrans->endState)
@@ -4201,6 +4290,9 @@ void REI_cmdExecuteIndirect(
 {
     REI_ASSERT(pCommandSignature);
     REI_ASSERT(pIndirectBuffer);
+    REI_POOL_VALIDATE_CMD(pCmd, pCmd->pRenderer->mBufferPool, pIndirectBuffer);
+    if (pCounterBuffer)
+        REI_POOL_VALIDATE_CMD(pCmd, pCmd->pRenderer->mBufferPool, pCounterBuffer);
 
     if (!pCounterBuffer)
         ((ID3D12GraphicsCommandList*)pCmd->pDxCmdList)
@@ -4220,6 +4312,7 @@ void REI_cmdResetQueryPool(REI_Cmd* pCmd, REI_QueryPool* pQueryPool, uint32_t st
 
 void REI_cmdBeginQuery(REI_Cmd* pCmd, REI_QueryPool* pQueryPool, uint32_t index)
 {
+    REI_POOL_VALIDATE_CMD(pCmd, pCmd->pRenderer->mQueryPoolPool, pQueryPool);
     D3D12_QUERY_TYPE           type = pQueryPool->mType;
     ID3D12GraphicsCommandList* d3dCmd = (ID3D12GraphicsCommandList*)pCmd->pDxCmdList;
 
@@ -4243,6 +4336,7 @@ void REI_cmdBeginQuery(REI_Cmd* pCmd, REI_QueryPool* pQueryPool, uint32_t index)
 
 void REI_cmdEndQuery(REI_Cmd* pCmd, REI_QueryPool* pQueryPool, uint32_t index)
 {
+    REI_POOL_VALIDATE_CMD(pCmd, pCmd->pRenderer->mQueryPoolPool, pQueryPool);
     D3D12_QUERY_TYPE           type = pQueryPool->mType;
     ID3D12GraphicsCommandList* d3dCmd = (ID3D12GraphicsCommandList*)pCmd->pDxCmdList;
 
@@ -4266,6 +4360,8 @@ void REI_cmdResolveQuery(
     REI_Cmd* pCmd, REI_Buffer* pBuffer, uint64_t bufferOffset, REI_QueryPool* pQueryPool, uint32_t startQuery,
     uint32_t queryCount)
 {
+    REI_POOL_VALIDATE_CMD(pCmd, pCmd->pRenderer->mBufferPool, pBuffer);
+    REI_POOL_VALIDATE_CMD(pCmd, pCmd->pRenderer->mQueryPoolPool, pQueryPool);
     ((ID3D12GraphicsCommandList*)pCmd->pDxCmdList)
         ->ResolveQueryData(
             pQueryPool->pDxQueryHeap, pQueryPool->mType, startQuery, queryCount, pBuffer->pDxResource, startQuery * 8);
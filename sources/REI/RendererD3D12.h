@@ -87,6 +87,12 @@ typedef struct REI_Renderer
     uint32_t                   mEnableGpuBasedValidation;
     D3D_ROOT_SIGNATURE_VERSION mHighestRootSignatureVersion;
     D3D12_SHADER_CACHE_SUPPORT_FLAGS mShaderCacheFlags;
+    // Fixed block pools for frequently created objects, semaphores share the fence pool
+    REI_Pool<struct REI_Buffer>    mBufferPool;
+    REI_Pool<struct REI_Texture>   mTexturePool;
+    REI_Pool<struct REI_Sampler>   mSamplerPool;
+    REI_Pool<struct REI_Fence>     mFencePool;
+    REI_Pool<struct REI_QueryPool> mQueryPoolPool;
     // Functions points for functions that need to be loaded
     PFN_D3D12_CREATE_ROOT_SIGNATURE_DESERIALIZER           fnD3D12CreateRootSignatureDeserializer = NULL;
     PFN_D3D12_SERIALIZE_VERSIONED_ROOT_SIGNATURE           fnD3D12SerializeVersionedRootSignature = NULL;
@@ -122,6 +128,11 @@ typedef struct REI_Cmd
 
     REI_Renderer* pRenderer;
     REI_Queue*    pQueue;
+
+#if REI_POOL_VALIDATION
+    // Pool objects the commands were recorded with, checked again in REI_queueSubmit
+    REI_PoolRefList poolRefs;
+#endif
 } REI_Cmd;
 
 typedef struct REI_CommandSignature
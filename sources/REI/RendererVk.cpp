@@ -2500,6 +2500,12 @@ void REI_removeRenderer(REI_Renderer* pRenderer)
     remove_instance(pRenderer);
 
     // Free all the renderer components!
+    pRenderer->bufferPool.destroy();
+    pRenderer->texturePool.destroy();
+    pRenderer->samplerPool.destroy();
+    pRenderer->fencePool.destroy();
+    pRenderer->semaphorePool.destroy();
+    pRenderer->queryPoolPool.destroy();
     pRenderer->allocator.pFree(pRenderer->allocator.pUserData, pRenderer);
 }
 /************************************************************************/
@@ -2510,7 +2516,7 @@ void REI_addFence(REI_Renderer* pRenderer, REI_Fence** ppFence)
     REI_ASSERT(pRenderer);
     REI_ASSERT(VK_NULL_HANDLE != pRenderer->pVkDevice);
 
-    REI_Fence* pFence = (REI_Fence*)REI_calloc(pRenderer->allocator, sizeof(*pFence));
+    REI_Fence* pFence = pRenderer->fencePool.allocate();
     REI_ASSERT(pFence);
 
     DECLARE_ZERO(VkFenceCreateInfo, add_info);
@@ -2534,14 +2540,25 @@ void REI_removeFence(REI_Renderer* pRenderer, REI_Fence* pFence)
 
     vkDestroyFence(pRenderer->pVkDevice, pFence->pVkFence, NULL);
 
-    pRenderer->allocator.pFree(pRenderer->allocator.pUserData, pFence);
+    pRenderer->fencePool.release(pFence);
+}
+
+REI_PoolHandle REI_getFenceHandle(REI_Renderer* pRenderer, REI_Fence* pFence)
+{
+    REI_POOL_VALIDATE(pRenderer->fencePool, pFence);
+    return pRenderer->fencePool.getHandle(pFence);
+}
+
+REI_Fence* REI_resolveFence(REI_Renderer* pRenderer, REI_PoolHandle handle)
+{
+    return pRenderer->fencePool.resolve(handle);
 }
 
 void REI_addSemaphore(REI_Renderer* pRenderer, REI_Semaphore** ppSemaphore)
 {
     REI_ASSERT(pRenderer);
 
-    REI_Semaphore* pSemaphore = (REI_Semaphore*)REI_calloc(pRenderer->allocator, sizeof(*pSemaphore));
+    REI_Semaphore* pSemaphore = pRenderer->semaphorePool.allocate();
     REI_ASSERT(pSemaphore);
 
     REI_ASSERT(VK_NULL_HANDLE != pRenderer->pVkDevice);
@@ -2567,7 +2584,7 @@ void REI_removeSemaphore(REI_Renderer* pRenderer, REI_Semaphore* pSemaphore)
 
     vkDestroySemaphore(pRenderer->pVkDevice, pSemaphore->pVkSemaphore, NULL);
 
-    pRenderer->allocator.pFree(pRenderer->allocator.pUserData, pSemaphore);
+    pRenderer->semaphorePool.release(pSemaphore);
 }
 
 void REI_addQueue(REI_Renderer* pRenderer, REI_QueueDesc* pDesc, REI_Queue** ppQueue)
@@ -2696,9 +2713,6 @@ void REI_removeCmdPool(REI_Renderer* pRenderer, REI_CmdPool* pCmdPool)
     pRenderer->allocator.pFree(pRenderer->allocator.pUserData, pCmdPool);
 }
 
-// get memChunk of REI_VK_CMD_SCRATCH_MEM_SIZE size allocated after eac REI_Cmd
-inline void* util_get_scratch_memory(const REI_Cmd* pCmd) { return (void*)(pCmd + 1); }
-
 void REI_addCmd(REI_Renderer* pRenderer, REI_CmdPool* pCmdPool, bool secondary, REI_Cmd** ppCmd)
 {
     REI_ASSERT(pCmdPool);
@@ -2710,7 +2724,7 @@ void REI_addCmd(REI_Renderer* pRenderer, REI_CmdPool* pCmdPool, bool secondary,
 
     REI_StackAllocator<false> persistentAlloc = { 0 };
 
-    persistentAlloc.reserve<REI_Cmd>().reserve<uint8_t>(REI_VK_CMD_SCRATCH_MEM_SIZE);
+    persistentAlloc.reserve<REI_Cmd>();
 
     if (!persistentAlloc.done(allocator))
     {
@@ -2725,6 +2739,10 @@ void REI_addCmd(REI_Renderer* pRenderer, REI_CmdPool* pCmdPool, bool secondary,
 
     pCmd->pRenderer = pRenderer;
     pCmd->pCmdPool = pCmdPool;
+    pCmd->scratchArena.init(allocator, REI_VK_CMD_SCRATCH_MEM_SIZE);
+#if REI_POOL_VALIDATION
+    pCmd->poolRefs.init(allocator);
+#endif
 
     DECLARE_ZERO(VkCommandBufferAllocateInfo, alloc_info);
     alloc_info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
@@ -2762,6 +2780,10 @@ void REI_removeCmd(REI_Renderer* pRenderer, REI_CmdPool* pCmdPool, REI_Cmd* pCmd
 
     vkFreeCommandBuffers(pRenderer->pVkDevice, pCmdPool->pVkCmdPool, 1, &(pCmd->pVkCmdBuf));
 
+    pCmd->scratchArena.destroy();
+#if REI_POOL_VALIDATION
+    pCmd->poolRefs.destroy();
+#endif
     REI_delete(pRenderer->allocator, pCmd);
 }
 
@@ -3117,7 +3139,7 @@ void REI_addBuffer(REI_Renderer* pRenderer, const REI_BufferDesc* pDesc, REI_Buf
     REI_ASSERT(pDesc->size > 0);
     REI_ASSERT(VK_NULL_HANDLE != pRenderer->pVkDevice);
 
-    REI_Buffer* pBuffer = (REI_Buffer*)REI_calloc(pRenderer->allocator, sizeof(*pBuffer));
+    REI_Buffer* pBuffer = pRenderer->bufferPool.allocate();
     REI_ASSERT(pBuffer);
 
     pBuffer->desc = *pDesc;
@@ -3257,7 +3279,18 @@ void REI_removeBuffer(REI_Renderer* pRenderer, REI_Buffer* pBuffer)
 
     vmaDestroyBuffer(pRenderer->pVmaAllocator, pBuffer->pVkBuffer, pBuffer->pVkAllocation);
 
-    pRenderer->allocator.pFree(pRenderer->allocator.pUserData, pBuffer);
+    pRenderer->bufferPool.release(pBuffer);
+}
+
+REI_PoolHandle REI_getBufferHandle(REI_Renderer* pRenderer, REI_Buffer* pBuffer)
+{
+    REI_POOL_VALIDATE(pRenderer->bufferPool, pBuffer);
+    return pRenderer->bufferPool.getHandle(pBuffer);
+}
+
+REI_Buffer* REI_resolveBuffer(REI_Renderer* pRenderer, REI_PoolHandle handle)
+{
+    return pRenderer->bufferPool.resolve(handle);
 }
 
 void REI_addTexture(REI_Renderer* pRenderer, const REI_TextureDesc* pDesc, REI_Texture** ppTexture)
@@ -3274,8 +3307,8 @@ void REI_addTexture(REI_Renderer* pRenderer, const REI_TextureDesc* pDesc, REI_T
     const REI_AllocatorCallbacks& allocator = pRenderer->allocator;
     REI_LogPtr                    pLog = pRenderer->pLog;
 
+    // View arrays and the debug name are variable sized, they live next to each other outside of the pooled REI_Texture
     REI_StackAllocator<false> persistentAlloc = { 0 };
-    persistentAlloc.reserve<REI_Texture>();
 
     if (((util_has_stencil_aspect(pDesc->format)) && (pDesc->descriptors & REI_DESCRIPTOR_TYPE_TEXTURE))) 
     {
@@ -3316,8 +3349,9 @@ void REI_addTexture(REI_Renderer* pRenderer, const REI_TextureDesc* pDesc, REI_T
         return;
     }
 
-    REI_Texture* pTexture = persistentAlloc.allocZeroed<REI_Texture>();
+    REI_Texture* pTexture = pRenderer->texturePool.allocate();
     REI_ASSERT(pTexture);
+    pTexture->pPersistentData = persistentAlloc.ptr;
 
     pTexture->desc = *pDesc;
     REI_TextureDesc& desc = pTexture->desc;
@@ -3665,7 +3699,20 @@ void REI_removeTexture(REI_Renderer* pRenderer, REI_Texture* pTexture)
         }
     }
 
-    allocator.pFree(allocator.pUserData, pTexture);
+    if (pTexture->pPersistentData)
+        allocator.pFree(allocator.pUserData, pTexture->pPersistentData);
+    pRenderer->texturePool.release(pTexture);
+}
+
+REI_PoolHandle REI_getTextureHandle(REI_Renderer* pRenderer, REI_Texture* pTexture)
+{
+    REI_POOL_VALIDATE(pRenderer->texturePool, pTexture);
+    return pRenderer->texturePool.getHandle(pTexture);
+}
+
+REI_Texture* REI_resolveTexture(REI_Renderer* pRenderer, REI_PoolHandle handle)
+{
+    return pRenderer->texturePool.resolve(handle);
 }
 
 void REI_addSampler(REI_Renderer* pRenderer, const REI_SamplerDesc* pDesc, REI_Sampler** pp_sampler)
@@ -3674,7 +3721,7 @@ void REI_addSampler(REI_Renderer* pRenderer, const REI_SamplerDesc* pDesc, REI_S
     REI_ASSERT(VK_NULL_HANDLE != pRenderer->pVkDevice);
     REI_ASSERT(pDesc->compareFunc < REI_MAX_COMPARE_MODES);
 
-    REI_Sampler* pSampler = (REI_Sampler*)REI_calloc(pRenderer->allocator, sizeof(*pSampler));
+    REI_Sampler* pSampler = pRenderer->samplerPool.allocate();
     REI_ASSERT(pSampler);
 
     DECLARE_ZERO(VkSamplerCreateInfo, add_info);
@@ -3715,7 +3762,18 @@ void REI_removeSampler(REI_Renderer* pRenderer, REI_Sampler* pSampler)
 
     vkDestroySampler(pRenderer->pVkDevice, pSampler->pVkSampler, NULL);
 
-    pRenderer->allocator.pFree(pRenderer->allocator.pUserData, pSampler);
+    pRenderer->samplerPool.release(pSampler);
+}
+
+REI_PoolHandle REI_getSamplerHandle(REI_Renderer* pRenderer, REI_Sampler* pSampler)
+{
+    REI_POOL_VALIDATE(pRenderer->samplerPool, pSampler);
+    return pRenderer->samplerPool.getHandle(pSampler);
+}
+
+REI_Sampler* REI_resolveSampler(REI_Renderer* pRenderer, REI_PoolHandle handle)
+{
+    return pRenderer->samplerPool.resolve(handle);
 }
 /************************************************************************/
 // REI_Buffer Functions
@@ -3775,12 +3833,12 @@ void REI_addDescriptorTableArray(
     size_t                    scratchMemSize =
         numDescriptors * pDesc->maxTables *
         std::max(sizeof(VkDescriptorImageInfo), std::max(sizeof(VkDescriptorBufferInfo), sizeof(VkBufferView)));
+    scratchMemSize = std::max(scratchMemSize, sizeof(VkDescriptorSetLayout) * pDesc->maxTables);
 
     structAlloc.reserve<REI_DescriptorTableArray>()
         .reserve<VkDescriptorSet>(pDesc->maxTables)
         .reserve<REI_BindingInfo>(numDescriptors)
         .reserve<VkWriteDescriptorSet>(numDescriptors * pDesc->maxTables)
-        .reserve<uint8_t>(scratchMemSize)
         .done(allocator);
 
     pDescriptorTableArr = structAlloc.alloc<REI_DescriptorTableArray>();
@@ -3804,10 +3862,8 @@ void REI_addDescriptorTableArray(
         pDescriptorTableArr->pDescriptorBindings[i] = pRootSignature->pDescriptorBindings[firstDescriptorIndex + i];
     }
 
-    pDescriptorTableArr->scratchMem = structAlloc.alloc<uint8_t>(scratchMemSize);
-    pDescriptorTableArr->scratchMemSize = scratchMemSize;
-    REI_ASSERT(scratchMemSize >= sizeof(VkDescriptorSetLayout) * pDesc->maxTables);
-    VkDescriptorSetLayout* pLayouts = (VkDescriptorSetLayout*)pDescriptorTableArr->scratchMem;
+    pDescriptorTableArr->scratchArena.init(allocator, scratchMemSize);
+    VkDescriptorSetLayout* pLayouts = pDescriptorTableArr->scratchArena.alloc<VkDescriptorSetLayout>(pDesc->maxTables);
     for (uint32_t i = 0; i < pDesc->maxTables; ++i)
     {
         pLayouts[i] = pRootSignature->vkDescriptorSetLayouts[slot];
@@ -3816,6 +3872,7 @@ void REI_addDescriptorTableArray(
     consume_descriptor_sets(
         pRenderer->pDescriptorPool, pLayouts, pDescriptorTableArr->pHandles, pDesc->maxTables,
         &pDescriptorTableArr->poolIndex);
+    pDescriptorTableArr->scratchArena.reset();
 
     *ppDescriptorTableArr = pDescriptorTableArr;
 }
@@ -3831,6 +3888,7 @@ void REI_removeDescriptorTableArray(REI_Renderer* pRenderer, REI_DescriptorTable
 
     const REI_AllocatorCallbacks& allocator = pRenderer->allocator;
 
+    pDescriptorTableArr->scratchArena.destroy();
     allocator.pFree(allocator.pUserData, pDescriptorTableArr);
 }
 
@@ -3854,7 +3912,8 @@ void REI_updateDescriptorTableArray(
     REI_ASSERT(pDescriptorTableArr->pHandles);
     REI_ASSERT(count > 0);
 
-    REI_StackAllocator<false>    scratchAlloc = { pDescriptorTableArr->scratchMem, pDescriptorTableArr->scratchMemSize };
+    REI_LinearArena& scratchAlloc = pDescriptorTableArr->scratchArena;
+    scratchAlloc.reset();
     VkWriteDescriptorSet* writeDescriptorSets = pDescriptorTableArr->pWriteDescriptorSets;
 
     for (uint32_t i = 0; i < count; ++i)
@@ -4961,6 +5020,16 @@ void REI_beginCmd(REI_Cmd* pCmd)
 
     // Reset CPU side data
     pCmd->pBoundRootSignature = NULL;
+    pCmd->scratchArena.reset();
+#if REI_POOL_VALIDATION
+    pCmd->poolRefs.reset();
+#endif
+}
+
+size_t REI_getCmdScratchHighWaterMarkVK(const REI_Cmd* pCmd)
+{
+    REI_ASSERT(pCmd);
+    return pCmd->scratchArena.getHighWaterMark();
 }
 
 static inline void util_use_dirty_state(REI_Cmd* pCmd)
@@ -5006,6 +5075,9 @@ void REI_cmdBindRenderTargets(
 {
     REI_ASSERT(pCmd);
     REI_ASSERT(VK_NULL_HANDLE != pCmd->pVkCmdBuf);
+    REI_POOL_VALIDATE_CMD_ARRAY(pCmd, pCmd->pRenderer->texturePool, ppRenderTargets, renderTargetCount);
+    if (pDepthStencil)
+        REI_POOL_VALIDATE_CMD(pCmd, pCmd->pRenderer->texturePool, pDepthStencil);
 
     auto& dirtyState = pCmd->mDirtyState;
     if (dirtyState.pVkActiveRenderPass)
@@ -5086,11 +5158,10 @@ void REI_cmdBindRenderTargets(
     }
     else
     {
-        constexpr uint32_t requiredScratchSpace = 2u * util_add_render_pass_stack_size_in_bytes();
-        static_assert(
-            requiredScratchSpace <= REI_VK_CMD_SCRATCH_MEM_SIZE, "not enough scratch space to use for allocations");
-
-        REI_StackAllocator<false> scratchAlloc = { util_get_scratch_memory(pCmd), REI_VK_CMD_SCRATCH_MEM_SIZE };
+        constexpr uint32_t        requiredScratchSpace = 2u * util_add_render_pass_stack_size_in_bytes();
+        REI_LinearArenaScope      scratchScope(pCmd->scratchArena);
+        REI_StackAllocator<false> scratchAlloc = { pCmd->scratchArena.alloc(requiredScratchSpace),
+                                                   requiredScratchSpace };
 
         REI_Format colorFormats[REI_MAX_RENDER_TARGET_ATTACHMENTS] = {};
         REI_Format depthStencilFormat = REI_FMT_UNDEFINED;
@@ -5139,11 +5210,10 @@ void REI_cmdBindRenderTargets(
     }
     else
     {
-        constexpr uint32_t requiredScratchSpace = util_add_framebuffer_stack_size_in_bytes();
-        static_assert(
-            requiredScratchSpace <= REI_VK_CMD_SCRATCH_MEM_SIZE, "not enough scratch space to use for allocations");
-
-        REI_StackAllocator<false> scratchAlloc = { util_get_scratch_memory(pCmd), REI_VK_CMD_SCRATCH_MEM_SIZE };
+        constexpr uint32_t        requiredScratchSpace = util_add_framebuffer_stack_size_in_bytes();
+        REI_LinearArenaScope      scratchScope(pCmd->scratchArena);
+        REI_StackAllocator<false> scratchAlloc = { pCmd->scratchArena.alloc(requiredScratchSpace),
+                                                   requiredScratchSpace };
 
         FrameBufferDesc desc{
             /*.renderPass = */ renderPass,
@@ -5262,6 +5332,7 @@ void REI_cmdBindIndexBuffer(REI_Cmd* pCmd, REI_Buffer* pBuffer, uint64_t offset)
     REI_ASSERT(pCmd);
     REI_ASSERT(pBuffer);
     REI_ASSERT(VK_NULL_HANDLE != pCmd->pVkCmdBuf);
+    REI_POOL_VALIDATE_CMD(pCmd, pCmd->pRenderer->bufferPool, pBuffer);
 
     VkIndexType vk_index_type =
         (REI_INDEX_TYPE_UINT16 == pBuffer->desc.indexType) ? VK_INDEX_TYPE_UINT16 : VK_INDEX_TYPE_UINT32;
@@ -5274,6 +5345,7 @@ void REI_cmdBindVertexBuffer(REI_Cmd* pCmd, uint32_t bufferCount, REI_Buffer** p
     REI_ASSERT(0 != bufferCount);
     REI_ASSERT(ppBuffers);
     REI_ASSERT(VK_NULL_HANDLE != pCmd->pVkCmdBuf);
+    REI_POOL_VALIDATE_CMD_ARRAY(pCmd, pCmd->pRenderer->bufferPool, ppBuffers, bufferCount);
 
     static constexpr VkDeviceSize s_buffer_offsets[REI_VK_MAX_VERTEX_BUFFERS] = { 0 };
 
@@ -5282,10 +5354,10 @@ void REI_cmdBindVertexBuffer(REI_Cmd* pCmd, uint32_t bufferCount, REI_Buffer** p
     // No upper bound for this, so use 64 for now
     REI_ASSERT(capped_buffer_count < REI_VK_MAX_VERTEX_BUFFERS);
 
-    REI_StackAllocator<false> scratchAlloc = { util_get_scratch_memory(pCmd), REI_VK_CMD_SCRATCH_MEM_SIZE };
+    REI_LinearArenaScope scratchScope(pCmd->scratchArena);
 
-    VkBuffer*     pVertexBuffers = scratchAlloc.alloc<VkBuffer>(capped_buffer_count);
-    VkDeviceSize* pVertexStrides = scratchAlloc.alloc<VkDeviceSize>(capped_buffer_count);
+    VkBuffer*     pVertexBuffers = pCmd->scratchArena.alloc<VkBuffer>(capped_buffer_count);
+    VkDeviceSize* pVertexStrides = pCmd->scratchArena.alloc<VkDeviceSize>(capped_buffer_count);
 
     for (uint32_t i = 0; i < capped_buffer_count; ++i)
     {
@@ -5354,14 +5426,14 @@ void REI_cmdResourceBarrier(
     REI_Cmd* pCmd, uint32_t numBufferBarriers, REI_BufferBarrier* pBufferBarriers, uint32_t numTextureBarriers,
     REI_TextureBarrier* pTextureBarriers)
 {
-    REI_StackAllocator<false> scratchAlloc = { util_get_scratch_memory(pCmd), REI_VK_CMD_SCRATCH_MEM_SIZE };
-   
+    REI_LinearArenaScope scratchScope(pCmd->scratchArena);
+
     VkImageMemoryBarrier* imageBarriers =
-        numTextureBarriers ? scratchAlloc.alloc<VkImageMemoryBarrier>(numTextureBarriers) : NULL;
+        numTextureBarriers ? pCmd->scratchArena.alloc<VkImageMemoryBarrier>(numTextureBarriers) : NULL;
     uint32_t imageBarrierCount = 0;
 
     VkBufferMemoryBarrier* bufferBarriers =
-        numBufferBarriers ? scratchAlloc.alloc<VkBufferMemoryBarrier>(numBufferBarriers) : NULL;
+        numBufferBarriers ? pCmd->scratchArena.alloc<VkBufferMemoryBarrier>(numBufferBarriers) : NULL;
     uint32_t bufferBarrierCount = 0;
 
     VkAccessFlags srcAccessFlags = 0;
@@ -5371,6 +5443,7 @@ void REI_cmdResourceBarrier(
     {
         REI_BufferBarrier* pTrans = &pBufferBarriers[i];
         REI_Buffer*        pBuffer = pTrans->pBuffer;
+        REI_POOL_VALIDATE_CMD(pCmd, pCmd->pRenderer->bufferPool, pBuffer);
 
         if (!(pTrans->endState & pTrans->startState))
         {
@@ -5415,6 +5488,7 @@ void REI_cmdResourceBarrier(
     {
         REI_TextureBarrier* pTrans = &pTextureBarriers[i];
         REI_Texture*        pTexture = pTrans->pTexture;
+        REI_POOL_VALIDATE_CMD(pCmd, pCmd->pRenderer->texturePool, pTexture);
 
         if (!(pTrans->endState & pTrans->startState))
         {
@@ -5513,6 +5587,8 @@ void REI_cmdCopyBuffer(
     REI_ASSERT(pBuffer->pVkBuffer);
     REI_ASSERT(srcOffset + size <= pSrcBuffer->desc.size);
     REI_ASSERT(dstOffset + size <= pBuffer->desc.size);
+    REI_POOL_VALIDATE_CMD(pCmd, pCmd->pRenderer->bufferPool, pBuffer);
+    REI_POOL_VALIDATE_CMD(pCmd, pCmd->pRenderer->bufferPool, pSrcBuffer);
 
     VkBufferCopy region{ /*.srcOffset = */ srcOffset,
                          /*.dstOffset = */ dstOffset,
@@ -5523,6 +5599,9 @@ void REI_cmdCopyBuffer(
 void REI_cmdCopyBufferToTexture(
     REI_Cmd* pCmd, REI_Texture* pTexture, REI_Buffer* pSrcBuffer, REI_SubresourceDesc* pSubresourceDesc)
 {
+    REI_POOL_VALIDATE_CMD(pCmd, pCmd->pRenderer->texturePool, pTexture);
+    REI_POOL_VALIDATE_CMD(pCmd, pCmd->pRenderer->bufferPool, pSrcBuffer);
+
     VkBufferImageCopy copyData;
     copyData.bufferOffset = pSubresourceDesc->bufferOffset;
     copyData.bufferRowLength = 0;
@@ -5545,6 +5624,9 @@ void REI_cmdCopyBufferToTexture(
 void REI_cmdCopyTextureToBuffer(
     REI_Cmd* pCmd, REI_Buffer* pDstBuffer, REI_Texture* pTexture, REI_SubresourceDesc* pSubresourceDesc)
 {
+    REI_POOL_VALIDATE_CMD(pCmd, pCmd->pRenderer->bufferPool, pDstBuffer);
+    REI_POOL_VALIDATE_CMD(pCmd, pCmd->pRenderer->texturePool, pTexture);
+
     VkBufferImageCopy copyData;
     copyData.bufferOffset = pSubresourceDesc->bufferOffset;
     copyData.bufferRowLength = 0;
@@ -5567,6 +5649,9 @@ void REI_cmdCopyTextureToBuffer(
 void REI_cmdResolveTexture(
     REI_Cmd* pCmd, REI_Texture* pDstTexture, REI_Texture* pSrcTexture, REI_ResolveDesc* pResolveDesc)
 {
+    REI_POOL_VALIDATE_CMD(pCmd, pCmd->pRenderer->texturePool, pDstTexture);
+    REI_POOL_VALIDATE_CMD(pCmd, pCmd->pRenderer->texturePool, pSrcTexture);
+
     VkImageResolve resolveData{};
     resolveData.srcSubresource.aspectMask = pSrcTexture->vkAspectMask;
     resolveData.srcSubresource.mipLevel = pResolveDesc->mipLevel;
@@ -5649,6 +5734,11 @@ void REI_queueSubmit(
     }
 
     REI_ASSERT(VK_NULL_HANDLE != pQueue->pVkQueue);
+    if (pFence)
+        REI_POOL_VALIDATE(pQueue->pRenderer->fencePool, pFence);
+    REI_POOL_VALIDATE_ARRAY(pQueue->pRenderer->semaphorePool, ppWaitSemaphores, waitSemaphoreCount);
+    REI_POOL_VALIDATE_ARRAY(pQueue->pRenderer->semaphorePool, ppSignalSemaphores, signalSemaphoreCount);
+    REI_POOL_VALIDATE_SUBMIT(ppCmds, cmdCount);
 
     cmdCount = cmdCount > REI_MAX_SUBMIT_CMDS ? REI_MAX_SUBMIT_CMDS : cmdCount;
     waitSemaphoreCount =
@@ -5761,6 +5851,7 @@ void REI_waitForFences(REI_Renderer* pRenderer, uint32_t fenceCount, REI_Fence**
     REI_ASSERT(pRenderer);
     REI_ASSERT(fenceCount);
     REI_ASSERT(ppFences);
+    REI_POOL_VALIDATE_ARRAY(pRenderer->fencePool, ppFences, fenceCount);
 
     VkFence* pFences = (VkFence*)alloca(fenceCount * sizeof(VkFence));
     uint32_t numValidFences = 0;
@@ -5784,6 +5875,8 @@ void REI_waitQueueIdle(REI_Queue* pQueue) { vkQueueWaitIdle(pQueue->pVkQueue); }
 
 void REI_getFenceStatus(REI_Renderer* pRenderer, REI_Fence* pFence, REI_FenceStatus* pFenceStatus)
 {
+    REI_POOL_VALIDATE(pRenderer->fencePool, pFence);
+
     *pFenceStatus = REI_FENCE_STATUS_COMPLETE;
 
     if (pFence->submitted)
@@ -5854,6 +5947,10 @@ void REI_cmdExecuteIndirect(
     REI_Cmd* pCmd, REI_CommandSignature* pCommandSignature, uint32_t maxCommandCount, REI_Buffer* pIndirectBuffer,
     uint64_t bufferOffset, REI_Buffer* pCounterBuffer, uint64_t counterBufferOffset)
 {
+    REI_POOL_VALIDATE_CMD(pCmd, pCmd->pRenderer->bufferPool, pIndirectBuffer);
+    if (pCounterBuffer)
+        REI_POOL_VALIDATE_CMD(pCmd, pCmd->pRenderer->bufferPool, pCounterBuffer);
+
     if (pCommandSignature->drawType == REI_INDIRECT_DRAW)
     {
         if (pCounterBuffer && pCmd->pRenderer->pfn_VkCmdDrawIndirectCountKHR)
@@ -5913,7 +6010,7 @@ void REI_getQueueProperties(REI_Queue* pQueue, REI_QueueProperties* outPropertie
 
 void REI_addQueryPool(REI_Renderer* pRenderer, const REI_QueryPoolDesc* pDesc, REI_QueryPool** ppQueryPool)
 {
-    REI_QueryPool* pQueryPool = (REI_QueryPool*)REI_calloc(pRenderer->allocator, sizeof(*pQueryPool));
+    REI_QueryPool* pQueryPool = pRenderer->queryPoolPool.allocate();
     pQueryPool->desc = *pDesc;
 
     VkQueryPoolCreateInfo createInfo = {};
@@ -5931,16 +6028,29 @@ void REI_addQueryPool(REI_Renderer* pRenderer, const REI_QueryPoolDesc* pDesc, R
 void REI_removeQueryPool(REI_Renderer* pRenderer, REI_QueryPool* pQueryPool)
 {
     vkDestroyQueryPool(pRenderer->pVkDevice, pQueryPool->pVkQueryPool, NULL);
-    pRenderer->allocator.pFree(pRenderer->allocator.pUserData, pQueryPool);
+    pRenderer->queryPoolPool.release(pQueryPool);
+}
+
+REI_PoolHandle REI_getQueryPoolHandle(REI_Renderer* pRenderer, REI_QueryPool* pQueryPool)
+{
+    REI_POOL_VALIDATE(pRenderer->queryPoolPool, pQueryPool);
+    return pRenderer->queryPoolPool.getHandle(pQueryPool);
+}
+
+REI_QueryPool* REI_resolveQueryPool(REI_Renderer* pRenderer, REI_PoolHandle handle)
+{
+    return pRenderer->queryPoolPool.resolve(handle);
 }
 
 void REI_cmdResetQueryPool(REI_Cmd* pCmd, REI_QueryPool* pQueryPool, uint32_t startQuery, uint32_t queryCount)
 {
+    REI_POOL_VALIDATE_CMD(pCmd, pCmd->pRenderer->queryPoolPool, pQueryPool);
     vkCmdResetQueryPool(pCmd->pVkCmdBuf, pQueryPool->pVkQueryPool, startQuery, queryCount);
 }
 
 void REI_cmdBeginQuery(REI_Cmd* pCmd, REI_QueryPool* pQueryPool, uint32_t index)
 {
+    REI_POOL_VALIDATE_CMD(pCmd, pCmd->pRenderer->queryPoolPool, pQueryPool);
     REI_QueryType type = pQueryPool->desc.type;
     switch (type)
     {
@@ -5962,6 +6072,7 @@ void REI_cmdBeginQuery(REI_Cmd* pCmd, REI_QueryPool* pQueryPool, uint32_t index)
 
 void REI_cmdEndQuery(REI_Cmd* pCmd, REI_QueryPool* pQueryPool, uint32_t index)
 {
+    REI_POOL_VALIDATE_CMD(pCmd, pCmd->pRenderer->queryPoolPool, pQueryPool);
     REI_QueryType type = pQueryPool->desc.type;
     switch (type)
     {
@@ -5980,6 +6091,8 @@ void REI_cmdResolveQuery(
     REI_Cmd* pCmd, REI_Buffer* pBuffer, uint64_t bufferOffset, REI_QueryPool* pQueryPool, uint32_t startQuery,
     uint32_t queryCount)
 {
+    REI_POOL_VALIDATE_CMD(pCmd, pCmd->pRenderer->bufferPool, pBuffer);
+    REI_POOL_VALIDATE_CMD(pCmd, pCmd->pRenderer->queryPoolPool, pQueryPool);
     vkCmdCopyQueryPoolResults(
         pCmd->pVkCmdBuf, pQueryPool->pVkQueryPool, startQuery, queryCount, pBuffer->pVkBuffer, bufferOffset,
         sizeof(uint64_t), VK_QUERY_RESULT_64_BIT | VK_QUERY_RESULT_WAIT_BIT);
@@ -52,7 +52,7 @@ enum
     REI_VK_MAX_QUEUE_FAMILY_COUNT = 16,
     REI_VK_MAX_QUEUES_PER_FAMILY = 64,
     REI_VK_MAX_VERTEX_BUFFERS = 64,
-    REI_VK_CMD_SCRATCH_MEM_SIZE = 4 * 1024,    // 4KB
+    REI_VK_CMD_SCRATCH_MEM_SIZE = 4 * 1024,    // 4KB, size of the first scratch arena page, the arena grows on demand
     REI_VK_MAX_EXTENSIONS_COUNT = 4000,
     REI_VK_MAX_DESCRIPTORS_SETS_IN_POOL = 8192,
     REI_VK_DESCRIPTOR_TYPE_SAMPLER_COUNT = 1024,
@@ -125,8 +125,7 @@ typedef struct REI_BindingInfo REI_BindingInfo;
 
 typedef struct REI_DescriptorTableArray
 {
-    void*                    scratchMem;
-    size_t                   scratchMemSize;
+    REI_LinearArena          scratchArena;
     VkDescriptorSet*         pHandles;
     REI_BindingInfo*         pDescriptorBindings;
     VkWriteDescriptorSet*    pWriteDescriptorSets;
@@ -138,7 +137,15 @@ typedef struct REI_DescriptorTableArray
 
 typedef struct REI_Renderer
 {
-    inline REI_Renderer(const REI_AllocatorCallbacks& inAllocatorCallbacks): allocator(inAllocatorCallbacks) {}
+    inline REI_Renderer(const REI_AllocatorCallbacks& inAllocatorCallbacks): allocator(inAllocatorCallbacks)
+    {
+        bufferPool.init(inAllocatorCallbacks);
+        texturePool.init(inAllocatorCallbacks);
+        samplerPool.init(inAllocatorCallbacks);
+        fencePool.init(inAllocatorCallbacks);
+        semaphorePool.init(inAllocatorCallbacks);
+        queryPoolPool.init(inAllocatorCallbacks);
+    }
 
     uint32_t                    numOfDevices;
     VkInstance                  pVkInstance;
@@ -192,6 +199,14 @@ typedef struct REI_Renderer
 
     REI_atomicptr_t textureIds = 0;
 
+    // Fixed block pools for frequently created objects
+    REI_Pool<struct REI_Buffer>    bufferPool;
+    REI_Pool<struct REI_Texture>   texturePool;
+    REI_Pool<struct REI_Sampler>   samplerPool;
+    REI_Pool<struct REI_Fence>     fencePool;
+    REI_Pool<struct REI_Semaphore> semaphorePool;
+    REI_Pool<struct REI_QueryPool> queryPoolPool;
+
     uint32_t vkUsedQueueCount[REI_VK_MAX_QUEUE_FAMILY_COUNT];
 } REI_Renderer;
 
@@ -301,6 +316,8 @@ typedef struct REI_Texture
     VkImageAspectFlags vkAspectMask;
     /// REI_Texture creation info
     REI_TextureDesc desc;    //88
+    /// View arrays and debug name storage, allocated separately from the pooled texture
+    void* pPersistentData;
     /// This value will be false if the underlying resource is not owned by the texture (swapchain textures,...)
     bool ownsImage;
 } REI_Texture;
@@ -328,6 +345,14 @@ typedef struct REI_Cmd
     RenderPassMap  renderPassMap;
     FrameBufferMap frameBufferMap;
 
+    /// Temporary memory for a single REI_cmd* call, reset in REI_beginCmd
+    REI_LinearArena scratchArena;
+
+#if REI_POOL_VALIDATION
+    /// Pool objects the commands were recorded with, checked again in REI_queueSubmit
+    REI_PoolRefList poolRefs;
+#endif
+
     struct DirtyState
     {
         VkRenderPass pVkActiveRenderPass;
@@ -364,4 +389,6 @@ typedef struct REI_Swapchain
 void REI_initRendererVk(const REI_RendererDescVk* pDescVk, REI_Renderer** ppRenderer);
 void REI_cmdBindDescriptorTableVK(
     REI_Cmd* pCmd, uint32_t tableIndex, REI_DescriptorTableArray* pDescriptorTableArr, uint32_t dynamicOffsetCount,
-    const uint32_t* pDynamicOffsets);
\ No newline at end of file
+    const uint32_t* pDynamicOffsets);
+/// Largest amount of scratch memory a single command of pCmd has used, useful to tune REI_VK_CMD_SCRATCH_MEM_SIZE
+size_t REI_getCmdScratchHighWaterMarkVK(const REI_Cmd* pCmd);
\ No newline at end of file
@@ -35,6 +35,8 @@ extern "C" {
 enum FONSflags {
 	FONS_ZERO_TOPLEFT = 1,
 	FONS_ZERO_BOTTOMLEFT = 2,
+	// Glyphs are rasterized once as signed distance fields at sdfSize and scaled to the requested size.
+	FONS_SDF = 4,
 };
 
 enum FONSalign {
@@ -60,15 +62,29 @@ enum FONSerrorCode {
 	FONS_STATES_UNDERFLOW = 4,
 };
 
+// A glyph to rasterize into its atlas rect, which includes the padding.
+struct FONSglyphJob {
+	const struct FONSttFontImpl* font;
+	int glyph;
+	float scale;
+	int x, y, width, height;
+	int padding, blur;
+	unsigned char sdf;
+};
+typedef struct FONSglyphJob FONSglyphJob;
+
 struct FONSparams {
 	int width, height;
 	unsigned char flags;
+	int sdfSize, sdfPadding;	// Pixel size and distance range of FONS_SDF glyphs.
 	void* userPtr;
 	int (*renderCreate)(void* uptr, int width, int height);
 	int (*renderResize)(void* uptr, int width, int height);
 	void (*renderUpdate)(void* uptr, int* rect, const unsigned char* data);
 	void (*renderDraw)(void* uptr, const float* verts, const float* tcoords, const unsigned int* colors, int nverts);
 	void (*renderDelete)(void* uptr);
+	// Returns 1 when the glyph is rasterized later with fonsRenderGlyphJob, its rect holds a placeholder until then.
+	int (*renderGlyph)(void* uptr, const FONSglyphJob* job);
 };
 typedef struct FONSparams FONSparams;
 
@@ -144,6 +160,9 @@ FONS_DEF int fonsValidateTexture(FONScontext* s, int* dirty);
 // Draws the stash texture for debugging
 FONS_DEF void fonsDrawDebug(FONScontext* s, float x, float y);
 
+// Rasterizes a job of FONSparams::renderGlyph into dst, safe to call from any thread while the fonts exist.
+FONS_DEF void fonsRenderGlyphJob(const FONSglyphJob* job, unsigned char* dst, int dstStride);
+
 #ifdef __cplusplus
 }
 #endif
@@ -247,6 +266,14 @@ static void fons__tt_renderGlyphBitmap(FONSttFontImpl *font, unsigned char *outp
 	}
 }
 
+// No distance field renderer for FreeType, the coverage bitmap is a field one pixel wide.
+static void fons__tt_renderGlyphSDF(FONSttFontImpl *font, unsigned char *output, int outWidth, int outHeight, int outStride,
+								float scale, int padding, int glyph)
+{
+	fons__tt_renderGlyphBitmap(font, output + padding * (outStride + 1), outWidth - padding*2, outHeight - padding*2, outStride,
+							   scale, scale, glyph);
+}
+
 static int fons__tt_getGlyphKernAdvance(FONSttFontImpl *font, int glyph1, int glyph2)
 {
 	FT_Vector ftKerning;
@@ -315,6 +342,82 @@ static void fons__tt_renderGlyphBitmap(FONSttFontImpl *font, unsigned char *outp
 	stbtt_MakeGlyphBitmap(&font->font, output, outWidth, outHeight, outStride, scaleX, scaleY, glyph);
 }
 
+#define FONS_SDF_INF 1e20f
+
+// Squared distance transform of n samples stride apart, in place (Felzenszwalb and Huttenlocher).
+static void fons__edt1d(float* grid, int offset, int stride, int n, float* f, float* z, int* v)
+{
+	int q, k, r;
+	float s;
+	v[0] = 0;
+	z[0] = -FONS_SDF_INF;
+	z[1] = FONS_SDF_INF;
+	f[0] = grid[offset];
+	for (q = 1, k = 0; q < n; q++) {
+		f[q] = grid[offset + q*stride];
+		do {
+			r = v[k];
+			s = (f[q] - f[r] + (float)(q*q - r*r)) / (float)(q - r) * 0.5f;
+		} while (s <= z[k] && --k > -1);
+		k++;
+		v[k] = q;
+		z[k] = s;
+		z[k+1] = FONS_SDF_INF;
+	}
+	for (q = 0, k = 0; q < n; q++) {
+		while (z[k+1] < q) k++;
+		r = v[k];
+		grid[offset + q*stride] = f[r] + (float)((q - r)*(q - r));
+	}
+}
+
+static void fons__edt(float* grid, int w, int h, float* f, float* z, int* v)
+{
+	int x, y;
+	for (x = 0; x < w; x++) fons__edt1d(grid, x, w, h, f, z, v);
+	for (y = 0; y < h; y++) fons__edt1d(grid, y*w, 1, w, f, z, v);
+}
+
+// The coverage bitmap is turned into distances, partially covered texels place the edge inside of them.
+static void fons__tt_renderGlyphSDF(FONSttFontImpl *font, unsigned char *output, int outWidth, int outHeight, int outStride,
+								float scale, int padding, int glyph)
+{
+	int i, x, y, n = outWidth*outHeight, len = outWidth > outHeight ? outWidth : outHeight;
+	int floatsOffset = (n + 3) & ~3;
+	float a, d, *outer, *inner, *f, *z;
+	int* v;
+	unsigned char* coverage = (unsigned char*)malloc(floatsOffset + (n*2 + len*2 + 1)*sizeof(float) + len*sizeof(int));
+	if (coverage == NULL) return;
+	outer = (float*)(coverage + floatsOffset);
+	inner = outer + n;
+	f = inner + n;
+	z = f + len;
+	v = (int*)(z + len + 1);
+
+	memset(coverage, 0, n);
+	stbtt_MakeGlyphBitmap(&font->font, coverage + padding * (outWidth + 1), outWidth - padding*2, outHeight - padding*2, outWidth,
+						  scale, scale, glyph);
+
+	for (i = 0; i < n; i++) {
+		a = coverage[i] / 255.0f;
+		outer[i] = a == 1.0f ? 0.0f : a == 0.0f ? FONS_SDF_INF : (a < 0.5f ? (0.5f - a)*(0.5f - a) : 0.0f);
+		inner[i] = a == 1.0f ? FONS_SDF_INF : a == 0.0f ? 0.0f : (a > 0.5f ? (a - 0.5f)*(a - 0.5f) : 0.0f);
+	}
+	fons__edt(outer, outWidth, outHeight, f, z, v);
+	fons__edt(inner, outWidth, outHeight, f, z, v);
+
+	// Edge at 128, padding texels away from it on either side maps to 0 and 255.
+	for (y = 0; y < outHeight; y++) {
+		for (x = 0; x < outWidth; x++) {
+			i = y*outWidth + x;
+			d = sqrtf(outer[i]) - sqrtf(inner[i]);
+			d = 128.0f - d * 128.0f / padding;
+			output[y*outStride + x] = (unsigned char)(d < 0.0f ? 0.0f : d > 255.0f ? 255.0f : d + 0.5f);
+		}
+	}
+	free(coverage);
+}
+
 static int fons__tt_getGlyphKernAdvance(FONSttFontImpl *font, int glyph1, int glyph2)
 {
 	return stbtt_GetGlyphKernAdvance(&font->font, glyph1, glyph2);
@@ -452,6 +555,10 @@ static void* fons__tmpalloc(size_t size, void* up)
 	unsigned char* ptr;
 	FONScontext* stash = (FONScontext*)up;
 
+	// Glyph jobs run without a context and its scratch buffer.
+	if (stash == NULL)
+		return malloc(size);
+
 	// 16-byte align the returned pointer
 	size = (size + 0xf) & ~0xf;
 
@@ -467,9 +574,8 @@ static void* fons__tmpalloc(size_t size, void* up)
 
 static void fons__tmpfree(void* ptr, void* up)
 {
-	(void)ptr;
-	(void)up;
-	// empty
+	if (up == NULL)
+		free(ptr);
 }
 
 #endif // STB_TRUETYPE_IMPLEMENTATION
@@ -1074,22 +1180,106 @@ static void fons__blur(FONScontext* stash, unsigned char* dst, int w, int h, int
 //	fons__blurcols(dst, w, h, dstStride, alpha);
 }
 
+static void fons__renderGlyph(FONSttFontImpl* font, const FONSglyphJob* job, unsigned char* dst, int dstStride)
+{
+	int x, y, gw = job->width, gh = job->height, pad = job->padding;
+
+	// Rasterize
+	if (job->sdf) {
+		fons__tt_renderGlyphSDF(font, dst, gw, gh, dstStride, job->scale, pad, job->glyph);
+	} else {
+		fons__tt_renderGlyphBitmap(font, dst + pad + pad*dstStride, gw-pad*2, gh-pad*2, dstStride, job->scale, job->scale, job->glyph);
+	}
+
+	// Make sure there is one pixel empty border.
+	for (y = 0; y < gh; y++) {
+		dst[y*dstStride] = 0;
+		dst[gw-1 + y*dstStride] = 0;
+	}
+	for (x = 0; x < gw; x++) {
+		dst[x] = 0;
+		dst[x + (gh-1)*dstStride] = 0;
+	}
+
+	// Debug code to color the glyph background
+/*	unsigned char* fdst = dst;
+	for (y = 0; y < gh; y++) {
+		for (x = 0; x < gw; x++) {
+			int a = (int)fdst[x+y*dstStride] + 20;
+			if (a > 255) a = 255;
+			fdst[x+y*dstStride] = a;
+		}
+	}*/
+
+	// Blur
+	if (job->blur > 0)
+		fons__blur(NULL, dst, gw, gh, dstStride, job->blur);
+}
+
+static void fons__placeholderRow(const FONSglyphJob* job, unsigned char* row, int y, int x0, int x1)
+{
+	int x, d, pad = job->padding;
+	int bx1 = job->width - pad - 1, by1 = job->height - pad - 1;
+	for (x = x0; x < x1; x++) {
+		// Distance to the outline, square at the corners.
+		d = fons__maxi(fons__maxi(pad - x, x - bx1), fons__maxi(pad - y, y - by1));
+		if (d < 0) d = -d;
+		if (job->sdf && d <= pad)
+			row[x] = (unsigned char)(128 + (64 - 128*d) / pad);
+		else if (d == 0)
+			row[x] = 0x80;
+	}
+}
+
+// Outline of the glyph box, drawn while the glyph is rasterized elsewhere.
+// Atlas space is clear until a glyph is packed into it, only texels close to the outline are written.
+static void fons__renderPlaceholder(const FONSglyphJob* job, unsigned char* dst, int dstStride)
+{
+	int y, pad = job->padding, band = job->sdf ? pad : 0;
+	int by1 = job->height - pad - 1, side = pad + band + 1;
+	for (y = 0; y < job->height; y++) {
+		unsigned char* row = dst + y*dstStride;
+		if (fons__mini(y - pad, by1 - y) > band && side < job->width - side) {
+			fons__placeholderRow(job, row, y, 0, side);
+			fons__placeholderRow(job, row, y, job->width - side, job->width);
+		} else {
+			fons__placeholderRow(job, row, y, 0, job->width);
+		}
+	}
+}
+
+FONS_DEF void fonsRenderGlyphJob(const FONSglyphJob* job, unsigned char* dst, int dstStride)
+{
+	// stb_truetype allocates from the heap instead of the context scratch through a copy of the font.
+	FONSttFontImpl font = *job->font;
+#ifndef FONS_USE_FREETYPE
+	font.font.userdata = NULL;
+#endif
+	fons__renderGlyph(&font, job, dst, dstStride);
+}
+
 static FONSglyph* fons__getGlyph(FONScontext* stash, FONSfont* font, unsigned int codepoint,
 								 short isize, short iblur)
 {
-	int i, g, advance, lsb, x0, y0, x1, y1, gw, gh, gx, gy, x, y;
+	int i, g, advance, lsb, x0, y0, x1, y1, gw, gh, gx, gy;
 	float scale;
 	FONSglyph* glyph = NULL;
 	unsigned int h;
 	float size = isize/10.0f;
 	int pad, added;
-	unsigned char* bdst;
 	unsigned char* dst;
 	FONSfont* renderFont = font;
+	FONSglyphJob job;
 
+	if (stash->params.flags & FONS_SDF) {
+		// One distance field serves every size.
+		isize = (short)(stash->params.sdfSize*10);
+		iblur = 0;
+		size = (float)stash->params.sdfSize;
+	}
 	if (isize < 2) return NULL;
 	if (iblur > 20) iblur = 20;
-	pad = iblur+2;
+	pad = (stash->params.flags & FONS_SDF) ? stash->params.sdfPadding : iblur+2;
 
 	// Reset allocator.
 	stash->nscratch = 0;
@@ -1152,37 +1342,25 @@ static FONSglyph* fons__getGlyph(FONScontext* stash, FONSfont* font, unsigned in
 	glyph->next = font->lut[h];
 	font->lut[h] = font->nglyphs-1;
 
-	// Rasterize
-	dst = &stash->texData[(glyph->x0+pad) + (glyph->y0+pad) * stash->params.width];
-	fons__tt_renderGlyphBitmap(&renderFont->font, dst, gw-pad*2,gh-pad*2, stash->params.width, scale,scale, g);
+	job.font = &renderFont->font;
+	job.glyph = g;
+	job.scale = scale;
+	job.x = gx;
+	job.y = gy;
+	job.width = gw;
+	job.height = gh;
+	job.padding = pad;
+	job.blur = iblur;
+	job.sdf = (unsigned char)((stash->params.flags & FONS_SDF) != 0);
 
-	// Make sure there is one pixel empty border.
 	dst = &stash->texData[glyph->x0 + glyph->y0 * stash->params.width];
-	for (y = 0; y < gh; y++) {
-		dst[y*stash->params.width] = 0;
-		dst[gw-1 + y*stash->params.width] = 0;
-	}
-	for (x = 0; x < gw; x++) {
-		dst[x] = 0;
-		dst[x + (gh-1)*stash->params.width] = 0;
-	}
-
-	// Debug code to color the glyph background
-/*	unsigned char* fdst = &stash->texData[glyph->x0 + glyph->y0 * stash->params.width];
-	for (y = 0; y < gh; y++) {
-		for (x = 0; x < gw; x++) {
-			int a = (int)fdst[x+y*stash->params.width] + 20;
-			if (a > 255) a = 255;
-			fdst[x+y*stash->params.width] = a;
-		}
-	}*/
-
-	// Blur
-	if (iblur > 0) {
-		stash->nscratch = 0;
-		bdst = &stash->texData[glyph->x0 + glyph->y0 * stash->params.width];
-		fons__blur(stash, bdst, gw,gh, stash->params.width, iblur);
-	}
+#ifndef FONS_USE_FREETYPE
+	// Glyphs without ink are not worth handing off, FreeType faces can't be shared between threads.
+	if (x1 > x0 && y1 > y0 && stash->params.renderGlyph != NULL && stash->params.renderGlyph(stash->params.userPtr, &job))
+		fons__renderPlaceholder(&job, dst, stash->params.width);
+	else
+#endif
+		fons__renderGlyph(&renderFont->font, &job, dst, stash->params.width);
 
 	stash->dirtyRect[0] = fons__mini(stash->dirtyRect[0], glyph->x0);
 	stash->dirtyRect[1] = fons__mini(stash->dirtyRect[1], glyph->y0);
@@ -1193,10 +1371,12 @@ static FONSglyph* fons__getGlyph(FONScontext* stash, FONSfont* font, unsigned in
 }
 
 static void fons__getQuad(FONScontext* stash, FONSfont* font,
-						   int prevGlyphIndex, FONSglyph* glyph,
+						   int prevGlyphIndex, FONSglyph* glyph, short isize,
 						   float scale, float spacing, float* x, float* y, FONSquad* q)
 {
 	float rx,ry,xoff,yoff,x0,y0,x1,y1;
+	// FONS_SDF glyphs are rasterized at another size than requested.
+	float gs = (float)isize / glyph->size;
 
 	if (prevGlyphIndex != -1) {
 		float adv = fons__tt_getGlyphKernAdvance(&font->font, prevGlyphIndex, glyph->index) * scale;
@@ -1206,8 +1386,8 @@ static void fons__getQuad(FONScontext* stash, FONSfont* font,
 	// Each glyph has 2px border to allow good interpolation,
 	// one pixel to prevent leaking, and one to allow good interpolation for rendering.
 	// Inset the texture region by one pixel for correct interpolation.
-	xoff = (short)(glyph->xoff+1);
-	yoff = (short)(glyph->yoff+1);
+	xoff = (short)(glyph->xoff+1) * gs;
+	yoff = (short)(glyph->yoff+1) * gs;
 	x0 = (float)(glyph->x0+1);
 	y0 = (float)(glyph->y0+1);
 	x1 = (float)(glyph->x1-1);
@@ -1219,8 +1399,8 @@ static void fons__getQuad(FONScontext* stash, FONSfont* font,
 
 		q->x0 = rx;
 		q->y0 = ry;
-		q->x1 = rx + x1 - x0;
-		q->y1 = ry + y1 - y0;
+		q->x1 = rx + (x1 - x0) * gs;
+		q->y1 = ry + (y1 - y0) * gs;
 
 		q->s0 = x0 * stash->itw;
 		q->t0 = y0 * stash->ith;
@@ -1232,8 +1412,8 @@ static void fons__getQuad(FONScontext* stash, FONSfont* font,
 
 		q->x0 = rx;
 		q->y0 = ry;
-		q->x1 = rx + x1 - x0;
-		q->y1 = ry - y1 + y0;
+		q->x1 = rx + (x1 - x0) * gs;
+		q->y1 = ry - (y1 - y0) * gs;
 
 		q->s0 = x0 * stash->itw;
 		q->t0 = y0 * stash->ith;
@@ -1241,7 +1421,7 @@ static void fons__getQuad(FONScontext* stash, FONSfont* font,
 		q->t1 = y1 * stash->ith;
 	}
 
-	*x += (int)(glyph->xadv / 10.0f + 0.5f);
+	*x += (int)(glyph->xadv * gs / 10.0f + 0.5f);
 }
 
 static void fons__flush(FONScontext* stash)
@@ -1345,7 +1525,7 @@ FONS_DEF float fonsDrawText(FONScontext* stash,
 			continue;
 		glyph = fons__getGlyph(stash, font, codepoint, isize, iblur);
 		if (glyph != NULL) {
-			fons__getQuad(stash, font, prevGlyphIndex, glyph, scale, state->spacing, &x, &y, &q);
+			fons__getQuad(stash, font, prevGlyphIndex, glyph, isize, scale, state->spacing, &x, &y, &q);
 
 			if (stash->nverts+6 > FONS_VERTEX_COUNT)
 				fons__flush(stash);
@@ -1428,7 +1608,7 @@ FONS_DEF int fonsTextIterNext(FONScontext* stash, FONStextIter* iter, FONSquad*
 		iter->y = iter->nexty;
 		glyph = fons__getGlyph(stash, iter->font, iter->codepoint, iter->isize, iter->iblur);
 		if (glyph != NULL)
-			fons__getQuad(stash, iter->font, iter->prevGlyphIndex, glyph, iter->scale, iter->spacing, &iter->nextx, &iter->nexty, quad);
+			fons__getQuad(stash, iter->font, iter->prevGlyphIndex, glyph, iter->isize, iter->scale, iter->spacing, &iter->nextx, &iter->nexty, quad);
 		iter->prevGlyphIndex = glyph != NULL ? glyph->index : -1;
 		break;
 	}
@@ -1525,7 +1705,7 @@ FONS_DEF float fonsTextBounds(FONScontext* stash,
 			continue;
 		glyph = fons__getGlyph(stash, font, codepoint, isize, iblur);
 		if (glyph != NULL) {
-			fons__getQuad(stash, font, prevGlyphIndex, glyph, scale, state->spacing, &x, &y, &q);
+			fons__getQuad(stash, font, prevGlyphIndex, glyph, isize, scale, state->spacing, &x, &y, &q);
 			if (q.x0 < minx) minx = q.x0;
 			if (q.x1 > maxx) maxx = q.x1;
 			if (stash->params.flags & FONS_ZERO_TOPLEFT) {
@@ -14,6 +14,15 @@
 
 #include "BasicDraw.h"
 
+#include "REI/Thread.h"
+
+#include <float.h>
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__SSE2__)
+#    include <emmintrin.h>
+#    define REI_BASICDRAW_SSE2
+#endif
+
 #ifdef _WIN32
 #    define strcpy strcpy_s
 #endif
@@ -29,6 +38,80 @@ struct REI_BasicDraw_Uniforms
 
 static_assert(sizeof(REI_BasicDraw_Uniforms)==16*5, "REI_BasicDraw_Uniforms will mismatch shader");
 
+// Must match SIZEOF_EXPANDED_POINT and THREAD_GROUP_SIZE in basicdraw_point_expand_cs.hlsl
+static const uint32_t EXPANDED_POINT_SIZE = 32;
+static const uint32_t EXPAND_THREAD_GROUP_SIZE = 64;
+
+enum DrawKind
+{
+    DRAW_KIND_MESH,
+    DRAW_KIND_LINES,
+    DRAW_KIND_LINES_INSTANCED,
+    DRAW_KIND_POINTS,
+    DRAW_KIND_POINTS_INSTANCED,
+};
+
+// Draw recorded in deferred mode, first and count are in elements of the draw kind
+struct DeferredDraw
+{
+    uint32_t kind;
+    uint32_t chunk;
+    uint32_t uniformIndex;
+    uint32_t format;    // REI_BasicDraw_PointFormat of points, 1 for quantized lines
+    uint32_t bufferSet;
+    uint32_t first;
+    uint32_t count;
+};
+
+// Draws recorded by one thread. Calls taking a REI_Cmd use the list of REI_BasicDraw, every
+// REI_BasicDraw_Context owns another one
+struct DrawList
+{
+    DeferredDraw*          draws;
+    uint32_t               drawCount;
+    uint32_t               maxDraws;
+    uint32_t               callCount;
+    uint32_t               lastUniformIndex;    // ~0u until the list writes uniforms in the current frame
+    uint32_t               lastUniformChunk;
+    REI_BasicDraw_Uniforms lastUniforms;
+};
+
+// Data and uniform buffers draws are allocated from. Chunk i < resourceSetCount is the base chunk of set i,
+// overflow chunks follow and are lent to the set that runs out of its base chunk during a frame
+struct DataChunk
+{
+    REI_Buffer*     dataBuffer;
+    void*           dataAddr;
+    REI_Buffer*     uniBuffer;
+    void*           uniAddr;
+    uint64_t        dataSize;
+    uint32_t        maxUniforms;
+    REI_atomicptr_t dataUsed;
+    REI_atomic32_t  uniformCount;
+    REI_atomicptr_t droppedBytes;    // base chunks only, data of draws that fit in no chunk
+    REI_atomic32_t  droppedDraws;
+};
+
+static const uint32_t DEFAULT_POINTS_PER_CHUNK = 4096;
+// Chunks of a point set index are culled in groups before testing them one by one
+static const uint32_t CHUNKS_PER_GROUP = 64;
+
+struct Bounds
+{
+    float lo[3];
+    float hi[3];
+};
+
+struct PointSetIndex
+{
+    uint32_t pointCount;
+    uint32_t pointsPerChunk;
+    uint32_t chunkCount;
+    uint32_t groupCount;
+    Bounds*  chunkBounds;    // NULL if the buffer set has no index
+    Bounds*  groupBounds;
+};
+
 struct PipelineData
 {
     REI_RootSignature* rootSignature;
@@ -42,32 +125,64 @@ struct REI_BasicDraw
     REI_AllocatorCallbacks    allocator;
     PipelineData              meshPipelineData;
     PipelineData              pointPipelineData;
+    PipelineData              pointInstancedPipelineData;
+    PipelineData              pointExpandPipelineData;
+    PipelineData              pointExpandedPipelineData;
     PipelineData              linePipelineData;
-    REI_Buffer**              dataBuffers;
-    void**                    dataBuffersAddr;
-    REI_Buffer**              uniBuffers;
-    void**                    uniBuffersAddr;
+    PipelineData              lineInstancedPipelineData;
+    DataChunk*                chunks;
+    uint32_t*                 chunkOwners;    // set using each overflow chunk, ~0u if free
+    Mutex*                    chunkMutex;
+    REI_Buffer**              expandedBuffers;
+    PointSetIndex*            pointSetIndices;
     REI_Pipeline*             currentPipeline;
+    uint32_t                  boundChunk;
+    uint32_t                  currentPointDataSet;
     REI_DescriptorTableArray* meshDescriptorSet;
     REI_DescriptorTableArray* lineDescriptorSet;
     REI_DescriptorTableArray* pointUniDescriptorSet;
     REI_DescriptorTableArray* pointDataDescriptorSet;
+    REI_DescriptorTableArray* expandUniDescriptorSet;
+    REI_DescriptorTableArray* expandDataDescriptorSet;
+    REI_DescriptorTableArray* expandedDescriptorSet;
     uint32_t                  setIndex;
-    uint64_t                  dataUsed;
-    uint32_t                  uniformDataCount;
+    REI_atomic32_t            activeChunk;
+    uint32_t                  frameIndex;
+    uint32_t                  expandedUsed;
+    bool                      expandedWritable;
+    DrawList                  drawList;
+    REI_BasicDraw_Stats       stats;
+};
+
+struct REI_BasicDraw_Context
+{
+    REI_BasicDraw* state;
+    DrawList       drawList;
+    uint32_t       frameIndex;
 };
 
 
 #include "shaderbin/basicdraw_point_vs.bin.h"
 
+#include "shaderbin/basicdraw_point_instanced_vs.bin.h"
+
+#include "shaderbin/basicdraw_point_expand_cs.bin.h"
+
+#include "shaderbin/basicdraw_point_expanded_vs.bin.h"
+
 #include "shaderbin/basicdraw_line_vs.bin.h"
 
+#include "shaderbin/basicdraw_line_instanced_vs.bin.h"
+
 #include "shaderbin/basicdraw_mesh_vs.bin.h"
 
 #include "shaderbin/basicdraw_ps.bin.h"
 
+// Pass NULL pRootSigDesc to reuse the root signature already stored in pipelineData
 void createPipelineData(
-    REI_BasicDraw* state, uint32_t vertexAttribCount, REI_VertexAttrib* vertexAttribs, REI_ShaderDesc* shaderDesc, uint32_t shaderCount, REI_RootSignatureDesc* pRootSigDesc, PipelineData* pipelineData)
+    REI_BasicDraw* state, uint32_t vertexAttribCount, REI_VertexAttrib* vertexAttribs, REI_ShaderDesc* shaderDesc,
+    uint32_t shaderCount, REI_RootSignatureDesc* pRootSigDesc, PipelineData* pipelineData,
+    REI_PrimitiveTopology primitiveTopo = REI_PRIMITIVE_TOPO_TRI_LIST)
 {
     REI_Shader* shaders[MAX_SHADER_COUNT] = {};
     REI_addShaders(state->renderer, shaderDesc, shaderCount, shaders);
@@ -85,12 +200,13 @@ void createPipelineData(
     blendState.blendAlphaModes[0] = REI_BM_ADD;
     blendState.masks[0] = REI_COLOR_MASK_ALL;
 
-    REI_addRootSignature(state->renderer, pRootSigDesc, &pipelineData->rootSignature);
+    if (pRootSigDesc)
+        REI_addRootSignature(state->renderer, pRootSigDesc, &pipelineData->rootSignature);
     REI_Format colorFormat = (REI_Format)state->desc.colorFormat;
     REI_PipelineDesc pipelineDesc = {};
     pipelineDesc.type = REI_PIPELINE_TYPE_GRAPHICS;
     REI_GraphicsPipelineDesc& graphicsDesc = pipelineDesc.graphicsDesc;
-    graphicsDesc.primitiveTopo = REI_PRIMITIVE_TOPO_TRI_LIST;
+    graphicsDesc.primitiveTopo = primitiveTopo;
     graphicsDesc.renderTargetCount = 1;
     graphicsDesc.pColorFormats = &colorFormat;
     graphicsDesc.sampleCount = state->desc.sampleCount;
@@ -107,6 +223,26 @@ void createPipelineData(
     REI_removeShaders(state->renderer, shaderCount, shaders);
 }
 
+void createComputePipelineData(
+    REI_BasicDraw* state, REI_ShaderDesc* shaderDesc, REI_RootSignatureDesc* pRootSigDesc, PipelineData* pipelineData)
+{
+    REI_Shader* shader = NULL;
+    REI_addShaders(state->renderer, shaderDesc, 1, &shader);
+
+    REI_addRootSignature(state->renderer, pRootSigDesc, &pipelineData->rootSignature);
+    REI_PipelineDesc pipelineDesc = {};
+    pipelineDesc.type = REI_PIPELINE_TYPE_COMPUTE;
+    REI_ComputePipelineDesc& computeDesc = pipelineDesc.computeDesc;
+    computeDesc.pShaderProgram = shader;
+    computeDesc.pRootSignature = pipelineData->rootSignature;
+    computeDesc.numThreadsPerGroup[0] = EXPAND_THREAD_GROUP_SIZE;
+    computeDesc.numThreadsPerGroup[1] = 1;
+    computeDesc.numThreadsPerGroup[2] = 1;
+    REI_addPipeline(state->renderer, &pipelineDesc, &pipelineData->pipeline);
+
+    REI_removeShaders(state->renderer, 1, &shader);
+}
+
 void destroyPipelineData(REI_BasicDraw* state, PipelineData* pipelineData)
 {
     if (pipelineData->rootSignature)
@@ -121,25 +257,220 @@ void destroyPipelineData(REI_BasicDraw* state, PipelineData* pipelineData)
     }
 }
 
-bool allocateData(REI_BasicDraw* state, uint32_t count, uint32_t size, uint64_t* offset)
+// Lock-free bump allocation, safe to call from recording contexts
+bool allocateData(DataChunk* chunk, uint32_t count, uint32_t size, uint64_t* offset)
+{
+    uint64_t  allocSize = (uint64_t)size * count;
+    uintptr_t used = REI_atomicptr_load_relaxed(&chunk->dataUsed);
+    for (;;)
+    {
+        if (chunk->dataSize - used < allocSize + size)
+            return false;
+
+        uintptr_t rem = used % size;
+        uintptr_t start = used + (rem ? size - rem : 0);
+        uintptr_t prev = REI_atomicptr_cas_relaxed(&chunk->dataUsed, used, (uintptr_t)(start + allocSize));
+        if (prev == used)
+        {
+            *offset = start;
+            return true;
+        }
+        used = prev;
+    }
+}
+
+// Consecutive draws of one list with identical parameters share one uniform slot
+bool allocateUniforms(
+    REI_BasicDraw* state, DrawList* list, uint32_t chunkIndex, const REI_BasicDraw_Uniforms& uniforms, uint32_t* index)
+{
+    if (list->lastUniformIndex != ~0u && list->lastUniformChunk == chunkIndex &&
+        !memcmp(&list->lastUniforms, &uniforms, sizeof(uniforms)))
+    {
+        *index = list->lastUniformIndex;
+        return true;
+    }
+
+    DataChunk* chunk = &state->chunks[chunkIndex];
+    if (REI_atomic32_load_relaxed(&chunk->uniformCount) >= chunk->maxUniforms)
+        return false;
+
+    uint32_t uniformIndex = REI_atomic32_add_relaxed(&chunk->uniformCount, 1);
+    if (uniformIndex >= chunk->maxUniforms)
+        return false;
+
+    // Write through a local copy, uniform buffers are write-combined and must not be read back
+    ((REI_BasicDraw_Uniforms*)chunk->uniAddr)[uniformIndex] = uniforms;
+    list->lastUniforms = uniforms;
+    list->lastUniformIndex = uniformIndex;
+    list->lastUniformChunk = chunkIndex;
+    *index = uniformIndex;
+    return true;
+}
+
+void setUniforms(
+    REI_BasicDraw_Uniforms* uniforms, const float mvp[16], float sx, float sy, float sz, uint32_t color)
+{
+    memcpy(uniforms->uMVP, mvp, sizeof(uniforms->uMVP));
+    uniforms->uPxScalers[0] = sx;
+    uniforms->uPxScalers[1] = sy;
+    uniforms->uPxScalers[2] = sz;
+    uniforms->uColor = color;
+}
+
+// Per set data tables of point pipelines come after the tables of registered buffer sets
+uint32_t pointDataTableIndex(REI_BasicDraw* state, uint32_t chunkIndex)
+{
+    return chunkIndex < state->desc.resourceSetCount ? chunkIndex : chunkIndex + state->desc.maxBufferSets;
+}
+
+bool createChunk(REI_BasicDraw* state, uint32_t chunkIndex, uint64_t dataSize, uint32_t maxUniforms)
 {
-    uint64_t allocSize = (uint64_t)size * count;
-    if (state->desc.maxDataSize - state->dataUsed < allocSize + size)
+    DataChunk* chunk = &state->chunks[chunkIndex];
+
+    REI_BufferDesc uniBufDesc = {};
+    uniBufDesc.descriptors = REI_DESCRIPTOR_TYPE_BUFFER;
+    uniBufDesc.memoryUsage = REI_RESOURCE_MEMORY_USAGE_CPU_TO_GPU;
+    uniBufDesc.size = maxUniforms * sizeof(REI_BasicDraw_Uniforms);
+    uniBufDesc.elementCount = maxUniforms;
+    uniBufDesc.structStride = sizeof(REI_BasicDraw_Uniforms);
+    uniBufDesc.flags = REI_BUFFER_CREATION_FLAG_PERSISTENT_MAP_BIT;
+    REI_addBuffer(state->renderer, &uniBufDesc, &chunk->uniBuffer);
+    if (!chunk->uniBuffer)
+        return false;
+
+    REI_BufferDesc dataBufDesc = {};
+    dataBufDesc.descriptors = REI_DESCRIPTOR_TYPE_BUFFER_RAW | REI_DESCRIPTOR_TYPE_VERTEX_BUFFER;
+    dataBufDesc.memoryUsage = REI_RESOURCE_MEMORY_USAGE_CPU_TO_GPU;
+    dataBufDesc.size = dataSize;
+    dataBufDesc.flags = REI_BUFFER_CREATION_FLAG_PERSISTENT_MAP_BIT;
+    dataBufDesc.format = REI_FMT_R32_UINT;
+    dataBufDesc.vertexStride = 16;
+    dataBufDesc.elementCount = dataBufDesc.size / dataBufDesc.vertexStride;
+    REI_addBuffer(state->renderer, &dataBufDesc, &chunk->dataBuffer);
+    if (!chunk->dataBuffer)
+    {
+        REI_removeBuffer(state->renderer, chunk->uniBuffer);
+        chunk->uniBuffer = NULL;
         return false;
+    }
+
+    REI_mapBuffer(state->renderer, chunk->uniBuffer, &chunk->uniAddr);
+    REI_mapBuffer(state->renderer, chunk->dataBuffer, &chunk->dataAddr);
+    chunk->dataSize = dataSize;
+    chunk->maxUniforms = maxUniforms;
+    REI_atomicptr_store_relaxed(&chunk->dataUsed, 0);
+    REI_atomic32_store_relaxed(&chunk->uniformCount, 0);
+    REI_atomicptr_store_relaxed(&chunk->droppedBytes, 0);
+    REI_atomic32_store_relaxed(&chunk->droppedDraws, 0);
+
+    REI_DescriptorData descrUpdate[2] = {};
+    descrUpdate[0].descriptorType = REI_DESCRIPTOR_TYPE_BUFFER;
+    descrUpdate[0].descriptorIndex = 0;
+    descrUpdate[0].count = 1;
+    descrUpdate[0].ppBuffers = &chunk->uniBuffer;
+    descrUpdate[0].tableIndex = chunkIndex;
+    REI_updateDescriptorTableArray(state->renderer, state->meshDescriptorSet, 1, descrUpdate);
+    REI_updateDescriptorTableArray(state->renderer, state->pointUniDescriptorSet, 1, descrUpdate);
+
+    descrUpdate[1].descriptorType = REI_DESCRIPTOR_TYPE_BUFFER_RAW;
+    descrUpdate[1].descriptorIndex = 1;
+    descrUpdate[1].count = 1;
+    descrUpdate[1].ppBuffers = &chunk->dataBuffer;
+    descrUpdate[1].tableIndex = chunkIndex;
+    REI_updateDescriptorTableArray(state->renderer, state->lineDescriptorSet, 2, descrUpdate);
+
+    if (state->desc.maxExpandedPoints && chunkIndex < state->desc.resourceSetCount)
+    {
+        descrUpdate[1].descriptorType = REI_DESCRIPTOR_TYPE_RW_BUFFER_RAW;
+        descrUpdate[1].ppBuffers = &state->expandedBuffers[chunkIndex];
+        REI_updateDescriptorTableArray(state->renderer, state->expandUniDescriptorSet, 2, descrUpdate);
+    }
+
+    descrUpdate[0].descriptorType = REI_DESCRIPTOR_TYPE_BUFFER_RAW;
+    descrUpdate[0].ppBuffers = &chunk->dataBuffer;
+    descrUpdate[0].tableIndex = pointDataTableIndex(state, chunkIndex);
+    descrUpdate[1].descriptorType = REI_DESCRIPTOR_TYPE_BUFFER;
+    descrUpdate[1].ppBuffers = &chunk->dataBuffer;
+    descrUpdate[1].tableIndex = pointDataTableIndex(state, chunkIndex);
+    REI_updateDescriptorTableArray(state->renderer, state->pointDataDescriptorSet, 2, descrUpdate);
+
+    if (state->desc.maxExpandedPoints && chunkIndex < state->desc.resourceSetCount)
+        REI_updateDescriptorTableArray(state->renderer, state->expandDataDescriptorSet, 2, descrUpdate);
 
-    uint64_t rem = state->dataUsed % size;
-    *offset = state->dataUsed + (rem ? size - rem : 0);
-    state->dataUsed = *offset + allocSize;
     return true;
 }
 
+void destroyChunk(REI_BasicDraw* state, uint32_t chunkIndex)
+{
+    DataChunk* chunk = &state->chunks[chunkIndex];
+    if (chunk->dataBuffer)
+        REI_removeBuffer(state->renderer, chunk->dataBuffer);
+    if (chunk->uniBuffer)
+        REI_removeBuffer(state->renderer, chunk->uniBuffer);
+    memset(chunk, 0, sizeof(DataChunk));
+}
+
+// Called when fullChunk can not fit a draw. Returns the chunk to retry with or ~0u when no overflow chunk is left
+uint32_t addOverflowChunk(REI_BasicDraw* state, uint32_t fullChunk, uint64_t minDataSize)
+{
+    MutexLock lock(*state->chunkMutex);
+
+    // Another thread already moved on from the full chunk
+    uint32_t activeChunk = REI_atomic32_load_relaxed(&state->activeChunk);
+    if (activeChunk != fullChunk)
+        return activeChunk;
+
+    for (uint32_t i = 0; i < state->desc.maxDataChunks; ++i)
+    {
+        if (state->chunkOwners[i] != ~0u)
+            continue;
+
+        const DataChunk& base = state->chunks[state->setIndex];
+        uint32_t         chunkIndex = state->desc.resourceSetCount + i;
+        if (!createChunk(state, chunkIndex, REI_max(base.dataSize, minDataSize), base.maxUniforms))
+            return ~0u;
+
+        state->chunkOwners[i] = state->setIndex;
+        REI_atomic32_store_release(&state->activeChunk, chunkIndex);
+        return chunkIndex;
+    }
+    return ~0u;
+}
+
+// Data and uniforms of a draw always come from one chunk, the tables of a chunk reference both buffers.
+// Draws that fit nowhere are counted and dropped.
+bool allocateDraw(
+    REI_BasicDraw* state, DrawList* list, uint32_t count, uint32_t size, const REI_BasicDraw_Uniforms& uniforms,
+    uint32_t* chunkIndex, uint64_t* offset, uint32_t* uniformIndex)
+{
+    uint32_t chunk = REI_atomic32_load_acquire(&state->activeChunk);
+    for (;;)
+    {
+        if ((!count || allocateData(&state->chunks[chunk], count, size, offset)) &&
+            allocateUniforms(state, list, chunk, uniforms, uniformIndex))
+        {
+            *chunkIndex = chunk;
+            return true;
+        }
+
+        chunk = addOverflowChunk(state, chunk, (uint64_t)size * (count + 1));
+        if (chunk == ~0u)
+        {
+            DataChunk* base = &state->chunks[state->setIndex];
+            REI_atomicptr_add_relaxed(&base->droppedBytes, (uintptr_t)size * count);
+            REI_atomic32_add_relaxed(&base->droppedDraws, 1);
+            return false;
+        }
+    }
+}
+
 void REI_RegisterPointBufferSet(
     REI_BasicDraw* state, uint32_t idx, REI_Buffer* interleaved, REI_Buffer* positions, REI_Buffer* colors)
 {
     if (idx >= state->desc.maxBufferSets)
         return;
 
-    if (!interleaved || !positions)
+    if (!interleaved && !positions)
         return;
 
     uint32_t           numDescrUpdates = 1;
@@ -172,6 +503,173 @@ void REI_RegisterPointBufferSet(
     }
 
     REI_updateDescriptorTableArray(state->renderer, state->pointDataDescriptorSet, numDescrUpdates, descrUpdate);
+    if (state->expandDataDescriptorSet)
+        REI_updateDescriptorTableArray(state->renderer, state->expandDataDescriptorSet, numDescrUpdates, descrUpdate);
+}
+
+static inline void extendBounds(Bounds* bounds, const float* p)
+{
+    for (uint32_t j = 0; j < 3; ++j)
+    {
+        bounds->lo[j] = REI_min(bounds->lo[j], p[j]);
+        bounds->hi[j] = REI_max(bounds->hi[j], p[j]);
+    }
+}
+
+static inline uint32_t spreadBits10(uint32_t v)
+{
+    v = (v | (v << 16)) & 0x030000FF;
+    v = (v | (v << 8)) & 0x0300F00F;
+    v = (v | (v << 4)) & 0x030C30C3;
+    v = (v | (v << 2)) & 0x09249249;
+    return v;
+}
+
+static inline uint32_t reverseBits(uint32_t v)
+{
+    v = ((v >> 1) & 0x55555555) | ((v & 0x55555555) << 1);
+    v = ((v >> 2) & 0x33333333) | ((v & 0x33333333) << 2);
+    v = ((v >> 4) & 0x0F0F0F0F) | ((v & 0x0F0F0F0F) << 4);
+    v = ((v >> 8) & 0x00FF00FF) | ((v & 0x00FF00FF) << 8);
+    return (v >> 16) | (v << 16);
+}
+
+void REI_BasicDraw_RemovePointSetIndex(REI_BasicDraw* state, uint32_t bufferSet)
+{
+    if (bufferSet >= state->desc.maxBufferSets)
+        return;
+
+    PointSetIndex& index = state->pointSetIndices[bufferSet];
+    if (index.chunkBounds)
+        state->allocator.pFree(state->allocator.pUserData, index.chunkBounds);
+    memset(&index, 0, sizeof(PointSetIndex));
+}
+
+bool REI_BasicDraw_BuildPointSetIndex(
+    REI_BasicDraw* state, uint32_t bufferSet, const REI_BasicDraw_PointSetIndexDesc* pDesc)
+{
+    if (bufferSet >= state->desc.maxBufferSets || !pDesc->pointCount)
+        return false;
+
+    const uint32_t pointsPerChunk = pDesc->pointsPerChunk ? pDesc->pointsPerChunk : DEFAULT_POINTS_PER_CHUNK;
+    REI_ASSERT(!(pointsPerChunk & (pointsPerChunk - 1)), "pointsPerChunk must be a power of two");
+
+    REI_BasicDraw_RemovePointSetIndex(state, bufferSet);
+
+    const uint32_t count = pDesc->pointCount;
+    auto           getPosition = [pDesc](uint32_t i) {
+        return (const float*)((const uint8_t*)pDesc->pPositions + (size_t)i * pDesc->positionStride);
+    };
+
+    Bounds total;
+    memcpy(total.lo, getPosition(0), sizeof(total.lo));
+    memcpy(total.hi, getPosition(0), sizeof(total.hi));
+    for (uint32_t i = 1; i < count; ++i)
+        extendBounds(&total, getPosition(i));
+
+    // Keys and values, twice for the radix sort passes
+    uint32_t* sortData = (uint32_t*)state->allocator.pMalloc(
+        state->allocator.pUserData, (size_t)count * 4 * sizeof(uint32_t), REI_DEFAULT_MALLOC_ALIGNMENT);
+    if (!sortData)
+        return false;
+
+    uint32_t* keys = sortData;
+    uint32_t* values = sortData + count;
+    uint32_t* tmpKeys = sortData + 2 * (size_t)count;
+    uint32_t* tmpValues = sortData + 3 * (size_t)count;
+
+    float quantScale[3];
+    for (uint32_t j = 0; j < 3; ++j)
+    {
+        float extent = total.hi[j] - total.lo[j];
+        quantScale[j] = extent > 0.0f ? 1023.0f / extent : 0.0f;
+    }
+    for (uint32_t i = 0; i < count; ++i)
+    {
+        const float* p = getPosition(i);
+        uint32_t     code = 0;
+        for (uint32_t j = 0; j < 3; ++j)
+            code |= spreadBits10(REI_min((uint32_t)((p[j] - total.lo[j]) * quantScale[j]), 1023u)) << j;
+        keys[i] = code;
+        values[i] = i;
+    }
+
+    // LSD radix sort of the 30 bit Morton codes
+    for (uint32_t shift = 0; shift < 30; shift += 10)
+    {
+        uint32_t offsets[1024] = {};
+        for (uint32_t i = 0; i < count; ++i)
+            ++offsets[(keys[i] >> shift) & 1023];
+        uint32_t sum = 0;
+        for (uint32_t& offset: offsets)
+        {
+            uint32_t bucketSize = offset;
+            offset = sum;
+            sum += bucketSize;
+        }
+        for (uint32_t i = 0; i < count; ++i)
+        {
+            uint32_t dst = offsets[(keys[i] >> shift) & 1023]++;
+            tmpKeys[dst] = keys[i];
+            tmpValues[dst] = values[i];
+        }
+        uint32_t* swapKeys = keys;
+        keys = tmpKeys;
+        tmpKeys = swapKeys;
+        uint32_t* swapValues = values;
+        values = tmpValues;
+        tmpValues = swapValues;
+    }
+
+    PointSetIndex& index = state->pointSetIndices[bufferSet];
+    index.pointCount = count;
+    index.pointsPerChunk = pointsPerChunk;
+    index.chunkCount = (count + pointsPerChunk - 1) / pointsPerChunk;
+    index.groupCount = (index.chunkCount + CHUNKS_PER_GROUP - 1) / CHUNKS_PER_GROUP;
+    index.chunkBounds =
+        (Bounds*)REI_calloc(state->allocator, (index.chunkCount + index.groupCount) * sizeof(Bounds));
+    if (!index.chunkBounds)
+    {
+        state->allocator.pFree(state->allocator.pUserData, sortData);
+        memset(&index, 0, sizeof(PointSetIndex));
+        return false;
+    }
+    index.groupBounds = index.chunkBounds + index.chunkCount;
+
+    uint32_t chunkBits = 0;
+    while ((1u << chunkBits) < pointsPerChunk)
+        ++chunkBits;
+
+    uint32_t orderIndex = 0;
+    for (uint32_t c = 0; c < index.chunkCount; ++c)
+    {
+        const uint32_t first = c * pointsPerChunk;
+        const uint32_t chunkSize = REI_min(pointsPerChunk, count - first);
+        Bounds&        bounds = index.chunkBounds[c];
+        memcpy(bounds.lo, getPosition(values[first]), sizeof(bounds.lo));
+        memcpy(bounds.hi, getPosition(values[first]), sizeof(bounds.hi));
+        for (uint32_t i = 0; i < pointsPerChunk; ++i)
+        {
+            uint32_t r = chunkBits ? reverseBits(i) >> (32 - chunkBits) : 0;
+            if (r >= chunkSize)
+                continue;
+            uint32_t point = values[first + r];
+            pDesc->pOrder[orderIndex++] = point;
+            extendBounds(&bounds, getPosition(point));
+        }
+
+        Bounds& groupBounds = index.groupBounds[c / CHUNKS_PER_GROUP];
+        if (c % CHUNKS_PER_GROUP)
+        {
+            extendBounds(&groupBounds, bounds.lo);
+            extendBounds(&groupBounds, bounds.hi);
+        }
+        else
+            groupBounds = bounds;
+    }
+
+    state->allocator.pFree(state->allocator.pUserData, sortData);
+    return true;
 }
 
 REI_BasicDraw* REI_BasicDraw_Init(REI_Renderer* renderer, REI_BasicDraw_Desc* info)
@@ -191,6 +689,11 @@ REI_BasicDraw* REI_BasicDraw_Init(REI_Renderer* renderer, REI_BasicDraw_Desc* in
 
     const REI_AllocatorCallbacks& allocator = state->allocator;
 
+    state->drawList.maxDraws = state->desc.maxDeferredDraws;
+    state->drawList.lastUniformIndex = ~0u;
+    if (state->drawList.maxDraws)
+        state->drawList.draws = (DeferredDraw*)REI_calloc(allocator, state->drawList.maxDraws * sizeof(DeferredDraw));
+
     const size_t     vertexAttribCount = 2;
     REI_VertexAttrib vertexAttribs[vertexAttribCount] = {};
     vertexAttribs[0].semantic = REI_SEMANTIC_POSITION0;
@@ -283,6 +786,107 @@ REI_BasicDraw* REI_BasicDraw_Init(REI_Renderer* renderer, REI_BasicDraw_Desc* in
         createPipelineData(state, 0, nullptr, pointShaderDesc, MAX_SHADER_COUNT, &rootDesc, &state->pointPipelineData);
     }
 
+    REI_ShaderDesc pointInstancedShaderDesc[MAX_SHADER_COUNT] = {
+        { REI_SHADER_STAGE_VERT, (uint8_t*)basicdraw_point_instanced_vs_bytecode,
+          sizeof(basicdraw_point_instanced_vs_bytecode) },
+        { REI_SHADER_STAGE_FRAG, (uint8_t*)basicdraw_ps_bytecode, sizeof(basicdraw_ps_bytecode) }
+    };
+
+    // Same layout as the point pipeline, so point descriptor tables are shared between both
+    state->pointInstancedPipelineData.rootSignature = state->pointPipelineData.rootSignature;
+    createPipelineData(
+        state, 0, nullptr, pointInstancedShaderDesc, MAX_SHADER_COUNT, nullptr, &state->pointInstancedPipelineData,
+        REI_PRIMITIVE_TOPO_TRI_STRIP);
+
+    if (state->desc.maxExpandedPoints)
+    {
+        REI_ShaderDesc expandShaderDesc = { REI_SHADER_STAGE_COMP, (uint8_t*)basicdraw_point_expand_cs_bytecode,
+                                            sizeof(basicdraw_point_expand_cs_bytecode) };
+
+        REI_DescriptorBinding binding[4] = {};
+        binding[0].descriptorCount = 1;
+        binding[0].descriptorType = REI_DESCRIPTOR_TYPE_BUFFER;
+        binding[0].reg = 0;
+        binding[0].binding = 0;
+
+        binding[1].descriptorCount = 1;
+        binding[1].descriptorType = REI_DESCRIPTOR_TYPE_RW_BUFFER_RAW;
+        binding[1].reg = 0;
+        binding[1].binding = 1;
+
+        binding[2].descriptorCount = 1;
+        binding[2].descriptorType = REI_DESCRIPTOR_TYPE_BUFFER_RAW;
+        binding[2].reg = 0;
+        binding[2].binding = 0;
+
+        binding[3].descriptorCount = 1;
+        binding[3].descriptorType = REI_DESCRIPTOR_TYPE_BUFFER;
+        binding[3].reg = 1;
+        binding[3].binding = 1;
+
+        REI_DescriptorTableLayout setLayout[2] = {};
+        setLayout[0].bindingCount = 2;
+        setLayout[0].pBindings = binding;
+        setLayout[0].slot = REI_DESCRIPTOR_TABLE_SLOT_0;
+        setLayout[0].stageFlags = REI_SHADER_STAGE_COMP;
+
+        setLayout[1].bindingCount = 2;
+        setLayout[1].pBindings = binding + 2;
+        setLayout[1].slot = REI_DESCRIPTOR_TABLE_SLOT_1;
+        setLayout[1].stageFlags = REI_SHADER_STAGE_COMP;
+
+        REI_PushConstantRange pRange = {};
+        pRange.size = sizeof(uint32_t[5]);
+        pRange.offset = 0;
+        pRange.stageFlags = REI_SHADER_STAGE_COMP;
+
+        REI_RootSignatureDesc rootDesc = {};
+        rootDesc.pipelineType = REI_PIPELINE_TYPE_COMPUTE;
+        rootDesc.tableLayoutCount = 2;
+        rootDesc.pTableLayouts = setLayout;
+        rootDesc.pushConstantRangeCount = 1;
+        rootDesc.pPushConstantRanges = &pRange;
+
+        createComputePipelineData(state, &expandShaderDesc, &rootDesc, &state->pointExpandPipelineData);
+    }
+
+    if (state->desc.maxExpandedPoints)
+    {
+        REI_ShaderDesc expandedShaderDesc[MAX_SHADER_COUNT] = {
+            { REI_SHADER_STAGE_VERT, (uint8_t*)basicdraw_point_expanded_vs_bytecode,
+              sizeof(basicdraw_point_expanded_vs_bytecode) },
+            { REI_SHADER_STAGE_FRAG, (uint8_t*)basicdraw_ps_bytecode, sizeof(basicdraw_ps_bytecode) }
+        };
+
+        REI_DescriptorBinding binding = {};
+        binding.descriptorCount = 1;
+        binding.descriptorType = REI_DESCRIPTOR_TYPE_BUFFER_RAW;
+        binding.reg = 0;
+        binding.binding = 0;
+
+        REI_DescriptorTableLayout setLayout = {};
+        setLayout.bindingCount = 1;
+        setLayout.pBindings = &binding;
+        setLayout.slot = REI_DESCRIPTOR_TABLE_SLOT_0;
+        setLayout.stageFlags = REI_SHADER_STAGE_VERT;
+
+        REI_PushConstantRange pRange = {};
+        pRange.size = sizeof(uint32_t);
+        pRange.offset = 0;
+        pRange.stageFlags = REI_SHADER_STAGE_VERT;
+
+        REI_RootSignatureDesc rootDesc = {};
+        rootDesc.pipelineType = REI_PIPELINE_TYPE_GRAPHICS;
+        rootDesc.tableLayoutCount = 1;
+        rootDesc.pTableLayouts = &setLayout;
+        rootDesc.pushConstantRangeCount = 1;
+        rootDesc.pPushConstantRanges = &pRange;
+
+        createPipelineData(
+            state, 0, nullptr, expandedShaderDesc, MAX_SHADER_COUNT, &rootDesc, &state->pointExpandedPipelineData,
+            REI_PRIMITIVE_TOPO_TRI_STRIP);
+    }
+
     REI_ShaderDesc lineShaderDesc[MAX_SHADER_COUNT] = {
         { REI_SHADER_STAGE_VERT, (uint8_t*)basicdraw_line_vs_bytecode, sizeof(basicdraw_line_vs_bytecode) },
         { REI_SHADER_STAGE_FRAG, (uint8_t*)basicdraw_ps_bytecode, sizeof(basicdraw_ps_bytecode) }
@@ -307,7 +911,7 @@ REI_BasicDraw* REI_BasicDraw_Init(REI_Renderer* renderer, REI_BasicDraw_Desc* in
         setLayout.stageFlags = REI_SHADER_STAGE_VERT;
 
         REI_PushConstantRange pRange = {};
-        pRange.size = sizeof(uint32_t[2]);
+        pRange.size = sizeof(uint32_t[3]);
         pRange.offset = 0;
         pRange.stageFlags = REI_SHADER_STAGE_VERT;
 
@@ -321,252 +925,854 @@ REI_BasicDraw* REI_BasicDraw_Init(REI_Renderer* renderer, REI_BasicDraw_Desc* in
         createPipelineData(state, 0, nullptr, lineShaderDesc, MAX_SHADER_COUNT, &rootDesc, &state->linePipelineData);
     }
 
+    REI_ShaderDesc lineInstancedShaderDesc[MAX_SHADER_COUNT] = {
+        { REI_SHADER_STAGE_VERT, (uint8_t*)basicdraw_line_instanced_vs_bytecode,
+          sizeof(basicdraw_line_instanced_vs_bytecode) },
+        { REI_SHADER_STAGE_FRAG, (uint8_t*)basicdraw_ps_bytecode, sizeof(basicdraw_ps_bytecode) }
+    };
 
+    // Same layout as the line pipeline, so line descriptor tables are shared between both
+    state->lineInstancedPipelineData.rootSignature = state->linePipelineData.rootSignature;
+    createPipelineData(
+        state, 0, nullptr, lineInstancedShaderDesc, MAX_SHADER_COUNT, nullptr, &state->lineInstancedPipelineData,
+        REI_PRIMITIVE_TOPO_TRI_STRIP);
 
-    REI_BufferDesc transformBufDesc = {};
-    transformBufDesc.descriptors = REI_DESCRIPTOR_TYPE_BUFFER;
-    transformBufDesc.memoryUsage = REI_RESOURCE_MEMORY_USAGE_CPU_TO_GPU;
-    transformBufDesc.size = state->desc.maxDrawCount * sizeof(REI_BasicDraw_Uniforms);
-    transformBufDesc.elementCount = state->desc.maxDrawCount;
-    transformBufDesc.flags = REI_BUFFER_CREATION_FLAG_PERSISTENT_MAP_BIT;
-    state->uniBuffers = (REI_Buffer**)REI_calloc(allocator, state->desc.resourceSetCount * sizeof(REI_Buffer*));
-    state->uniBuffersAddr = (void**)REI_calloc(allocator, state->desc.resourceSetCount * sizeof(void*));
-    transformBufDesc.structStride = sizeof(REI_BasicDraw_Uniforms);
-    for (uint32_t i = 0; i < state->desc.resourceSetCount; ++i)
-    {
-        REI_addBuffer(state->renderer, &transformBufDesc, &state->uniBuffers[i]);
-        REI_mapBuffer(state->renderer, state->uniBuffers[i], &state->uniBuffersAddr[i]);
-    }
+
+
+    const uint32_t chunkCount = state->desc.resourceSetCount + state->desc.maxDataChunks;
 
     REI_DescriptorTableArrayDesc meshDescriptorSetDesc = {};
     meshDescriptorSetDesc.pRootSignature = state->meshPipelineData.rootSignature;
-    meshDescriptorSetDesc.maxTables = state->desc.resourceSetCount;
+    meshDescriptorSetDesc.maxTables = chunkCount;
     meshDescriptorSetDesc.slot = REI_DESCRIPTOR_TABLE_SLOT_0;
     REI_addDescriptorTableArray(state->renderer, &meshDescriptorSetDesc, &state->meshDescriptorSet);
 
     REI_DescriptorTableArrayDesc pointDataDescriptorSetDesc = {};
     pointDataDescriptorSetDesc.pRootSignature = state->pointPipelineData.rootSignature;
-    pointDataDescriptorSetDesc.maxTables = state->desc.resourceSetCount + state->desc.maxBufferSets;
+    pointDataDescriptorSetDesc.maxTables = chunkCount + state->desc.maxBufferSets;
     pointDataDescriptorSetDesc.slot = REI_DESCRIPTOR_TABLE_SLOT_1;
     REI_addDescriptorTableArray(state->renderer, &pointDataDescriptorSetDesc, &state->pointDataDescriptorSet);
 
-    REI_BufferDesc dataBufDesc = {};
-    dataBufDesc.descriptors = REI_DESCRIPTOR_TYPE_BUFFER_RAW | REI_DESCRIPTOR_TYPE_VERTEX_BUFFER;
-    dataBufDesc.memoryUsage = REI_RESOURCE_MEMORY_USAGE_CPU_TO_GPU;
-    dataBufDesc.size = state->desc.maxDataSize;
-    dataBufDesc.flags = REI_BUFFER_CREATION_FLAG_PERSISTENT_MAP_BIT;
-    dataBufDesc.format = REI_FMT_R32_UINT;
-    dataBufDesc.vertexStride = 16;
-    dataBufDesc.elementCount = dataBufDesc.size / dataBufDesc.vertexStride;
-    state->dataBuffers = (REI_Buffer**)REI_calloc(allocator, state->desc.resourceSetCount * sizeof(REI_Buffer*));
-    state->dataBuffersAddr = (void**)REI_calloc(allocator, state->desc.resourceSetCount * sizeof(void*));
+    REI_DescriptorTableArrayDesc pointUniDescriptorSetDesc = {};
+    pointUniDescriptorSetDesc.pRootSignature = state->pointPipelineData.rootSignature;
+    pointUniDescriptorSetDesc.maxTables = chunkCount;
+    pointUniDescriptorSetDesc.slot = REI_DESCRIPTOR_TABLE_SLOT_0;
+    REI_addDescriptorTableArray(state->renderer, &pointUniDescriptorSetDesc, &state->pointUniDescriptorSet);
 
-    REI_DescriptorData descrUpdate[2] = {};
-    descrUpdate[0].descriptorType = REI_DESCRIPTOR_TYPE_BUFFER_RAW;
-    descrUpdate[0].descriptorIndex = 0;
-    descrUpdate[0].count = 1;
+    REI_DescriptorTableArrayDesc lineDescriptorSetDesc = {};
+    lineDescriptorSetDesc.pRootSignature = state->linePipelineData.rootSignature;
+    lineDescriptorSetDesc.maxTables = chunkCount;
+    lineDescriptorSetDesc.slot = REI_DESCRIPTOR_TABLE_SLOT_0;
+    REI_addDescriptorTableArray(state->renderer, &lineDescriptorSetDesc, &state->lineDescriptorSet);
 
-    descrUpdate[1].descriptorType = REI_DESCRIPTOR_TYPE_BUFFER;
-    descrUpdate[1].count = 1;
-    descrUpdate[1].descriptorIndex = 1;
-    
-    for (uint32_t i = 0; i < state->desc.resourceSetCount; ++i)
+    if (state->desc.maxExpandedPoints)
     {
-        REI_addBuffer(state->renderer, &dataBufDesc, &state->dataBuffers[i]);
-        REI_mapBuffer(state->renderer, state->dataBuffers[i], &state->dataBuffersAddr[i]);
-        descrUpdate[0].ppBuffers = &state->dataBuffers[i];
-        descrUpdate[0].tableIndex = i;
-        descrUpdate[1].ppBuffers = &state->dataBuffers[i];
-        descrUpdate[1].tableIndex = i;
+        REI_BufferDesc expandedBufDesc = {};
+        expandedBufDesc.descriptors = REI_DESCRIPTOR_TYPE_BUFFER_RAW | REI_DESCRIPTOR_TYPE_RW_BUFFER_RAW;
+        expandedBufDesc.memoryUsage = REI_RESOURCE_MEMORY_USAGE_GPU_ONLY;
+        expandedBufDesc.size = (uint64_t)state->desc.maxExpandedPoints * EXPANDED_POINT_SIZE;
+        expandedBufDesc.format = REI_FMT_R32_UINT;
+        expandedBufDesc.elementCount = expandedBufDesc.size / sizeof(uint32_t);
+        expandedBufDesc.startState = REI_RESOURCE_STATE_SHADER_RESOURCE;
+        state->expandedBuffers =
+            (REI_Buffer**)REI_calloc(allocator, state->desc.resourceSetCount * sizeof(REI_Buffer*));
+
+        REI_DescriptorTableArrayDesc expandUniDescriptorSetDesc = {};
+        expandUniDescriptorSetDesc.pRootSignature = state->pointExpandPipelineData.rootSignature;
+        expandUniDescriptorSetDesc.maxTables = state->desc.resourceSetCount;
+        expandUniDescriptorSetDesc.slot = REI_DESCRIPTOR_TABLE_SLOT_0;
+        REI_addDescriptorTableArray(state->renderer, &expandUniDescriptorSetDesc, &state->expandUniDescriptorSet);
+
+        REI_DescriptorTableArrayDesc expandDataDescriptorSetDesc = {};
+        expandDataDescriptorSetDesc.pRootSignature = state->pointExpandPipelineData.rootSignature;
+        expandDataDescriptorSetDesc.maxTables = state->desc.resourceSetCount + state->desc.maxBufferSets;
+        expandDataDescriptorSetDesc.slot = REI_DESCRIPTOR_TABLE_SLOT_1;
+        REI_addDescriptorTableArray(state->renderer, &expandDataDescriptorSetDesc, &state->expandDataDescriptorSet);
+
+        REI_DescriptorTableArrayDesc expandedDescriptorSetDesc = {};
+        expandedDescriptorSetDesc.pRootSignature = state->pointExpandedPipelineData.rootSignature;
+        expandedDescriptorSetDesc.maxTables = state->desc.resourceSetCount;
+        expandedDescriptorSetDesc.slot = REI_DESCRIPTOR_TABLE_SLOT_0;
+        REI_addDescriptorTableArray(state->renderer, &expandedDescriptorSetDesc, &state->expandedDescriptorSet);
+
+        REI_DescriptorData descrUpdate = {};
+        descrUpdate.descriptorType = REI_DESCRIPTOR_TYPE_BUFFER_RAW;
+        descrUpdate.descriptorIndex = 0;
+        descrUpdate.count = 1;
+
+        for (uint32_t i = 0; i < state->desc.resourceSetCount; ++i)
+        {
+            REI_addBuffer(state->renderer, &expandedBufDesc, &state->expandedBuffers[i]);
 
-        REI_updateDescriptorTableArray(state->renderer, state->pointDataDescriptorSet, 2, descrUpdate);
+            descrUpdate.ppBuffers = &state->expandedBuffers[i];
+            descrUpdate.tableIndex = i;
+            REI_updateDescriptorTableArray(state->renderer, state->expandedDescriptorSet, 1, &descrUpdate);
+        }
     }
 
-    descrUpdate[0].descriptorIndex = 0;
-    descrUpdate[0].descriptorType = REI_DESCRIPTOR_TYPE_BUFFER;
+    if (state->desc.maxBufferSets)
+        state->pointSetIndices =
+            (PointSetIndex*)REI_calloc(allocator, state->desc.maxBufferSets * sizeof(PointSetIndex));
+
+    state->chunks = (DataChunk*)REI_calloc(allocator, chunkCount * sizeof(DataChunk));
+    state->chunkMutex = REI_new<Mutex>(allocator);
+    if (state->desc.maxDataChunks)
+    {
+        state->chunkOwners = (uint32_t*)REI_calloc(allocator, state->desc.maxDataChunks * sizeof(uint32_t));
+        memset(state->chunkOwners, 0xff, state->desc.maxDataChunks * sizeof(uint32_t));
+    }
 
     for (uint32_t i = 0; i < state->desc.resourceSetCount; ++i)
+        createChunk(state, i, state->desc.maxDataSize, state->desc.maxDrawCount);
+
+    return state;
+}
+
+void REI_BasicDraw_SetupRender(REI_BasicDraw* state, uint32_t set_index)
+{
+    REI_ASSERT(!state->drawList.drawCount, "REI_BasicDraw_Flush was not called for the previous frame");
+
+    // GPU is done with the set: retire the overflow chunks it borrowed and grow its base chunk to fit the last frame
+    DataChunk* base = &state->chunks[set_index];
+    uint64_t   dataNeeded =
+        REI_atomicptr_load_relaxed(&base->dataUsed) + REI_atomicptr_load_relaxed(&base->droppedBytes);
+    uint64_t uniformsNeeded = REI_min(REI_atomic32_load_relaxed(&base->uniformCount), base->maxUniforms) +
+                              REI_atomic32_load_relaxed(&base->droppedDraws);
+    for (uint32_t i = 0; i < state->desc.maxDataChunks; ++i)
     {
-        descrUpdate[0].ppBuffers = &state->uniBuffers[i];
-        descrUpdate[0].tableIndex = i;
-        REI_updateDescriptorTableArray(state->renderer, state->meshDescriptorSet, 1, descrUpdate);
+        if (state->chunkOwners[i] != set_index)
+            continue;
+
+        DataChunk* chunk = &state->chunks[state->desc.resourceSetCount + i];
+        dataNeeded += REI_atomicptr_load_relaxed(&chunk->dataUsed);
+        uniformsNeeded += REI_min(REI_atomic32_load_relaxed(&chunk->uniformCount), chunk->maxUniforms);
+        destroyChunk(state, state->desc.resourceSetCount + i);
+        state->chunkOwners[i] = ~0u;
     }
 
-    REI_DescriptorTableArrayDesc pointUniDescriptorSetDesc = {};
-    pointUniDescriptorSetDesc.pRootSignature = state->pointPipelineData.rootSignature;
-    pointUniDescriptorSetDesc.maxTables = state->desc.resourceSetCount;
-    pointUniDescriptorSetDesc.slot = REI_DESCRIPTOR_TABLE_SLOT_0;
-    REI_addDescriptorTableArray(state->renderer, &pointUniDescriptorSetDesc, &state->pointUniDescriptorSet);
+    if (state->desc.maxDataChunks && (dataNeeded > base->dataSize || uniformsNeeded > base->maxUniforms))
+    {
+        // Doubling starts from 1 so that a set created with a zero budget grows as well
+        uint64_t dataSize = REI_max(base->dataSize, (uint64_t)1);
+        while (dataSize < dataNeeded)
+            dataSize *= 2;
+        uint64_t maxUniforms = REI_max((uint64_t)base->maxUniforms, (uint64_t)1);
+        while (maxUniforms < uniformsNeeded)
+            maxUniforms *= 2;
+
+        uint64_t prevDataSize = base->dataSize;
+        uint32_t prevMaxUniforms = base->maxUniforms;
+        destroyChunk(state, set_index);
+        if (!createChunk(state, set_index, dataSize, (uint32_t)REI_min(maxUniforms, (uint64_t)UINT32_MAX)))
+            createChunk(state, set_index, prevDataSize, prevMaxUniforms);
+    }
 
-    for (uint32_t i = 0; i < state->desc.resourceSetCount; ++i)
+    REI_atomicptr_store_relaxed(&base->dataUsed, 0);
+    REI_atomic32_store_relaxed(&base->uniformCount, 0);
+    REI_atomicptr_store_relaxed(&base->droppedBytes, 0);
+    REI_atomic32_store_relaxed(&base->droppedDraws, 0);
+    REI_atomic32_store_relaxed(&state->activeChunk, set_index);
+    ++state->frameIndex;
+    state->setIndex = set_index;
+    state->currentPipeline = NULL;
+    state->expandedUsed = 0;
+    state->expandedWritable = false;
+    state->drawList.callCount = 0;
+    state->drawList.lastUniformIndex = ~0u;
+    state->stats = {};
+}
+
+void REI_BasicDraw_GetStats(REI_BasicDraw* state, REI_BasicDraw_Stats* pStats)
+{
+    *pStats = state->stats;
+    pStats->callCount += state->drawList.callCount;
+
+    DataChunk* base = &state->chunks[state->setIndex];
+    pStats->uniformCount = REI_min(REI_atomic32_load_relaxed(&base->uniformCount), base->maxUniforms);
+    pStats->droppedBytes = REI_atomicptr_load_relaxed(&base->droppedBytes);
+    pStats->droppedDraws = REI_atomic32_load_relaxed(&base->droppedDraws);
+    for (uint32_t i = 0; i < state->desc.maxDataChunks; ++i)
     {
-        descrUpdate[0].ppBuffers = &state->uniBuffers[i];
-        descrUpdate[0].tableIndex = i;
-        REI_updateDescriptorTableArray(state->renderer, state->pointUniDescriptorSet, 1, descrUpdate);
+        if (state->chunkOwners[i] != state->setIndex)
+            continue;
+
+        DataChunk* chunk = &state->chunks[state->desc.resourceSetCount + i];
+        uint32_t   uniformCount = REI_min(REI_atomic32_load_relaxed(&chunk->uniformCount), chunk->maxUniforms);
+        pStats->uniformCount += uniformCount;
+        pStats->grownBytes +=
+            REI_atomicptr_load_relaxed(&chunk->dataUsed) + uniformCount * sizeof(REI_BasicDraw_Uniforms);
     }
+}
 
-    REI_DescriptorTableArrayDesc lineDescriptorSetDesc = {};
-    lineDescriptorSetDesc.pRootSignature = state->linePipelineData.rootSignature;
-    lineDescriptorSetDesc.maxTables = state->desc.resourceSetCount;
-    lineDescriptorSetDesc.slot = REI_DESCRIPTOR_TABLE_SLOT_0;
-    REI_addDescriptorTableArray(state->renderer, &lineDescriptorSetDesc, &state->lineDescriptorSet);
+void emitMesh(
+    REI_BasicDraw* state, REI_Cmd* pCmd, uint32_t chunk, uint32_t uniformIndex, uint32_t firstVertex, uint32_t count)
+{
+    if (state->currentPipeline != state->meshPipelineData.pipeline)
+    {
+        state->currentPipeline = state->meshPipelineData.pipeline;
+        state->boundChunk = ~0u;
+        REI_cmdBindPipeline(pCmd, state->meshPipelineData.pipeline);
+        REI_cmdSetViewport(pCmd, 0.0f, 0.0f, (float)state->desc.fbWidth, (float)state->desc.fbHeight, 0.0f, 1.0f);
+    }
 
-    descrUpdate[1].descriptorType = REI_DESCRIPTOR_TYPE_BUFFER_RAW;
-    descrUpdate[1].descriptorIndex = 1;
-    descrUpdate[1].count = 1;
+    if (state->boundChunk != chunk)
+    {
+        state->boundChunk = chunk;
+        uint64_t vertex_offset = 0;
+        REI_cmdBindVertexBuffer(pCmd, 1, &state->chunks[chunk].dataBuffer, &vertex_offset);
+        REI_cmdBindDescriptorTable(pCmd, chunk, state->meshDescriptorSet);
+    }
 
-    for (uint32_t i = 0; i < state->desc.resourceSetCount; ++i)
+    REI_cmdBindPushConstants(
+        pCmd, state->meshPipelineData.rootSignature, REI_SHADER_STAGE_VERT, 0, sizeof(uint32_t), &uniformIndex);
+    REI_cmdDraw(pCmd, count, firstVertex);
+    ++state->stats.drawCount;
+}
+
+void emitLines(
+    REI_BasicDraw* state, REI_Cmd* pCmd, uint32_t chunk, uint32_t uniformIndex, uint32_t format, uint32_t firstLine,
+    uint32_t count, bool instanced)
+{
+    const PipelineData& pipelineData = instanced ? state->lineInstancedPipelineData : state->linePipelineData;
+
+    if (state->currentPipeline != pipelineData.pipeline)
     {
-        descrUpdate[0].ppBuffers = &state->uniBuffers[i];
-        descrUpdate[0].tableIndex = i;
-        descrUpdate[1].ppBuffers = &state->dataBuffers[i];
-        descrUpdate[1].tableIndex = i;
-        REI_updateDescriptorTableArray(state->renderer, state->lineDescriptorSet, 2, descrUpdate);
+        state->currentPipeline = pipelineData.pipeline;
+        state->boundChunk = ~0u;
+        REI_cmdBindPipeline(pCmd, pipelineData.pipeline);
+        REI_cmdSetViewport(pCmd, 0.0f, 0.0f, (float)state->desc.fbWidth, (float)state->desc.fbHeight, 0.0f, 1.0f);
     }
 
-    return state;
+    if (state->boundChunk != chunk)
+    {
+        state->boundChunk = chunk;
+        REI_cmdBindDescriptorTable(pCmd, chunk, state->lineDescriptorSet);
+    }
+
+    if (instanced)
+    {
+        uint32_t pushConstants[3]{ uniformIndex, firstLine, format };
+        REI_cmdBindPushConstants(
+            pCmd, pipelineData.rootSignature, REI_SHADER_STAGE_VERT, 0, sizeof(pushConstants), pushConstants);
+        REI_cmdDrawInstanced(pCmd, 4, 0, count, firstLine);
+    }
+    else
+    {
+        uint32_t baseVertex = 6 * firstLine;
+        uint32_t pushConstants[3]{ uniformIndex, baseVertex, format };
+        REI_cmdBindPushConstants(
+            pCmd, pipelineData.rootSignature, REI_SHADER_STAGE_VERT, 0, sizeof(pushConstants), pushConstants);
+        REI_cmdDraw(pCmd, 6 * count, baseVertex);
+    }
+    ++state->stats.drawCount;
 }
 
-void REI_BasicDraw_SetupRender(REI_BasicDraw* state, uint32_t set_index)
+void emitPoints(
+    REI_BasicDraw* state, REI_Cmd* pCmd, uint32_t chunk, uint32_t uniformIndex, uint32_t type, uint32_t bufferSet,
+    uint32_t firstPoint, uint32_t pointCount, bool instanced)
 {
-    state->dataUsed = 0;
-    state->uniformDataCount = 0;
-    state->setIndex = set_index;
-    state->currentPipeline = NULL;
+    const PipelineData& pipelineData = instanced ? state->pointInstancedPipelineData : state->pointPipelineData;
+
+    if (state->currentPipeline != pipelineData.pipeline)
+    {
+        state->currentPipeline = pipelineData.pipeline;
+        state->boundChunk = ~0u;
+        state->currentPointDataSet = ~0u;
+        REI_cmdBindPipeline(pCmd, pipelineData.pipeline);
+        REI_cmdSetViewport(pCmd, 0.0f, 0.0f, (float)state->desc.fbWidth, (float)state->desc.fbHeight, 0.0f, 1.0f);
+    }
+
+    if (state->boundChunk != chunk)
+    {
+        state->boundChunk = chunk;
+        REI_cmdBindDescriptorTable(pCmd, chunk, state->pointUniDescriptorSet);
+    }
+
+    if (state->currentPointDataSet != bufferSet)
+    {
+        state->currentPointDataSet = bufferSet;
+        REI_cmdBindDescriptorTable(pCmd, bufferSet, state->pointDataDescriptorSet);
+    }
+
+    if (instanced)
+    {
+        uint32_t pushConstants[3]{ uniformIndex, type, firstPoint };
+        REI_cmdBindPushConstants(
+            pCmd, pipelineData.rootSignature, REI_SHADER_STAGE_VERT, 0, sizeof(pushConstants), pushConstants);
+        REI_cmdDrawInstanced(pCmd, 4, 0, pointCount, firstPoint);
+    }
+    else
+    {
+        uint32_t baseVertex = 6 * firstPoint;
+        uint32_t pushConstants[3]{ uniformIndex, type, baseVertex };
+        REI_cmdBindPushConstants(
+            pCmd, pipelineData.rootSignature, REI_SHADER_STAGE_VERT, 0, sizeof(pushConstants), pushConstants);
+        REI_cmdDraw(pCmd, 6 * pointCount, baseVertex);
+    }
+    ++state->stats.drawCount;
 }
 
-void REI_BasicDraw_RenderMesh(
-    REI_BasicDraw* state, REI_Cmd* pCmd, const float mvp[16], uint32_t count, REI_BasicDraw_V_P3C** verts)
+void emitDraw(REI_BasicDraw* state, REI_Cmd* pCmd, const DeferredDraw& draw)
+{
+    switch (draw.kind)
+    {
+        case DRAW_KIND_MESH: emitMesh(state, pCmd, draw.chunk, draw.uniformIndex, draw.first, draw.count); break;
+        case DRAW_KIND_LINES:
+        case DRAW_KIND_LINES_INSTANCED:
+            emitLines(
+                state, pCmd, draw.chunk, draw.uniformIndex, draw.format, draw.first, draw.count,
+                draw.kind == DRAW_KIND_LINES_INSTANCED);
+            break;
+        case DRAW_KIND_POINTS:
+        case DRAW_KIND_POINTS_INSTANCED:
+            emitPoints(
+                state, pCmd, draw.chunk, draw.uniformIndex, draw.format, draw.bufferSet, draw.first, draw.count,
+                draw.kind == DRAW_KIND_POINTS_INSTANCED);
+            break;
+        default: REI_ASSERT(false); break;
+    }
+}
+
+bool growDrawList(REI_BasicDraw* state, DrawList* list)
+{
+    uint32_t      maxDraws = list->maxDraws * 2;
+    DeferredDraw* draws = (DeferredDraw*)state->allocator.pMalloc(
+        state->allocator.pUserData, maxDraws * sizeof(DeferredDraw), REI_DEFAULT_MALLOC_ALIGNMENT);
+    if (!draws)
+        return false;
+
+    memcpy(draws, list->draws, list->drawCount * sizeof(DeferredDraw));
+    state->allocator.pFree(state->allocator.pUserData, list->draws);
+    list->draws = draws;
+    list->maxDraws = maxDraws;
+    return true;
+}
+
+void flushDrawList(REI_BasicDraw* state, REI_Cmd* pCmd, DrawList* list)
+{
+    for (uint32_t i = 0; i < list->drawCount; ++i)
+        emitDraw(state, pCmd, list->draws[i]);
+    list->drawCount = 0;
+}
+
+// Emits the draw right away in immediate mode. In deferred mode the draw extends the previous recorded one
+// when both use the same pipeline, uniforms and buffer and their ranges are adjacent, which keeps blending order.
+// Lists of recording contexts have no command buffer to flush to and grow instead.
+void submitDraw(REI_BasicDraw* state, DrawList* list, REI_Cmd* pCmd, const DeferredDraw& draw)
 {
-    if (state->uniformDataCount >= state->desc.maxDrawCount)
+    ++list->callCount;
+
+    if (!list->maxDraws)
+    {
+        emitDraw(state, pCmd, draw);
         return;
+    }
 
-    uint64_t offset;
-    if (!allocateData(state, count, sizeof(REI_BasicDraw_V_P3C), &offset))
+    if (list->drawCount)
+    {
+        DeferredDraw& last = list->draws[list->drawCount - 1];
+        if (last.kind == draw.kind && last.chunk == draw.chunk && last.uniformIndex == draw.uniformIndex &&
+            last.format == draw.format && last.bufferSet == draw.bufferSet &&
+            last.first + last.count == draw.first)
+        {
+            last.count += draw.count;
+            return;
+        }
+    }
+
+    if (list->drawCount == list->maxDraws)
+    {
+        if (list == &state->drawList)
+            flushDrawList(state, pCmd, list);
+        else if (!growDrawList(state, list))
+            return;
+    }
+
+    list->draws[list->drawCount++] = draw;
+}
+
+void REI_BasicDraw_Flush(REI_BasicDraw* state, REI_Cmd* pCmd) { flushDrawList(state, pCmd, &state->drawList); }
+
+void renderMesh(
+    REI_BasicDraw* state, DrawList* list, REI_Cmd* pCmd, const float mvp[16], uint32_t count,
+    REI_BasicDraw_V_P3C** verts)
+{
+    REI_BasicDraw_Uniforms uniforms;
+    setUniforms(&uniforms, mvp, 0.0f, 0.0f, 0.0f, 0);
+
+    DeferredDraw draw = {};
+    uint64_t     offset;
+    if (!allocateDraw(
+            state, list, count, sizeof(REI_BasicDraw_V_P3C), uniforms, &draw.chunk, &offset, &draw.uniformIndex))
         return;
-    uint8_t* ptr = ((uint8_t*)state->dataBuffersAddr[state->setIndex]) + offset;
+    uint8_t* ptr = ((uint8_t*)state->chunks[draw.chunk].dataAddr) + offset;
     *verts = (REI_BasicDraw_V_P3C*)ptr;
 
-    if (state->currentPipeline != state->meshPipelineData.pipeline)
+    draw.kind = DRAW_KIND_MESH;
+    draw.first = (uint32_t)(offset / sizeof(REI_BasicDraw_V_P3C));
+    draw.count = count;
+    submitDraw(state, list, pCmd, draw);
+}
+
+// Points of bufferSet ~0u are allocated in the data of the frame, their address is returned
+void* renderPoints(
+    REI_BasicDraw* state, DrawList* list, REI_Cmd* pCmd, const float mvp[16], float ptsize, uint32_t type,
+    uint32_t color, uint32_t bufferSet, uint32_t pointCount, uint32_t firstPoint, REI_BasicDraw_PointPath path)
+{
+    REI_BasicDraw_Uniforms uniforms;
+    setUniforms(
+        &uniforms, mvp, ptsize / (float)state->desc.fbWidth, ptsize / (float)state->desc.fbHeight, 0.0f, color);
+
+    uint32_t pointSize = 0;
+    if (bufferSet == ~0u)
     {
-        state->currentPipeline = state->meshPipelineData.pipeline;
-        // Bind pipeline and descriptor sets:
-        REI_cmdBindPipeline(pCmd, state->meshPipelineData.pipeline);
-        uint64_t vertex_offset = 0;
-        REI_cmdBindVertexBuffer(pCmd, 1, &state->dataBuffers[state->setIndex], &vertex_offset);
-        REI_cmdBindDescriptorTable(pCmd, state->setIndex, state->meshDescriptorSet);
-        REI_cmdSetViewport(pCmd, 0.0f, 0.0f, (float)state->desc.fbWidth, (float)state->desc.fbHeight, 0.0f, 1.0f);
+        switch (type)
+        {
+            case REI_BASICDRAW_POINT_FORMAT_P3C: pointSize = sizeof(REI_BasicDraw_V_P3C); break;
+            case REI_BASICDRAW_POINT_FORMAT_Q3C: pointSize = sizeof(REI_BasicDraw_V_Q3C); break;
+            default: pointSize = sizeof(REI_BasicDraw_V_P3); break;
+        }
     }
 
-    REI_cmdBindPushConstants(
-        pCmd, state->meshPipelineData.rootSignature, REI_SHADER_STAGE_VERT, 0, sizeof(uint32_t), &state->uniformDataCount);
-    REI_cmdDraw(pCmd, count, (uint32_t)(offset) / sizeof(REI_BasicDraw_V_P3C));
+    DeferredDraw draw = {};
+    uint64_t     offset = 0;
+    if (!allocateDraw(
+            state, list, pointSize ? pointCount : 0, pointSize, uniforms, &draw.chunk, &offset, &draw.uniformIndex))
+        return NULL;
 
-    REI_BasicDraw_Uniforms* uniform_ptr =
-        ((REI_BasicDraw_Uniforms*)state->uniBuffersAddr[state->setIndex]) + state->uniformDataCount;
+    draw.kind = path == REI_BASICDRAW_POINT_PATH_INSTANCED ? DRAW_KIND_POINTS_INSTANCED : DRAW_KIND_POINTS;
+    draw.format = type;
+    draw.bufferSet = pointSize ? pointDataTableIndex(state, draw.chunk) : bufferSet;
+    draw.first = pointSize ? (uint32_t)(offset / pointSize) : firstPoint;
+    draw.count = pointCount;
+    submitDraw(state, list, pCmd, draw);
+    return ((uint8_t*)state->chunks[draw.chunk].dataAddr) + offset;
+}
 
-    memcpy(&uniform_ptr->uMVP, mvp, sizeof(uniform_ptr->uMVP));
-    uniform_ptr->uPxScalers[0] = 0.0f;
-    uniform_ptr->uPxScalers[1] = 0.0f;
-    uniform_ptr->uPxScalers[2] = 0.0f;
-    uniform_ptr->uColor = 0;
-    ++state->uniformDataCount;
+void renderPoints(
+    REI_BasicDraw* state, DrawList* list, REI_Cmd* pCmd, const float mvp[16], float ptsize, uint32_t count,
+    REI_BasicDraw_V_P3C** point_data)
+{
+    void* ptr = renderPoints(
+        state, list, pCmd, mvp, ptsize, REI_BASICDRAW_POINT_FORMAT_P3C, 0, ~0u, count, 0,
+        REI_BASICDRAW_POINT_PATH_INSTANCED);
+    if (ptr)
+        *point_data = (REI_BasicDraw_V_P3C*)ptr;
 }
 
-void REI_BasicDraw_RenderPoints(
-    REI_BasicDraw* state, REI_Cmd* pCmd, const float mvp[16], float ptsize, uint32_t type, uint32_t color, uint32_t bufferSet,
-    uint32_t pointCount, uint32_t firstPoint)
+void renderPoints(
+    REI_BasicDraw* state, DrawList* list, REI_Cmd* pCmd, const float mvp[16], float ptsize, uint32_t count,
+    REI_BasicDraw_V_P3** positions, uint32_t color)
+{
+    void* ptr = renderPoints(
+        state, list, pCmd, mvp, ptsize, REI_BASICDRAW_POINT_FORMAT_P3, color, ~0u, count, 0,
+        REI_BASICDRAW_POINT_PATH_INSTANCED);
+    if (ptr)
+        *positions = (REI_BasicDraw_V_P3*)ptr;
+}
+
+void renderPointBufferSet(
+    REI_BasicDraw* state, DrawList* list, REI_Cmd* pCmd, const float mvp[16], float ptsize,
+    REI_BasicDraw_PointFormat format, uint32_t color, uint32_t bufferSet, uint32_t pointCount, uint32_t firstPoint,
+    REI_BasicDraw_PointPath path)
+{
+    if (bufferSet >= state->desc.maxBufferSets)
+        return;
+
+    renderPoints(
+        state, list, pCmd, mvp, ptsize, format, color, bufferSet + state->desc.resourceSetCount, pointCount,
+        firstPoint, path);
+}
+
+// Returns false when all corners of bounds are outside one clip plane. Otherwise pixelArea receives the
+// screen area covered by the bounds, FLT_MAX when they reach behind the eye
+bool projectBounds(REI_BasicDraw* state, const float mvp[16], const Bounds& bounds, float* pixelArea)
 {
-    if (state->currentPipeline != state->pointPipelineData.pipeline)
+    uint32_t outside = 0x3F;
+    bool     behind = false;
+    float    ndcMin[2] = { 1.0f, 1.0f };
+    float    ndcMax[2] = { -1.0f, -1.0f };
+    for (uint32_t corner = 0; corner < 8; ++corner)
     {
-        state->currentPipeline = state->pointPipelineData.pipeline;
-        REI_cmdBindPipeline(pCmd, state->pointPipelineData.pipeline);
-        REI_cmdBindDescriptorTable(pCmd, state->setIndex, state->pointUniDescriptorSet);
-        REI_cmdSetViewport(pCmd, 0.0f, 0.0f, (float)state->desc.fbWidth, (float)state->desc.fbHeight, 0.0f, 1.0f);
+        const float p[3] = { (corner & 1) ? bounds.hi[0] : bounds.lo[0], (corner & 2) ? bounds.hi[1] : bounds.lo[1],
+                             (corner & 4) ? bounds.hi[2] : bounds.lo[2] };
+        float       clip[4];
+        for (uint32_t r = 0; r < 4; ++r)
+            clip[r] = mvp[r] * p[0] + mvp[4 + r] * p[1] + mvp[8 + r] * p[2] + mvp[12 + r];
+
+        outside &= (clip[0] < -clip[3]) | (clip[0] > clip[3]) << 1 | (clip[1] < -clip[3]) << 2 |
+                   (clip[1] > clip[3]) << 3 | (clip[2] < 0.0f) << 4 | (clip[2] > clip[3]) << 5;
+
+        if (clip[3] <= FLT_EPSILON)
+        {
+            behind = true;
+            continue;
+        }
+        for (uint32_t j = 0; j < 2; ++j)
+        {
+            float ndc = clip[j] / clip[3];
+            ndcMin[j] = REI_min(ndcMin[j], ndc);
+            ndcMax[j] = REI_max(ndcMax[j], ndc);
+        }
     }
 
-    REI_cmdBindDescriptorTable(pCmd, bufferSet, state->pointDataDescriptorSet);    // TODO: cache
-    uint32_t baseVertex = 6 * firstPoint;
-    uint32_t pushConstants[3]{ state->uniformDataCount, type, baseVertex };
-    REI_cmdBindPushConstants(
-        pCmd, state->pointPipelineData.rootSignature, REI_SHADER_STAGE_VERT, 0, sizeof(pushConstants), pushConstants);
-    REI_cmdDraw(pCmd, 6 * pointCount, baseVertex);
+    if (outside)
+        return false;
 
-    REI_BasicDraw_Uniforms* uniform_ptr =
-        ((REI_BasicDraw_Uniforms*)state->uniBuffersAddr[state->setIndex]) + state->uniformDataCount;
-    memcpy(&uniform_ptr->uMVP, mvp, sizeof(float) * 16);
-    uniform_ptr->uPxScalers[0] = ptsize / (float)state->desc.fbWidth;
-    uniform_ptr->uPxScalers[1] = ptsize / (float)state->desc.fbHeight;
-    uniform_ptr->uPxScalers[2] = 0.0f;
-    uniform_ptr->uColor = color;
-    ++state->uniformDataCount;
+    if (pixelArea)
+    {
+        if (behind)
+            *pixelArea = FLT_MAX;
+        else
+        {
+            float w = REI_min(ndcMax[0], 1.0f) - REI_max(ndcMin[0], -1.0f);
+            float h = REI_min(ndcMax[1], 1.0f) - REI_max(ndcMin[1], -1.0f);
+            *pixelArea = REI_max(w, 0.0f) * 0.5f * (float)state->desc.fbWidth * REI_max(h, 0.0f) * 0.5f *
+                         (float)state->desc.fbHeight;
+        }
+    }
+    return true;
+}
+
+uint32_t renderPointBufferSetCulled(
+    REI_BasicDraw* state, DrawList* list, REI_Cmd* pCmd, const float mvp[16], float ptsize,
+    REI_BasicDraw_PointFormat format, uint32_t color, uint32_t bufferSet, float pixelsPerPoint,
+    REI_BasicDraw_PointPath path)
+{
+    if (bufferSet >= state->desc.maxBufferSets)
+        return 0;
+
+    const PointSetIndex& index = state->pointSetIndices[bufferSet];
+    uint32_t             pointCount = 0;
+    for (uint32_t g = 0; g < index.groupCount; ++g)
+    {
+        if (!projectBounds(state, mvp, index.groupBounds[g], NULL))
+            continue;
+
+        const uint32_t lastChunk = REI_min((g + 1) * CHUNKS_PER_GROUP, index.chunkCount);
+        for (uint32_t c = g * CHUNKS_PER_GROUP; c < lastChunk; ++c)
+        {
+            float pixelArea;
+            if (!projectBounds(state, mvp, index.chunkBounds[c], &pixelArea))
+                continue;
+
+            // Halving a prefix of the bit-reversed chunk doubles the stride between drawn points
+            const uint32_t first = c * index.pointsPerChunk;
+            uint32_t       count = REI_min(index.pointsPerChunk, index.pointCount - first);
+            if (pixelsPerPoint > 0.0f)
+            {
+                float minCount = pixelArea / pixelsPerPoint;
+                while (count > 1 && (float)((count + 1) / 2) >= minCount)
+                    count = (count + 1) / 2;
+            }
+
+            renderPoints(
+                state, list, pCmd, mvp, ptsize, format, color, bufferSet + state->desc.resourceSetCount, count, first,
+                path);
+            pointCount += count;
+        }
+    }
+    return pointCount;
+}
+
+// Lines of format 0 are REI_BasicDraw_Line, of format 1 REI_BasicDraw_QLine
+void* renderLines(
+    REI_BasicDraw* state, DrawList* list, REI_Cmd* pCmd, const float mvp[16], uint32_t format, uint32_t count,
+    REI_BasicDraw_LinePath path)
+{
+    REI_BasicDraw_Uniforms uniforms;
+    setUniforms(
+        &uniforms, mvp, 1.0f / (float)state->desc.fbWidth, 1.0f / (float)state->desc.fbHeight,
+        (float)state->desc.fbWidth / (float)state->desc.fbHeight, 0);
+
+    uint32_t     lineSize = format ? sizeof(REI_BasicDraw_QLine) : sizeof(REI_BasicDraw_Line);
+    DeferredDraw draw = {};
+    uint64_t     offset;
+    if (!allocateDraw(state, list, count, lineSize, uniforms, &draw.chunk, &offset, &draw.uniformIndex))
+        return NULL;
+
+    draw.kind = path == REI_BASICDRAW_LINE_PATH_INSTANCED ? DRAW_KIND_LINES_INSTANCED : DRAW_KIND_LINES;
+    draw.format = format;
+    draw.first = (uint32_t)(offset / lineSize);
+    draw.count = count;
+    submitDraw(state, list, pCmd, draw);
+    return ((uint8_t*)state->chunks[draw.chunk].dataAddr) + offset;
+}
+
+void renderLines(
+    REI_BasicDraw* state, DrawList* list, REI_Cmd* pCmd, const float mvp[16], uint32_t count,
+    REI_BasicDraw_Line** line_data, REI_BasicDraw_LinePath path)
+{
+    void* ptr = renderLines(state, list, pCmd, mvp, 0, count, path);
+    if (ptr)
+        *line_data = (REI_BasicDraw_Line*)ptr;
+}
+
+void renderLines(
+    REI_BasicDraw* state, DrawList* list, REI_Cmd* pCmd, const float mvp[16], const REI_BasicDraw_QuantBox* box,
+    uint32_t count, REI_BasicDraw_QLine** line_data, REI_BasicDraw_LinePath path)
+{
+    float quantizedMVP[16];
+    REI_BasicDraw_QuantizeMVP(mvp, box, quantizedMVP);
+    void* ptr = renderLines(state, list, pCmd, quantizedMVP, 1, count, path);
+    if (ptr)
+        *line_data = (REI_BasicDraw_QLine*)ptr;
+}
+
+void renderPoints(
+    REI_BasicDraw* state, DrawList* list, REI_Cmd* pCmd, const float mvp[16], float ptsize,
+    const REI_BasicDraw_QuantBox* box, uint32_t count, REI_BasicDraw_V_Q3C** point_data)
+{
+    float quantizedMVP[16];
+    REI_BasicDraw_QuantizeMVP(mvp, box, quantizedMVP);
+    void* ptr = renderPoints(
+        state, list, pCmd, quantizedMVP, ptsize, REI_BASICDRAW_POINT_FORMAT_Q3C, 0, ~0u, count, 0,
+        REI_BASICDRAW_POINT_PATH_INSTANCED);
+    if (ptr)
+        *point_data = (REI_BasicDraw_V_Q3C*)ptr;
+}
+
+void REI_BasicDraw_RenderMesh(
+    REI_BasicDraw* state, REI_Cmd* pCmd, const float mvp[16], uint32_t count, REI_BasicDraw_V_P3C** verts)
+{
+    renderMesh(state, &state->drawList, pCmd, mvp, count, verts);
 }
 
 void REI_BasicDraw_RenderPoints(
     REI_BasicDraw* state, REI_Cmd* pCmd, const float mvp[16], float ptsize, uint32_t count, REI_BasicDraw_V_P3C** point_data)
 {
-    if (state->uniformDataCount >= state->desc.maxDrawCount)
-        return;
+    renderPoints(state, &state->drawList, pCmd, mvp, ptsize, count, point_data);
+}
 
-    uint64_t offset;
-    if (!allocateData(state, count, sizeof(REI_BasicDraw_V_P3C), &offset))
-        return;
-    *point_data = (REI_BasicDraw_V_P3C*)(((uint8_t*)state->dataBuffersAddr[state->setIndex]) + offset);
+void REI_BasicDraw_RenderPoints(
+    REI_BasicDraw* state, REI_Cmd* pCmd, const float mvp[16], float ptsize, uint32_t count, REI_BasicDraw_V_P3** positions,
+    uint32_t color)
+{
+    renderPoints(state, &state->drawList, pCmd, mvp, ptsize, count, positions, color);
+}
 
-    REI_BasicDraw_RenderPoints(
-        state, pCmd, mvp, ptsize, 0, 0, state->setIndex, count, (uint32_t)(offset / sizeof(REI_BasicDraw_V_P3C)));
+void REI_BasicDraw_RenderPointBufferSet(
+    REI_BasicDraw* state, REI_Cmd* pCmd, const float mvp[16], float ptsize, REI_BasicDraw_PointFormat format,
+    uint32_t color, uint32_t bufferSet, uint32_t pointCount, uint32_t firstPoint, REI_BasicDraw_PointPath path)
+{
+    renderPointBufferSet(
+        state, &state->drawList, pCmd, mvp, ptsize, format, color, bufferSet, pointCount, firstPoint, path);
+}
+
+uint32_t REI_BasicDraw_RenderPointBufferSetCulled(
+    REI_BasicDraw* state, REI_Cmd* pCmd, const float mvp[16], float ptsize, REI_BasicDraw_PointFormat format,
+    uint32_t color, uint32_t bufferSet, float pixelsPerPoint, REI_BasicDraw_PointPath path)
+{
+    return renderPointBufferSetCulled(
+        state, &state->drawList, pCmd, mvp, ptsize, format, color, bufferSet, pixelsPerPoint, path);
+}
+
+void REI_BasicDraw_RenderLines(
+    REI_BasicDraw* state, REI_Cmd* pCmd, float const mvp[16], uint32_t count, REI_BasicDraw_Line** line_data,
+    REI_BasicDraw_LinePath path)
+{
+    renderLines(state, &state->drawList, pCmd, mvp, count, line_data, path);
 }
 
 void REI_BasicDraw_RenderPoints(
-    REI_BasicDraw* state, REI_Cmd* pCmd, const float mvp[16], float ptsize, uint32_t count, REI_BasicDraw_V_P3** positions,
+    REI_BasicDraw* state, REI_Cmd* pCmd, const float mvp[16], float ptsize, const REI_BasicDraw_QuantBox* box,
+    uint32_t count, REI_BasicDraw_V_Q3C** point_data)
+{
+    renderPoints(state, &state->drawList, pCmd, mvp, ptsize, box, count, point_data);
+}
+
+void REI_BasicDraw_RenderLines(
+    REI_BasicDraw* state, REI_Cmd* pCmd, const float mvp[16], const REI_BasicDraw_QuantBox* box, uint32_t count,
+    REI_BasicDraw_QLine** line_data, REI_BasicDraw_LinePath path)
+{
+    renderLines(state, &state->drawList, pCmd, mvp, box, count, line_data, path);
+}
+
+REI_BasicDraw_Context* REI_BasicDraw_AddContext(REI_BasicDraw* state, uint32_t maxDraws)
+{
+    REI_BasicDraw_Context* context = (REI_BasicDraw_Context*)REI_calloc(state->allocator, sizeof(REI_BasicDraw_Context));
+    if (!context)
+        return NULL;
+
+    context->state = state;
+    context->drawList.maxDraws = maxDraws ? maxDraws : 64;
+    context->drawList.draws =
+        (DeferredDraw*)REI_calloc(state->allocator, context->drawList.maxDraws * sizeof(DeferredDraw));
+    if (!context->drawList.draws)
+    {
+        state->allocator.pFree(state->allocator.pUserData, context);
+        return NULL;
+    }
+    context->frameIndex = state->frameIndex - 1;
+    return context;
+}
+
+void REI_BasicDraw_RemoveContext(REI_BasicDraw* state, REI_BasicDraw_Context* context)
+{
+    state->allocator.pFree(state->allocator.pUserData, context->drawList.draws);
+    state->allocator.pFree(state->allocator.pUserData, context);
+}
+
+// Contexts notice a new frame lazily, uniform slots of the previous frame must not be reused
+DrawList* beginContextFrame(REI_BasicDraw_Context* context)
+{
+    if (context->frameIndex != context->state->frameIndex)
+    {
+        REI_ASSERT(!context->drawList.drawCount, "REI_BasicDraw_FlushContext was not called for the previous frame");
+        context->frameIndex = context->state->frameIndex;
+        context->drawList.drawCount = 0;
+        context->drawList.callCount = 0;
+        context->drawList.lastUniformIndex = ~0u;
+    }
+    return &context->drawList;
+}
+
+void REI_BasicDraw_FlushContext(REI_BasicDraw* state, REI_Cmd* pCmd, REI_BasicDraw_Context* context)
+{
+    DrawList* list = beginContextFrame(context);
+    flushDrawList(state, pCmd, list);
+    state->stats.callCount += list->callCount;
+    list->callCount = 0;
+}
+
+void REI_BasicDraw_RenderMesh(
+    REI_BasicDraw_Context* context, const float mvp[16], uint32_t count, REI_BasicDraw_V_P3C** verts)
+{
+    renderMesh(context->state, beginContextFrame(context), NULL, mvp, count, verts);
+}
+
+void REI_BasicDraw_RenderPoints(
+    REI_BasicDraw_Context* context, const float mvp[16], float ptsize, uint32_t count, REI_BasicDraw_V_P3C** point_data)
+{
+    renderPoints(context->state, beginContextFrame(context), NULL, mvp, ptsize, count, point_data);
+}
+
+void REI_BasicDraw_RenderPoints(
+    REI_BasicDraw_Context* context, const float mvp[16], float ptsize, uint32_t count, REI_BasicDraw_V_P3** positions,
     uint32_t color)
 {
-    if (state->uniformDataCount >= state->desc.maxDrawCount)
-        return;
+    renderPoints(context->state, beginContextFrame(context), NULL, mvp, ptsize, count, positions, color);
+}
 
-    uint64_t offset;
-    if (!allocateData(state, count, sizeof(REI_BasicDraw_V_P3), &offset))
-        return;
-    *positions = (REI_BasicDraw_V_P3*)(((uint8_t*)state->dataBuffersAddr[state->setIndex]) + offset);
+void REI_BasicDraw_RenderPointBufferSet(
+    REI_BasicDraw_Context* context, const float mvp[16], float ptsize, REI_BasicDraw_PointFormat format,
+    uint32_t color, uint32_t bufferSet, uint32_t pointCount, uint32_t firstPoint, REI_BasicDraw_PointPath path)
+{
+    renderPointBufferSet(
+        context->state, beginContextFrame(context), NULL, mvp, ptsize, format, color, bufferSet, pointCount,
+        firstPoint, path);
+}
 
-    REI_BasicDraw_RenderPoints(
-        state, pCmd, mvp, ptsize, 2, color, state->setIndex, count, (uint32_t)(offset / sizeof(REI_BasicDraw_V_P3)));
+uint32_t REI_BasicDraw_RenderPointBufferSetCulled(
+    REI_BasicDraw_Context* context, const float mvp[16], float ptsize, REI_BasicDraw_PointFormat format,
+    uint32_t color, uint32_t bufferSet, float pixelsPerPoint, REI_BasicDraw_PointPath path)
+{
+    return renderPointBufferSetCulled(
+        context->state, beginContextFrame(context), NULL, mvp, ptsize, format, color, bufferSet, pixelsPerPoint,
+        path);
 }
 
 void REI_BasicDraw_RenderLines(
-    REI_BasicDraw* state, REI_Cmd* pCmd, float const mvp[16], uint32_t count, REI_BasicDraw_Line** line_data)
+    REI_BasicDraw_Context* context, const float mvp[16], uint32_t count, REI_BasicDraw_Line** line_data,
+    REI_BasicDraw_LinePath path)
 {
-    if (state->uniformDataCount >= state->desc.maxDrawCount)
+    renderLines(context->state, beginContextFrame(context), NULL, mvp, count, line_data, path);
+}
+
+void REI_BasicDraw_RenderPoints(
+    REI_BasicDraw_Context* context, const float mvp[16], float ptsize, const REI_BasicDraw_QuantBox* box,
+    uint32_t count, REI_BasicDraw_V_Q3C** point_data)
+{
+    renderPoints(context->state, beginContextFrame(context), NULL, mvp, ptsize, box, count, point_data);
+}
+
+void REI_BasicDraw_RenderLines(
+    REI_BasicDraw_Context* context, const float mvp[16], const REI_BasicDraw_QuantBox* box, uint32_t count,
+    REI_BasicDraw_QLine** line_data, REI_BasicDraw_LinePath path)
+{
+    renderLines(context->state, beginContextFrame(context), NULL, mvp, box, count, line_data, path);
+}
+
+uint32_t REI_BasicDraw_ExpandPoints(
+    REI_BasicDraw* state, REI_Cmd* pCmd, const float mvp[16], float ptsize, REI_BasicDraw_PointFormat format,
+    uint32_t color, uint32_t bufferSet, uint32_t pointCount, uint32_t firstPoint)
+{
+    if (!state->desc.maxExpandedPoints || bufferSet >= state->desc.maxBufferSets)
+        return REI_BASICDRAW_EXPAND_FAILED;
+
+    if (state->desc.maxExpandedPoints - state->expandedUsed < pointCount)
+        return REI_BASICDRAW_EXPAND_FAILED;
+
+    // The expansion tables of a set only reference its base chunk
+    REI_BasicDraw_Uniforms uniforms;
+    setUniforms(
+        &uniforms, mvp, ptsize / (float)state->desc.fbWidth, ptsize / (float)state->desc.fbHeight, 0.0f, color);
+    uint32_t uniformIndex;
+    if (!allocateUniforms(state, &state->drawList, state->setIndex, uniforms, &uniformIndex))
+        return REI_BASICDRAW_EXPAND_FAILED;
+
+    REI_Buffer* expandedBuffer = state->expandedBuffers[state->setIndex];
+    if (!state->expandedWritable)
+    {
+        REI_BufferBarrier barrier = { expandedBuffer, REI_RESOURCE_STATE_SHADER_RESOURCE,
+                                      REI_RESOURCE_STATE_UNORDERED_ACCESS };
+        REI_cmdResourceBarrier(pCmd, 1, &barrier, 0, NULL);
+        state->expandedWritable = true;
+    }
+
+    // Compute work breaks pipeline tracking of graphics draws
+    state->currentPipeline = NULL;
+    REI_cmdBindPipeline(pCmd, state->pointExpandPipelineData.pipeline);
+    REI_cmdBindDescriptorTable(pCmd, state->setIndex, state->expandUniDescriptorSet);
+    REI_cmdBindDescriptorTable(pCmd, bufferSet + state->desc.resourceSetCount, state->expandDataDescriptorSet);
+
+    uint32_t firstExpanded = state->expandedUsed;
+    uint32_t pushConstants[5]{ uniformIndex, (uint32_t)format, firstPoint, pointCount, firstExpanded };
+    REI_cmdBindPushConstants(
+        pCmd, state->pointExpandPipelineData.rootSignature, REI_SHADER_STAGE_COMP, 0, sizeof(pushConstants),
+        pushConstants);
+    REI_cmdDispatch(pCmd, (pointCount + EXPAND_THREAD_GROUP_SIZE - 1) / EXPAND_THREAD_GROUP_SIZE, 1, 1);
+
+    state->expandedUsed += pointCount;
+    return firstExpanded;
+}
+
+void REI_BasicDraw_FinishExpandPoints(REI_BasicDraw* state, REI_Cmd* pCmd)
+{
+    if (!state->expandedWritable)
         return;
 
-    uint64_t offset;
-    if (!allocateData(state, count, sizeof(REI_BasicDraw_Line), &offset))
+    REI_BufferBarrier barrier = { state->expandedBuffers[state->setIndex], REI_RESOURCE_STATE_UNORDERED_ACCESS,
+                                  REI_RESOURCE_STATE_SHADER_RESOURCE };
+    REI_cmdResourceBarrier(pCmd, 1, &barrier, 0, NULL);
+    state->expandedWritable = false;
+}
+
+void REI_BasicDraw_RenderExpandedPoints(REI_BasicDraw* state, REI_Cmd* pCmd, uint32_t firstExpanded, uint32_t pointCount)
+{
+    if (firstExpanded == REI_BASICDRAW_EXPAND_FAILED || !pointCount)
         return;
-    uint8_t* ptr = ((uint8_t*)state->dataBuffersAddr[state->setIndex]) + offset;
-    *line_data = (REI_BasicDraw_Line*)ptr;
 
-    if (state->currentPipeline != state->linePipelineData.pipeline)
+    REI_ASSERT(!state->expandedWritable, "REI_BasicDraw_FinishExpandPoints must be called before rendering");
+    REI_ASSERT(firstExpanded + pointCount <= state->expandedUsed);
+
+    // Keep submission order with draws still waiting in the deferred list
+    REI_BasicDraw_Flush(state, pCmd);
+
+    if (state->currentPipeline != state->pointExpandedPipelineData.pipeline)
     {
-        state->currentPipeline = state->linePipelineData.pipeline;
-        REI_cmdBindPipeline(pCmd, state->linePipelineData.pipeline);
-        REI_cmdBindDescriptorTable(pCmd, state->setIndex, state->lineDescriptorSet);
+        state->currentPipeline = state->pointExpandedPipelineData.pipeline;
+        REI_cmdBindPipeline(pCmd, state->pointExpandedPipelineData.pipeline);
+        REI_cmdBindDescriptorTable(pCmd, state->setIndex, state->expandedDescriptorSet);
         REI_cmdSetViewport(pCmd, 0.0f, 0.0f, (float)state->desc.fbWidth, (float)state->desc.fbHeight, 0.0f, 1.0f);
     }
-    uint32_t baseVertex = 6 * (uint32_t)(offset / sizeof(REI_BasicDraw_Line));
-    uint32_t pushConstants[2]{ state->uniformDataCount, baseVertex };
-    REI_cmdBindPushConstants(
-        pCmd, state->linePipelineData.rootSignature, REI_SHADER_STAGE_VERT, 0, sizeof(pushConstants), pushConstants);
-    REI_cmdDraw(pCmd, 6 * count, baseVertex);
-
-    REI_BasicDraw_Uniforms* uniforms_ptr =
-        ((REI_BasicDraw_Uniforms*)state->uniBuffersAddr[state->setIndex]) + state->uniformDataCount;
 
-    memcpy(&uniforms_ptr->uMVP, mvp, sizeof(float) * 16);
-    uniforms_ptr->uPxScalers[0] = 1.0f / (float)state->desc.fbWidth;
-    uniforms_ptr->uPxScalers[1] = 1.0f / (float)state->desc.fbHeight;
-    uniforms_ptr->uPxScalers[2] = (float)state->desc.fbWidth / (float)state->desc.fbHeight;
-    uniforms_ptr->uColor = 0;
-    ++state->uniformDataCount;
+    REI_cmdBindPushConstants(
+        pCmd, state->pointExpandedPipelineData.rootSignature, REI_SHADER_STAGE_VERT, 0, sizeof(uint32_t),
+        &firstExpanded);
+    REI_cmdDrawInstanced(pCmd, 4, 0, pointCount, firstExpanded);
+    ++state->drawList.callCount;
+    ++state->stats.drawCount;
 }
 
 void REI_BasicDraw_Shutdown(REI_BasicDraw* state)
@@ -576,23 +1782,227 @@ void REI_BasicDraw_Shutdown(REI_BasicDraw* state)
     REI_removeDescriptorTableArray(state->renderer, state->pointDataDescriptorSet);
     REI_removeDescriptorTableArray(state->renderer, state->lineDescriptorSet);
 
-    for (uint32_t i = 0; i < state->desc.resourceSetCount; ++i)
+    for (uint32_t i = 0; i < state->desc.resourceSetCount + state->desc.maxDataChunks; ++i)
     {
-        REI_removeBuffer(state->renderer, state->dataBuffers[i]);
+        destroyChunk(state, i);
     }
-    state->allocator.pFree(state->allocator.pUserData, state->dataBuffers);
-    state->allocator.pFree(state->allocator.pUserData, state->dataBuffersAddr);
+    state->allocator.pFree(state->allocator.pUserData, state->chunks);
+    if (state->chunkOwners)
+        state->allocator.pFree(state->allocator.pUserData, state->chunkOwners);
+    REI_delete(state->allocator, state->chunkMutex);
 
-    for (uint32_t i = 0; i < state->desc.resourceSetCount; ++i)
+    if (state->drawList.draws)
+        state->allocator.pFree(state->allocator.pUserData, state->drawList.draws);
+
+    if (state->pointSetIndices)
     {
-        REI_removeBuffer(state->renderer, state->uniBuffers[i]);
+        for (uint32_t i = 0; i < state->desc.maxBufferSets; ++i)
+            REI_BasicDraw_RemovePointSetIndex(state, i);
+        state->allocator.pFree(state->allocator.pUserData, state->pointSetIndices);
+    }
+
+    if (state->desc.maxExpandedPoints)
+    {
+        REI_removeDescriptorTableArray(state->renderer, state->expandUniDescriptorSet);
+        REI_removeDescriptorTableArray(state->renderer, state->expandDataDescriptorSet);
+        REI_removeDescriptorTableArray(state->renderer, state->expandedDescriptorSet);
+
+        for (uint32_t i = 0; i < state->desc.resourceSetCount; ++i)
+        {
+            REI_removeBuffer(state->renderer, state->expandedBuffers[i]);
+        }
+        state->allocator.pFree(state->allocator.pUserData, state->expandedBuffers);
     }
-    state->allocator.pFree(state->allocator.pUserData, state->uniBuffers);
-    state->allocator.pFree(state->allocator.pUserData, state->uniBuffersAddr);
 
     destroyPipelineData(state, &state->meshPipelineData);
+    // Root signature is owned by pointPipelineData
+    state->pointInstancedPipelineData.rootSignature = NULL;
+    destroyPipelineData(state, &state->pointInstancedPipelineData);
     destroyPipelineData(state, &state->pointPipelineData);
+    destroyPipelineData(state, &state->pointExpandPipelineData);
+    destroyPipelineData(state, &state->pointExpandedPipelineData);
+    // Root signature is owned by linePipelineData
+    state->lineInstancedPipelineData.rootSignature = NULL;
+    destroyPipelineData(state, &state->lineInstancedPipelineData);
     destroyPipelineData(state, &state->linePipelineData);
 
     state->allocator.pFree(state->allocator.pUserData, state);
 }
+
+void REI_BasicDraw_ComputeQuantBox(const float* positions, uint32_t count, uint32_t stride, REI_BasicDraw_QuantBox* box)
+{
+    if (!count)
+    {
+        *box = {};
+        return;
+    }
+
+    float lo[3] = { positions[0], positions[1], positions[2] };
+    float hi[3] = { positions[0], positions[1], positions[2] };
+#if defined(REI_BASICDRAW_SSE2)
+    __m128 vlo = _mm_setr_ps(lo[0], lo[1], lo[2], 0.0f);
+    __m128 vhi = vlo;
+    for (uint32_t i = 1; i < count; ++i)
+    {
+        const float* p = (const float*)((const uint8_t*)positions + (size_t)i * stride);
+        __m128       v = _mm_setr_ps(p[0], p[1], p[2], 0.0f);
+        vlo = _mm_min_ps(vlo, v);
+        vhi = _mm_max_ps(vhi, v);
+    }
+    float tmp[4];
+    _mm_storeu_ps(tmp, vlo);
+    memcpy(lo, tmp, sizeof(lo));
+    _mm_storeu_ps(tmp, vhi);
+    memcpy(hi, tmp, sizeof(hi));
+#else
+    for (uint32_t i = 1; i < count; ++i)
+    {
+        const float* p = (const float*)((const uint8_t*)positions + (size_t)i * stride);
+        for (uint32_t j = 0; j < 3; ++j)
+        {
+            lo[j] = REI_min(lo[j], p[j]);
+            hi[j] = REI_max(hi[j], p[j]);
+        }
+    }
+#endif
+
+    for (uint32_t j = 0; j < 3; ++j)
+    {
+        box->origin[j] = lo[j];
+        box->scale[j] = (hi[j] - lo[j]) / 65535.0f;
+    }
+}
+
+// mvp * translate(origin) * scale(scale), matrices are column major
+void REI_BasicDraw_QuantizeMVP(const float mvp[16], const REI_BasicDraw_QuantBox* box, float quantizedMVP[16])
+{
+    for (uint32_t r = 0; r < 4; ++r)
+    {
+        quantizedMVP[r] = mvp[r] * box->scale[0];
+        quantizedMVP[4 + r] = mvp[4 + r] * box->scale[1];
+        quantizedMVP[8 + r] = mvp[8 + r] * box->scale[2];
+        quantizedMVP[12 + r] =
+            mvp[r] * box->origin[0] + mvp[4 + r] * box->origin[1] + mvp[8 + r] * box->origin[2] + mvp[12 + r];
+    }
+}
+
+static inline uint16_t quantize(float v, float origin, float invScale)
+{
+    float q = (v - origin) * invScale + 0.5f;
+    q = q > 0.0f ? q : 0.0f;
+    q = q < 65535.0f ? q : 65535.0f;
+    return (uint16_t)q;
+}
+
+static inline uint16_t packColor4444(uint32_t c)
+{
+    return (uint16_t)(((c >> 4) & 0xF) | ((c >> 8) & 0xF0) | ((c >> 12) & 0xF00) | ((c >> 16) & 0xF000));
+}
+
+static inline void getInvScale(const REI_BasicDraw_QuantBox* box, float invScale[3])
+{
+    for (uint32_t j = 0; j < 3; ++j)
+        invScale[j] = box->scale[j] > 0.0f ? 1.0f / box->scale[j] : 0.0f;
+}
+
+#if defined(REI_BASICDRAW_SSE2)
+static inline __m128i quantizeSSE2(__m128 v, __m128 origin, __m128 invScale)
+{
+    __m128 q = _mm_add_ps(_mm_mul_ps(_mm_sub_ps(v, origin), invScale), _mm_set1_ps(0.5f));
+    q = _mm_min_ps(_mm_max_ps(q, _mm_setzero_ps()), _mm_set1_ps(65535.0f));
+    return _mm_cvttps_epi32(q);
+}
+
+// RGBA8888 to RGBA4444 in every lane
+static inline __m128i packColor4444SSE2(__m128i c)
+{
+    __m128i r = _mm_and_si128(_mm_srli_epi32(c, 4), _mm_set1_epi32(0xF));
+    __m128i g = _mm_and_si128(_mm_srli_epi32(c, 8), _mm_set1_epi32(0xF0));
+    __m128i b = _mm_and_si128(_mm_srli_epi32(c, 12), _mm_set1_epi32(0xF00));
+    __m128i a = _mm_and_si128(_mm_srli_epi32(c, 16), _mm_set1_epi32(0xF000));
+    return _mm_or_si128(_mm_or_si128(r, g), _mm_or_si128(b, a));
+}
+
+// Replaces the last lane of xyz with the last lane of w
+static inline __m128i mergeLastLaneSSE2(__m128i xyz, __m128i w)
+{
+    const __m128i mask = _mm_setr_epi32(-1, -1, -1, 0);
+    return _mm_or_si128(_mm_and_si128(xyz, mask), _mm_andnot_si128(mask, w));
+}
+
+// Packs lanes holding values in [0, 65535] to 16 bits, SSE2 only has signed saturation
+static inline __m128i packU16SSE2(__m128i a, __m128i b)
+{
+    const __m128i bias = _mm_set1_epi32(0x8000);
+    __m128i       packed = _mm_packs_epi32(_mm_sub_epi32(a, bias), _mm_sub_epi32(b, bias));
+    return _mm_xor_si128(packed, _mm_set1_epi16((short)0x8000));
+}
+#endif
+
+void REI_BasicDraw_PackPoints(
+    const REI_BasicDraw_QuantBox* box, uint32_t count, const REI_BasicDraw_V_P3C* src, REI_BasicDraw_V_Q3C* dst)
+{
+    float invScale[3];
+    getInvScale(box, invScale);
+
+    uint32_t i = 0;
+#if defined(REI_BASICDRAW_SSE2)
+    // Two points per 16 byte store
+    const __m128 vorigin = _mm_setr_ps(box->origin[0], box->origin[1], box->origin[2], 0.0f);
+    const __m128 vinvScale = _mm_setr_ps(invScale[0], invScale[1], invScale[2], 0.0f);
+    for (; i + 2 <= count; i += 2)
+    {
+        __m128 v0 = _mm_loadu_ps(src[i].p);
+        __m128 v1 = _mm_loadu_ps(src[i + 1].p);
+        __m128i q0 = mergeLastLaneSSE2(
+            quantizeSSE2(v0, vorigin, vinvScale), packColor4444SSE2(_mm_castps_si128(v0)));
+        __m128i q1 = mergeLastLaneSSE2(
+            quantizeSSE2(v1, vorigin, vinvScale), packColor4444SSE2(_mm_castps_si128(v1)));
+        _mm_storeu_si128((__m128i*)(dst + i), packU16SSE2(q0, q1));
+    }
+#endif
+    for (; i < count; ++i)
+    {
+        REI_BasicDraw_V_Q3C q;
+        for (uint32_t j = 0; j < 3; ++j)
+            q.p[j] = quantize(src[i].p[j], box->origin[j], invScale[j]);
+        q.c = packColor4444(src[i].c);
+        dst[i] = q;
+    }
+}
+
+void REI_BasicDraw_PackLines(
+    const REI_BasicDraw_QuantBox* box, uint32_t count, const REI_BasicDraw_Line* src, REI_BasicDraw_QLine* dst)
+{
+    float invScale[3];
+    getInvScale(box, invScale);
+
+    uint32_t i = 0;
+#if defined(REI_BASICDRAW_SSE2)
+    // The last lane of the first half quantizes the width to 8.8 fixed point
+    const __m128 vorigin = _mm_setr_ps(box->origin[0], box->origin[1], box->origin[2], 0.0f);
+    const __m128 vinvScale0 = _mm_setr_ps(invScale[0], invScale[1], invScale[2], 256.0f);
+    const __m128 vinvScale1 = _mm_setr_ps(invScale[0], invScale[1], invScale[2], 0.0f);
+    for (; i < count; ++i)
+    {
+        __m128  v0 = _mm_loadu_ps(src[i].p0);
+        __m128  v1 = _mm_loadu_ps(src[i].p1);
+        __m128i q0 = quantizeSSE2(v0, vorigin, vinvScale0);
+        __m128i q1 = mergeLastLaneSSE2(
+            quantizeSSE2(v1, vorigin, vinvScale1), packColor4444SSE2(_mm_castps_si128(v1)));
+        _mm_storeu_si128((__m128i*)(dst + i), packU16SSE2(q0, q1));
+    }
+#endif
+    for (; i < count; ++i)
+    {
+        REI_BasicDraw_QLine q;
+        for (uint32_t j = 0; j < 3; ++j)
+        {
+            q.p0[j] = quantize(src[i].p0[j], box->origin[j], invScale[j]);
+            q.p1[j] = quantize(src[i].p1[j], box->origin[j], invScale[j]);
+        }
+        q.w = quantize(src[i].w, 0.0f, 256.0f);
+        q.c = packColor4444(src[i].c);
+        dst[i] = q;
+    }
+}
@@ -28,6 +28,68 @@ struct REI_BasicDraw_Desc
     uint32_t                      maxBufferSets;
     uint64_t                      maxDataSize;
     const REI_AllocatorCallbacks* pAllocator;
+    // Capacity of per set buffers written by REI_BasicDraw_ExpandPoints, 0 disables compute expansion
+    uint32_t                      maxExpandedPoints;
+    // Capacity of the deferred draw list, 0 records draws immediately. In deferred mode draws are merged and
+    // recorded to the command buffer by REI_BasicDraw_Flush, which has to be called before the render pass ends
+    uint32_t                      maxDeferredDraws;
+    // Overflow chunks shared by all sets, 0 keeps the fixed maxDataSize and maxDrawCount budget. A set that runs
+    // out of data or uniforms borrows chunks for the rest of the frame, its next REI_BasicDraw_SetupRender retires
+    // them and grows the buffers of the set to what the frame needed
+    uint32_t                      maxDataChunks;
+};
+
+struct REI_BasicDraw_Stats
+{
+    uint32_t callCount;       // draw calls made since REI_BasicDraw_SetupRender
+    uint32_t drawCount;       // draws recorded to command buffers
+    uint32_t uniformCount;    // uniform slots written
+    uint32_t droppedDraws;    // draws skipped because no data or uniforms were left
+    uint64_t droppedBytes;    // data bytes of skipped draws
+    uint64_t grownBytes;      // data and uniform bytes placed in overflow chunks
+};
+
+// Layout of point data in a buffer set registered with REI_RegisterPointBufferSet
+enum REI_BasicDraw_PointFormat
+{
+    REI_BASICDRAW_POINT_FORMAT_P3C = 0,    // interleaved REI_BasicDraw_V_P3C
+    REI_BASICDRAW_POINT_FORMAT_P3_C,       // REI_BasicDraw_V_P3 positions with separate uint32_t colors
+    REI_BASICDRAW_POINT_FORMAT_P3,         // REI_BasicDraw_V_P3 positions drawn with a single color
+    REI_BASICDRAW_POINT_FORMAT_Q3C,        // REI_BasicDraw_V_Q3C, mvp has to be made by REI_BasicDraw_QuantizeMVP
+};
+
+enum REI_BasicDraw_PointPath
+{
+    // Six vertices per point, quad corners are derived from SV_VertexID
+    REI_BASICDRAW_POINT_PATH_VERTEX = 0,
+    // One instance per point, drawn as a 4 vertex triangle strip
+    REI_BASICDRAW_POINT_PATH_INSTANCED,
+};
+
+enum REI_BasicDraw_LinePath
+{
+    // Six vertices per line, quad corners are derived from SV_VertexID
+    REI_BASICDRAW_LINE_PATH_VERTEX = 0,
+    // One instance per line, drawn as a 4 vertex triangle strip
+    REI_BASICDRAW_LINE_PATH_INSTANCED,
+};
+
+enum
+{
+    REI_BASICDRAW_EXPAND_FAILED = ~0u
+};
+
+// Spatial index of a registered buffer set. Points are sorted along a Morton curve and split into chunks of
+// pointsPerChunk points with their bounds. Inside a chunk points are stored in bit-reversed order, so that the
+// first pointsPerChunk >> k points are every 2^k-th point of the chunk and serve as level of detail k.
+struct REI_BasicDraw_PointSetIndexDesc
+{
+    const float* pPositions;        // first position, in the space transformed by the mvp of culled draws
+    uint32_t     positionStride;    // bytes between positions
+    uint32_t     pointCount;
+    uint32_t     pointsPerChunk;    // power of two, 0 selects 4096
+    // Receives pointCount indices: point i of the buffer set has to be source point pOrder[i]
+    uint32_t*    pOrder;
 };
 
 struct REI_BasicDraw_V_P3C
@@ -49,10 +111,34 @@ struct REI_BasicDraw_Line
     uint32_t c;
 };
 
+// Quantized formats store positions as 16-bit steps inside a box, decoded as origin + p * scale,
+// and colors as RGBA4444
+struct REI_BasicDraw_QuantBox
+{
+    float origin[3];
+    float scale[3];
+};
+
+struct REI_BasicDraw_V_Q3C
+{
+    uint16_t p[3];
+    uint16_t c;
+};
+
+struct REI_BasicDraw_QLine
+{
+    uint16_t p0[3];
+    uint16_t w;    // 8.8 fixed point width
+    uint16_t p1[3];
+    uint16_t c;
+};
+
 struct REI_BasicDraw;
 
 REI_BasicDraw* REI_BasicDraw_Init(REI_Renderer* Renderer, REI_BasicDraw_Desc* info);
 void           REI_BasicDraw_SetupRender(REI_BasicDraw* state, uint32_t set_index);
+void           REI_BasicDraw_Flush(REI_BasicDraw* state, REI_Cmd* pCmd);
+void           REI_BasicDraw_GetStats(REI_BasicDraw* state, REI_BasicDraw_Stats* pStats);
 void           REI_BasicDraw_Shutdown(REI_BasicDraw* state);
 
 void REI_RegisterPointBufferSet(
@@ -64,7 +150,87 @@ void REI_BasicDraw_RenderPoints(
     REI_BasicDraw* state, REI_Cmd* pCmd, const float mvp[16], float ptsize, uint32_t count, REI_BasicDraw_V_P3** positions,
     uint32_t color);
 
+void REI_BasicDraw_RenderPointBufferSet(
+    REI_BasicDraw* state, REI_Cmd* pCmd, const float mvp[16], float ptsize, REI_BasicDraw_PointFormat format,
+    uint32_t color, uint32_t bufferSet, uint32_t pointCount, uint32_t firstPoint,
+    REI_BasicDraw_PointPath path = REI_BASICDRAW_POINT_PATH_INSTANCED);
+
+bool REI_BasicDraw_BuildPointSetIndex(
+    REI_BasicDraw* state, uint32_t bufferSet, const REI_BasicDraw_PointSetIndexDesc* pDesc);
+void REI_BasicDraw_RemovePointSetIndex(REI_BasicDraw* state, uint32_t bufferSet);
+// Draws the chunks of an indexed buffer set that intersect the frustum of mvp. A chunk covering A pixels on
+// screen draws the smallest level of detail with at least A / pixelsPerPoint points, 0 always draws all points.
+// Returns the number of points drawn.
+uint32_t REI_BasicDraw_RenderPointBufferSetCulled(
+    REI_BasicDraw* state, REI_Cmd* pCmd, const float mvp[16], float ptsize, REI_BasicDraw_PointFormat format,
+    uint32_t color, uint32_t bufferSet, float pixelsPerPoint,
+    REI_BasicDraw_PointPath path = REI_BASICDRAW_POINT_PATH_INSTANCED);
+
+// Compute expansion of registered buffer sets. Expansion is recorded outside of a render pass, after
+// REI_BasicDraw_SetupRender, and closed with REI_BasicDraw_FinishExpandPoints before any
+// REI_BasicDraw_RenderExpandedPoints. Returns the first expanded point or REI_BASICDRAW_EXPAND_FAILED.
+uint32_t REI_BasicDraw_ExpandPoints(
+    REI_BasicDraw* state, REI_Cmd* pCmd, const float mvp[16], float ptsize, REI_BasicDraw_PointFormat format,
+    uint32_t color, uint32_t bufferSet, uint32_t pointCount, uint32_t firstPoint);
+void REI_BasicDraw_FinishExpandPoints(REI_BasicDraw* state, REI_Cmd* pCmd);
+void REI_BasicDraw_RenderExpandedPoints(REI_BasicDraw* state, REI_Cmd* pCmd, uint32_t firstExpanded, uint32_t pointCount);
+
 void REI_BasicDraw_RenderLines(
-    REI_BasicDraw* state, REI_Cmd* pCmd, const float mvp[16], uint32_t count, REI_BasicDraw_Line** line_data);
+    REI_BasicDraw* state, REI_Cmd* pCmd, const float mvp[16], uint32_t count, REI_BasicDraw_Line** line_data,
+    REI_BasicDraw_LinePath path = REI_BASICDRAW_LINE_PATH_INSTANCED);
 void REI_BasicDraw_RenderMesh(
     REI_BasicDraw* state, REI_Cmd* pCmd, const float mvp[16], uint32_t count, REI_BasicDraw_V_P3C** verts);
+
+// Quantized variants, data has to be written with positions inside box
+void REI_BasicDraw_RenderPoints(
+    REI_BasicDraw* state, REI_Cmd* pCmd, const float mvp[16], float ptsize, const REI_BasicDraw_QuantBox* box,
+    uint32_t count, REI_BasicDraw_V_Q3C** point_data);
+void REI_BasicDraw_RenderLines(
+    REI_BasicDraw* state, REI_Cmd* pCmd, const float mvp[16], const REI_BasicDraw_QuantBox* box, uint32_t count,
+    REI_BasicDraw_QLine** line_data, REI_BasicDraw_LinePath path = REI_BASICDRAW_LINE_PATH_INSTANCED);
+
+// Box covering count positions read every stride bytes
+void REI_BasicDraw_ComputeQuantBox(
+    const float* positions, uint32_t count, uint32_t stride, REI_BasicDraw_QuantBox* box);
+// Folds the decoding of box into mvp, used for quantized points of registered buffer sets
+void REI_BasicDraw_QuantizeMVP(const float mvp[16], const REI_BasicDraw_QuantBox* box, float quantizedMVP[16]);
+// Convert to quantized formats, positions are clamped to box. dst may be mapped GPU memory, it is only written
+void REI_BasicDraw_PackPoints(
+    const REI_BasicDraw_QuantBox* box, uint32_t count, const REI_BasicDraw_V_P3C* src, REI_BasicDraw_V_Q3C* dst);
+void REI_BasicDraw_PackLines(
+    const REI_BasicDraw_QuantBox* box, uint32_t count, const REI_BasicDraw_Line* src, REI_BasicDraw_QLine* dst);
+
+// Recording contexts let worker threads record draws between REI_BasicDraw_SetupRender and the end of the frame.
+// Data and uniforms are sub-allocated from the shared per set buffers without locks, draws are kept on the CPU
+// and recorded to the frame command buffer by REI_BasicDraw_FlushContext, in the order contexts are flushed.
+// A context must be used by one thread at a time and flushed every frame it records draws.
+struct REI_BasicDraw_Context;
+
+REI_BasicDraw_Context* REI_BasicDraw_AddContext(REI_BasicDraw* state, uint32_t maxDraws);
+void                   REI_BasicDraw_FlushContext(REI_BasicDraw* state, REI_Cmd* pCmd, REI_BasicDraw_Context* context);
+void                   REI_BasicDraw_RemoveContext(REI_BasicDraw* state, REI_BasicDraw_Context* context);
+
+void REI_BasicDraw_RenderPoints(
+    REI_BasicDraw_Context* context, const float mvp[16], float ptsize, uint32_t count, REI_BasicDraw_V_P3C** point_data);
+void REI_BasicDraw_RenderPoints(
+    REI_BasicDraw_Context* context, const float mvp[16], float ptsize, uint32_t count, REI_BasicDraw_V_P3** positions,
+    uint32_t color);
+void REI_BasicDraw_RenderPointBufferSet(
+    REI_BasicDraw_Context* context, const float mvp[16], float ptsize, REI_BasicDraw_PointFormat format,
+    uint32_t color, uint32_t bufferSet, uint32_t pointCount, uint32_t firstPoint,
+    REI_BasicDraw_PointPath path = REI_BASICDRAW_POINT_PATH_INSTANCED);
+uint32_t REI_BasicDraw_RenderPointBufferSetCulled(
+    REI_BasicDraw_Context* context, const float mvp[16], float ptsize, REI_BasicDraw_PointFormat format,
+    uint32_t color, uint32_t bufferSet, float pixelsPerPoint,
+    REI_BasicDraw_PointPath path = REI_BASICDRAW_POINT_PATH_INSTANCED);
+void REI_BasicDraw_RenderLines(
+    REI_BasicDraw_Context* context, const float mvp[16], uint32_t count, REI_BasicDraw_Line** line_data,
+    REI_BasicDraw_LinePath path = REI_BASICDRAW_LINE_PATH_INSTANCED);
+void REI_BasicDraw_RenderMesh(
+    REI_BasicDraw_Context* context, const float mvp[16], uint32_t count, REI_BasicDraw_V_P3C** verts);
+void REI_BasicDraw_RenderPoints(
+    REI_BasicDraw_Context* context, const float mvp[16], float ptsize, const REI_BasicDraw_QuantBox* box,
+    uint32_t count, REI_BasicDraw_V_Q3C** point_data);
+void REI_BasicDraw_RenderLines(
+    REI_BasicDraw_Context* context, const float mvp[16], const REI_BasicDraw_QuantBox* box, uint32_t count,
+    REI_BasicDraw_QLine** line_data, REI_BasicDraw_LinePath path = REI_BASICDRAW_LINE_PATH_INSTANCED);
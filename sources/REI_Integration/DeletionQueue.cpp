@@ -0,0 +1,137 @@
+/*
+ * Copyright (c) 2023-2024 Dragons Lake, part of Room 8 Group.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you may not use this file except in compliance with the License. You may obtain a copy of the License at 
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software distributed under the License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the License for the specific language governing permissions and limitations under the License.
+ */
+
+#include "DeletionQueue.h"
+
+#include "REI/Common.h"
+
+enum REI_DQ_EntryType
+{
+    REI_DQ_ENTRY_TEXTURE,
+    REI_DQ_ENTRY_BUFFER,
+    REI_DQ_ENTRY_CALLBACK,
+};
+
+struct REI_DQ_Entry
+{
+    REI_DQ_EntryType type;
+    union
+    {
+        REI_Texture*     pTexture;
+        REI_Buffer*      pBuffer;
+        REI_DQ_ReleaseFn pfnRelease;
+    };
+    void*    pUserData;
+    uint64_t value;
+};
+
+struct REI_DQ_State
+{
+    REI_Renderer*          pRenderer;
+    REI_AllocatorCallbacks allocator;
+    uint32_t               resourceSetCount;
+    uint32_t               setIndex;    // set being recorded, ~0u before the first one is begun
+    // One list per resource set
+    REI_vector<REI_DQ_Entry>* pEntries;
+};
+
+static void REI_DQ_execute(REI_DQ_State* pState, const REI_DQ_Entry& entry)
+{
+    switch (entry.type)
+    {
+        case REI_DQ_ENTRY_TEXTURE: REI_removeTexture(pState->pRenderer, entry.pTexture); break;
+        case REI_DQ_ENTRY_BUFFER: REI_removeBuffer(pState->pRenderer, entry.pBuffer); break;
+        case REI_DQ_ENTRY_CALLBACK: entry.pfnRelease(entry.pUserData, entry.value); break;
+    }
+}
+
+static void REI_DQ_executeSet(REI_DQ_State* pState, uint32_t setIndex)
+{
+    REI_vector<REI_DQ_Entry>& entries = pState->pEntries[setIndex];
+    for (const REI_DQ_Entry& entry: entries)
+        REI_DQ_execute(pState, entry);
+    entries.clear();
+}
+
+static void REI_DQ_push(REI_DQ_State* pState, const REI_DQ_Entry& entry)
+{
+    if (pState->setIndex == ~0u)
+        REI_DQ_execute(pState, entry);
+    else
+        pState->pEntries[pState->setIndex].push_back(entry);
+}
+
+void REI_DQ_addDeletionQueue(REI_Renderer* pRenderer, REI_DQ_DeletionQueueDesc* pDesc, REI_DQ_State** ppState)
+{
+    REI_AllocatorCallbacks allocator;
+    REI_setupAllocatorCallbacks(pDesc->pAllocator, allocator);
+
+    REI_DQ_State* pState = REI_new<REI_DQ_State>(allocator);
+    pState->pRenderer = pRenderer;
+    pState->allocator = allocator;
+    pState->resourceSetCount = REI_max(pDesc->resourceSetCount, 1u);
+    pState->setIndex = ~0u;
+    pState->pEntries = (REI_vector<REI_DQ_Entry>*)REI_calloc(
+        allocator, pState->resourceSetCount * sizeof(REI_vector<REI_DQ_Entry>));
+    for (uint32_t i = 0; i < pState->resourceSetCount; ++i)
+        new (&pState->pEntries[i]) REI_vector<REI_DQ_Entry>(REI_allocator<REI_DQ_Entry>(pState->allocator));
+
+    *ppState = pState;
+}
+
+void REI_DQ_removeDeletionQueue(REI_DQ_State* pState)
+{
+    REI_DQ_flush(pState);
+
+    REI_AllocatorCallbacks allocator = pState->allocator;
+    for (uint32_t i = 0; i < pState->resourceSetCount; ++i)
+        pState->pEntries[i].~vector();
+    allocator.pFree(allocator.pUserData, pState->pEntries);
+    REI_delete(allocator, pState);
+}
+
+void REI_DQ_beginResourceSet(REI_DQ_State* pState, uint32_t setIndex)
+{
+    REI_ASSERT(setIndex < pState->resourceSetCount);
+    REI_DQ_executeSet(pState, setIndex);
+    pState->setIndex = setIndex;
+}
+
+void REI_DQ_removeTexture(REI_DQ_State* pState, REI_Texture* pTexture)
+{
+    REI_DQ_Entry entry = {};
+    entry.type = REI_DQ_ENTRY_TEXTURE;
+    entry.pTexture = pTexture;
+    REI_DQ_push(pState, entry);
+}
+
+void REI_DQ_removeBuffer(REI_DQ_State* pState, REI_Buffer* pBuffer)
+{
+    REI_DQ_Entry entry = {};
+    entry.type = REI_DQ_ENTRY_BUFFER;
+    entry.pBuffer = pBuffer;
+    REI_DQ_push(pState, entry);
+}
+
+void REI_DQ_release(REI_DQ_State* pState, REI_DQ_ReleaseFn pfnRelease, void* pUserData, uint64_t value)
+{
+    REI_DQ_Entry entry = {};
+    entry.type = REI_DQ_ENTRY_CALLBACK;
+    entry.pfnRelease = pfnRelease;
+    entry.pUserData = pUserData;
+    entry.value = value;
+    REI_DQ_push(pState, entry);
+}
+
+void REI_DQ_flush(REI_DQ_State* pState)
+{
+    for (uint32_t i = 0; i < pState->resourceSetCount; ++i)
+        REI_DQ_executeSet(pState, i);
+}
@@ -0,0 +1,45 @@
+/*
+ * Copyright (c) 2023-2024 Dragons Lake, part of Room 8 Group.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you may not use this file except in compliance with the License. You may obtain a copy of the License at 
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software distributed under the License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the License for the specific language governing permissions and limitations under the License.
+ */
+
+#pragma once
+
+#include "REI/Renderer.h"
+
+// Defers removal of resources that command buffers in flight may still reference. Removals are tagged with the
+// resource set being recorded and are executed when that set is begun again. Integrations already rely on the
+// application waiting for the fence of a resource set before reusing it, which makes that point safe.
+// A deletion queue is not thread safe, it is meant to be owned by a single integration.
+
+typedef void (*REI_DQ_ReleaseFn)(void* pUserData, uint64_t value);
+
+typedef struct REI_DQ_DeletionQueueDesc
+{
+    uint32_t                      resourceSetCount;
+    const REI_AllocatorCallbacks* pAllocator;
+} REI_DQ_DeletionQueueDesc;
+
+struct REI_DQ_State;
+
+void REI_DQ_addDeletionQueue(REI_Renderer* pRenderer, REI_DQ_DeletionQueueDesc* pDesc, REI_DQ_State** ppState);
+// Executes everything still queued, the GPU must be done with all of it
+void REI_DQ_removeDeletionQueue(REI_DQ_State* pState);
+
+// Call before recording into setIndex, once the fence of its previous use has passed. Executes the removals
+// queued while setIndex was recorded last time. Removals queued before the first set is begun are executed
+// right away
+void REI_DQ_beginResourceSet(REI_DQ_State* pState, uint32_t setIndex);
+
+void REI_DQ_removeTexture(REI_DQ_State* pState, REI_Texture* pTexture);
+void REI_DQ_removeBuffer(REI_DQ_State* pState, REI_Buffer* pBuffer);
+// Defers a call to pfnRelease, for state that lives as long as the resources do, like descriptor table indices
+void REI_DQ_release(REI_DQ_State* pState, REI_DQ_ReleaseFn pfnRelease, void* pUserData, uint64_t value);
+
+// Executes everything queued, the GPU must be done with all of it
+void REI_DQ_flush(REI_DQ_State* pState);
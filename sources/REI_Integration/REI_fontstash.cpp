@@ -20,16 +20,69 @@
 #        define WIN32_LEAN_AND_MEAN 1
 #    endif
 #    include "windows.h"
+#else
+#    include <fcntl.h>
+#    include <sys/mman.h>
+#    include <sys/stat.h>
+#    include <unistd.h>
 #endif
 #define FONTSTASH_IMPLEMENTATION
 
 #include "REI_fontstash.h"
+#include "DeletionQueue.h"
+
+#include "REI/Thread.h"
 
 #ifdef _WIN32
 #    define strcpy strcpy_s
 #endif
 
+#if defined(_M_X64) || defined(_M_IX86) || defined(__SSE2__)
+#    include <emmintrin.h>
+#    define REI_FONTSTASH_SSE2
+#endif
+
 static const uint32_t MAX_SHADER_COUNT = 2;
+static const uint32_t MAX_DIRTY_RECTS = 32;
+static const uint32_t MAX_PENDING_UPLOADS = 32;
+static const uint32_t MAX_GLYPH_THREAD_COUNT = 8;
+
+// Atlas copy started by the resource loader
+struct REI_Fontstash_Upload
+{
+    REI_RL_RequestId token;
+};
+
+struct REI_Fontstash_GlyphTask
+{
+    FONSglyphJob   job;
+    unsigned char* pixels;    // job.width * job.height, filled by a worker
+};
+
+// Glyphs fontstash hands off through FONSparams::renderGlyph, rasterized by worker threads into their own memory
+struct REI_Fontstash_Workers
+{
+    REI_Fontstash_Workers(const REI_AllocatorCallbacks& allocator):
+        queued(REI_allocator<REI_Fontstash_GlyphTask>(allocator)),
+        finished(REI_allocator<REI_Fontstash_GlyphTask>(allocator)),
+        collected(REI_allocator<REI_Fontstash_GlyphTask>(allocator))
+    {
+    }
+
+    Mutex                               mutex;
+    ConditionVariable                   cond;
+    ConditionVariable                   idleCond;
+    // Workers take tasks from queueHead on, the vector is cleared once all were taken
+    REI_vector<REI_Fontstash_GlyphTask> queued;
+    size_t                              queueHead;
+    REI_vector<REI_Fontstash_GlyphTask> finished;
+    REI_vector<REI_Fontstash_GlyphTask> collected;
+    uint32_t                            busy;
+    bool                                run;
+    ThreadDesc                          threadDesc;
+    ThreadHandle                        threads[MAX_GLYPH_THREAD_COUNT];
+    uint32_t                            threadCount;
+};
 
 struct REI_Fontstash_State
 {
@@ -38,16 +91,79 @@ struct REI_Fontstash_State
     REI_AllocatorCallbacks    allocator;
     REI_Queue*                queue;
     REI_RL_State*             loader;
+    REI_DQ_State*             deletionQueue;
     REI_RootSignature*        rootSignature;
     REI_DescriptorTableArray* descriptorSet;
     REI_Pipeline*             pipeline;
+    REI_Pipeline*             quadPipeline;
     REI_Sampler*              fontSampler;
     REI_Texture*              fontTexture;
     REI_Buffer**              buffers;
     void**                    buffersAddr;
+    REI_Buffer**              quadBuffers;
+    void**                    quadBuffersAddr;
     uint32_t                  setIndex;
     uint32_t                  vertexCount;
+    uint32_t                  maxVertexCount;
+    uint32_t                  quadCount;
+    uint32_t                  maxQuadCount;
     uint32_t                  fontTextureWidth;
+    // Each resource set binds its own table, updated when the font texture was recreated since its last use
+    uint32_t                  fontTextureGeneration;
+    uint32_t*                 tableGenerations;
+    // Glyphs rasterized during the frame, merged and uploaded by REI_Fontstash_FlushUploads
+    const unsigned char*      texData;
+    int                       dirtyRects[MAX_DIRTY_RECTS][4];
+    uint32_t                  dirtyRectCount;
+    REI_Fontstash_Upload      uploads[MAX_PENDING_UPLOADS];
+    uint32_t                  uploadCount;
+    // Atlas file of REI_Fontstash_Desc::pBakedAtlasPath, mapped until shutdown since fonts use its font data
+    const uint8_t*            bakedAtlas;
+    size_t                    bakedAtlasSize;
+    void*                     bakedAtlasMapping;
+    FONScontext*              ctx;
+    REI_Fontstash_Workers*    glyphWorkers;
+};
+
+// Atlas file written by REI_Fontstash_BakeAtlas. Offsets are from the start of the file and 4 byte aligned, the
+// file holds the atlas nodes, a table per font, the glyphs of every font, the font files and the atlas texels
+static const uint32_t BAKED_ATLAS_MAGIC = 0x41425346;    // "FSBA"
+static const uint32_t BAKED_ATLAS_VERSION = 1;
+
+struct REI_Fontstash_BakedHeader
+{
+    uint32_t magic;
+    uint32_t version;
+    int32_t  width;
+    int32_t  height;
+    int32_t  sdfSize;    // 0 for coverage glyphs
+    int32_t  sdfPadding;
+    int32_t  nodeCount;
+    int32_t  fontCount;
+    uint32_t nodesOffset;
+    uint32_t fontsOffset;
+    uint32_t texelsOffset;
+};
+
+struct REI_Fontstash_BakedFont
+{
+    char     name[64];
+    uint32_t dataOffset;
+    int32_t  dataSize;
+    uint32_t glyphsOffset;
+    int32_t  glyphCount;
+    int32_t  fallbackCount;
+    int32_t  fallbacks[FONS_MAX_FALLBACKS];
+};
+
+struct REI_Fontstash_BakedGlyph
+{
+    uint32_t codepoint;
+    int32_t  index;
+    int16_t  size, blur;
+    int16_t  x0, y0, x1, y1;
+    int16_t  xadv, xoff, yoff;
+    int16_t  reserved;
 };
 
 
@@ -55,6 +171,10 @@ struct REI_Fontstash_State
 
 #include "shaderbin/fontstash_ps.bin.h"
 
+#include "shaderbin/fontstash_sdf_ps.bin.h"
+
+#include "shaderbin/fontstash_quad_vs.bin.h"
+
 struct FontVert
 {
     float    pos[2];
@@ -62,15 +182,39 @@ struct FontVert
     uint32_t col;
 };
 
+// One glyph drawn by REI_Fontstash_DrawText, expanded to 6 vertices by fontstash_quad_vs
+struct FontQuad
+{
+    int16_t  pos[4];    // x0, y0, x1, y1 in pixels
+    uint16_t uv[4];     // s0, t0, s1, t1 in atlas texels
+    uint32_t col;
+};
+
+struct FontConstants
+{
+    float scaleTranslate[4];
+    float invTexSize[2];
+};
+
 #define OFFSETOF(type, mem) ((size_t)(&(((type*)0)->mem)))
 
+static void REI_Fontstash_collectGlyphs(REI_Fontstash_State* state, bool wait);
+
 static int REI_Fontstash_renderResize(void* userPtr, int width, int height)
 {
     REI_Fontstash_State* state = (REI_Fontstash_State*)userPtr;
-    REI_waitQueueIdle(state->queue);
+
+    // Glyph rects are only valid in the atlas they were packed into, fontstash copies the finished glyphs over
+    REI_Fontstash_collectGlyphs(state, true);
+
+    // fontstash marks the preserved part of the atlas dirty after the resize, pending copies target the old texture
+    for (uint32_t i = 0; i < state->uploadCount; ++i)
+        REI_RL_waitTokenCompleted(state->loader, state->uploads[i].token);
+    state->uploadCount = 0;
+    state->dirtyRectCount = 0;
 
     if (state->fontTexture)
-        REI_removeTexture(state->renderer, state->fontTexture);
+        REI_DQ_removeTexture(state->deletionQueue, state->fontTexture);
 
     REI_TextureDesc textureDesc{};
     textureDesc.flags = REI_TEXTURE_CREATION_FLAG_OWN_MEMORY_BIT;
@@ -81,14 +225,7 @@ static int REI_Fontstash_renderResize(void* userPtr, int width, int height)
     REI_addTexture(state->renderer, &textureDesc, &state->fontTexture);
 
     state->fontTextureWidth = width;
-
-    REI_DescriptorData params[1] = {};
-    params[0].descriptorType = REI_DESCRIPTOR_TYPE_TEXTURE;
-    params[0].descriptorIndex = 0;    //uTexture;
-    params[0].ppTextures = &state->fontTexture;
-    params[0].count = 1;
-    params[0].tableIndex = 0;
-    REI_updateDescriptorTableArray(state->renderer, state->descriptorSet, 1, params);
+    ++state->fontTextureGeneration;
 
     return 1;
 }
@@ -96,12 +233,15 @@ static int REI_Fontstash_renderResize(void* userPtr, int width, int height)
 static int REI_Fontstash_renderCreate(void* userPtr, int width, int height)
 {
     REI_Fontstash_State* state = (REI_Fontstash_State*)userPtr;
-    REI_ShaderDesc       shaderDesc[MAX_SHADER_COUNT] = {
+    const bool           sdf = state->desc.sdfSize != 0;
+    REI_ShaderDesc       shaderDesc[MAX_SHADER_COUNT + 1] = {
         { REI_SHADER_STAGE_VERT, (uint8_t*)fontstash_vs_bytecode, sizeof(fontstash_vs_bytecode) },
-        { REI_SHADER_STAGE_FRAG, (uint8_t*)fontstash_ps_bytecode, sizeof(fontstash_ps_bytecode) }
+        { REI_SHADER_STAGE_FRAG, sdf ? (uint8_t*)fontstash_sdf_ps_bytecode : (uint8_t*)fontstash_ps_bytecode,
+          sdf ? sizeof(fontstash_sdf_ps_bytecode) : sizeof(fontstash_ps_bytecode) },
+        { REI_SHADER_STAGE_VERT, (uint8_t*)fontstash_quad_vs_bytecode, sizeof(fontstash_quad_vs_bytecode) }
     };
-    REI_Shader* shaders[MAX_SHADER_COUNT] = {};
-    REI_addShaders(state->renderer, shaderDesc, MAX_SHADER_COUNT, shaders);
+    REI_Shader* shaders[MAX_SHADER_COUNT + 1] = {};
+    REI_addShaders(state->renderer, shaderDesc, MAX_SHADER_COUNT + 1, shaders);
 
     REI_SamplerDesc samplerDesc = {
         REI_FILTER_LINEAR,
@@ -120,7 +260,7 @@ static int REI_Fontstash_renderCreate(void* userPtr, int width, int height)
 
     REI_PushConstantRange pConst = {};
     pConst.offset = 0;
-    pConst.size = sizeof(float[4]);
+    pConst.size = sizeof(FontConstants);
     pConst.stageFlags = REI_SHADER_STAGE_VERT;
 
     REI_DescriptorBinding binding = {};
@@ -156,7 +296,7 @@ static int REI_Fontstash_renderCreate(void* userPtr, int width, int height)
 
     REI_DescriptorTableArrayDesc descriptorSetDesc = {};
     descriptorSetDesc.pRootSignature = state->rootSignature;
-    descriptorSetDesc.maxTables = 1;
+    descriptorSetDesc.maxTables = state->desc.resourceSetCount;
     descriptorSetDesc.slot = REI_DESCRIPTOR_TABLE_SLOT_1;
     REI_addDescriptorTableArray(state->renderer, &descriptorSetDesc, &state->descriptorSet);
 
@@ -206,7 +346,32 @@ static int REI_Fontstash_renderCreate(void* userPtr, int width, int height)
     graphicsDesc.pBlendState = &blendState;
     REI_addPipeline(state->renderer, &pipelineDesc, &state->pipeline);
 
-    REI_removeShaders(state->renderer, MAX_SHADER_COUNT, shaders);
+    if (state->desc.quadBufferSize)
+    {
+        REI_VertexAttrib quadAttribs[vertexAttribCount] = {};
+        quadAttribs[0].semantic = REI_SEMANTIC_POSITION0;
+        quadAttribs[0].offset = OFFSETOF(FontQuad, pos);
+        quadAttribs[0].location = 0;
+        quadAttribs[0].format = REI_FMT_R16G16B16A16_SINT;
+        quadAttribs[0].rate = REI_VERTEX_ATTRIB_RATE_INSTANCE;
+        quadAttribs[1].semantic = REI_SEMANTIC_TEXCOORD0;
+        quadAttribs[1].offset = OFFSETOF(FontQuad, uv);
+        quadAttribs[1].location = 1;
+        quadAttribs[1].format = REI_FMT_R16G16B16A16_UINT;
+        quadAttribs[1].rate = REI_VERTEX_ATTRIB_RATE_INSTANCE;
+        quadAttribs[2].semantic = REI_SEMANTIC_COLOR0;
+        quadAttribs[2].offset = OFFSETOF(FontQuad, col);
+        quadAttribs[2].location = 2;
+        quadAttribs[2].format = REI_FMT_R8G8B8A8_UNORM;
+        quadAttribs[2].rate = REI_VERTEX_ATTRIB_RATE_INSTANCE;
+
+        REI_Shader* quadShaders[MAX_SHADER_COUNT] = { shaders[2], shaders[1] };
+        graphicsDesc.ppShaderPrograms = quadShaders;
+        graphicsDesc.pVertexAttribs = quadAttribs;
+        REI_addPipeline(state->renderer, &pipelineDesc, &state->quadPipeline);
+    }
+
+    REI_removeShaders(state->renderer, MAX_SHADER_COUNT + 1, shaders);
 
     REI_BufferDesc vbDesc = {};
     vbDesc.descriptors = REI_DESCRIPTOR_TYPE_BUFFER | REI_DESCRIPTOR_TYPE_VERTEX_BUFFER;
@@ -224,39 +389,262 @@ static int REI_Fontstash_renderCreate(void* userPtr, int width, int height)
         REI_addBuffer(state->renderer, &vbDesc, &state->buffers[i]);
         REI_mapBuffer(state->renderer, state->buffers[i], &state->buffersAddr[i]);
     }
+    state->maxVertexCount = (uint32_t)(state->desc.vertexBufferSize / sizeof(FontVert));
+
+    if (state->desc.quadBufferSize)
+    {
+        REI_BufferDesc qbDesc = vbDesc;
+        qbDesc.vertexStride = sizeof(FontQuad);
+        qbDesc.structStride = sizeof(FontQuad);
+        qbDesc.size = state->desc.quadBufferSize;
+        qbDesc.elementCount = qbDesc.size / qbDesc.structStride;
+
+        state->quadBuffers =
+            (REI_Buffer**)REI_calloc(state->allocator, state->desc.resourceSetCount * sizeof(REI_Buffer*));
+        state->quadBuffersAddr = (void**)REI_calloc(state->allocator, state->desc.resourceSetCount * sizeof(void*));
+        for (uint32_t i = 0; i < state->desc.resourceSetCount; ++i)
+        {
+            REI_addBuffer(state->renderer, &qbDesc, &state->quadBuffers[i]);
+            REI_mapBuffer(state->renderer, state->quadBuffers[i], &state->quadBuffersAddr[i]);
+        }
+        state->maxQuadCount = (uint32_t)(state->desc.quadBufferSize / sizeof(FontQuad));
+    }
+
+    state->tableGenerations =
+        (uint32_t*)REI_calloc(state->allocator, state->desc.resourceSetCount * sizeof(uint32_t));
+
+    REI_DQ_DeletionQueueDesc deletionQueueDesc = { state->desc.resourceSetCount, &state->allocator };
+    REI_DQ_addDeletionQueue(state->renderer, &deletionQueueDesc, &state->deletionQueue);
 
     REI_Fontstash_renderResize(userPtr, width, height);
 
     return 1;
 }
 
+static bool REI_Fontstash_rectsTouch(const int* a, const int* b)
+{
+    return a[0] <= b[2] && b[0] <= a[2] && a[1] <= b[3] && b[1] <= a[3];
+}
+
+static void REI_Fontstash_unionRect(int* dst, const int* src)
+{
+    dst[0] = REI_min(dst[0], src[0]);
+    dst[1] = REI_min(dst[1], src[1]);
+    dst[2] = REI_max(dst[2], src[2]);
+    dst[3] = REI_max(dst[3], src[3]);
+}
+
+static int64_t REI_Fontstash_rectArea(const int* r) { return (int64_t)(r[2] - r[0]) * (r[3] - r[1]); }
+
 static void REI_Fontstash_renderUpdate(void* userPtr, int* rect, const unsigned char* data)
 {
     REI_Fontstash_State* state = (REI_Fontstash_State*)userPtr;
+    state->texData = data;
 
-    uint32_t                 width = state->fontTextureWidth;
-    REI_RL_TextureUpdateDesc updateDesc = { state->fontTexture,
-                                            (uint8_t*)data + rect[1] * width,
-                                            REI_FMT_R8_UNORM,
-                                            0,
-                                            (uint32_t)rect[1],
-                                            0,
-                                            width,
-                                            (uint32_t)(rect[3] - rect[1]),
-                                            1,
-                                            0,
-                                            0,
-                                            REI_RESOURCE_STATE_SHADER_RESOURCE };
-    REI_RL_updateResource(state->loader, &updateDesc);
+    // Rects overlapping or touching the new one are folded into it, the grown rect may reach further ones
+    int merged[4] = { rect[0], rect[1], rect[2], rect[3] };
+    for (uint32_t i = 0; i < state->dirtyRectCount;)
+    {
+        if (REI_Fontstash_rectsTouch(merged, state->dirtyRects[i]))
+        {
+            REI_Fontstash_unionRect(merged, state->dirtyRects[i]);
+            memcpy(state->dirtyRects[i], state->dirtyRects[--state->dirtyRectCount], sizeof(merged));
+            i = 0;
+        }
+        else
+        {
+            ++i;
+        }
+    }
+
+    if (state->dirtyRectCount < MAX_DIRTY_RECTS)
+    {
+        memcpy(state->dirtyRects[state->dirtyRectCount++], merged, sizeof(merged));
+        return;
+    }
+
+    // No room left, the rect goes into the one that grows the least
+    uint32_t best = 0;
+    int64_t  bestGrowth = INT64_MAX;
+    for (uint32_t i = 0; i < state->dirtyRectCount; ++i)
+    {
+        int grown[4] = { merged[0], merged[1], merged[2], merged[3] };
+        REI_Fontstash_unionRect(grown, state->dirtyRects[i]);
+        int64_t growth = REI_Fontstash_rectArea(grown) - REI_Fontstash_rectArea(state->dirtyRects[i]);
+        if (growth < bestGrowth)
+        {
+            best = i;
+            bestGrowth = growth;
+        }
+    }
+    REI_Fontstash_unionRect(state->dirtyRects[best], merged);
 }
 
-static void REI_Fontstash_renderDraw(
-    void* userPtr, const float* verts, const float* tcoords, const unsigned int* colors, int nverts)
+// Drops uploads the loader has finished, keeping the rest in submission order
+static void REI_Fontstash_retireUploads(REI_Fontstash_State* state)
 {
-    REI_Fontstash_State* state = (REI_Fontstash_State*)userPtr;
+    uint32_t count = 0;
+    for (uint32_t i = 0; i < state->uploadCount; ++i)
+    {
+        if (!REI_RL_isTokenCompleted(state->loader, state->uploads[i].token))
+            state->uploads[count++] = state->uploads[i];
+    }
+    state->uploadCount = count;
+}
 
-    FontVert* vptr = ((FontVert*)state->buffersAddr[state->setIndex]) + state->vertexCount;
-    for (int i = 0; i < nverts; ++i)
+static void REI_Fontstash_glyphThreadFunc(void* pThreadData)
+{
+    REI_Fontstash_State*   state = (REI_Fontstash_State*)pThreadData;
+    REI_Fontstash_Workers* workers = state->glyphWorkers;
+
+    workers->mutex.Acquire();
+    while (1)
+    {
+        while (workers->run && workers->queueHead == workers->queued.size())
+        {
+            workers->cond.Wait(workers->mutex);
+        }
+        if (!workers->run)
+        {
+            break;
+        }
+
+        REI_Fontstash_GlyphTask task = workers->queued[workers->queueHead++];
+        ++workers->busy;
+        workers->mutex.Release();
+
+        task.pixels = (unsigned char*)REI_calloc(state->allocator, (size_t)task.job.width * task.job.height);
+        fonsRenderGlyphJob(&task.job, task.pixels, task.job.width);
+
+        workers->mutex.Acquire();
+        workers->finished.push_back(task);
+        --workers->busy;
+        if (workers->queueHead == workers->queued.size() && !workers->busy)
+            workers->idleCond.WakeAll();
+    }
+    workers->mutex.Release();
+}
+
+static int REI_Fontstash_renderGlyph(void* userPtr, const FONSglyphJob* job)
+{
+    REI_Fontstash_State*   state = (REI_Fontstash_State*)userPtr;
+    REI_Fontstash_Workers* workers = state->glyphWorkers;
+    if (!workers)
+        return 0;
+
+    workers->mutex.Acquire();
+    if (workers->queueHead == workers->queued.size())
+    {
+        workers->queued.clear();
+        workers->queueHead = 0;
+    }
+    workers->queued.push_back({ *job, NULL });
+    workers->cond.WakeOne();
+    workers->mutex.Release();
+    return 1;
+}
+
+// Copies the glyphs workers finished over their placeholders, the rects go into the next batched upload. With wait
+// every queued glyph is finished first
+static void REI_Fontstash_collectGlyphs(REI_Fontstash_State* state, bool wait)
+{
+    REI_Fontstash_Workers* workers = state->glyphWorkers;
+    if (!workers)
+        return;
+
+    workers->mutex.Acquire();
+    while (wait && (workers->queueHead != workers->queued.size() || workers->busy))
+    {
+        workers->idleCond.Wait(workers->mutex);
+    }
+    workers->collected.swap(workers->finished);
+    workers->mutex.Release();
+
+    FONScontext* ctx = state->ctx;
+    for (const REI_Fontstash_GlyphTask& task : workers->collected)
+    {
+        const FONSglyphJob& job = task.job;
+        for (int y = 0; y < job.height; ++y)
+        {
+            memcpy(
+                ctx->texData + (size_t)(job.y + y) * ctx->params.width + job.x, task.pixels + (size_t)y * job.width,
+                (size_t)job.width);
+        }
+        int rect[4] = { job.x, job.y, job.x + job.width, job.y + job.height };
+        REI_Fontstash_renderUpdate(state, rect, ctx->texData);
+        state->allocator.pFree(state->allocator.pUserData, task.pixels);
+    }
+    workers->collected.clear();
+}
+
+static void REI_Fontstash_addGlyphWorkers(REI_Fontstash_State* state)
+{
+    REI_Fontstash_Workers* workers = REI_new<REI_Fontstash_Workers>(state->allocator, state->allocator);
+    workers->run = true;
+    workers->threadCount = REI_min(state->desc.glyphThreadCount, MAX_GLYPH_THREAD_COUNT);
+    workers->threadDesc.pFunc = REI_Fontstash_glyphThreadFunc;
+    workers->threadDesc.pData = state;
+    state->glyphWorkers = workers;
+
+    for (uint32_t i = 0; i < workers->threadCount; ++i)
+    {
+        workers->threads[i] = create_thread(&workers->threadDesc);
+    }
+}
+
+static void REI_Fontstash_removeGlyphWorkers(REI_Fontstash_State* state)
+{
+    REI_Fontstash_Workers* workers = state->glyphWorkers;
+    if (!workers)
+        return;
+
+    workers->mutex.Acquire();
+    workers->run = false;
+    workers->cond.WakeAll();
+    workers->mutex.Release();
+    for (uint32_t i = 0; i < workers->threadCount; ++i)
+    {
+        destroy_thread(workers->threads[i]);
+    }
+
+    for (const REI_Fontstash_GlyphTask& task : workers->finished)
+        state->allocator.pFree(state->allocator.pUserData, task.pixels);
+
+    REI_delete(state->allocator, workers);
+    state->glyphWorkers = NULL;
+}
+
+// Interleaves fontstash's split position, texcoord and color arrays into FontVert
+void REI_Fontstash_InterleaveVertices(
+    void* pDst, const float* verts, const float* tcoords, const unsigned int* colors, uint32_t count)
+{
+    FontVert* vptr = (FontVert*)pDst;
+    uint32_t  i = 0;
+#ifdef REI_FONTSTASH_SSE2
+    // 4 vertices are 5 registers of output
+    float* dst = (float*)pDst;
+    for (; i + 4 <= count; i += 4, dst += 20)
+    {
+        __m128 p0 = _mm_loadu_ps(verts + i * 2);        // x0 y0 x1 y1
+        __m128 p1 = _mm_loadu_ps(verts + i * 2 + 4);    // x2 y2 x3 y3
+        __m128 t0 = _mm_loadu_ps(tcoords + i * 2);      // s0 t0 s1 t1
+        __m128 t1 = _mm_loadu_ps(tcoords + i * 2 + 4);  // s2 t2 s3 t3
+        __m128 c = _mm_castsi128_ps(_mm_loadu_si128((const __m128i*)(colors + i)));
+
+        __m128 v1 = _mm_movehl_ps(t0, p0);    // x1 y1 s1 t1
+        __m128 t1c1 = _mm_shuffle_ps(t0, c, _MM_SHUFFLE(1, 1, 3, 3));
+        __m128 c2x3 = _mm_shuffle_ps(c, p1, _MM_SHUFFLE(2, 2, 2, 2));
+        __m128 y3s3 = _mm_shuffle_ps(p1, t1, _MM_SHUFFLE(2, 2, 3, 3));
+        __m128 t3c3 = _mm_shuffle_ps(t1, c, _MM_SHUFFLE(3, 3, 3, 3));
+
+        _mm_storeu_ps(dst, _mm_movelh_ps(p0, t0));
+        _mm_storeu_ps(dst + 4, _mm_move_ss(_mm_castsi128_ps(_mm_slli_si128(_mm_castps_si128(v1), 4)), c));
+        _mm_storeu_ps(dst + 8, _mm_shuffle_ps(t1c1, p1, _MM_SHUFFLE(1, 0, 2, 0)));
+        _mm_storeu_ps(dst + 12, _mm_shuffle_ps(t1, c2x3, _MM_SHUFFLE(2, 0, 1, 0)));
+        _mm_storeu_ps(dst + 16, _mm_shuffle_ps(y3s3, t3c3, _MM_SHUFFLE(2, 0, 2, 0)));
+    }
+#endif
+    for (; i < count; ++i)
     {
         vptr[i].pos[0] = verts[i * 2];
         vptr[i].pos[1] = verts[i * 2 + 1];
@@ -264,13 +652,38 @@ static void REI_Fontstash_renderDraw(
         vptr[i].uv[1] = tcoords[i * 2 + 1];
         vptr[i].col = colors[i];
     }
-    state->vertexCount += nverts;
 }
 
+static void REI_Fontstash_renderDraw(
+    void* userPtr, const float* verts, const float* tcoords, const unsigned int* colors, int nverts)
+{
+    REI_Fontstash_State* state = (REI_Fontstash_State*)userPtr;
+
+    // Whole triangles that still fit the buffer of the set are kept, the rest is dropped
+    uint32_t count = REI_min((uint32_t)nverts, state->maxVertexCount - state->vertexCount);
+    count -= count % 3;
+
+    FontVert* vptr = ((FontVert*)state->buffersAddr[state->setIndex]) + state->vertexCount;
+    REI_Fontstash_InterleaveVertices(vptr, verts, tcoords, colors, count);
+    state->vertexCount += count;
+}
+
+static void REI_Fontstash_unmapBakedAtlas(REI_Fontstash_State* state);
+
 static void REI_Fontstash_renderDelete(void* userPtr)
 {
     REI_Fontstash_State* state = (REI_Fontstash_State*)userPtr;
 
+    // Workers read the fonts, which are freed after this callback
+    REI_Fontstash_removeGlyphWorkers(state);
+
+    for (uint32_t i = 0; i < state->uploadCount; ++i)
+        REI_RL_waitTokenCompleted(state->loader, state->uploads[i].token);
+
+    if (state->deletionQueue)
+        REI_DQ_removeDeletionQueue(state->deletionQueue);
+    state->allocator.pFree(state->allocator.pUserData, state->tableGenerations);
+
     for (uint32_t i = 0; i < state->desc.resourceSetCount; ++i)
     {
         REI_removeBuffer(state->renderer, state->buffers[i]);
@@ -278,6 +691,16 @@ static void REI_Fontstash_renderDelete(void* userPtr)
     state->allocator.pFree(state->allocator.pUserData, state->buffers);
     state->allocator.pFree(state->allocator.pUserData, state->buffersAddr);
 
+    if (state->quadBuffers)
+    {
+        for (uint32_t i = 0; i < state->desc.resourceSetCount; ++i)
+        {
+            REI_removeBuffer(state->renderer, state->quadBuffers[i]);
+        }
+        state->allocator.pFree(state->allocator.pUserData, state->quadBuffers);
+        state->allocator.pFree(state->allocator.pUserData, state->quadBuffersAddr);
+    }
+
     if (state->fontTexture)
     {
         REI_removeTexture(state->renderer, state->fontTexture);
@@ -298,15 +721,244 @@ static void REI_Fontstash_renderDelete(void* userPtr)
         REI_removePipeline(state->renderer, state->pipeline);
         state->pipeline = NULL;
     }
+    if (state->quadPipeline)
+    {
+        REI_removePipeline(state->renderer, state->quadPipeline);
+        state->quadPipeline = NULL;
+    }
     if (state->descriptorSet)
     {
         REI_removeDescriptorTableArray(state->renderer, state->descriptorSet);
         state->descriptorSet = NULL;
     }
 
+    // Fonts are freed after this callback, they never free or read the data they point to in the mapping
+    REI_Fontstash_unmapBakedAtlas(state);
+
     state->allocator.pFree(state->allocator.pUserData, state);
 }
 
+static void REI_Fontstash_unmapBakedAtlas(REI_Fontstash_State* state)
+{
+    if (!state->bakedAtlas)
+        return;
+
+#ifdef _WIN32
+    UnmapViewOfFile(state->bakedAtlas);
+    CloseHandle((HANDLE)state->bakedAtlasMapping);
+#else
+    munmap((void*)state->bakedAtlas, state->bakedAtlasSize);
+#endif
+    state->bakedAtlas = NULL;
+}
+
+static bool REI_Fontstash_mapBakedAtlas(REI_Fontstash_State* state, const char* path)
+{
+#ifdef _WIN32
+    HANDLE file = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+    if (file == INVALID_HANDLE_VALUE)
+        return false;
+
+    LARGE_INTEGER fileSize;
+    HANDLE        mapping = NULL;
+    if (GetFileSizeEx(file, &fileSize) && fileSize.QuadPart)
+        mapping = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+    CloseHandle(file);
+    if (!mapping)
+        return false;
+
+    state->bakedAtlas = (const uint8_t*)MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+    if (!state->bakedAtlas)
+    {
+        CloseHandle(mapping);
+        return false;
+    }
+    state->bakedAtlasSize = (size_t)fileSize.QuadPart;
+    state->bakedAtlasMapping = mapping;
+#else
+    int file = open(path, O_RDONLY);
+    if (file < 0)
+        return false;
+
+    struct stat fileStat;
+    void*       data = MAP_FAILED;
+    if (fstat(file, &fileStat) == 0 && fileStat.st_size)
+        data = mmap(NULL, (size_t)fileStat.st_size, PROT_READ, MAP_PRIVATE, file, 0);
+    close(file);
+    if (data == MAP_FAILED)
+        return false;
+
+    state->bakedAtlas = (const uint8_t*)data;
+    state->bakedAtlasSize = (size_t)fileStat.st_size;
+#endif
+    return true;
+}
+
+static bool REI_Fontstash_bakedRangeValid(uint64_t offset, uint64_t size, uint64_t fileSize)
+{
+    return (offset & 3) == 0 && offset <= fileSize && size <= fileSize - offset;
+}
+
+// Everything the loader reads has to be inside the file
+static const REI_Fontstash_BakedHeader* REI_Fontstash_validateBakedAtlas(const uint8_t* file, size_t fileSize)
+{
+    if (fileSize < sizeof(REI_Fontstash_BakedHeader))
+        return NULL;
+
+    const REI_Fontstash_BakedHeader* header = (const REI_Fontstash_BakedHeader*)file;
+    if (header->magic != BAKED_ATLAS_MAGIC || header->version != BAKED_ATLAS_VERSION || header->width <= 0 ||
+        header->height <= 0 || header->width > 0x8000 || header->height > 0x8000 || header->sdfSize < 0 ||
+        (header->sdfSize && header->sdfPadding < 1) || header->nodeCount <= 0 || header->fontCount < 0 ||
+        !REI_Fontstash_bakedRangeValid(header->nodesOffset, (uint64_t)header->nodeCount * sizeof(FONSatlasNode), fileSize) ||
+        !REI_Fontstash_bakedRangeValid(
+            header->fontsOffset, (uint64_t)header->fontCount * sizeof(REI_Fontstash_BakedFont), fileSize) ||
+        !REI_Fontstash_bakedRangeValid(header->texelsOffset, (uint64_t)header->width * header->height, fileSize))
+        return NULL;
+
+    // The packer places new glyphs on top of the nodes, so they have to lie inside the atlas
+    const FONSatlasNode* nodes = (const FONSatlasNode*)(file + header->nodesOffset);
+    for (int32_t i = 0; i < header->nodeCount; ++i)
+    {
+        const FONSatlasNode& node = nodes[i];
+        if (node.x < 0 || node.y < 0 || node.width < 0 || node.x + node.width > header->width ||
+            node.y > header->height)
+            return NULL;
+    }
+
+    const REI_Fontstash_BakedFont* fonts = (const REI_Fontstash_BakedFont*)(file + header->fontsOffset);
+    for (int32_t i = 0; i < header->fontCount; ++i)
+    {
+        const REI_Fontstash_BakedFont& font = fonts[i];
+        if (font.dataSize <= 0 || font.glyphCount < 0 || font.fallbackCount < 0 ||
+            font.fallbackCount > FONS_MAX_FALLBACKS || !memchr(font.name, 0, sizeof(font.name)) ||
+            !REI_Fontstash_bakedRangeValid(font.dataOffset, (uint64_t)font.dataSize, fileSize) ||
+            !REI_Fontstash_bakedRangeValid(
+                font.glyphsOffset, (uint64_t)font.glyphCount * sizeof(REI_Fontstash_BakedGlyph), fileSize))
+            return NULL;
+
+        const REI_Fontstash_BakedGlyph* glyphs = (const REI_Fontstash_BakedGlyph*)(file + font.glyphsOffset);
+        for (int32_t g = 0; g < font.glyphCount; ++g)
+        {
+            const REI_Fontstash_BakedGlyph& glyph = glyphs[g];
+            if (glyph.x0 < 0 || glyph.y0 < 0 || glyph.x0 > glyph.x1 || glyph.y0 > glyph.y1 ||
+                glyph.x1 > header->width || glyph.y1 > header->height)
+                return NULL;
+        }
+
+        for (int32_t f = 0; f < font.fallbackCount; ++f)
+        {
+            if (font.fallbacks[f] < 0 || font.fallbacks[f] >= header->fontCount)
+                return NULL;
+        }
+    }
+    return header;
+}
+
+// Restores fonts, glyph tables and atlas nodes, then uploads the atlas texels from the mapping. Glyphs missing from
+// the file are rasterized on demand into the space the baked ones left
+static void REI_Fontstash_loadBakedAtlas(FONScontext* ctx, const REI_Fontstash_BakedHeader* header)
+{
+    REI_Fontstash_State*           state = (REI_Fontstash_State*)ctx->params.userPtr;
+    const uint8_t*                 file = state->bakedAtlas;
+    const REI_Fontstash_BakedFont* fonts = (const REI_Fontstash_BakedFont*)(file + header->fontsOffset);
+
+    for (int32_t i = 0; i < header->fontCount; ++i)
+    {
+        // Glyphs and fallbacks refer to fonts by index, a font that fails to load leaves the atlas empty
+        if (fonsAddFontMem(ctx, fonts[i].name, (unsigned char*)file + fonts[i].dataOffset, fonts[i].dataSize, 0) != i)
+            return;
+    }
+
+    // Everything that can fail is allocated before the glyph tables and the atlas are touched, so a failure leaves
+    // them empty and every glyph is rasterized on demand as without a baked atlas
+    for (int32_t i = 0; i < header->fontCount; ++i)
+    {
+        FONSfont* font = ctx->fonts[i];
+        int       glyphCount = font->nglyphs + fonts[i].glyphCount;
+        if (font->cglyphs < glyphCount)
+        {
+            FONSglyph* glyphs = (FONSglyph*)realloc(font->glyphs, sizeof(FONSglyph) * glyphCount);
+            if (!glyphs)
+                return;
+            font->glyphs = glyphs;
+            font->cglyphs = glyphCount;
+        }
+    }
+
+    FONSatlas* atlas = ctx->atlas;
+    if (atlas->cnodes < header->nodeCount)
+    {
+        FONSatlasNode* nodes = (FONSatlasNode*)realloc(atlas->nodes, sizeof(FONSatlasNode) * header->nodeCount);
+        if (!nodes)
+            return;
+        atlas->nodes = nodes;
+        atlas->cnodes = header->nodeCount;
+    }
+
+    for (int32_t i = 0; i < header->fontCount; ++i)
+    {
+        for (int32_t f = 0; f < fonts[i].fallbackCount; ++f)
+            fonsAddFallbackFont(ctx, i, fonts[i].fallbacks[f]);
+
+        FONSfont*                       font = ctx->fonts[i];
+        const REI_Fontstash_BakedGlyph* bakedGlyphs =
+            (const REI_Fontstash_BakedGlyph*)(file + fonts[i].glyphsOffset);
+        for (int32_t g = 0; g < fonts[i].glyphCount; ++g)
+        {
+            const REI_Fontstash_BakedGlyph& baked = bakedGlyphs[g];
+            FONSglyph*                      glyph = &font->glyphs[font->nglyphs++];
+
+            glyph->codepoint = baked.codepoint;
+            glyph->index = baked.index;
+            glyph->size = baked.size;
+            glyph->blur = baked.blur;
+            glyph->x0 = baked.x0;
+            glyph->y0 = baked.y0;
+            glyph->x1 = baked.x1;
+            glyph->y1 = baked.y1;
+            glyph->xadv = baked.xadv;
+            glyph->xoff = baked.xoff;
+            glyph->yoff = baked.yoff;
+
+            unsigned int h = fons__hashint(baked.codepoint) & (FONS_HASH_LUT_SIZE - 1);
+            glyph->next = font->lut[h];
+            font->lut[h] = font->nglyphs - 1;
+        }
+    }
+
+    memcpy(atlas->nodes, file + header->nodesOffset, sizeof(FONSatlasNode) * header->nodeCount);
+    atlas->nnodes = header->nodeCount;
+
+    // fontstash keeps its copy for glyphs added later, the upload is staged straight from the mapping
+    const uint32_t width = (uint32_t)header->width;
+    const uint32_t height = (uint32_t)header->height;
+    const uint8_t* texels = file + header->texelsOffset;
+    memcpy(ctx->texData, texels, (size_t)width * height);
+
+    REI_RL_TextureUpdateDesc updateDesc = { state->fontTexture,
+                                            NULL,
+                                            REI_FMT_R8_UNORM,
+                                            0,
+                                            0,
+                                            0,
+                                            width,
+                                            height,
+                                            1,
+                                            0,
+                                            0,
+                                            REI_RESOURCE_STATE_SHADER_RESOURCE,
+                                            REI_RL_PRIORITY_HIGH };
+
+    REI_RL_UpdateMemory updateMemory;
+    REI_RL_beginUpdate(state->loader, &updateDesc, &updateMemory);
+    for (uint32_t row = 0; row < height; ++row)
+        memcpy(updateMemory.pData + (size_t)row * updateMemory.rowPitch, texels + (size_t)row * width, width);
+
+    // Render waits for it like for any other copy into the atlas
+    REI_Fontstash_Upload& upload = state->uploads[state->uploadCount++];
+    REI_RL_endUpdate(state->loader, &updateDesc, &updateMemory, &upload.token);
+}
+
 FONScontext*
     REI_Fontstash_Init(REI_Renderer* renderer, REI_Queue* queue, REI_RL_State* loader, REI_Fontstash_Desc* info)
 {
@@ -332,31 +984,147 @@ FONScontext*
     params.width = info->texWidth;
     params.height = info->texHeight;
     params.flags = FONS_ZERO_TOPLEFT;
+    // Distances up to an eighth of the glyph size from the edge are stored
+    params.sdfSize = (int)info->sdfSize;
+    params.sdfPadding = REI_max((int)info->sdfSize / 8, 2);
+
+    // The glyph table of an atlas file is only valid for its atlas size and glyph mode, a missing or invalid file
+    // leaves all glyphs to be rasterized on demand
+    const REI_Fontstash_BakedHeader* baked = NULL;
+    if (info->pBakedAtlasPath && REI_Fontstash_mapBakedAtlas(state, info->pBakedAtlasPath))
+    {
+        baked = REI_Fontstash_validateBakedAtlas(state->bakedAtlas, state->bakedAtlasSize);
+        if (baked)
+        {
+            params.width = baked->width;
+            params.height = baked->height;
+            params.sdfSize = baked->sdfSize;
+            params.sdfPadding = baked->sdfPadding;
+            state->desc.texWidth = (uint32_t)baked->width;
+            state->desc.texHeight = (uint32_t)baked->height;
+            state->desc.sdfSize = (uint32_t)baked->sdfSize;
+        }
+        else
+        {
+            REI_Fontstash_unmapBakedAtlas(state);
+        }
+    }
+    if (params.sdfSize)
+        params.flags = (unsigned char)(params.flags | FONS_SDF);
+
     params.renderCreate = REI_Fontstash_renderCreate;
     params.renderResize = REI_Fontstash_renderResize;
     params.renderUpdate = REI_Fontstash_renderUpdate;
     params.renderDraw = REI_Fontstash_renderDraw;
     params.renderDelete = REI_Fontstash_renderDelete;
+    if (info->glyphThreadCount)
+        params.renderGlyph = REI_Fontstash_renderGlyph;
     params.userPtr = state;
 
-    return fonsCreateInternal(&params);
+    FONScontext* ctx = fonsCreateInternal(&params);
+    if (ctx && baked)
+        REI_Fontstash_loadBakedAtlas(ctx, baked);
+
+    state->ctx = ctx;
+    if (ctx && info->glyphThreadCount)
+        REI_Fontstash_addGlyphWorkers(state);
+
+    return ctx;
 }
 
 void REI_Fontstash_SetupRender(FONScontext* ctx, uint32_t set_index)
 {
     REI_Fontstash_State* state = (REI_Fontstash_State*)ctx->params.userPtr;
     state->vertexCount = 0;
+    state->quadCount = 0;
     state->setIndex = set_index;
+    REI_DQ_beginResourceSet(state->deletionQueue, set_index);
+}
+
+void REI_Fontstash_FlushUploads(FONScontext* ctx)
+{
+    REI_Fontstash_State* state = (REI_Fontstash_State*)ctx->params.userPtr;
+
+    // Glyphs rasterized by fonsTextIterNext outside of a draw call are still in the dirty rect of the context
+    fons__flush(ctx);
+    REI_Fontstash_collectGlyphs(state, false);
+
+    const uint32_t width = state->fontTextureWidth;
+    for (uint32_t r = 0; r < state->dirtyRectCount; ++r)
+    {
+        const int* rect = state->dirtyRects[r];
+        if (state->uploadCount == MAX_PENDING_UPLOADS)
+        {
+            REI_Fontstash_retireUploads(state);
+            if (state->uploadCount == MAX_PENDING_UPLOADS)
+            {
+                REI_RL_waitTokenCompleted(state->loader, state->uploads[0].token);
+                memmove(state->uploads, state->uploads + 1, --state->uploadCount * sizeof(REI_Fontstash_Upload));
+            }
+        }
+
+        const uint32_t w = (uint32_t)(rect[2] - rect[0]);
+        const uint32_t h = (uint32_t)(rect[3] - rect[1]);
+
+        REI_RL_TextureUpdateDesc updateDesc = { state->fontTexture,
+                                                NULL,
+                                                REI_FMT_R8_UNORM,
+                                                (uint32_t)rect[0],
+                                                (uint32_t)rect[1],
+                                                0,
+                                                w,
+                                                h,
+                                                1,
+                                                0,
+                                                0,
+                                                REI_RESOURCE_STATE_SHADER_RESOURCE,
+                                                REI_RL_PRIORITY_HIGH };
+
+        REI_RL_UpdateMemory   updateMemory;
+        const unsigned char* src = state->texData + (size_t)rect[1] * width + rect[0];
+        REI_RL_beginUpdate(state->loader, &updateDesc, &updateMemory);
+        for (uint32_t row = 0; row < h; ++row)
+            memcpy(updateMemory.pData + (size_t)row * updateMemory.rowPitch, src + (size_t)row * width, w);
+
+        REI_Fontstash_Upload& upload = state->uploads[state->uploadCount++];
+        REI_RL_endUpdate(state->loader, &updateDesc, &updateMemory, &upload.token);
+    }
+    state->dirtyRectCount = 0;
 }
 
 void REI_Fontstash_Render(FONScontext* ctx, REI_Cmd* pCmd)
 {
     REI_Fontstash_State* state = (REI_Fontstash_State*)ctx->params.userPtr;
 
+    REI_Fontstash_FlushUploads(ctx);
+
+    // The loader moves the whole atlas into a copy state around each copy, so no copy may be in flight while the
+    // draws below sample it
+    if (state->vertexCount || state->quadCount)
+    {
+        REI_Fontstash_retireUploads(state);
+        for (uint32_t i = 0; i < state->uploadCount; ++i)
+            REI_RL_waitTokenCompleted(state->loader, state->uploads[i].token);
+        state->uploadCount = 0;
+    }
+
+    // Frames that used this table before are complete, it can point to the current font texture
+    if (state->tableGenerations[state->setIndex] != state->fontTextureGeneration)
+    {
+        REI_DescriptorData params[1] = {};
+        params[0].descriptorType = REI_DESCRIPTOR_TYPE_TEXTURE;
+        params[0].descriptorIndex = 0;    //uTexture;
+        params[0].ppTextures = &state->fontTexture;
+        params[0].count = 1;
+        params[0].tableIndex = state->setIndex;
+        REI_updateDescriptorTableArray(state->renderer, state->descriptorSet, 1, params);
+        state->tableGenerations[state->setIndex] = state->fontTextureGeneration;
+    }
+
     // Bind pipeline and descriptor sets:
     {
         REI_cmdBindPipeline(pCmd, state->pipeline);
-        REI_cmdBindDescriptorTable(pCmd, 0, state->descriptorSet);
+        REI_cmdBindDescriptorTable(pCmd, state->setIndex, state->descriptorSet);
     }
 
     // Bind Vertex And Index Buffer:
@@ -372,17 +1140,158 @@ void REI_Fontstash_Render(FONScontext* ctx, REI_Cmd* pCmd)
 
     // Setup scale and translation:
     {
-        float scaleTranslate[4];
-        scaleTranslate[0] = 2.0f / state->desc.fbWidth;
-        scaleTranslate[1] = -2.0f / state->desc.fbHeight;
-        scaleTranslate[2] = -1.0f;
-        scaleTranslate[3] = 1.0f;
+        FontConstants constants;
+        constants.scaleTranslate[0] = 2.0f / state->desc.fbWidth;
+        constants.scaleTranslate[1] = -2.0f / state->desc.fbHeight;
+        constants.scaleTranslate[2] = -1.0f;
+        constants.scaleTranslate[3] = 1.0f;
+        constants.invTexSize[0] = 1.0f / ctx->params.width;
+        constants.invTexSize[1] = 1.0f / ctx->params.height;
         REI_cmdBindPushConstants(
-            pCmd, state->rootSignature, REI_SHADER_STAGE_VERT, 0, sizeof(scaleTranslate), scaleTranslate);
+            pCmd, state->rootSignature, REI_SHADER_STAGE_VERT, 0, sizeof(constants), &constants);
     }
 
     // Draw
     REI_cmdDraw(pCmd, state->vertexCount, 0);
+
+    // Glyph quads share the root signature, so tables and constants stay bound
+    if (state->quadCount)
+    {
+        uint64_t vertex_offset = 0;
+        REI_cmdBindPipeline(pCmd, state->quadPipeline);
+        REI_cmdBindVertexBuffer(pCmd, 1, &state->quadBuffers[state->setIndex], &vertex_offset);
+        REI_cmdDrawInstanced(pCmd, 6, 0, state->quadCount, 0);
+    }
+}
+
+float REI_Fontstash_DrawText(FONScontext* ctx, float x, float y, const char* str, const char* end)
+{
+    REI_Fontstash_State* state = (REI_Fontstash_State*)ctx->params.userPtr;
+    REI_ASSERT(state->quadPipeline, "REI_Fontstash_Desc::quadBufferSize is 0");
+
+    FONStextIter iter;
+    if (!fonsTextIterInit(ctx, &iter, x, y, str, end))
+        return x;
+
+    const float    texWidth = (float)ctx->params.width;
+    const float    texHeight = (float)ctx->params.height;
+    const uint32_t color = fons__getState(ctx)->color;
+
+    FontQuad* quads = (FontQuad*)state->quadBuffersAddr[state->setIndex];
+    FONSquad  q;
+    for (;;)
+    {
+        // The iterator leaves the quad untouched for missing glyphs
+        q.x0 = q.x1 = 0.0f;
+        if (!fonsTextIterNext(ctx, &iter, &q))
+            break;
+
+        // Empty glyphs are skipped, glyphs past the end of the buffer are dropped while the pen still advances
+        if (q.x0 == q.x1 || state->quadCount == state->maxQuadCount)
+            continue;
+
+        // fontstash snaps quads to whole pixels and atlas texels, only the far edge of scaled distance field glyphs
+        // is rounded
+        FontQuad& quad = quads[state->quadCount++];
+        quad.pos[0] = (int16_t)q.x0;
+        quad.pos[1] = (int16_t)q.y0;
+        quad.pos[2] = (int16_t)floorf(q.x1 + 0.5f);
+        quad.pos[3] = (int16_t)floorf(q.y1 + 0.5f);
+        quad.uv[0] = (uint16_t)(q.s0 * texWidth + 0.5f);
+        quad.uv[1] = (uint16_t)(q.t0 * texHeight + 0.5f);
+        quad.uv[2] = (uint16_t)(q.s1 * texWidth + 0.5f);
+        quad.uv[3] = (uint16_t)(q.t1 * texHeight + 0.5f);
+        quad.col = color;
+    }
+
+    // Records the glyphs rasterized by the iterator for upload
+    fons__flush(ctx);
+
+    return iter.nextx;
+}
+
+static void REI_Fontstash_writeAligned(FILE* file, const void* data, size_t size, bool* ok)
+{
+    static const uint8_t zeros[4] = {};
+    *ok = *ok && fwrite(data, 1, size, file) == size;
+    *ok = *ok && fwrite(zeros, 1, REI_align_up(size, (size_t)4) - size, file) == REI_align_up(size, (size_t)4) - size;
+}
+
+bool REI_Fontstash_BakeAtlas(FONScontext* ctx, const char* path)
+{
+    // Glyphs still with the workers would be baked as placeholders
+    if (ctx->params.renderGlyph == REI_Fontstash_renderGlyph)
+        REI_Fontstash_collectGlyphs((REI_Fontstash_State*)ctx->params.userPtr, true);
+
+    FONSatlas* atlas = ctx->atlas;
+
+    REI_Fontstash_BakedHeader header = {};
+    header.magic = BAKED_ATLAS_MAGIC;
+    header.version = BAKED_ATLAS_VERSION;
+    header.width = ctx->params.width;
+    header.height = ctx->params.height;
+    header.sdfSize = (ctx->params.flags & FONS_SDF) ? ctx->params.sdfSize : 0;
+    header.sdfPadding = (ctx->params.flags & FONS_SDF) ? ctx->params.sdfPadding : 0;
+    header.nodeCount = atlas->nnodes;
+    header.fontCount = ctx->nfonts;
+
+    size_t offset = sizeof(header);
+    header.nodesOffset = (uint32_t)offset;
+    offset += REI_align_up(sizeof(FONSatlasNode) * atlas->nnodes, (size_t)4);
+    header.fontsOffset = (uint32_t)offset;
+    offset += sizeof(REI_Fontstash_BakedFont) * ctx->nfonts;
+
+    REI_Fontstash_BakedFont* fonts =
+        (REI_Fontstash_BakedFont*)calloc(ctx->nfonts ? ctx->nfonts : 1, sizeof(REI_Fontstash_BakedFont));
+    if (!fonts)
+        return false;
+
+    for (int i = 0; i < ctx->nfonts; ++i)
+    {
+        fonts[i].glyphsOffset = (uint32_t)offset;
+        fonts[i].glyphCount = ctx->fonts[i]->nglyphs;
+        offset += sizeof(REI_Fontstash_BakedGlyph) * ctx->fonts[i]->nglyphs;
+    }
+    for (int i = 0; i < ctx->nfonts; ++i)
+    {
+        FONSfont* font = ctx->fonts[i];
+        memcpy(fonts[i].name, font->name, sizeof(fonts[i].name));
+        fonts[i].name[sizeof(fonts[i].name) - 1] = 0;
+        fonts[i].dataOffset = (uint32_t)offset;
+        fonts[i].dataSize = font->dataSize;
+        fonts[i].fallbackCount = font->nfallbacks;
+        memcpy(fonts[i].fallbacks, font->fallbacks, sizeof(fonts[i].fallbacks));
+        offset += REI_align_up((size_t)font->dataSize, (size_t)4);
+    }
+    header.texelsOffset = (uint32_t)offset;
+
+    FILE* file = fopen(path, "wb");
+    bool  ok = file != NULL;
+    if (ok)
+    {
+        REI_Fontstash_writeAligned(file, &header, sizeof(header), &ok);
+        REI_Fontstash_writeAligned(file, atlas->nodes, sizeof(FONSatlasNode) * atlas->nnodes, &ok);
+        REI_Fontstash_writeAligned(file, fonts, sizeof(REI_Fontstash_BakedFont) * ctx->nfonts, &ok);
+        for (int i = 0; i < ctx->nfonts; ++i)
+        {
+            FONSfont* font = ctx->fonts[i];
+            for (int g = 0; g < font->nglyphs; ++g)
+            {
+                const FONSglyph&         glyph = font->glyphs[g];
+                REI_Fontstash_BakedGlyph baked = { glyph.codepoint, glyph.index, glyph.size, glyph.blur,
+                                                   glyph.x0,        glyph.y0,    glyph.x1,   glyph.y1,
+                                                   glyph.xadv,      glyph.xoff,  glyph.yoff, 0 };
+                REI_Fontstash_writeAligned(file, &baked, sizeof(baked), &ok);
+            }
+        }
+        for (int i = 0; i < ctx->nfonts; ++i)
+            REI_Fontstash_writeAligned(file, ctx->fonts[i]->data, (size_t)ctx->fonts[i]->dataSize, &ok);
+        REI_Fontstash_writeAligned(file, ctx->texData, (size_t)header.width * header.height, &ok);
+        ok = fclose(file) == 0 && ok;
+    }
+
+    free(fonts);
+    return ok;
 }
 
 void REI_Fontstash_Shutdown(FONScontext* ctx) { fonsDeleteInternal(ctx); }
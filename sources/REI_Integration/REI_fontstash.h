@@ -22,7 +22,9 @@
 
 struct REI_Fontstash_Desc
 {
+    // Bytes of fonsDrawText vertices per set, 20 per vertex. Triangles past it are dropped until the next SetupRender
     uint64_t                      vertexBufferSize;
+    uint64_t                      quadBufferSize;    // glyph instances of REI_Fontstash_DrawText per set, 0 disables it
     uint32_t                      colorFormat : REI_FORMAT_BIT_COUNT;
     uint32_t                      depthStencilFormat : REI_FORMAT_BIT_COUNT;
     uint32_t                      sampleCount : REI_SAMPLE_COUNT_BIT_COUNT;
@@ -31,6 +33,12 @@ struct REI_Fontstash_Desc
     uint32_t                      fbHeight;
     uint32_t                      texWidth;
     uint32_t                      texHeight;
+    uint32_t                      sdfSize;    // glyphs are rasterized once at this pixel size as distance fields, 0 rasterizes every size
+    // Atlas file of REI_Fontstash_BakeAtlas, its fonts, glyphs, atlas size and glyph mode replace the ones above
+    const char*                   pBakedAtlasPath;
+    // Threads rasterizing new glyphs, which are drawn as placeholders until a later flush uploads them. 0 rasterizes
+    // them while drawing
+    uint32_t                      glyphThreadCount;
     const REI_AllocatorCallbacks* pAllocator;
 };
 
@@ -39,5 +47,18 @@ struct FONScontext;
 FONScontext*
      REI_Fontstash_Init(REI_Renderer* Renderer, REI_Queue* queue, REI_RL_State* loader, REI_Fontstash_Desc* info);
 void REI_Fontstash_SetupRender(FONScontext* ctx, uint32_t set_index);
+// Starts the copies of glyphs rasterized since the last flush. The loader moves the whole atlas into a copy state
+// for each of them, so Render flushes as well and waits for all pending copies before it draws anything. Flushing
+// right after the text was laid out gives them time to complete
+void REI_Fontstash_FlushUploads(FONScontext* ctx);
 void REI_Fontstash_Render(FONScontext* ctx, REI_Cmd* pCmd);
+// Same as fonsDrawText, but writes one 20 byte instance per glyph straight into the quad buffer of the set instead
+// of 6 vertices. Quads are drawn after the vertices of fonsDrawText
+float REI_Fontstash_DrawText(FONScontext* ctx, float x, float y, const char* str, const char* end);
+// Kernel behind fonsDrawText, exposed for tests and benchmarks. pDst receives count 20 byte vertices
+void REI_Fontstash_InterleaveVertices(
+    void* pDst, const float* verts, const float* tcoords, const unsigned int* colors, uint32_t count);
+// Writes the atlas of ctx with its fonts and glyph table to path, for REI_Fontstash_Desc::pBakedAtlasPath. ctx can be
+// a plain fontstash context made with fonsCreateInternal, fonts keep the names they were added with
+bool REI_Fontstash_BakeAtlas(FONScontext* ctx, const char* path);
 void REI_Fontstash_Shutdown(FONScontext* ctx);
@@ -14,6 +14,7 @@
 
 #include <stdio.h>
 
+#include "DeletionQueue.h"
 #include "ResourceLoader.h"
 #include "REI_imgui.h"
 
@@ -35,6 +36,10 @@ struct REI_ImGui_State
     REI_Buffer**              buffers;
     void**                    buffersAddr;
     REI_AllocatorCallbacks    allocator;
+    REI_DQ_State*             deletionQueue;
+    // Each resource set binds its own table, updated when the font texture was recreated since its last use
+    uint32_t                  fontTextureGeneration;
+    uint32_t*                 tableGenerations;
 };
 
 static REI_ImGui_State g_State = {};
@@ -45,12 +50,12 @@ static REI_ImGui_State g_State = {};
 
 static void REI_ImGui_SetupRenderState(
     ImDrawData* draw_data, REI_Cmd* command_buffer, REI_Buffer* vertex_buffer, REI_Buffer* index_buffer, int fb_width,
-    int fb_height)
+    int fb_height, uint32_t resource_set)
 {
     // Bind pipeline and descriptor sets:
     {
         REI_cmdBindPipeline(command_buffer, g_State.pipeline);
-        REI_cmdBindDescriptorTable(command_buffer, 0, g_State.descriptorSet);
+        REI_cmdBindDescriptorTable(command_buffer, resource_set, g_State.descriptorSet);
     }
 
     // Bind Vertex And Index Buffer:
@@ -82,6 +87,8 @@ static void REI_ImGui_SetupRenderState(
 // (this used to be set in io.RenderDrawListsFn and called by ImGui::Render(), but you can now call this directly from your main loop)
 void REI_ImGui_Render(ImDrawData* draw_data, REI_Cmd* command_buffer, uint32_t resource_set)
 {
+    REI_DQ_beginResourceSet(g_State.deletionQueue, resource_set);
+
     if (!draw_data)
     {
         return;
@@ -111,7 +118,20 @@ void REI_ImGui_Render(ImDrawData* draw_data, REI_Cmd* command_buffer, uint32_t r
     REI_Buffer* vertex_buffer = g_State.buffers[resource_set * 2];
     REI_Buffer* index_buffer = g_State.buffers[resource_set * 2 + 1];
 
-    REI_ImGui_SetupRenderState(draw_data, command_buffer, vertex_buffer, index_buffer, fb_width, fb_height);
+    // Frames that used this table before are complete, it can point to the current font texture
+    if (g_State.tableGenerations[resource_set] != g_State.fontTextureGeneration)
+    {
+        REI_DescriptorData params[1] = {};
+        params[0].descriptorType = REI_DESCRIPTOR_TYPE_TEXTURE;
+        params[0].descriptorIndex = 0;    //uTexture
+        params[0].ppTextures = &g_State.fontTexture;
+        params[0].tableIndex = resource_set;
+        REI_updateDescriptorTableArray(g_State.renderer, g_State.descriptorSet, 1, params);
+        g_State.tableGenerations[resource_set] = g_State.fontTextureGeneration;
+    }
+
+    REI_ImGui_SetupRenderState(
+        draw_data, command_buffer, vertex_buffer, index_buffer, fb_width, fb_height, resource_set);
 
     // Will project scissor/clipping rectangles into framebuffer space
     ImVec2 clip_off = draw_data->DisplayPos;            // (0,0) unless using multi-viewports
@@ -141,7 +161,7 @@ void REI_ImGui_Render(ImDrawData* draw_data, REI_Cmd* command_buffer, uint32_t r
                 if (pcmd->UserCallback == ImDrawCallback_ResetRenderState)
                 {
                     REI_ImGui_SetupRenderState(
-                        draw_data, command_buffer, vertex_buffer, index_buffer, fb_width, fb_height);
+                        draw_data, command_buffer, vertex_buffer, index_buffer, fb_width, fb_height, resource_set);
                 }
                 else
                 {
@@ -188,6 +208,10 @@ bool REI_ImGui_CreateFontsTexture(REI_RL_State* loader, REI_RL_RequestId* token)
     io.Fonts->GetTexDataAsRGBA32(&pixels, &width, &height);
     //size_t upload_size = width * height * 4 * sizeof(char);
 
+    // Rebuilt fonts replace the texture, frames in flight keep sampling the old one
+    if (g_State.fontTexture)
+        REI_DQ_removeTexture(g_State.deletionQueue, g_State.fontTexture);
+
     REI_TextureDesc textureDesc{};
     textureDesc.flags = REI_TEXTURE_CREATION_FLAG_OWN_MEMORY_BIT;
     textureDesc.width = (uint32_t)width;
@@ -209,13 +233,7 @@ bool REI_ImGui_CreateFontsTexture(REI_RL_State* loader, REI_RL_RequestId* token)
                                             REI_RESOURCE_STATE_SHADER_RESOURCE };
     REI_RL_updateResource(loader, &updateDesc, token);
     io.Fonts->TexID = (void*)g_State.fontTexture;
-
-    REI_DescriptorData params[1] = {};
-    params[0].descriptorType = REI_DESCRIPTOR_TYPE_TEXTURE;
-    params[0].descriptorIndex = 0;    //uTexture
-    params[0].ppTextures = &g_State.fontTexture;
-    params[0].tableIndex = 0;
-    REI_updateDescriptorTableArray(g_State.renderer, g_State.descriptorSet, 1, params);
+    ++g_State.fontTextureGeneration;
 
     // Store our identifier
     io.Fonts->TexID = (ImTextureID)(intptr_t)g_State.fontTexture;
@@ -285,7 +303,7 @@ bool REI_ImGui_CreateDeviceObjects()
 
     REI_DescriptorTableArrayDesc descriptorSetDesc = {};
     descriptorSetDesc.pRootSignature = g_State.rootSignature;
-    descriptorSetDesc.maxTables = 1;
+    descriptorSetDesc.maxTables = g_State.desc.resourceSetCount;
     descriptorSetDesc.slot = REI_DESCRIPTOR_TABLE_SLOT_1;
     REI_addDescriptorTableArray(g_State.renderer, &descriptorSetDesc, &g_State.descriptorSet);
 
@@ -362,6 +380,12 @@ bool REI_ImGui_CreateDeviceObjects()
         REI_mapBuffer(g_State.renderer, g_State.buffers[2 * i + 1], &g_State.buffersAddr[2 * i + 1]);
     }
 
+    g_State.tableGenerations =
+        (uint32_t*)REI_calloc(g_State.allocator, g_State.desc.resourceSetCount * sizeof(uint32_t));
+
+    REI_DQ_DeletionQueueDesc deletionQueueDesc = { g_State.desc.resourceSetCount, &g_State.allocator };
+    REI_DQ_addDeletionQueue(g_State.renderer, &deletionQueueDesc, &g_State.deletionQueue);
+
     return true;
 }
 
@@ -385,6 +409,11 @@ bool REI_ImGui_Init(REI_Renderer* renderer, REI_ImGui_Desc* info)
 
 void REI_ImGui_Shutdown()
 {
+    REI_DQ_removeDeletionQueue(g_State.deletionQueue);
+    g_State.deletionQueue = NULL;
+    g_State.allocator.pFree(g_State.allocator.pUserData, g_State.tableGenerations);
+    g_State.tableGenerations = NULL;
+
     for (uint32_t i = 0; i < g_State.desc.resourceSetCount; ++i)
     {
         REI_removeBuffer(g_State.renderer, g_State.buffers[2 * i]);
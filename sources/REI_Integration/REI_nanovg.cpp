@@ -28,6 +28,7 @@
 #    define strcpy strcpy_s
 #endif
 
+#include "DeletionQueue.h"
 #include "ResourceLoader.h"
 #include "REI_nanovg.h"
 
@@ -49,13 +50,37 @@ enum REI_NanoVG_shaderType
     NSVG_SHADER_IMG
 };
 
+// Images packed into an atlas keep a gutter of repeated border texels, rects are aligned so that every atlas mip
+// level starts on a texel
+static const uint32_t ATLAS_MIP_LEVELS = 3;
+static const uint32_t ATLAS_ALIGNMENT = 1 << (ATLAS_MIP_LEVELS - 1);
+static const uint32_t ATLAS_GUTTER = 4;
+
 struct REI_NanoVG_texture
 {
     //TODO: add generations and upload state tracking
-    REI_Texture* tex;
+    REI_Texture* tex;    // NULL for images packed into an atlas
     uint32_t     width;
     uint32_t     height;
     uint32_t     flags;
+    uint32_t     mipLevels;
+    uint32_t     table;    // texDescriptorSet table the image is bound with
+    uint32_t     atlas;    // 1 + index into REI_NanoVG_State::atlases, 0 for images with their own texture
+    uint32_t     x, y;     // position in the atlas
+};
+
+struct REI_NanoVG_skylineNode
+{
+    int x, y, width;
+};
+
+struct REI_NanoVG_atlas
+{
+    REI_Texture*                        tex;
+    uint32_t                            table;
+    uint32_t                            mipLevels;
+    uint32_t                            imageCount;
+    REI_vector<REI_NanoVG_skylineNode> skyline;
 };
 
 enum REI_NanoVG_callType
@@ -70,12 +95,13 @@ enum REI_NanoVG_callType
 struct REI_NanoVG_call
 {
     int      type;
-    int      image;
+    uint32_t table;    // texDescriptorSet table of the image
     uint32_t pathOffset, pathCount;
     uint32_t fillOffset, fillCount;
     uint32_t strokeOffset, strokeCount;
     uint32_t triangleOffset, triangleCount;
     uint32_t uniformIndex;
+    uint32_t replay;    // 1 + index of the replay in REI_NanoVG_State::replays for calls of retained groups
 };
 
 struct REI_NanoVG_path
@@ -101,8 +127,52 @@ struct REI_NanoVG_fragUniforms
     float           strokeThr;
     int             texType;
     int             type;
+    float           atlasRect[4];     // offset and scale from image to texture coordinates
+    float           atlasClamp[4];    // texture coordinates of the outer texel centers of the image
+};
+
+struct REI_NanoVG_vertexConstants
+{
+    float    scaleTranslate[4];
+    float    xform[6];
+    uint32_t paintBase;
+};
+
+struct REI_NanoVG_retained
+{
+    REI_NanoVG_retained(const REI_AllocatorCallbacks& allocator):
+        vertices(REI_allocator<NVGvertex>(allocator)), paints(REI_allocator<uint32_t>(allocator)),
+        uniforms(REI_allocator<REI_NanoVG_fragUniforms>(allocator)), calls(REI_allocator<REI_NanoVG_call>(allocator))
+    {
+    }
+
+    REI_Buffer*      vtxBuffer = NULL;
+    REI_Buffer*      paintBuffer = NULL;
+    REI_RL_RequestId uploadToken = 0;
+    bool             uploaded = false;
+    uint32_t         vertexCount = 0;
+#if REI_NANOVG_VALIDATE_RETAINED
+    uint64_t         contentHash = 0;
+#endif
+
+    // Vertices are kept on the CPU until the upload completes, they are drawn from the frame buffers until then
+    REI_vector<NVGvertex>               vertices;
+    REI_vector<uint32_t>                paints;    // uniform index relative to the group
+    REI_vector<REI_NanoVG_fragUniforms> uniforms;
+    REI_vector<REI_NanoVG_call>         calls;
+};
+
+// Keeps the group buffers rather than the group, which REI_NanoVG_RemoveRetained may delete before the flush
+struct REI_NanoVG_replay
+{
+    REI_Buffer* vtxBuffer;    // NULL while the group is drawn from the frame buffers
+    REI_Buffer* paintBuffer;
+    uint32_t    paintBase;
+    float       xform[6];
 };
 
+typedef REI_unordered_map<uint64_t, REI_NanoVG_retained*> REI_NanoVG_retainedMap;
+
 struct REI_NanoVG_State
 {
     REI_NanoVG_Desc           desc;
@@ -110,6 +180,7 @@ struct REI_NanoVG_State
     REI_AllocatorCallbacks    allocator;
     REI_Queue*                queue;
     REI_RL_State*             loader;
+    REI_DQ_State*             deletionQueue;
     REI_RootSignature*        rootSignature;
     REI_DescriptorTableArray* uniDescriptorSet;
     REI_DescriptorTableArray* texDescriptorSet;
@@ -120,18 +191,37 @@ struct REI_NanoVG_State
     REI_Sampler*              sampler;
     REI_Buffer**              vtxBuffers;
     void**                    vtxBuffersAddr;
+    REI_Buffer**              paintBuffers;    // per vertex uniform index, lets one draw cover calls with different paints
+    void**                    paintBuffersAddr;
     REI_Buffer**              uniBuffers;
     void**                    uniBuffersAddr;
     REI_Texture*              dummyTexture;
     REI_Cmd*                  cmd;
+    REI_Pipeline*             boundPipeline;
+    REI_Buffer*               boundVertexBuffer;
+    uint32_t                  boundReplay;
+    uint32_t                  boundTable;
+    REI_NanoVG_retained*      recording;    // group receiving calls between REI_NanoVG_BeginRetained and EndRetained
+#if REI_NANOVG_VALIDATE_RETAINED
+    REI_NanoVG_retained*      validated;    // stored group the calls being recorded are compared with
+#endif
+    uint32_t                  frameVtxCount;
+    uint32_t                  frameUniCount;
     uint32_t                  setIndex;
     uint32_t                  width;
     uint32_t                  height;
     uint32_t                  vtxCount;
     uint32_t                  uniCount;
+    REI_NanoVG_Stats          stats;
 
     REI_vector<REI_NanoVG_call>    calls;
     REI_vector<REI_NanoVG_texture> textures;
+    REI_vector<REI_NanoVG_replay>  replays;
+    REI_vector<REI_NanoVG_atlas>   atlases;
+    REI_vector<uint32_t>           freeTables;
+    REI_vector<REI_RL_RequestId>   tableUploads;    // last upload into the image of each table, waited for when bound
+
+    REI_NanoVG_retainedMap         retained;
 };
 
 
@@ -141,12 +231,24 @@ struct REI_NanoVG_State
 
 #define OFFSETOF(type, mem) ((size_t)(&(((type*)0)->mem)))
 
-NVGvertex* allocVertices(REI_NanoVG_State* state, uint32_t count)
+NVGvertex* allocVertices(REI_NanoVG_State* state, uint32_t count, uint32_t uniformIndex)
 {
+    if (state->recording)
+    {
+        state->recording->vertices.resize(state->vtxCount + count);
+        state->recording->paints.resize(state->vtxCount + count, uniformIndex);
+        NVGvertex* vtx = state->recording->vertices.data() + state->vtxCount;
+        state->vtxCount += count;
+        return vtx;
+    }
+
     bool enoughSpace = state->desc.maxVerts - state->vtxCount >= count;
     if (enoughSpace)
     {
         NVGvertex* vtx = ((NVGvertex*)state->vtxBuffersAddr[state->setIndex]) + state->vtxCount;
+        uint32_t*  paint = ((uint32_t*)state->paintBuffersAddr[state->setIndex]) + state->vtxCount;
+        for (uint32_t i = 0; i < count; ++i)
+            paint[i] = uniformIndex;
         state->vtxCount += count;
         return vtx;
     }
@@ -155,6 +257,13 @@ NVGvertex* allocVertices(REI_NanoVG_State* state, uint32_t count)
 
 REI_NanoVG_fragUniforms* allocUniformData(REI_NanoVG_State* state)
 {
+    if (state->recording)
+    {
+        state->recording->uniforms.emplace_back();
+        ++state->uniCount;
+        return &state->recording->uniforms.back();
+    }
+
     bool enoughSpace = state->desc.maxDraws > state->uniCount;
     if (enoughSpace)
     {
@@ -166,6 +275,14 @@ REI_NanoVG_fragUniforms* allocUniformData(REI_NanoVG_State* state)
     return 0;
 }
 
+// Releases the slot of the last allocUniformData when the vertices of its call don't fit
+void freeUniformData(REI_NanoVG_State* state)
+{
+    if (state->recording)
+        state->recording->uniforms.pop_back();
+    --state->uniCount;
+}
+
 static int REI_NanoVG_renderCreate(void* userPtr)
 {
     REI_NanoVG_State* state = (REI_NanoVG_State*)userPtr;
@@ -191,14 +308,10 @@ static int REI_NanoVG_renderCreate(void* userPtr)
 
     REI_RootSignatureDesc rootSigDesc = {};
 
-    REI_PushConstantRange pConst[2] = {};
-    pConst[0].offset = 0;
-    pConst[0].size = sizeof(float[4]);
-    pConst[0].stageFlags = REI_SHADER_STAGE_VERT;
-
-    pConst[1].offset = 16;
-    pConst[1].size = sizeof(uint32_t);
-    pConst[1].stageFlags = REI_SHADER_STAGE_FRAG;
+    REI_PushConstantRange pConst = {};
+    pConst.offset = 0;
+    pConst.size = sizeof(REI_NanoVG_vertexConstants);
+    pConst.stageFlags = REI_SHADER_STAGE_VERT;
 
     REI_DescriptorBinding binding[2] = {};
 
@@ -231,8 +344,8 @@ static int REI_NanoVG_renderCreate(void* userPtr)
 
 
     rootSigDesc.pipelineType = REI_PIPELINE_TYPE_GRAPHICS;
-    rootSigDesc.pushConstantRangeCount = 2;
-    rootSigDesc.pPushConstantRanges = pConst;
+    rootSigDesc.pushConstantRangeCount = 1;
+    rootSigDesc.pPushConstantRanges = &pConst;
     rootSigDesc.tableLayoutCount = 2;
     rootSigDesc.pTableLayouts = setLayout;
     rootSigDesc.staticSamplerBindingCount = 1;
@@ -252,7 +365,7 @@ static int REI_NanoVG_renderCreate(void* userPtr)
     descriptorSetDesc.slot = REI_DESCRIPTOR_TABLE_SLOT_2;
     REI_addDescriptorTableArray(state->renderer, &descriptorSetDesc, &state->texDescriptorSet);
 
-    const size_t     vertexAttribCount = 2;
+    const size_t     vertexAttribCount = 3;
     REI_VertexAttrib vertexAttribs[vertexAttribCount] = {};
     vertexAttribs[0].semantic = REI_SEMANTIC_POSITION0;
     vertexAttribs[0].offset = OFFSETOF(NVGvertex, x);
@@ -262,6 +375,11 @@ static int REI_NanoVG_renderCreate(void* userPtr)
     vertexAttribs[1].offset = OFFSETOF(NVGvertex, u);
     vertexAttribs[1].location = 1;
     vertexAttribs[1].format = REI_FMT_R32G32_SFLOAT;
+    vertexAttribs[2].semantic = REI_SEMANTIC_TEXCOORD1;
+    vertexAttribs[2].offset = 0;
+    vertexAttribs[2].location = 2;
+    vertexAttribs[2].binding = 1;
+    vertexAttribs[2].format = REI_FMT_R32_UINT;
 
     REI_RasterizerStateDesc rasterizerState{};
     rasterizerState.cullMode = REI_CULL_MODE_BACK;
@@ -360,6 +478,20 @@ static int REI_NanoVG_renderCreate(void* userPtr)
         REI_mapBuffer(state->renderer, state->vtxBuffers[i], &state->vtxBuffersAddr[i]);
     }
 
+    vbDesc.descriptors = REI_DESCRIPTOR_TYPE_VERTEX_BUFFER;
+    vbDesc.vertexStride = sizeof(uint32_t);
+    vbDesc.structStride = sizeof(uint32_t);
+    vbDesc.size = state->desc.maxVerts * sizeof(uint32_t);
+
+    state->paintBuffers =
+        (REI_Buffer**)REI_calloc(state->allocator, state->desc.resourceSetCount * sizeof(REI_Buffer*));
+    state->paintBuffersAddr = (void**)REI_calloc(state->allocator, state->desc.resourceSetCount * sizeof(void*));
+    for (uint32_t i = 0; i < state->desc.resourceSetCount; ++i)
+    {
+        REI_addBuffer(state->renderer, &vbDesc, &state->paintBuffers[i]);
+        REI_mapBuffer(state->renderer, state->paintBuffers[i], &state->paintBuffersAddr[i]);
+    }
+
     REI_NanoVG_fragUniforms frag{};
     frag.strokeThr = -1.0f;
     frag.type = NSVG_SHADER_SIMPLE;
@@ -433,13 +565,49 @@ static int REI_NanoVG_renderCreate(void* userPtr)
 
     state->textures.resize(1);
 
+    REI_DQ_DeletionQueueDesc deletionQueueDesc = { state->desc.resourceSetCount, &state->allocator };
+    REI_DQ_addDeletionQueue(state->renderer, &deletionQueueDesc, &state->deletionQueue);
+
+    // Table 0 keeps the dummy texture
+    for (uint32_t i = state->desc.maxTextures; i > 1; --i)
+        state->freeTables.push_back(i - 1);
+    state->tableUploads.resize(state->desc.maxTextures, 0);
+
+    if (state->desc.atlasSize && !state->desc.maxAtlasImageSize)
+        state->desc.maxAtlasImageSize = state->desc.atlasSize / 8;
+
     return 1;
 }
 
+static void REI_NanoVG_removeRetainedGroup(REI_NanoVG_State* state, REI_NanoVG_retained* group)
+{
+    if (group->vtxBuffer)
+        REI_DQ_removeBuffer(state->deletionQueue, group->vtxBuffer);
+    if (group->paintBuffer)
+        REI_DQ_removeBuffer(state->deletionQueue, group->paintBuffer);
+    REI_delete(state->allocator, group);
+}
+
 static void REI_NanoVG_renderDelete(void* userPtr)
 {
     REI_NanoVG_State* state = (REI_NanoVG_State*)userPtr;
 
+    for (auto& it: state->retained)
+    {
+        if (!it.second->uploaded && it.second->vtxBuffer)
+            REI_RL_waitTokenCompleted(state->loader, it.second->uploadToken);
+        REI_NanoVG_removeRetainedGroup(state, it.second);
+    }
+    for (REI_RL_RequestId token: state->tableUploads)
+    {
+        if (token)
+            REI_RL_waitTokenCompleted(state->loader, token);
+    }
+
+    // Deferred removals go before the textures, they may still return tables and atlas space
+    if (state->deletionQueue)
+        REI_DQ_removeDeletionQueue(state->deletionQueue);
+
     for (uint32_t i = 0; i < state->desc.resourceSetCount; ++i)
     {
         REI_removeBuffer(state->renderer, state->vtxBuffers[i]);
@@ -447,6 +615,13 @@ static void REI_NanoVG_renderDelete(void* userPtr)
     state->allocator.pFree(state->allocator.pUserData, state->vtxBuffers);
     state->allocator.pFree(state->allocator.pUserData, state->vtxBuffersAddr);
 
+    for (uint32_t i = 0; i < state->desc.resourceSetCount; ++i)
+    {
+        REI_removeBuffer(state->renderer, state->paintBuffers[i]);
+    }
+    state->allocator.pFree(state->allocator.pUserData, state->paintBuffers);
+    state->allocator.pFree(state->allocator.pUserData, state->paintBuffersAddr);
+
     for (uint32_t i = 0; i < state->desc.resourceSetCount; ++i)
     {
         REI_removeBuffer(state->renderer, state->uniBuffers[i]);
@@ -500,21 +675,294 @@ static void REI_NanoVG_renderDelete(void* userPtr)
         if (tex.tex != 0 && (tex.flags & NVGL_TEXTURE_NODELETE) == 0)
             REI_removeTexture(state->renderer, tex.tex);
     }
+    for (auto& atlas: state->atlases)
+        REI_removeTexture(state->renderer, atlas.tex);
 
     REI_removeTexture(state->renderer, state->dummyTexture);
 
+    state->retained.~REI_NanoVG_retainedMap();
+    state->replays.~vector();
+    state->atlases.~vector();
+    state->freeTables.~vector();
+    state->tableUploads.~vector();
     state->textures.~vector();
     state->calls.~vector();
 
     state->allocator.pFree(state->allocator.pUserData, state);
 }
 
+static uint32_t REI_NanoVG_imageTable(REI_NanoVG_State* state, int image)
+{
+    if (image <= 0 || (size_t)image >= state->textures.size())
+        return 0;
+    return state->textures[image].table;
+}
+
+// Returns the y of a rect of w x h placed at skyline node i, -1 if it does not fit
+static int REI_NanoVG_skylineFit(const REI_NanoVG_atlas& atlas, int size, size_t i, int w, int h)
+{
+    int x = atlas.skyline[i].x;
+    int y = atlas.skyline[i].y;
+    if (x + w > size)
+        return -1;
+
+    int spaceLeft = w;
+    while (spaceLeft > 0)
+    {
+        if (i == atlas.skyline.size())
+            return -1;
+        y = REI_max(y, atlas.skyline[i].y);
+        if (y + h > size)
+            return -1;
+        spaceLeft -= atlas.skyline[i].width;
+        ++i;
+    }
+    return y;
+}
+
+// Bottom-left skyline packing, the same scheme fontstash uses for its glyph atlas
+static bool REI_NanoVG_skylinePack(REI_NanoVG_atlas& atlas, int size, int w, int h, uint32_t* pX, uint32_t* pY)
+{
+    int    bestHeight = size, bestWidth = size, bestX = -1, bestY = -1;
+    size_t bestNode = ~(size_t)0;
+    for (size_t i = 0; i < atlas.skyline.size(); ++i)
+    {
+        int y = REI_NanoVG_skylineFit(atlas, size, i, w, h);
+        if (y < 0)
+            continue;
+        if (y + h < bestHeight || (y + h == bestHeight && atlas.skyline[i].width < bestWidth))
+        {
+            bestNode = i;
+            bestWidth = atlas.skyline[i].width;
+            bestHeight = y + h;
+            bestX = atlas.skyline[i].x;
+            bestY = y;
+        }
+    }
+    if (bestNode == ~(size_t)0)
+        return false;
+
+    REI_NanoVG_skylineNode node = { bestX, bestY + h, w };
+    atlas.skyline.insert(atlas.skyline.begin() + bestNode, node);
+
+    // Shrink or remove the nodes under the new one
+    for (size_t i = bestNode + 1; i < atlas.skyline.size();)
+    {
+        const REI_NanoVG_skylineNode& prev = atlas.skyline[i - 1];
+        int                           shrink = prev.x + prev.width - atlas.skyline[i].x;
+        if (shrink <= 0)
+            break;
+        atlas.skyline[i].x += shrink;
+        atlas.skyline[i].width -= shrink;
+        if (atlas.skyline[i].width > 0)
+            break;
+        atlas.skyline.erase(atlas.skyline.begin() + i);
+    }
+
+    // Merge neighbours of the same height
+    for (size_t i = 0; i + 1 < atlas.skyline.size();)
+    {
+        if (atlas.skyline[i].y == atlas.skyline[i + 1].y)
+        {
+            atlas.skyline[i].width += atlas.skyline[i + 1].width;
+            atlas.skyline.erase(atlas.skyline.begin() + i + 1);
+        }
+        else
+            ++i;
+    }
+
+    *pX = (uint32_t)bestX;
+    *pY = (uint32_t)bestY;
+    return true;
+}
+
+static void REI_NanoVG_resetAtlas(REI_NanoVG_atlas& atlas, uint32_t size)
+{
+    REI_NanoVG_skylineNode node = { 0, 0, (int)size };
+    atlas.skyline.clear();
+    atlas.skyline.push_back(node);
+    atlas.imageCount = 0;
+}
+
+// Places an RGBA image into an atlas with the same mip setting, adding a new atlas when all of them are full
+static bool REI_NanoVG_packImage(REI_NanoVG_State* state, REI_NanoVG_texture& tex, uint32_t mipLevels)
+{
+    const uint32_t size = state->desc.atlasSize;
+    const uint32_t w = REI_align_up(tex.width + 2 * ATLAS_GUTTER, ATLAS_ALIGNMENT);
+    const uint32_t h = REI_align_up(tex.height + 2 * ATLAS_GUTTER, ATLAS_ALIGNMENT);
+
+    size_t atlasIndex = 0;
+    for (; atlasIndex < state->atlases.size(); ++atlasIndex)
+    {
+        REI_NanoVG_atlas& atlas = state->atlases[atlasIndex];
+        if (atlas.mipLevels == mipLevels && REI_NanoVG_skylinePack(atlas, (int)size, (int)w, (int)h, &tex.x, &tex.y))
+            break;
+    }
+
+    if (atlasIndex == state->atlases.size())
+    {
+        if (state->freeTables.empty())
+            return false;
+
+        REI_TextureDesc desc{};
+        desc.width = size;
+        desc.height = size;
+        desc.mipLevels = mipLevels;
+        desc.format = REI_FMT_R8G8B8A8_UNORM;
+        desc.descriptors = REI_DESCRIPTOR_TYPE_TEXTURE;
+
+        state->atlases.emplace_back(REI_NanoVG_atlas{ NULL, state->freeTables.back(), mipLevels, 0,
+                                                      REI_vector<REI_NanoVG_skylineNode>(
+                                                          REI_allocator<REI_NanoVG_skylineNode>(state->allocator)) });
+        state->freeTables.pop_back();
+        REI_NanoVG_atlas& atlas = state->atlases.back();
+        REI_addTexture(state->renderer, &desc, &atlas.tex);
+        REI_NanoVG_resetAtlas(atlas, size);
+
+        REI_DescriptorData descrUpdateDesc{};
+        descrUpdateDesc.descriptorType = REI_DESCRIPTOR_TYPE_TEXTURE;
+        descrUpdateDesc.descriptorIndex = 0;    //uTexture;
+        descrUpdateDesc.ppTextures = &atlas.tex;
+        descrUpdateDesc.count = 1;
+        descrUpdateDesc.tableIndex = atlas.table;
+        REI_updateDescriptorTableArray(state->renderer, state->texDescriptorSet, 1, &descrUpdateDesc);
+
+        if (!REI_NanoVG_skylinePack(atlas, (int)size, (int)w, (int)h, &tex.x, &tex.y))
+            return false;
+    }
+
+    REI_NanoVG_atlas& atlas = state->atlases[atlasIndex];
+    ++atlas.imageCount;
+    tex.atlas = (uint32_t)atlasIndex + 1;
+    tex.table = atlas.table;
+    tex.mipLevels = mipLevels;
+    tex.x += ATLAS_GUTTER;
+    tex.y += ATLAS_GUTTER;
+    return true;
+}
+
+// Box filters a level into the next one, odd sides repeat their last texel
+static void REI_NanoVG_downsample(uint8_t* dst, const uint8_t* src, uint32_t w, uint32_t h, uint32_t bpp)
+{
+    const uint32_t dw = REI_max(w >> 1, 1u);
+    const uint32_t dh = REI_max(h >> 1, 1u);
+    for (uint32_t y = 0; y < dh; ++y)
+    {
+        const uint8_t* row0 = src + (size_t)REI_min(2 * y, h - 1) * w * bpp;
+        const uint8_t* row1 = src + (size_t)REI_min(2 * y + 1, h - 1) * w * bpp;
+        for (uint32_t x = 0; x < dw; ++x)
+        {
+            const uint32_t x0 = REI_min(2 * x, w - 1) * bpp;
+            const uint32_t x1 = REI_min(2 * x + 1, w - 1) * bpp;
+            for (uint32_t c = 0; c < bpp; ++c)
+                *dst++ = (uint8_t)((row0[x0 + c] + row0[x1 + c] + row1[x0 + c] + row1[x1 + c] + 2) >> 2);
+        }
+    }
+}
+
+static void REI_NanoVG_uploadLevel(
+    REI_NanoVG_State* state, REI_Texture* texture, REI_Format format, uint32_t mipLevel, uint32_t x, uint32_t y,
+    uint32_t w, uint32_t h, const uint8_t* data, REI_RL_Priority priority, REI_RL_RequestId* token)
+{
+    const uint32_t bpp = format == REI_FMT_R8_UNORM ? 1 : 4;
+
+    REI_RL_TextureUpdateDesc updateDesc{};
+    updateDesc.pTexture = texture;
+    updateDesc.format = format;
+    updateDesc.width = w;
+    updateDesc.height = h;
+    updateDesc.depth = 1;
+    updateDesc.arrayLayer = 0;
+    updateDesc.mipLevel = mipLevel;
+    updateDesc.x = x;
+    updateDesc.y = y;
+    updateDesc.z = 0;
+    updateDesc.endState = REI_RESOURCE_STATE_SHADER_RESOURCE;
+    updateDesc.priority = priority;
+
+    REI_RL_UpdateMemory updateMemory;
+    REI_RL_beginUpdate(state->loader, &updateDesc, &updateMemory);
+    for (uint32_t row = 0; row < h; ++row)
+        memcpy(updateMemory.pData + (size_t)row * updateMemory.rowPitch, data + (size_t)row * w * bpp, (size_t)w * bpp);
+    REI_RL_endUpdate(state->loader, &updateDesc, &updateMemory, token);
+}
+
+// Uploads the whole image with all of its mip levels, atlas images together with their gutter
+static void REI_NanoVG_uploadImage(REI_NanoVG_State* state, const REI_NanoVG_texture& tex, const unsigned char* data)
+{
+    const bool       isL8 = tex.flags & NVGL_TEXTURE_LUMINANCE;
+    const uint32_t   bpp = isL8 ? 1 : 4;
+    const REI_Format format = isL8 ? REI_FMT_R8_UNORM : REI_FMT_R8G8B8A8_UNORM;
+
+    REI_Texture* texture = tex.tex;
+    uint32_t     x = 0, y = 0, w = tex.width, h = tex.height;
+    size_t       levelSize = (size_t)w * h * bpp;
+    if (tex.atlas)
+    {
+        texture = state->atlases[tex.atlas - 1].tex;
+        x = tex.x - ATLAS_GUTTER;
+        y = tex.y - ATLAS_GUTTER;
+        w = REI_align_up(tex.width + 2 * ATLAS_GUTTER, ATLAS_ALIGNMENT);
+        h = REI_align_up(tex.height + 2 * ATLAS_GUTTER, ATLAS_ALIGNMENT);
+        levelSize = (size_t)w * h * bpp;
+    }
+
+    uint8_t* scratch = NULL;
+    if (tex.atlas || tex.mipLevels > 1)
+    {
+        // Two levels, the first one is large enough for any of them
+        scratch = (uint8_t*)state->allocator.pMalloc(
+            state->allocator.pUserData, levelSize + levelSize / 4 + bpp, REI_DEFAULT_MALLOC_ALIGNMENT);
+        if (!scratch)
+            return;
+    }
+
+    const uint8_t* level = data;
+    if (tex.atlas)
+    {
+        uint8_t* dst = scratch;
+        for (uint32_t py = 0; py < h; ++py)
+        {
+            const uint32_t sy = (uint32_t)REI_min(REI_max((int)py - (int)ATLAS_GUTTER, 0), (int)tex.height - 1);
+            for (uint32_t px = 0; px < w; ++px, dst += bpp)
+            {
+                const uint32_t sx = (uint32_t)REI_min(REI_max((int)px - (int)ATLAS_GUTTER, 0), (int)tex.width - 1);
+                memcpy(dst, data + ((size_t)sy * tex.width + sx) * bpp, bpp);
+            }
+        }
+        level = scratch;
+    }
+
+    REI_RL_RequestId token = 0;
+    for (uint32_t mip = 0; mip < tex.mipLevels; ++mip)
+    {
+        REI_NanoVG_uploadLevel(
+            state, texture, format, mip, x >> mip, y >> mip, w, h, level, REI_RL_PRIORITY_HIGH, &token);
+        if (mip + 1 == tex.mipLevels)
+            break;
+
+        // Levels alternate between the two halves of the scratch memory
+        uint8_t* next = level == scratch ? scratch + levelSize : scratch;
+        REI_NanoVG_downsample(next, level, w, h, bpp);
+        level = next;
+        w = REI_max(w >> 1, 1u);
+        h = REI_max(h >> 1, 1u);
+    }
+    // The levels are in the staging memory already, draws wait for the copies only when they bind the image. All
+    // uploads use one priority, the loader completes them in order and the last token covers the earlier ones
+    state->tableUploads[tex.table] = token;
+
+    if (scratch)
+        state->allocator.pFree(state->allocator.pUserData, scratch);
+}
+
 static int REI_NanoVG_renderCreateTexture(void* uptr, int type, int w, int h, int imageFlags, const unsigned char* data)
 {
     REI_NanoVG_State* state = (REI_NanoVG_State*)uptr;
 
-    auto it = std::find_if(
-        state->textures.begin() + 1, state->textures.end(), [](REI_NanoVG_texture& tex) { return tex.tex == 0; });
+    auto it = std::find_if(state->textures.begin() + 1, state->textures.end(), [](REI_NanoVG_texture& tex) {
+        return tex.tex == 0 && tex.atlas == 0;
+    });
     size_t idx = it - state->textures.begin();
     if (idx == state->textures.size())
         state->textures.emplace_back();
@@ -526,50 +974,67 @@ static int REI_NanoVG_renderCreateTexture(void* uptr, int type, int w, int h, in
     tex.height = h;
 
     const bool formatR8 = type == NVG_TEXTURE_ALPHA;
-    //const bool useMipmaps = (imageFlags & NVG_IMAGE_GENERATE_MIPMAPS) != 0;
+    const bool useMipmaps = (imageFlags & NVG_IMAGE_GENERATE_MIPMAPS) != 0;
 
     if (formatR8)
         tex.flags |= NVGL_TEXTURE_LUMINANCE;
 
-    REI_TextureDesc desc{};
-    desc.width = w;
-    desc.height = h;
-    desc.mipLevels = /*useMipmaps ? bit_fls(core::max<uint32_t>(w, h)) :*/ 1;
-    desc.format = formatR8 ? REI_FMT_R8_UNORM : REI_FMT_R8G8B8A8_UNORM;
-    desc.descriptors = REI_DESCRIPTOR_TYPE_TEXTURE;
-    REI_addTexture(state->renderer, &desc, &tex.tex);
+    // Small RGBA images share atlas textures, so calls using different ones still batch into one draw
+    const bool packed = !formatR8 && (uint32_t)REI_max(w, h) <= state->desc.maxAtlasImageSize &&
+                        REI_NanoVG_packImage(state, tex, useMipmaps ? ATLAS_MIP_LEVELS : 1);
 
-    if (data)
+    if (!packed)
     {
-        REI_RL_TextureUpdateDesc updateDesc{};
-        updateDesc.pTexture = tex.tex;
-        updateDesc.pRawData = (uint8_t*)data;
-        updateDesc.format = (REI_Format)desc.format;
-        updateDesc.width = desc.width;
-        updateDesc.height = desc.height;
-        updateDesc.depth = 1;
-        updateDesc.arrayLayer = 0;
-        updateDesc.mipLevel = 0;// for desc.mipLevels;
-        updateDesc.x = 0;
-        updateDesc.y = 0;
-        updateDesc.z = 0;
-        updateDesc.endState = REI_RESOURCE_STATE_SHADER_RESOURCE;
-        REI_RL_updateResource(state->loader, &updateDesc);
-    }
+        if (state->freeTables.empty())
+            return 0;
 
-    REI_DescriptorData descrUpdateDesc{};
-    descrUpdateDesc.descriptorType = REI_DESCRIPTOR_TYPE_TEXTURE;
-    descrUpdateDesc.descriptorIndex = 0; //uTexture;
-    descrUpdateDesc.ppTextures = &tex.tex;
-    descrUpdateDesc.count = 1;
-    descrUpdateDesc.tableIndex = (uint32_t)idx;
-    REI_updateDescriptorTableArray(state->renderer, state->texDescriptorSet, 1, &descrUpdateDesc);
+        tex.mipLevels = 1;
+        if (useMipmaps)
+            while ((uint32_t)REI_max(w, h) >> tex.mipLevels)
+                ++tex.mipLevels;
+        tex.table = state->freeTables.back();
+        state->freeTables.pop_back();
+
+        REI_TextureDesc desc{};
+        desc.width = w;
+        desc.height = h;
+        desc.mipLevels = tex.mipLevels;
+        desc.format = formatR8 ? REI_FMT_R8_UNORM : REI_FMT_R8G8B8A8_UNORM;
+        desc.descriptors = REI_DESCRIPTOR_TYPE_TEXTURE;
+        REI_addTexture(state->renderer, &desc, &tex.tex);
+
+        REI_DescriptorData descrUpdateDesc{};
+        descrUpdateDesc.descriptorType = REI_DESCRIPTOR_TYPE_TEXTURE;
+        descrUpdateDesc.descriptorIndex = 0; //uTexture;
+        descrUpdateDesc.ppTextures = &tex.tex;
+        descrUpdateDesc.count = 1;
+        descrUpdateDesc.tableIndex = tex.table;
+        REI_updateDescriptorTableArray(state->renderer, state->texDescriptorSet, 1, &descrUpdateDesc);
+    }
 
-    //TODO support mips and mips generation
+    if (data)
+        REI_NanoVG_uploadImage(state, tex, data);
 
     return (int)idx;
 }
 
+static void REI_NanoVG_releaseTable(void* userPtr, uint64_t table)
+{
+    REI_NanoVG_State* state = (REI_NanoVG_State*)userPtr;
+    state->tableUploads[table] = 0;
+    state->freeTables.push_back((uint32_t)table);
+}
+
+static void REI_NanoVG_releaseAtlasImage(void* userPtr, uint64_t atlasIndex)
+{
+    REI_NanoVG_State* state = (REI_NanoVG_State*)userPtr;
+
+    // Atlas space is only reclaimed once all of its images are deleted
+    REI_NanoVG_atlas& atlas = state->atlases[atlasIndex];
+    if (--atlas.imageCount == 0)
+        REI_NanoVG_resetAtlas(atlas, state->desc.atlasSize);
+}
+
 static int REI_NanoVG_renderDeleteTexture(void* uptr, int image)
 {
     REI_NanoVG_State* state = (REI_NanoVG_State*)uptr;
@@ -577,10 +1042,23 @@ static int REI_NanoVG_renderDeleteTexture(void* uptr, int image)
         return 0;
     REI_NanoVG_texture& tex = state->textures[image];
 
-    if (tex.tex != 0 && (tex.flags & NVGL_TEXTURE_NODELETE) == 0)
+    // Frames in flight may still sample the image, its texture, table and atlas space are released once they
+    // complete
+    if (tex.atlas)
     {
-        REI_waitQueueIdle(state->queue);
-        REI_removeTexture(state->renderer, tex.tex);
+        REI_DQ_release(state->deletionQueue, REI_NanoVG_releaseAtlasImage, state, tex.atlas - 1);
+    }
+    else if (tex.tex != 0)
+    {
+        // The deletion queue only waits for the frames, copies of an image that was never drawn may still be running
+        if (state->tableUploads[tex.table])
+        {
+            REI_RL_waitTokenCompleted(state->loader, state->tableUploads[tex.table]);
+            state->tableUploads[tex.table] = 0;
+        }
+        if ((tex.flags & NVGL_TEXTURE_NODELETE) == 0)
+            REI_DQ_removeTexture(state->deletionQueue, tex.tex);
+        REI_DQ_release(state->deletionQueue, REI_NanoVG_releaseTable, state, tex.table);
     }
     memset(&tex, 0, sizeof(REI_NanoVG_texture));
 
@@ -594,6 +1072,13 @@ static int REI_NanoVG_renderUpdateTexture(void* uptr, int image, int x, int y, i
         return 0;
     REI_NanoVG_texture& tex = state->textures[image];
 
+    // Gutters and mip levels depend on the whole image
+    if (tex.atlas || tex.mipLevels > 1)
+    {
+        REI_NanoVG_uploadImage(state, tex, data);
+        return 1;
+    }
+
     bool isL8 = tex.flags & NVGL_TEXTURE_LUMINANCE;
 
     if (isL8)
@@ -617,7 +1102,8 @@ static int REI_NanoVG_renderUpdateTexture(void* uptr, int image, int x, int y, i
     updateDesc.y = y;
     updateDesc.z = 0;
     updateDesc.endState = REI_RESOURCE_STATE_SHADER_RESOURCE;
-    REI_RL_updateResource(state->loader, &updateDesc);
+    updateDesc.priority = REI_RL_PRIORITY_HIGH;
+    REI_RL_updateResource(state->loader, &updateDesc, &state->tableUploads[tex.table]);
 
     // Handled in resource loader?
     //REI_TextureBarrier texBarrier{ tex.tex, REI_RESOURCE_STATE_SHADER_RESOURCE, false };
@@ -714,6 +1200,24 @@ static int REI_NanoVG_convertPaint(
             frag->texType = 2;
         else
             frag->texType = (tex.flags & NVGL_TEXTURE_PREMULTIPLIED) ? 0 : 1;
+
+        if (tex.atlas)
+        {
+            float invSize = 1.0f / (float)state->desc.atlasSize;
+            frag->atlasRect[0] = tex.x * invSize;
+            frag->atlasRect[1] = tex.y * invSize;
+            frag->atlasRect[2] = tex.width * invSize;
+            frag->atlasRect[3] = tex.height * invSize;
+            frag->atlasClamp[0] = (tex.x + 0.5f) * invSize;
+            frag->atlasClamp[1] = (tex.y + 0.5f) * invSize;
+            frag->atlasClamp[2] = (tex.x + tex.width - 0.5f) * invSize;
+            frag->atlasClamp[3] = (tex.y + tex.height - 0.5f) * invSize;
+        }
+        else
+        {
+            frag->atlasRect[2] = frag->atlasRect[3] = 1.0f;
+            frag->atlasClamp[2] = frag->atlasClamp[3] = 1.0f;
+        }
     }
     else
     {
@@ -728,25 +1232,92 @@ static int REI_NanoVG_convertPaint(
     return 1;
 }
 
-static void REI_NanoVG_setUniforms(REI_NanoVG_State* state, uint32_t uniformIndex, int imageIndex)
+// Binds the state shared by all calls of a flush. Pipelines, textures and vertex buffers are rebound only when a
+// call changes them
+static void REI_NanoVG_beginFlush(REI_NanoVG_State* state)
 {
-    uint64_t vertex_offset = 0;
-    float    scaleTranslate[4];
-
-    scaleTranslate[0] = 2.0f / state->width;
-    scaleTranslate[1] = -2.0f / state->height;
-    scaleTranslate[2] = -1.0f;
-    scaleTranslate[3] = 1.0f;
+    // Other renderers may have used the command buffer since the last flush
+    state->boundPipeline = NULL;
+    state->boundVertexBuffer = NULL;
+    state->boundReplay = ~0u;
+    state->boundTable = ~0u;
 
     REI_cmdBindDescriptorTable(state->cmd, state->setIndex, state->uniDescriptorSet);
-    REI_cmdBindDescriptorTable(state->cmd, (uint32_t)imageIndex, state->texDescriptorSet);
-    REI_cmdBindPushConstants(
-        state->cmd, state->rootSignature, REI_SHADER_STAGE_VERT, 0, sizeof(scaleTranslate), scaleTranslate);
-    REI_cmdBindPushConstants(
-        state->cmd, state->rootSignature, REI_SHADER_STAGE_FRAG, sizeof(scaleTranslate), sizeof(uniformIndex),
-        &uniformIndex);
-    REI_cmdBindVertexBuffer(state->cmd, 1, &state->vtxBuffers[state->setIndex], &vertex_offset);
     REI_cmdSetViewport(state->cmd, 0.0f, 0.0f, (float)state->width, (float)state->height, 0.0f, 1.0f);
+    REI_cmdSetStencilRef(state->cmd, REI_STENCIL_FACE_FRONT_AND_BACK, 0);
+    ++state->stats.tableBinds;
+}
+
+// Immediate calls use the frame buffers and no transform, calls of retained groups the transform and
+// uniforms of their replay
+static void REI_NanoVG_bindReplay(REI_NanoVG_State* state, uint32_t replay)
+{
+    if (state->boundReplay == replay)
+        return;
+
+    static const float         identity[6] = { 1.0f, 0.0f, 0.0f, 1.0f, 0.0f, 0.0f };
+    REI_NanoVG_vertexConstants constants;
+    constants.scaleTranslate[0] = 2.0f / state->width;
+    constants.scaleTranslate[1] = -2.0f / state->height;
+    constants.scaleTranslate[2] = -1.0f;
+    constants.scaleTranslate[3] = 1.0f;
+    memcpy(constants.xform, identity, sizeof(constants.xform));
+    constants.paintBase = 0;
+
+    REI_Buffer* vertexBuffers[2] = { state->vtxBuffers[state->setIndex], state->paintBuffers[state->setIndex] };
+    uint64_t    vertexOffsets[2] = {};
+    if (replay)
+    {
+        const REI_NanoVG_replay& r = state->replays[replay - 1];
+        memcpy(constants.xform, r.xform, sizeof(constants.xform));
+        constants.paintBase = r.paintBase;
+        if (r.vtxBuffer)
+        {
+            vertexBuffers[0] = r.vtxBuffer;
+            vertexBuffers[1] = r.paintBuffer;
+        }
+    }
+
+    REI_cmdBindPushConstants(
+        state->cmd, state->rootSignature, REI_SHADER_STAGE_VERT, 0, sizeof(constants), &constants);
+    if (state->boundVertexBuffer != vertexBuffers[0])
+    {
+        REI_cmdBindVertexBuffer(state->cmd, 2, vertexBuffers, vertexOffsets);
+        state->boundVertexBuffer = vertexBuffers[0];
+    }
+    state->boundReplay = replay;
+}
+
+static void REI_NanoVG_bindPipeline(REI_NanoVG_State* state, REI_Pipeline* pipeline)
+{
+    if (state->boundPipeline == pipeline)
+        return;
+
+    REI_cmdBindPipeline(state->cmd, pipeline);
+    state->boundPipeline = pipeline;
+    ++state->stats.pipelineBinds;
+}
+
+static void REI_NanoVG_bindTable(REI_NanoVG_State* state, uint32_t table)
+{
+    if (state->boundTable == table)
+        return;
+
+    if (state->tableUploads[table])
+    {
+        REI_RL_waitTokenCompleted(state->loader, state->tableUploads[table]);
+        state->tableUploads[table] = 0;
+    }
+
+    REI_cmdBindDescriptorTable(state->cmd, table, state->texDescriptorSet);
+    state->boundTable = table;
+    ++state->stats.tableBinds;
+}
+
+static void REI_NanoVG_draw(REI_NanoVG_State* state, uint32_t count, uint32_t first)
+{
+    REI_cmdDraw(state->cmd, count, first);
+    ++state->stats.drawCount;
 }
 
 static void REI_NanoVG_renderViewport(void* uptr, int width, int height, float devicePixelRatio)
@@ -758,55 +1329,58 @@ static void REI_NanoVG_renderViewport(void* uptr, int width, int height, float d
 
 static void REI_NanoVG_fill(REI_NanoVG_State* state, REI_NanoVG_call& call)
 {
-    // Draw shapes
-    REI_cmdBindPipeline(state->cmd, state->maskPipeline);
-    REI_cmdSetStencilRef(state->cmd, REI_STENCIL_FACE_FRONT_AND_BACK, 0);
-    REI_NanoVG_setUniforms(state, 0, 0);
-    REI_cmdDraw(state->cmd, call.fillCount, call.fillOffset);
+    // Draw shapes, color writes are masked so any texture will do
+    REI_NanoVG_bindPipeline(state, state->maskPipeline);
+    if (state->boundTable == ~0u)
+        REI_NanoVG_bindTable(state, 0);
+    REI_NanoVG_draw(state, call.fillCount, call.fillOffset);
 
     // Draw fill
-    REI_cmdBindPipeline(state->cmd, state->drawPipeline);
-    REI_cmdSetStencilRef(state->cmd, REI_STENCIL_FACE_FRONT_AND_BACK, 0);
-    REI_NanoVG_setUniforms(state, call.uniformIndex, call.image);
-    REI_cmdDraw(state->cmd, call.triangleCount, call.triangleOffset);
+    REI_NanoVG_bindPipeline(state, state->drawPipeline);
+    REI_NanoVG_bindTable(state, call.table);
+    REI_NanoVG_draw(state, call.triangleCount, call.triangleOffset);
 }
 
 static void REI_NanoVG_convexFill(REI_NanoVG_State* state, REI_NanoVG_call& call)
 {
-    REI_cmdBindPipeline(state->cmd, state->fillPipeline);
-    REI_NanoVG_setUniforms(state, call.uniformIndex, call.image);
-    REI_cmdDraw(state->cmd, call.fillCount, call.fillOffset);
+    REI_NanoVG_bindPipeline(state, state->fillPipeline);
+    REI_NanoVG_bindTable(state, call.table);
+    REI_NanoVG_draw(state, call.fillCount, call.fillOffset);
 }
 
 static void REI_NanoVG_stroke(REI_NanoVG_State* state, REI_NanoVG_call& call)
 {
     // Draw Strokes
-    REI_cmdBindPipeline(state->cmd, state->fillPipeline);
-    REI_NanoVG_setUniforms(state, call.uniformIndex, call.image);
-    REI_cmdDraw(state->cmd, call.strokeCount, call.strokeOffset);
+    REI_NanoVG_bindPipeline(state, state->fillPipeline);
+    REI_NanoVG_bindTable(state, call.table);
+    REI_NanoVG_draw(state, call.strokeCount, call.strokeOffset);
 }
 
 static void REI_NanoVG_triangles(REI_NanoVG_State* state, REI_NanoVG_call& call)
 {
-    REI_cmdBindPipeline(state->cmd, state->triPipeline);
-    REI_NanoVG_setUniforms(state, call.uniformIndex, call.image);
-    REI_cmdDraw(state->cmd, call.triangleCount, call.triangleOffset);
+    REI_NanoVG_bindPipeline(state, state->triPipeline);
+    REI_NanoVG_bindTable(state, call.table);
+    REI_NanoVG_draw(state, call.triangleCount, call.triangleOffset);
 }
 
 static void REI_NanoVG_renderCancel(void* uptr)
 {
     REI_NanoVG_State* state = (REI_NanoVG_State*)uptr;
     state->calls.clear();
+    state->replays.clear();
 }
 
 static void REI_NanoVG_renderFlush(void* uptr, NVGcompositeOperationState compositeOperation)
 {
     REI_NanoVG_State* state = (REI_NanoVG_State*)uptr;
+    REI_ASSERT(!state->recording, "REI_NanoVG_EndRetained has to be called before the frame ends");
 
     if (!state->calls.empty())
     {
+        REI_NanoVG_beginFlush(state);
         for (REI_NanoVG_call& call: state->calls)
         {
+            REI_NanoVG_bindReplay(state, call.replay);
             if (call.type == GLNVG_FILL)
                 REI_NanoVG_fill(state, call);
             else if (call.type == GLNVG_CONVEXFILL)
@@ -820,6 +1394,7 @@ static void REI_NanoVG_renderFlush(void* uptr, NVGcompositeOperationState compos
 
     // Reset calls
     state->calls.clear();
+    state->replays.clear();
 }
 
 static int REI_NanoVG_uploadeStrokes(REI_NanoVG_State* state, REI_NanoVG_call& call, const NVGpath* paths, int npaths)
@@ -836,7 +1411,7 @@ static int REI_NanoVG_uploadeStrokes(REI_NanoVG_State* state, REI_NanoVG_call& c
     call.strokeCount = maxverts;
     call.strokeOffset = state->vtxCount;
 
-    NVGvertex* vtx = allocVertices(state, maxverts);
+    NVGvertex* vtx = allocVertices(state, maxverts, call.uniformIndex);
     if (!vtx)
         return 0;
 
@@ -858,6 +1433,26 @@ static int REI_NanoVG_uploadeStrokes(REI_NanoVG_State* state, REI_NanoVG_call& c
     return 1;
 }
 
+// Writes nfill + 1 vertices, the last one repeated so strips can be joined
+static NVGvertex* REI_NanoVG_writeFillStrip(NVGvertex* vtx, const NVGvertex* fill, uint32_t nfill)
+{
+    *vtx++ = fill[0];
+    int avtx = nfill & 1;
+    int halfvcount = (nfill - 1) / 2;
+    int j = 1;
+    for (; j <= halfvcount; ++j)
+    {
+        *vtx++ = fill[j];
+        *vtx++ = fill[nfill - j];
+    }
+    if (avtx == 0)
+    {
+        *vtx++ = fill[j];
+    }
+    *vtx++ = fill[j - avtx];
+    return vtx;
+}
+
 static int REI_NanoVG_uploadeFills(REI_NanoVG_State* state, REI_NanoVG_call& call, const NVGpath* paths, int npaths)
 {
     // Allocate vertices for all the paths.
@@ -875,7 +1470,7 @@ static int REI_NanoVG_uploadeFills(REI_NanoVG_State* state, REI_NanoVG_call& cal
     call.fillCount = maxverts;
     call.fillOffset = state->vtxCount;
 
-    NVGvertex* vtx = allocVertices(state, maxverts);
+    NVGvertex* vtx = allocVertices(state, maxverts, call.uniformIndex);
     if (!vtx)
         return 0;
 
@@ -885,29 +1480,62 @@ static int REI_NanoVG_uploadeFills(REI_NanoVG_State* state, REI_NanoVG_call& cal
         uint32_t       nfill = path->nfill;
         if (nfill > 2)
         {
-            NVGvertex* fill = path->fill;
             if (i > 0)
-                *vtx++ = fill[0];
-            *vtx++ = fill[0];
-            int avtx = nfill & 1;
-            int halfvcount = (nfill - 1) / 2;
-            int j = 1;
-            for (; j <= halfvcount; ++j)
-            {
-                *vtx++ = fill[j];
-                *vtx++ = fill[nfill - j];
-            }
-            if (avtx == 0)
-            {
-                *vtx++ = fill[j];
-            }
-            *vtx++ = fill[j - avtx];
+                *vtx++ = path->fill[0];
+            vtx = REI_NanoVG_writeFillStrip(vtx, path->fill, nfill);
         }
     }
 
     return 1;
 }
 
+// Convex fills recorded one after another with the same texture extend a single strip. Degenerate triangles join the
+// paths and start each one on an even vertex, so its winding is kept for back face culling.
+static void REI_NanoVG_renderConvexFill(
+    REI_NanoVG_State* state, NVGpaint* paint, NVGscissor* scissor, float fringe, const NVGpath* path)
+{
+    uint32_t nfill = path->nfill;
+    if (nfill < 3)
+        return;
+
+    uint32_t                 uniformIndex = state->uniCount;
+    REI_NanoVG_fragUniforms* frag = allocUniformData(state);
+    if (!frag)
+        return;
+    REI_NanoVG_convertPaint(state, frag, paint, scissor, fringe, fringe, -1.0f);
+
+    REI_NanoVG_call* prev = state->calls.empty() ? NULL : &state->calls.back();
+    bool             merge = prev && prev->type == GLNVG_CONVEXFILL && !prev->replay && prev->table == REI_NanoVG_imageTable(state, paint->image) &&
+                 prev->fillOffset + prev->fillCount == state->vtxCount;
+    uint32_t joinCount = merge ? 2 - (prev->fillCount & 1) : 0;
+    uint32_t count = joinCount + nfill + 1;
+
+    NVGvertex* vtx = allocVertices(state, count, uniformIndex);
+    if (!vtx)
+    {
+        freeUniformData(state);
+        return;
+    }
+
+    for (uint32_t i = 0; i < joinCount; ++i)
+        *vtx++ = path->fill[0];
+    REI_NanoVG_writeFillStrip(vtx, path->fill, nfill);
+
+    if (merge)
+    {
+        prev->fillCount += count;
+        return;
+    }
+
+    state->calls.emplace_back();
+    REI_NanoVG_call& call = state->calls.back();
+    call.type = GLNVG_CONVEXFILL;
+    call.table = REI_NanoVG_imageTable(state, paint->image);
+    call.fillOffset = state->vtxCount - count;
+    call.fillCount = count;
+    call.uniformIndex = uniformIndex;
+}
+
 static void REI_NanoVG_renderFill(
     void* uptr, NVGpaint* paint, NVGscissor* scissor, float fringe, const float* bounds, const NVGpath* paths,
     int npaths)
@@ -916,21 +1544,28 @@ static void REI_NanoVG_renderFill(
     REI_NanoVG_fragUniforms* frag;
     NVGvertex*               vtx;
 
+    ++state->stats.callCount;
+    if (npaths == 1 && paths[0].convex)
+    {
+        REI_NanoVG_renderConvexFill(state, paint, scissor, fringe, &paths[0]);
+        return;
+    }
+
     state->calls.emplace_back();
     REI_NanoVG_call& call = state->calls.back();
 
-    call.type = (npaths == 1 && paths[0].convex) ? GLNVG_CONVEXFILL : GLNVG_FILL;
-    call.image = paint->image;
+    call.type = GLNVG_FILL;
+    call.table = REI_NanoVG_imageTable(state, paint->image);
+    call.uniformIndex = state->uniCount;
 
     if (!REI_NanoVG_uploadeFills(state, call, paths, npaths) || !REI_NanoVG_uploadeStrokes(state, call, paths, npaths))
         goto error;
 
     call.triangleOffset = state->vtxCount;
     call.triangleCount = 6;
-    call.uniformIndex = state->uniCount;
 
     // Quad
-    vtx = allocVertices(state, 6);
+    vtx = allocVertices(state, 6, call.uniformIndex);
     if (!vtx)
         goto error;
 
@@ -962,11 +1597,12 @@ static void REI_NanoVG_renderStroke(
 {
     REI_NanoVG_State*        state = (REI_NanoVG_State*)uptr;
     REI_NanoVG_fragUniforms* frag;
+    ++state->stats.callCount;
     state->calls.emplace_back();
     REI_NanoVG_call& call = state->calls.back();
 
     call.type = GLNVG_STROKE;
-    call.image = paint->image;
+    call.table = REI_NanoVG_imageTable(state, paint->image);
     call.uniformIndex = state->uniCount;
 
     if (!REI_NanoVG_uploadeStrokes(state, call, paths, npaths))
@@ -987,42 +1623,51 @@ error:
         state->calls.pop_back();
 }
 
+// Triangles recorded one after another with the same texture are appended to the previous call
 static void
     REI_NanoVG_renderTriangles(void* uptr, NVGpaint* paint, NVGscissor* scissor, const NVGvertex* verts, int nverts)
 {
     REI_NanoVG_State* state = (REI_NanoVG_State*)uptr;
 
-    state->calls.emplace_back();
-    REI_NanoVG_call& call = state->calls.back();
-
     if (nverts < 3)
         return;
 
-    call.type = GLNVG_TRIANGLES;
-    call.image = paint->image;
-    call.triangleCount = nverts;
-    call.triangleOffset = state->vtxCount;
-    call.uniformIndex = state->uniCount;
+    ++state->stats.callCount;
 
-    // Allocate vertices for all the paths.
-    NVGvertex*               vtx = allocVertices(state, nverts);
+    uint32_t                 uniformIndex = state->uniCount;
     REI_NanoVG_fragUniforms* frag = allocUniformData(state);
-    if (!vtx || !frag)
-        goto error;
-
-    memcpy(vtx, verts, sizeof(NVGvertex) * nverts);
+    if (!frag)
+        return;
 
     // Fill shader
     REI_NanoVG_convertPaint(state, frag, paint, scissor, 1.0f, 1.0f, -1.0f);
     frag->type = NSVG_SHADER_IMG;
 
-    return;
+    // Allocate vertices for all the paths.
+    NVGvertex* vtx = allocVertices(state, nverts, uniformIndex);
+    if (!vtx)
+    {
+        freeUniformData(state);
+        return;
+    }
 
-error:
-    // We get here if call alloc was ok, but something else is not.
-    // Roll back the last call to prevent drawing it.
-    if (!state->calls.empty())
-        state->calls.pop_back();
+    memcpy(vtx, verts, sizeof(NVGvertex) * nverts);
+
+    REI_NanoVG_call* prev = state->calls.empty() ? NULL : &state->calls.back();
+    if (prev && prev->type == GLNVG_TRIANGLES && !prev->replay && prev->table == REI_NanoVG_imageTable(state, paint->image) &&
+        prev->triangleOffset + prev->triangleCount == state->vtxCount - nverts)
+    {
+        prev->triangleCount += nverts;
+        return;
+    }
+
+    state->calls.emplace_back();
+    REI_NanoVG_call& call = state->calls.back();
+    call.type = GLNVG_TRIANGLES;
+    call.table = REI_NanoVG_imageTable(state, paint->image);
+    call.triangleCount = nverts;
+    call.triangleOffset = state->vtxCount - nverts;
+    call.uniformIndex = uniformIndex;
 }
 
 NVGcontext* REI_NanoVG_Init(REI_Renderer* renderer, REI_Queue* queue, REI_RL_State* loader, REI_NanoVG_Desc* info)
@@ -1061,6 +1706,12 @@ NVGcontext* REI_NanoVG_Init(REI_Renderer* renderer, REI_Queue* queue, REI_RL_Sta
 
     new (&state->textures) REI_vector<REI_NanoVG_texture>(REI_allocator<REI_NanoVG_texture>(state->allocator));
     new (&state->calls) REI_vector<REI_NanoVG_call>(REI_allocator<REI_NanoVG_call>(state->allocator));
+    new (&state->replays) REI_vector<REI_NanoVG_replay>(REI_allocator<REI_NanoVG_replay>(state->allocator));
+    new (&state->atlases) REI_vector<REI_NanoVG_atlas>(REI_allocator<REI_NanoVG_atlas>(state->allocator));
+    new (&state->freeTables) REI_vector<uint32_t>(REI_allocator<uint32_t>(state->allocator));
+    new (&state->tableUploads) REI_vector<REI_RL_RequestId>(REI_allocator<REI_RL_RequestId>(state->allocator));
+    new (&state->retained)
+        REI_NanoVG_retainedMap(REI_allocator<std::pair<const uint64_t, REI_NanoVG_retained*>>(state->allocator));
 
     return nvgCreateInternal(&params);
 }
@@ -1072,6 +1723,202 @@ void REI_NanoVG_SetupRender(NVGcontext* ctx, REI_Cmd* pCmd, uint32_t set_index)
     state->vtxCount = 0;
     state->uniCount = 1;
     state->setIndex = set_index;
+    memset(&state->stats, 0, sizeof(REI_NanoVG_Stats));
+    REI_DQ_beginResourceSet(state->deletionQueue, set_index);
+}
+
+void REI_NanoVG_GetStats(NVGcontext* ctx, REI_NanoVG_Stats* pStats)
+{
+    REI_NanoVG_State* state = (REI_NanoVG_State*)nvgInternalParams(ctx)->userPtr;
+    *pStats = state->stats;
 }
 
 void REI_NanoVG_Shutdown(NVGcontext* ctx) { nvgDeleteInternal(ctx); }
+
+bool REI_NanoVG_BeginRetained(NVGcontext* ctx, uint64_t key)
+{
+    REI_NanoVG_State* state = (REI_NanoVG_State*)nvgInternalParams(ctx)->userPtr;
+    REI_ASSERT(!state->recording, "Retained groups can't be nested");
+
+    REI_NanoVG_retained* group = NULL;
+    auto                 it = state->retained.find(key);
+    if (it != state->retained.end())
+    {
+#if REI_NANOVG_VALIDATE_RETAINED
+        // Recorded into a scratch group that EndRetained hashes and discards
+        state->validated = it->second;
+        group = REI_new<REI_NanoVG_retained>(state->allocator, state->allocator);
+#else
+        return false;
+#endif
+    }
+    else
+    {
+        group = REI_new<REI_NanoVG_retained>(state->allocator, state->allocator);
+        state->retained[key] = group;
+    }
+
+    // Calls are recorded with offsets relative to the group
+    state->recording = group;
+    state->frameVtxCount = state->vtxCount;
+    state->frameUniCount = state->uniCount;
+    state->vtxCount = 0;
+    state->uniCount = 0;
+    state->calls.swap(group->calls);
+    return true;
+}
+
+#if REI_NANOVG_VALIDATE_RETAINED
+static uint64_t REI_NanoVG_hashRetained(const REI_NanoVG_retained* group)
+{
+    uint64_t hash = REI_murmurHash2_x64_64(
+        group->vertices.data(), (int)(group->vertices.size() * sizeof(NVGvertex)), group->vertices.size());
+    hash = REI_murmurHash2_x64_64(group->paints.data(), (int)(group->paints.size() * sizeof(uint32_t)), hash);
+    hash = REI_murmurHash2_x64_64(
+        group->uniforms.data(), (int)(group->uniforms.size() * sizeof(REI_NanoVG_fragUniforms)), hash);
+    return REI_murmurHash2_x64_64(group->calls.data(), (int)(group->calls.size() * sizeof(REI_NanoVG_call)), hash);
+}
+#endif
+
+static void REI_NanoVG_uploadRetained(
+    REI_NanoVG_State* state, REI_NanoVG_retained* group, REI_Buffer* buffer, const void* data, uint64_t size)
+{
+    REI_RL_BufferUpdateDesc updateDesc = {};
+    updateDesc.pBuffer = buffer;
+    updateDesc.size = size;
+    REI_RL_UpdateMemory updateMemory;
+    REI_RL_beginUpdate(state->loader, &updateDesc, &updateMemory);
+    memcpy(updateMemory.pData, data, size);
+    // Same priority requests complete in order, the last token covers both buffers
+    REI_RL_endUpdate(state->loader, &updateDesc, &updateMemory, &group->uploadToken);
+}
+
+void REI_NanoVG_EndRetained(NVGcontext* ctx)
+{
+    REI_NanoVG_State*    state = (REI_NanoVG_State*)nvgInternalParams(ctx)->userPtr;
+    REI_NanoVG_retained* group = state->recording;
+    REI_ASSERT(group, "REI_NanoVG_EndRetained called without REI_NanoVG_BeginRetained");
+
+    state->calls.swap(group->calls);
+    state->vtxCount = state->frameVtxCount;
+    state->uniCount = state->frameUniCount;
+    group->vertexCount = (uint32_t)group->vertices.size();
+    state->recording = NULL;
+
+#if REI_NANOVG_VALIDATE_RETAINED
+    group->contentHash = REI_NanoVG_hashRetained(group);
+    if (state->validated)
+    {
+        REI_ASSERT(
+            group->contentHash == state->validated->contentHash,
+            "Retained group content changed under the same key, the group recorded first is drawn");
+        state->validated = NULL;
+        REI_delete(state->allocator, group);
+        return;
+    }
+#endif
+
+    if (group->vertexCount)
+    {
+        REI_BufferDesc vbDesc = {};
+        vbDesc.descriptors = REI_DESCRIPTOR_TYPE_VERTEX_BUFFER;
+        vbDesc.memoryUsage = REI_RESOURCE_MEMORY_USAGE_GPU_ONLY;
+        vbDesc.vertexStride = sizeof(NVGvertex);
+        vbDesc.structStride = sizeof(NVGvertex);
+        vbDesc.size = group->vertexCount * sizeof(NVGvertex);
+        vbDesc.elementCount = group->vertexCount;
+        REI_addBuffer(state->renderer, &vbDesc, &group->vtxBuffer);
+
+        vbDesc.vertexStride = sizeof(uint32_t);
+        vbDesc.structStride = sizeof(uint32_t);
+        vbDesc.size = group->vertexCount * sizeof(uint32_t);
+        REI_addBuffer(state->renderer, &vbDesc, &group->paintBuffer);
+
+        REI_NanoVG_uploadRetained(
+            state, group, group->vtxBuffer, group->vertices.data(), group->vertexCount * sizeof(NVGvertex));
+        REI_NanoVG_uploadRetained(
+            state, group, group->paintBuffer, group->paints.data(), group->vertexCount * sizeof(uint32_t));
+    }
+    else
+        group->uploaded = true;
+}
+
+bool REI_NanoVG_DrawRetained(NVGcontext* ctx, uint64_t key, const float xform[6])
+{
+    REI_NanoVG_State* state = (REI_NanoVG_State*)nvgInternalParams(ctx)->userPtr;
+    REI_ASSERT(!state->recording, "Retained groups can't be drawn while recording");
+
+    auto it = state->retained.find(key);
+    if (it == state->retained.end())
+        return false;
+
+    REI_NanoVG_retained* group = it->second;
+    if (!group->uploaded && REI_RL_isTokenCompleted(state->loader, group->uploadToken))
+    {
+        group->uploaded = true;
+        REI_vector<NVGvertex>(REI_allocator<NVGvertex>(state->allocator)).swap(group->vertices);
+        REI_vector<uint32_t>(REI_allocator<uint32_t>(state->allocator)).swap(group->paints);
+    }
+
+    uint32_t uniformCount = (uint32_t)group->uniforms.size();
+    if (state->desc.maxDraws - state->uniCount < uniformCount)
+        return true;
+
+    REI_NanoVG_replay replay;
+    replay.vtxBuffer = group->vtxBuffer;
+    replay.paintBuffer = group->paintBuffer;
+    replay.paintBase = state->uniCount;
+    if (xform)
+        memcpy(replay.xform, xform, sizeof(replay.xform));
+    else
+        nvgTransformIdentity(replay.xform);
+
+    uint32_t vertexBase = 0;
+    if (!group->uploaded)
+    {
+        // Draw a copy from the frame buffers until the group buffers are ready
+        vertexBase = state->vtxCount;
+        NVGvertex* vtx = allocVertices(state, group->vertexCount, 0);
+        if (!vtx)
+            return true;
+        memcpy(vtx, group->vertices.data(), group->vertexCount * sizeof(NVGvertex));
+        memcpy(
+            (uint32_t*)state->paintBuffersAddr[state->setIndex] + vertexBase, group->paints.data(),
+            group->vertexCount * sizeof(uint32_t));
+        replay.vtxBuffer = NULL;
+        replay.paintBuffer = NULL;
+    }
+
+    memcpy(
+        (REI_NanoVG_fragUniforms*)state->uniBuffersAddr[state->setIndex] + state->uniCount, group->uniforms.data(),
+        uniformCount * sizeof(REI_NanoVG_fragUniforms));
+    state->uniCount += uniformCount;
+
+    state->replays.push_back(replay);
+    for (const REI_NanoVG_call& groupCall: group->calls)
+    {
+        state->calls.push_back(groupCall);
+        REI_NanoVG_call& call = state->calls.back();
+        call.fillOffset += vertexBase;
+        call.strokeOffset += vertexBase;
+        call.triangleOffset += vertexBase;
+        call.replay = (uint32_t)state->replays.size();
+    }
+    ++state->stats.callCount;
+    return true;
+}
+
+void REI_NanoVG_RemoveRetained(NVGcontext* ctx, uint64_t key)
+{
+    REI_NanoVG_State* state = (REI_NanoVG_State*)nvgInternalParams(ctx)->userPtr;
+
+    auto it = state->retained.find(key);
+    if (it == state->retained.end())
+        return;
+
+    // Copies into the group buffers have to finish, draws are waited for by the deletion queue
+    if (!it->second->uploaded && it->second->vtxBuffer)
+        REI_RL_waitTokenCompleted(state->loader, it->second->uploadToken);
+    REI_NanoVG_removeRetainedGroup(state, it->second);
+    state->retained.erase(it);
+}
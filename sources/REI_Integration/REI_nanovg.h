@@ -26,13 +26,47 @@ struct REI_NanoVG_Desc
     uint32_t                      resourceSetCount;
     uint32_t                      maxVerts;
     uint32_t                      maxDraws;
-    uint32_t                      maxTextures;
+    uint32_t                      maxTextures;          // descriptor tables for images and atlases
+    uint32_t                      atlasSize;            // side of atlas textures small RGBA images share, 0 disables them
+    uint32_t                      maxAtlasImageSize;    // largest side of a packed image, 0 selects atlasSize / 8
     const REI_AllocatorCallbacks* pAllocator;
 };
 
+struct REI_NanoVG_Stats
+{
+    uint32_t callCount;        // fills, strokes and triangle calls made since REI_NanoVG_SetupRender
+    uint32_t drawCount;        // draws recorded to the command buffer
+    uint32_t pipelineBinds;    // pipelines bound to the command buffer
+    uint32_t tableBinds;       // descriptor tables bound to the command buffer
+};
+
 struct NVGcontext;
 struct REI_ResourceLoader;
 
 NVGcontext* REI_NanoVG_Init(REI_Renderer* Renderer, REI_Queue* queue, REI_RL_State* loader, REI_NanoVG_Desc* info);
 void        REI_NanoVG_SetupRender(NVGcontext* ctx, REI_Cmd* pCmd, uint32_t set_index);
+void        REI_NanoVG_GetStats(NVGcontext* ctx, REI_NanoVG_Stats* pStats);
 void        REI_NanoVG_Shutdown(NVGcontext* ctx);
+
+// Retained groups store fills, strokes and triangles in GPU buffers once and draw them again with one call. Calls
+// made between REI_NanoVG_BeginRetained and REI_NanoVG_EndRetained are recorded into the group instead of being
+// drawn, both have to be called between nvgBeginFrame and nvgEndFrame. key is a hash of the group content chosen by
+// the caller, REI_NanoVG_BeginRetained returns false and records nothing when a group with that key exists.
+// Paints and scissors stay in the space the group was recorded in and move with it when drawn with xform, record
+// with an identity transform to place the group freely. A NULL xform draws the group where it was recorded.
+// With REI_NANOVG_VALIDATE_RETAINED, on in debug builds, REI_NanoVG_BeginRetained returns true for an existing key as
+// well. Those calls are only hashed, and REI_NanoVG_EndRetained asserts when they differ from the stored group.
+#ifndef REI_NANOVG_VALIDATE_RETAINED
+#    if defined(_DEBUG)
+#        define REI_NANOVG_VALIDATE_RETAINED 1
+#    else
+#        define REI_NANOVG_VALIDATE_RETAINED 0
+#    endif
+#endif
+bool REI_NanoVG_BeginRetained(NVGcontext* ctx, uint64_t key);
+void REI_NanoVG_EndRetained(NVGcontext* ctx);
+// Returns false when no group has this key
+bool REI_NanoVG_DrawRetained(NVGcontext* ctx, uint64_t key, const float xform[6] = NULL);
+// The group buffers are freed once the sets that drew them are begun again, only a copy into them that is still
+// pending is waited for
+void REI_NanoVG_RemoveRetained(NVGcontext* ctx, uint64_t key);
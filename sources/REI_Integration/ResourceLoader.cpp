@@ -18,10 +18,28 @@
 #include "REI/Common.h"
 #include "REI/Thread.h"
 
+#include <chrono>
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__SSE2__)
+#    include <emmintrin.h>
+#    define REI_RL_SSE2
+#elif defined(__ARM_NEON) || defined(_M_ARM64)
+#    include <arm_neon.h>
+#    define REI_RL_NEON
+#endif
+
 struct REI_RL_MappedMemoryRange
 {
-    uint8_t* pData;
-    uint64_t offset;
+    uint8_t*    pData;
+    uint64_t    offset;
+    REI_Buffer* pBuffer;
+};
+
+struct REI_RL_TransientBuffer
+{
+    REI_Buffer* pBuffer;
+    uint64_t    size;
+    size_t      set;
 };
 
 struct REI_RL_ResourceSet
@@ -38,7 +56,29 @@ enum
     DEFAULT_BUFFER_SIZE = 16ull << 20,
     DEFAULT_BUFFER_COUNT = 2u,
     DEFAULT_TIMESLICE_MS = 4u,
+    DEFAULT_COPY_THREAD_COUNT = 2u,
+    DEFAULT_MAX_TRANSIENT_SIZE = 256ull << 20,
     MAX_BUFFER_COUNT = 8u,
+    MAX_COPY_THREAD_COUNT = 8u,
+    // Staging copies are split into tasks of roughly this size so copy workers can share a single large upload
+    COPY_TASK_SIZE = 256u << 10,
+    // With a timeslice large requests are recorded in steps of at most this size, so the timeslice is checked between them
+    TIMESLICE_STEP_SIZE = 1u << 20,
+    // Capacity of each per priority request ring, must be a power of two
+    REQUEST_RING_SIZE = 1024u,
+    // Tokens completed out of order are tracked in a ring of this many slots past the completed watermark
+    TOKEN_WINDOW_SIZE = 4096u,
+};
+
+/// Part of a staging copy: rowCount rows of rowSize bytes, zero filled when pSrc is null
+struct REI_RL_CopyTask
+{
+    uint8_t*       pDst;
+    const uint8_t* pSrc;
+    uint64_t       rowSize;
+    uint32_t       rowCount;
+    uint32_t       srcPitch;
+    uint32_t       dstPitch;
 };
 
 typedef enum REI_RL_UpdateRequestType
@@ -50,16 +90,27 @@ typedef enum REI_RL_UpdateRequestType
 
 struct REI_RL_UpdateRequest
 {
-    REI_RL_UpdateRequest(): type(REI_RL_UPDATE_REQUEST_INVALID) {}
-    REI_RL_UpdateRequest(REI_RL_BufferUpdateDesc& buffer):
-        type(REI_RL_UPDATE_REQUEST_UPDATE_BUFFER), bufUpdateDesc(buffer)
+    REI_RL_UpdateRequest(): type(REI_RL_UPDATE_REQUEST_INVALID), token(0), pStagingBuffer(nullptr), stagingSize(0) {}
+    REI_RL_UpdateRequest(const REI_RL_BufferUpdateDesc& buffer, REI_RL_RequestId token):
+        type(REI_RL_UPDATE_REQUEST_UPDATE_BUFFER), token(token), pStagingBuffer(nullptr), stagingSize(0),
+        bufUpdateDesc(buffer)
+    {
+    }
+    REI_RL_UpdateRequest(const REI_RL_TextureUpdateDesc& texture, REI_RL_RequestId token):
+        type(REI_RL_UPDATE_REQUEST_UPDATE_TEXTURE), token(token), pStagingBuffer(nullptr), stagingSize(0),
+        texUpdateDesc(texture)
     {
     }
-    REI_RL_UpdateRequest(REI_RL_TextureUpdateDesc& texture):
-        type(REI_RL_UPDATE_REQUEST_UPDATE_TEXTURE), texUpdateDesc(texture)
+    REI_RL_UpdateRequest(const REI_RL_UpdateRequest& request, REI_RL_RequestId token): REI_RL_UpdateRequest(request)
     {
+        this->token = token;
     }
+
     REI_RL_UpdateRequestType type;
+    REI_RL_RequestId         token;
+    // Set for updates written by the caller between REI_RL_beginUpdate and REI_RL_endUpdate
+    REI_Buffer*              pStagingBuffer;
+    uint64_t                 stagingSize;
     union
     {
         REI_RL_BufferUpdateDesc  bufUpdateDesc;
@@ -67,14 +118,107 @@ struct REI_RL_UpdateRequest
     };
 };
 
+// Bounded multi producer single consumer ring, the sequence of a slot tells whose turn it is:
+// position - free for the producer claiming the position, position + 1 - ready for the streamer
+struct REI_RL_RequestSlot
+{
+    REI_atomicptr_t      sequence;
+    REI_RL_UpdateRequest request;
+};
+
+struct REI_RL_RequestRing
+{
+    REI_RL_RequestSlot* slots;
+    REI_atomicptr_t     head;    // next position claimed by producers
+    uintptr_t           tail;    // next position read by the streamer
+};
+
+static void REI_RL_initRequestRing(const REI_AllocatorCallbacks& allocator, REI_RL_RequestRing& ring)
+{
+    ring.slots = (REI_RL_RequestSlot*)allocator.pMalloc(
+        allocator.pUserData, sizeof(REI_RL_RequestSlot) * REQUEST_RING_SIZE, alignof(REI_RL_RequestSlot));
+    for (uintptr_t i = 0; i < REQUEST_RING_SIZE; ++i)
+    {
+        ring.slots[i].sequence = i;
+    }
+    ring.head = 0;
+    ring.tail = 0;
+}
+
+// Claims count consecutive positions with a single compare-and-swap, fails if the ring has no room for all of them
+template<typename T>
+static bool REI_RL_pushRequests(REI_RL_RequestRing& ring, const T* pDescs, uint32_t count, REI_RL_RequestId firstToken)
+{
+    REI_ASSERT(count && count <= REQUEST_RING_SIZE);
+    uintptr_t pos = REI_atomicptr_load_relaxed(&ring.head);
+    while (1)
+    {
+        // The streamer frees slots in order, so if the last slot of the range is free all of them are
+        REI_RL_RequestSlot& lastSlot = ring.slots[(pos + count - 1) & (REQUEST_RING_SIZE - 1)];
+        intptr_t diff = (intptr_t)REI_atomicptr_load_acquire(&lastSlot.sequence) - (intptr_t)(pos + count - 1);
+        if (diff == 0)
+        {
+            uintptr_t prevPos = REI_atomicptr_cas_relaxed(&ring.head, pos, pos + count);
+            if (prevPos == pos)
+                break;
+            pos = prevPos;
+        }
+        else if (diff < 0)
+        {
+            return false;
+        }
+        else
+        {
+            pos = REI_atomicptr_load_relaxed(&ring.head);
+        }
+    }
+
+    for (uint32_t i = 0; i < count; ++i)
+    {
+        REI_RL_RequestSlot& slot = ring.slots[(pos + i) & (REQUEST_RING_SIZE - 1)];
+        slot.request = REI_RL_UpdateRequest(pDescs[i], firstToken + i);
+        REI_atomicptr_store_release(&slot.sequence, pos + i + 1);
+    }
+    return true;
+}
+
+static bool REI_RL_isRequestRingEmpty(REI_RL_RequestRing& ring)
+{
+    REI_RL_RequestSlot& slot = ring.slots[ring.tail & (REQUEST_RING_SIZE - 1)];
+    return REI_atomicptr_load_acquire(&slot.sequence) != ring.tail + 1;
+}
+
+static bool REI_RL_popRequest(REI_RL_RequestRing& ring, REI_RL_UpdateRequest& request)
+{
+    REI_RL_RequestSlot& slot = ring.slots[ring.tail & (REQUEST_RING_SIZE - 1)];
+    if (REI_atomicptr_load_acquire(&slot.sequence) != ring.tail + 1)
+        return false;
+
+    request = slot.request;
+    REI_atomicptr_store_release(&slot.sequence, ring.tail + REQUEST_RING_SIZE);
+    ++ring.tail;
+    return true;
+}
+
+// Lives on the stack of a waiting thread, linked into REI_RL_State::tokenWaiters while it sleeps
+struct REI_RL_TokenWaiter
+{
+    REI_RL_RequestId    token;
+    bool                batch;    // waits for every token up to token
+    bool                signaled;
+    ConditionVariable   cond;
+    REI_RL_TokenWaiter* pNext;
+};
+
 struct REI_RL_State
 {
     REI_RL_State(const REI_AllocatorCallbacks& inAllocator):
-        allocator(inAllocator), requestQueue(REI_allocator<REI_RL_UpdateRequest>(allocator))
+        allocator(inAllocator), tokensDeferred(REI_allocator<REI_RL_RequestId>(allocator)),
+        copyTasks(REI_allocator<REI_RL_CopyTask>(allocator)),
+        transientBuffers(REI_allocator<REI_RL_TransientBuffer>(allocator))
     {
     }
 
-
     REI_Renderer*             pRenderer;
     REI_AllocatorCallbacks    allocator;
     REI_RL_ResourceLoaderDesc desc;
@@ -83,24 +227,70 @@ struct REI_RL_State
     ThreadDesc   threadDesc;
     ThreadHandle thread;
 
-    Mutex                            queueMutex;
-    ConditionVariable                queueCond;
-    Mutex                            tokenMutex;
-    ConditionVariable                tokenCond;
-    REI_deque<REI_RL_UpdateRequest>  requestQueue;
-
-    REI_atomicptr_t requestsCompleted;
-    REI_atomicptr_t requestsSubmitted;
+    // Producers only take queueMutex to wake the streamer after it went to sleep on empty rings
+    REI_RL_RequestRing requestRings[REI_RL_PRIORITY_COUNT];
+    REI_atomic32_t     streamerSleeping;
+    Mutex              queueMutex;
+    ConditionVariable  queueCond;
+
+    // All tokens up to requestsCompleted are done. A token completed out of order is stored in its slot of
+    // completedTokens until the watermark passes it, tokens too far ahead for the window wait in tokensDeferred
+    REI_atomicptr_t              requestsCompleted;
+    REI_atomicptr_t              requestsSubmitted;
+    REI_atomicptr_t*             completedTokens;
+    REI_vector<REI_RL_RequestId> tokensDeferred;
+
+    // Waiters are only woken once the tokens they wait for are done
+    Mutex               tokenMutex;
+    REI_RL_TokenWaiter* tokenWaiters;
+    REI_atomic32_t      tokenWaiterCount;
+
+    // Copy workers fill staging memory while the streamer records commands, see REI_RL_flushCopyTasks
+    ThreadDesc                  copyThreadDesc;
+    ThreadHandle                copyThreads[MAX_COPY_THREAD_COUNT];
+    Mutex                       copyMutex;
+    ConditionVariable           copyCond;
+    ConditionVariable           copyDoneCond;
+    REI_vector<REI_RL_CopyTask> copyTasks;
+    uint64_t                    copyTaskBytes;
+    uint32_t                    copyBatch;
+    uint32_t                    copyTaskCount;
+    uint32_t                    copyTasksDone;
+    uint32_t                    copyWorkersBusy;
+    REI_atomic32_t              copyTaskNext;
+
+    Mutex        statsMutex;
+    REI_RL_Stats stats;
 
     REI_Queue*          pQueue;
     REI_RL_ResourceSet* resourceSets;
     uint64_t            uniformBufferAlignment;
     uint64_t            allocatedSpace;
+    // Dedicated buffers of uploads too large for the staging buffer, released after the fence of their set
+    REI_vector<REI_RL_TransientBuffer> transientBuffers;
+    uint64_t                           transientSize;
+    uint64_t                           transientSpace;    // part of transientSize recorded into the current submit
     REI_Extent3D        uploadGranularity;
     uint32_t            uploadBufferTextureAlignment;
     uint32_t            uploadBufferTextureRowAlignment;
 };
 
+static inline uint64_t REI_RL_getTimeUs()
+{
+    return (uint64_t)std::chrono::duration_cast<std::chrono::microseconds>(
+               std::chrono::steady_clock::now().time_since_epoch())
+        .count();
+}
+
+/// Staging memory the current request may use in one step
+static inline uint64_t REI_RL_getStagingSpaceAvailable(REI_RL_State* pRMState)
+{
+    uint64_t spaceAvailable = pRMState->desc.bufferSize - pRMState->allocatedSpace;
+    if (pRMState->desc.timesliceMs)
+        spaceAvailable = REI_min<uint64_t>(spaceAvailable, TIMESLICE_STEP_SIZE);
+    return spaceAvailable;
+}
+
 /// Return memory from pre-allocated staging buffer or create a temporary buffer if the streamer ran out of memory
 static REI_RL_MappedMemoryRange REI_RL_allocateStagingMemory(
     REI_RL_State* pRMState, size_t activeSet, uint64_t memoryRequirement, uint32_t alignment)
@@ -118,10 +308,231 @@ static REI_RL_MappedMemoryRange REI_RL_allocateStagingMemory(
     {
         uint8_t* pDstData = (uint8_t*)pResourceSet->pMappedAddress + offset;
         pRMState->allocatedSpace = offset + memoryRequirement;
-        return { pDstData, offset };
+        return { pDstData, offset, pResourceSet->pBuffer };
+    }
+
+    return { nullptr, 0, nullptr };
+}
+
+static void REI_RL_updateTransientStats(REI_RL_State* pRMState, uint64_t createdCount)
+{
+    pRMState->statsMutex.Acquire();
+    REI_RL_Stats& stats = pRMState->stats;
+    stats.transientBufferCount += createdCount;
+    stats.transientBytes = pRMState->transientSize;
+    stats.maxTransientBytes = REI_max(stats.maxTransientBytes, pRMState->transientSize);
+    pRMState->statsMutex.Release();
+}
+
+static void REI_RL_trackTransientBuffer(REI_RL_State* pRMState, size_t activeSet, REI_Buffer* pBuffer, uint64_t size)
+{
+    pRMState->transientBuffers.push_back({ pBuffer, size, activeSet });
+    pRMState->transientSize += size;
+    pRMState->transientSpace += size;
+    REI_RL_updateTransientStats(pRMState, 1);
+}
+
+/// Uploads that would not fit even an empty staging buffer get a dedicated buffer, so they are recorded in one submit
+/// instead of being sliced across many. Returns an empty range if the upload is small enough or over the budget
+static REI_RL_MappedMemoryRange
+    REI_RL_allocateTransientMemory(REI_RL_State* pRMState, size_t activeSet, uint64_t memoryRequirement)
+{
+    if (memoryRequirement <= pRMState->desc.bufferSize ||
+        pRMState->transientSize + memoryRequirement > pRMState->desc.maxTransientSize)
+    {
+        return { nullptr, 0, nullptr };
+    }
+
+    REI_BufferDesc bufferDesc = {};
+    bufferDesc.size = memoryRequirement;
+    bufferDesc.memoryUsage = REI_RESOURCE_MEMORY_USAGE_CPU_ONLY;
+    bufferDesc.flags = REI_BUFFER_CREATION_FLAG_OWN_MEMORY_BIT | REI_BUFFER_CREATION_FLAG_PERSISTENT_MAP_BIT;
+    REI_Buffer* pBuffer = nullptr;
+    REI_addBuffer(pRMState->pRenderer, &bufferDesc, &pBuffer);
+    if (!pBuffer)
+        return { nullptr, 0, nullptr };
+
+    void* pMappedAddress = nullptr;
+    REI_mapBuffer(pRMState->pRenderer, pBuffer, &pMappedAddress);
+
+    REI_RL_trackTransientBuffer(pRMState, activeSet, pBuffer, memoryRequirement);
+
+    return { (uint8_t*)pMappedAddress, 0, pBuffer };
+}
+
+/// Releases transient buffers recorded into set, all of them if set is ~0
+static void REI_RL_releaseTransientMemory(REI_RL_State* pRMState, size_t set)
+{
+    REI_vector<REI_RL_TransientBuffer>& buffers = pRMState->transientBuffers;
+    if (buffers.empty())
+        return;
+
+    for (size_t i = 0; i < buffers.size();)
+    {
+        if (set == ~(size_t)0 || buffers[i].set == set)
+        {
+            REI_removeBuffer(pRMState->pRenderer, buffers[i].pBuffer);
+            pRMState->transientSize -= buffers[i].size;
+            buffers[i] = buffers.back();
+            buffers.pop_back();
+        }
+        else
+        {
+            ++i;
+        }
+    }
+    REI_RL_updateTransientStats(pRMState, 0);
+}
+
+static void REI_RL_executeCopyTask(const REI_RL_CopyTask& task)
+{
+    uint8_t*       pDst = task.pDst;
+    const uint8_t* pSrc = task.pSrc;
+    for (uint32_t r = 0; r < task.rowCount; ++r)
+    {
+        if (pSrc)
+        {
+            memcpy(pDst, pSrc, (size_t)task.rowSize);
+            pSrc += task.srcPitch;
+        }
+        else
+        {
+            memset(pDst, 0, (size_t)task.rowSize);
+        }
+        pDst += task.dstPitch;
+    }
+}
+
+/// Copy rows into staging memory. Without copy workers the copy is done immediately,
+/// otherwise it is split into tasks which are executed in parallel by REI_RL_flushCopyTasks.
+static void REI_RL_queueCopy(
+    REI_RL_State* pRMState, uint8_t* pDst, const uint8_t* pSrc, uint64_t rowSize, uint32_t rowCount, uint32_t srcPitch,
+    uint32_t dstPitch)
+{
+    if (pRMState->desc.copyThreadCount == 0)
+    {
+        REI_RL_executeCopyTask({ pDst, pSrc, rowSize, rowCount, srcPitch, dstPitch });
+        return;
+    }
+
+    pRMState->copyTaskBytes += rowSize * rowCount;
+
+    if (rowCount == 1)
+    {
+        // Contiguous copy, split into disjoint byte ranges
+        for (uint64_t offset = 0; offset < rowSize; offset += COPY_TASK_SIZE)
+        {
+            uint64_t size = REI_min<uint64_t>(COPY_TASK_SIZE, rowSize - offset);
+            pRMState->copyTasks.push_back({ pDst + offset, pSrc ? pSrc + offset : nullptr, size, 1, 0, 0 });
+        }
+        return;
+    }
+
+    // Strided copy, split into disjoint row ranges
+    uint32_t rowsPerTask = (uint32_t)REI_max<uint64_t>(COPY_TASK_SIZE / REI_max<uint64_t>(rowSize, 1), 1);
+    for (uint32_t row = 0; row < rowCount; row += rowsPerTask)
+    {
+        uint32_t count = REI_min(rowsPerTask, rowCount - row);
+        pRMState->copyTasks.push_back({ pDst + (uint64_t)row * dstPitch,
+                                        pSrc ? pSrc + (uint64_t)row * srcPitch : nullptr, rowSize, count, srcPitch,
+                                        dstPitch });
     }
+}
 
-    return { nullptr, 0 };
+static uint32_t REI_RL_processCopyTasks(REI_RL_State* pRMState, uint32_t taskCount)
+{
+    uint32_t processed = 0;
+    while (1)
+    {
+        uint32_t taskIndex = REI_atomic32_add_relaxed(&pRMState->copyTaskNext, 1);
+        if (taskIndex >= taskCount)
+            break;
+        REI_RL_executeCopyTask(pRMState->copyTasks[taskIndex]);
+        ++processed;
+    }
+    return processed;
+}
+
+/// Wait until all queued staging copies are done. Must be called before the commands reading
+/// the staging buffer are submitted.
+static void REI_RL_flushCopyTasks(REI_RL_State* pRMState)
+{
+    uint32_t taskCount = (uint32_t)pRMState->copyTasks.size();
+    if (taskCount == 0)
+        return;
+
+    REI_atomic32_store_relaxed(&pRMState->copyTaskNext, 0);
+
+    // Waking workers is not worth it for a handful of small copies
+    if (pRMState->copyTaskBytes <= COPY_TASK_SIZE)
+    {
+        REI_RL_processCopyTasks(pRMState, taskCount);
+    }
+    else
+    {
+        pRMState->copyMutex.Acquire();
+        pRMState->copyTaskCount = taskCount;
+        pRMState->copyTasksDone = 0;
+        ++pRMState->copyBatch;
+        pRMState->copyMutex.Release();
+        pRMState->copyCond.WakeAll();
+
+        uint32_t processed = REI_RL_processCopyTasks(pRMState, taskCount);
+
+        pRMState->copyMutex.Acquire();
+        pRMState->copyTasksDone += processed;
+        while (pRMState->copyTasksDone < taskCount || pRMState->copyWorkersBusy)
+        {
+            pRMState->copyDoneCond.Wait(pRMState->copyMutex);
+        }
+        // Close the batch, workers waking up late must not touch copyTasks anymore
+        pRMState->copyTaskCount = 0;
+        pRMState->copyMutex.Release();
+    }
+
+    pRMState->copyTasks.clear();
+    pRMState->copyTaskBytes = 0;
+}
+
+static void copyWorkerThreadFunc(void* pThreadData)
+{
+    REI_RL_State* pRMState = (REI_RL_State*)pThreadData;
+    REI_ASSERT(pRMState);
+
+    uint32_t lastBatch = 0;
+    while (1)
+    {
+        pRMState->copyMutex.Acquire();
+        while (pRMState->run && pRMState->copyBatch == lastBatch)
+        {
+            pRMState->copyCond.Wait(pRMState->copyMutex);
+        }
+        lastBatch = pRMState->copyBatch;
+        uint32_t taskCount = pRMState->copyTaskCount;
+        if (taskCount)
+            ++pRMState->copyWorkersBusy;
+        pRMState->copyMutex.Release();
+
+        if (!pRMState->run && !taskCount)
+        {
+            break;
+        }
+
+        if (!taskCount)
+        {
+            continue;
+        }
+
+        uint32_t processed = REI_RL_processCopyTasks(pRMState, taskCount);
+
+        pRMState->copyMutex.Acquire();
+        pRMState->copyTasksDone += processed;
+        --pRMState->copyWorkersBusy;
+        bool batchDone = pRMState->copyTasksDone == taskCount && pRMState->copyWorkersBusy == 0;
+        pRMState->copyMutex.Release();
+        if (batchDone)
+            pRMState->copyDoneCond.WakeOne();
+    }
 }
 
 struct uint3
@@ -150,14 +561,25 @@ struct REI_RL_UpdateState
     uint64_t             size;
 };
 
+// Bit i of the index moves to bit 2 * i
+struct REI_RL_MortonTable
+{
+    constexpr REI_RL_MortonTable(): spread()
+    {
+        for (uint32_t i = 0; i < 256; ++i)
+        {
+            for (uint32_t bit = 0; bit < 8; ++bit)
+                spread[i] |= (uint16_t)(((i >> bit) & 1) << (2 * bit));
+        }
+    }
+    uint16_t spread[256];
+};
+
+static constexpr REI_RL_MortonTable gMortonTable;
+
 static inline uint32_t REI_RL_SplitBitsWith0(uint32_t x)
 {
-    x &= 0x0000ffff;
-    x = (x ^ (x << 8)) & 0x00ff00ff;
-    x = (x ^ (x << 4)) & 0x0f0f0f0f;
-    x = (x ^ (x << 2)) & 0x33333333;
-    x = (x ^ (x << 1)) & 0x55555555;
-    return x;
+    return gMortonTable.spread[x & 0xff] | ((uint32_t)gMortonTable.spread[(x >> 8) & 0xff] << 16);
 }
 
 static inline uint32_t REI_RL_EncodeMorton(uint32_t x, uint32_t y)
@@ -165,40 +587,145 @@ static inline uint32_t REI_RL_EncodeMorton(uint32_t x, uint32_t y)
     return (REI_RL_SplitBitsWith0(y) << 1) + REI_RL_SplitBitsWith0(x);
 }
 
-// TODO: test and fix
-static void REI_RL_copyUploadRectZCurve(
-    uint8_t* pDstData, uint8_t* pSrcData, REI_Region3D uploadRegion, uint3 srcPitches, uint3 dstPitches)
+// Swizzled images interleave the low bits of both coordinates up to the shorter side,
+// the remaining high bits of the longer side follow above them
+static inline uint32_t REI_RL_zCurveRowIndex(uint32_t y, uint32_t interleavedBits)
+{
+    uint32_t mask = (1u << interleavedBits) - 1;
+    return (REI_RL_SplitBitsWith0(y & mask) << 1) | ((y >> interleavedBits) << (2 * interleavedBits));
+}
+
+static inline uint32_t REI_RL_zCurveColumnIndex(uint32_t x, uint32_t interleavedBits)
+{
+    uint32_t mask = (1u << interleavedBits) - 1;
+    return REI_RL_SplitBitsWith0(x & mask) | ((x >> interleavedBits) << (2 * interleavedBits));
+}
+
+static inline void REI_RL_copy16(uint8_t* pDst, const uint8_t* pSrc)
+{
+#if defined(REI_RL_SSE2)
+    _mm_storeu_si128((__m128i*)pDst, _mm_loadu_si128((const __m128i*)pSrc));
+#elif defined(REI_RL_NEON)
+    vst1q_u8(pDst, vld1q_u8(pSrc));
+#else
+    memcpy(pDst, pSrc, 16);
+#endif
+}
+
+void REI_RL_copyLinearBlocks(
+    uint8_t* pDst, const uint8_t* pSrc, uint32_t blockSize, uint32_t widthInBlocks, uint32_t heightInBlocks,
+    const REI_Region3D* pRegion, uint32_t dstRowPitch, uint32_t dstSlicePitch)
 {
-    uint32_t offset = 0;
-    for (uint32_t z = uploadRegion.z; z < uploadRegion.z + uploadRegion.d; ++z)
+    const uint64_t srcRowPitch = (uint64_t)widthInBlocks * blockSize;
+    const uint64_t srcSlicePitch = srcRowPitch * heightInBlocks;
+    const size_t   rowSize = (size_t)pRegion->w * blockSize;
+    for (uint32_t z = 0; z < pRegion->d; ++z)
     {
-        for (uint32_t y = uploadRegion.y; y < uploadRegion.y + uploadRegion.h; ++y)
+        const uint8_t* pSrcRow = pSrc + (pRegion->z + z) * srcSlicePitch + pRegion->y * srcRowPitch +
+                                 (uint64_t)pRegion->x * blockSize;
+        uint8_t* pDstRow = pDst + (uint64_t)z * dstSlicePitch;
+        for (uint32_t y = 0; y < pRegion->h; ++y)
+        {
+            memcpy(pDstRow, pSrcRow, rowSize);
+            pSrcRow += srcRowPitch;
+            pDstRow += dstRowPitch;
+        }
+    }
+}
+
+void REI_RL_copyZCurveBlocks(
+    uint8_t* pDst, const uint8_t* pSrc, uint32_t blockSize, uint32_t widthInBlocks, uint32_t heightInBlocks,
+    const REI_Region3D* pRegion, uint32_t dstRowPitch, uint32_t dstSlicePitch)
+{
+    REI_ASSERT(REI_isPowerOf2(widthInBlocks) && REI_isPowerOf2(heightInBlocks));
+    REI_ASSERT(widthInBlocks <= 0x10000 && heightInBlocks <= 0x10000);
+
+    uint32_t interleavedBits;
+    REI_ctz32(&interleavedBits, REI_min(widthInBlocks, heightInBlocks));
+    const uint64_t srcSlicePitch = (uint64_t)widthInBlocks * heightInBlocks * blockSize;
+    const uint32_t x0 = pRegion->x, x1 = pRegion->x + pRegion->w;
+    const uint32_t y0 = pRegion->y, y1 = pRegion->y + pRegion->h;
+
+    auto copyBlock = [&](const uint8_t* pSrcSlice, uint8_t* pDstSlice, uint32_t x, uint32_t y)
+    {
+        uint32_t index = REI_RL_zCurveRowIndex(y, interleavedBits) | REI_RL_zCurveColumnIndex(x, interleavedBits);
+        memcpy(
+            pDstSlice + (uint64_t)(y - y0) * dstRowPitch + (uint64_t)(x - x0) * blockSize,
+            pSrcSlice + (uint64_t)index * blockSize, blockSize);
+    };
+
+    for (uint32_t z = 0; z < pRegion->d; ++z)
+    {
+        const uint8_t* pSrcSlice = pSrc + (pRegion->z + z) * srcSlicePitch;
+        uint8_t*       pDstSlice = pDst + (uint64_t)z * dstSlicePitch;
+
+        if (blockSize != 8 || interleavedBits == 0)
         {
-            for (uint32_t x = uploadRegion.x; x < uploadRegion.x + uploadRegion.w; ++x)
+            for (uint32_t y = y0; y < y1; ++y)
             {
-                uint32_t blockOffset = REI_RL_EncodeMorton(y, x);
-                memcpy(pDstData + offset, pSrcData + blockOffset * srcPitches.x, srcPitches.x);
-                offset += dstPitches.x;
+                for (uint32_t x = x0; x < x1; ++x)
+                    copyBlock(pSrcSlice, pDstSlice, x, y);
+            }
+            continue;
+        }
+
+        // 2x2 quads of 8 byte blocks are 32 contiguous source bytes, the two halves go to two destination rows
+        uint32_t y = y0;
+        if (y & 1)
+        {
+            for (uint32_t x = x0; x < x1; ++x)
+                copyBlock(pSrcSlice, pDstSlice, x, y);
+            ++y;
+        }
+        for (; y + 1 < y1; y += 2)
+        {
+            const uint32_t rowIndex = REI_RL_zCurveRowIndex(y, interleavedBits);
+            uint8_t*       pDstRow0 = pDstSlice + (uint64_t)(y - y0) * dstRowPitch;
+            uint8_t*       pDstRow1 = pDstRow0 + dstRowPitch;
+
+            uint32_t x = x0;
+            if (x & 1)
+            {
+                copyBlock(pSrcSlice, pDstSlice, x, y);
+                copyBlock(pSrcSlice, pDstSlice, x, y + 1);
+                ++x;
+            }
+            for (; x + 1 < x1; x += 2)
+            {
+                const uint8_t* pQuad = pSrcSlice + (uint64_t)(rowIndex | REI_RL_zCurveColumnIndex(x, interleavedBits)) * 8;
+                REI_RL_copy16(pDstRow0 + (uint64_t)(x - x0) * 8, pQuad);
+                REI_RL_copy16(pDstRow1 + (uint64_t)(x - x0) * 8, pQuad + 16);
+            }
+            if (x < x1)
+            {
+                copyBlock(pSrcSlice, pDstSlice, x, y);
+                copyBlock(pSrcSlice, pDstSlice, x, y + 1);
             }
-            offset = REI_align_up(offset, dstPitches.y);
         }
-        pSrcData += srcPitches.z;
+        if (y < y1)
+        {
+            for (uint32_t x = x0; x < x1; ++x)
+                copyBlock(pSrcSlice, pDstSlice, x, y);
+        }
     }
 }
 
-static void REI_RL_copyUploadRect(
+static void REI_RL_copyUploadRectZCurve(
     uint8_t* pDstData, uint8_t* pSrcData, REI_Region3D uploadRegion, uint3 srcPitches, uint3 dstPitches)
+{
+    REI_RL_copyZCurveBlocks(
+        pDstData, pSrcData, srcPitches.x, srcPitches.y / srcPitches.x, srcPitches.z / srcPitches.y, &uploadRegion,
+        dstPitches.y, dstPitches.z);
+}
+
+static void REI_RL_copyUploadRect(
+    REI_RL_State* pRMState, uint8_t* pDstData, uint8_t* pSrcData, REI_Region3D uploadRegion, uint3 srcPitches,
+    uint3 dstPitches)
 {
     uint32_t srcOffset = uploadRegion.z * srcPitches.z + uploadRegion.y * srcPitches.y + uploadRegion.x * srcPitches.x;
     uint32_t numSlices = uploadRegion.h * uploadRegion.d;
     uint32_t pitch = uploadRegion.w * srcPitches.x;
-    pSrcData += srcOffset;
-    for (uint32_t s = 0; s < numSlices; ++s)
-    {
-        memcpy(pDstData, pSrcData, pitch);
-        pSrcData += srcPitches.y;
-        pDstData += dstPitches.y;
-    }
+    REI_RL_queueCopy(pRMState, pDstData, pSrcData + srcOffset, pitch, numSlices, srcPitches.y, dstPitches.y);
 }
 
 static uint3 REI_RL_calculateUploadRect(uint64_t mem, uint3 pitches, uint3 offset, uint3 extent, uint3 granularity)
@@ -557,6 +1084,63 @@ static inline uint32_t REI_RL_util_heightOfBlock(REI_Format fmt)
     }
 }
 
+/// Layout of a whole texture update in staging memory: rows of blocks aligned to the upload row alignment
+static void REI_RL_getTextureStagingLayout(
+    REI_RL_State* pRMState, const REI_RL_TextureUpdateDesc& texUpdateDesc, uint32_t* pRowPitch, uint32_t* pSlicePitch,
+    uint32_t* pSliceCount)
+{
+    uint32_t blockSize = REI_RL_util_bitSizeOfBlock(texUpdateDesc.format) / 8;
+    uint32_t blockWidth = REI_RL_util_widthOfBlock(texUpdateDesc.format);
+    uint32_t blockHeight = REI_RL_util_heightOfBlock(texUpdateDesc.format);
+    uint32_t rowCount = (texUpdateDesc.height + blockHeight - 1) / blockHeight;
+    *pRowPitch = REI_align_up(blockSize * ((texUpdateDesc.width + blockWidth - 1) / blockWidth),
+                              pRMState->uploadBufferTextureRowAlignment);
+    *pSlicePitch = *pRowPitch * rowCount;
+    *pSliceCount = texUpdateDesc.depth;
+}
+
+/// Updates written straight into their own staging buffer only need the copy recorded
+static bool REI_RL_updateStaged(REI_RL_State* pRMState, size_t activeSet, REI_RL_UpdateState& pUpdate)
+{
+    REI_RL_UpdateRequest& request = pUpdate.request;
+    REI_Cmd*              pCmd = pRMState->resourceSets[activeSet].pCmd;
+
+    if (request.type == REI_RL_UPDATE_REQUEST_UPDATE_BUFFER)
+    {
+        REI_RL_BufferUpdateDesc& bufUpdateDesc = request.bufUpdateDesc;
+        REI_cmdCopyBuffer(
+            pCmd, bufUpdateDesc.pBuffer, bufUpdateDesc.dstOffset, request.pStagingBuffer, 0, bufUpdateDesc.size);
+    }
+    else
+    {
+        REI_RL_TextureUpdateDesc& texUpdateDesc = request.texUpdateDesc;
+        REI_Texture*              pTexture = texUpdateDesc.pTexture;
+
+        uint32_t rowPitch, slicePitch, sliceCount;
+        REI_RL_getTextureStagingLayout(pRMState, texUpdateDesc, &rowPitch, &slicePitch, &sliceCount);
+
+        REI_TextureBarrier preCopyBarrier = { pTexture, REI_RESOURCE_STATE_UNDEFINED, REI_RESOURCE_STATE_COPY_DEST };
+        REI_cmdResourceBarrier(pCmd, 0, NULL, 1, &preCopyBarrier);
+
+        REI_SubresourceDesc texData;
+        texData.arrayLayer = texUpdateDesc.arrayLayer;
+        texData.mipLevel = texUpdateDesc.mipLevel;
+        texData.bufferOffset = 0;
+        texData.rowPitch = rowPitch;
+        texData.slicePitch = slicePitch;
+        texData.region = { texUpdateDesc.x,     texUpdateDesc.y,      texUpdateDesc.z,
+                           texUpdateDesc.width, texUpdateDesc.height, texUpdateDesc.depth };
+        REI_cmdCopyBufferToTexture(pCmd, pTexture, request.pStagingBuffer, &texData);
+
+        REI_TextureBarrier postCopyBarrier = { pTexture, REI_RESOURCE_STATE_COPY_DEST, texUpdateDesc.endState };
+        REI_cmdResourceBarrier(pCmd, 0, NULL, 1, &postCopyBarrier);
+    }
+
+    // From here on the staging buffer is owned by the loader
+    REI_RL_trackTransientBuffer(pRMState, activeSet, request.pStagingBuffer, request.stagingSize);
+    return true;
+}
+
 static bool REI_RL_updateTexture(REI_RL_State* pRMState, size_t activeSet, REI_RL_UpdateState& pTextureUpdate)
 {
     REI_RL_TextureUpdateDesc& texUpdateDesc = pTextureUpdate.request.texUpdateDesc;
@@ -601,7 +1185,16 @@ static bool REI_RL_updateTexture(REI_RL_State* pRMState, size_t activeSet, REI_R
     REI_ASSERT(uploadOffset.x < uploadExtent.x || uploadOffset.y < uploadExtent.y || uploadOffset.z < uploadExtent.z);
 
     uint64_t spaceAvailable{ REI_align_down<uint64_t>(
-        pRMState->desc.bufferSize - pRMState->allocatedSpace, textureRowAlignment) };
+        REI_RL_getStagingSpaceAvailable(pRMState), textureRowAlignment) };
+
+    REI_RL_MappedMemoryRange transientRange = {};
+    if ((uploadOffset.x == 0) && (uploadOffset.y == 0) && (uploadOffset.z == 0))
+    {
+        uint64_t uploadSize = (uint64_t)dstPitches.z * REI_align_up(uploadExtent.z, granularity.z);
+        transientRange = REI_RL_allocateTransientMemory(pRMState, activeSet, uploadSize);
+        if (transientRange.pData)
+            spaceAvailable = uploadSize;
+    }
     uint3    uploadRectExtent{ REI_RL_calculateUploadRect(
         spaceAvailable, dstPitches, uploadOffset, uploadExtent, granularity) };
     uint32_t uploadPitchY{ REI_align_up(uploadRectExtent.x * dstPitches.x, textureRowAlignment) };
@@ -618,7 +1211,9 @@ static bool REI_RL_updateTexture(REI_RL_State* pRMState, size_t activeSet, REI_R
     }
 
     REI_RL_MappedMemoryRange range =
-        REI_RL_allocateStagingMemory(pRMState, activeSet, uploadRectExtent.z * uploadPitches.z, textureAlignment);
+        transientRange.pData
+            ? transientRange
+            : REI_RL_allocateStagingMemory(pRMState, activeSet, uploadRectExtent.z * uploadPitches.z, textureAlignment);
     // TODO: should not happed, resolve, simplify
     //REI_ASSERT(range.pData);
     if (!range.pData)
@@ -642,11 +1237,11 @@ static bool REI_RL_updateTexture(REI_RL_State* pRMState, size_t activeSet, REI_R
                                uploadRectExtent.x, uploadRectExtent.y, uploadRectExtent.z };
 
     if (REI_RL_isLinearLayout(texUpdateDesc.format))
-        REI_RL_copyUploadRect(range.pData, texUpdateDesc.pRawData, uploadRegion, srcPitches, uploadPitches);
+        REI_RL_copyUploadRect(pRMState, range.pData, texUpdateDesc.pRawData, uploadRegion, srcPitches, uploadPitches);
     else
         REI_RL_copyUploadRectZCurve(range.pData, texUpdateDesc.pRawData, uploadRegion, srcPitches, uploadPitches);
 
-    REI_cmdCopyBufferToTexture(pCmd, pTexture, pRMState->resourceSets[activeSet].pBuffer, &texData);
+    REI_cmdCopyBufferToTexture(pCmd, pTexture, range.pBuffer, &texData);
 
     uploadOffset.x += uploadRectExtent.x;
     uploadOffset.y += (uploadOffset.x < uploadExtent.x) ? 0 : uploadRectExtent.y;
@@ -676,35 +1271,41 @@ static bool REI_RL_updateBuffer(REI_RL_State* pRMState, size_t activeSet, REI_RL
     REI_Buffer*              pBuffer = bufUpdateDesc.pBuffer;
 
     const uint64_t bufferSize = bufUpdateDesc.size;
-    uint64_t       spaceAvailable =
-        REI_align_down<uint64_t>(pRMState->desc.bufferSize - pRMState->allocatedSpace, REI_RESOURCE_BUFFER_ALIGNMENT);
+    REI_Cmd*       pCmd = pRMState->resourceSets[activeSet].pCmd;
 
-    if (spaceAvailable < REI_RESOURCE_BUFFER_ALIGNMENT)
-        return false;
+    REI_RL_MappedMemoryRange range = {};
+    uint64_t                 dataToCopy = bufferSize;
+    if (pBufferUpdate.size == 0)
+    {
+        range = REI_RL_allocateTransientMemory(pRMState, activeSet, bufferSize);
+    }
 
-    uint64_t dataToCopy = REI_min(spaceAvailable, bufferSize - pBufferUpdate.size);
+    if (!range.pData)
+    {
+        uint64_t spaceAvailable =
+            REI_align_down<uint64_t>(REI_RL_getStagingSpaceAvailable(pRMState), REI_RESOURCE_BUFFER_ALIGNMENT);
 
-    REI_Cmd* pCmd = pRMState->resourceSets[activeSet].pCmd;
+        if (spaceAvailable < REI_RESOURCE_BUFFER_ALIGNMENT)
+            return false;
 
-    REI_RL_MappedMemoryRange range =
-        REI_RL_allocateStagingMemory(pRMState, activeSet, dataToCopy, REI_RESOURCE_BUFFER_ALIGNMENT);
+        dataToCopy = REI_min(spaceAvailable, bufferSize - pBufferUpdate.size);
+
+        range = REI_RL_allocateStagingMemory(pRMState, activeSet, dataToCopy, REI_RESOURCE_BUFFER_ALIGNMENT);
+    }
 
     // TODO: should not happed, resolve, simplify
     //REI_ASSERT(range.pData);
     if (!range.pData)
         return false;
 
-    void* pSrcBufferAddress = NULL;
+    const uint8_t* pSrcBufferAddress = NULL;
     if (bufUpdateDesc.pData)
-        pSrcBufferAddress = (uint8_t*)(bufUpdateDesc.pData) + (bufUpdateDesc.srcOffset + pBufferUpdate.size);
+        pSrcBufferAddress = (const uint8_t*)(bufUpdateDesc.pData) + (bufUpdateDesc.srcOffset + pBufferUpdate.size);
 
-    if (pSrcBufferAddress)
-        memcpy(range.pData, pSrcBufferAddress, (size_t)dataToCopy);
-    else
-        memset(range.pData, 0, (size_t)dataToCopy);
+    REI_RL_queueCopy(pRMState, range.pData, pSrcBufferAddress, dataToCopy, 1, 0, 0);
 
     REI_cmdCopyBuffer(
-        pCmd, pBuffer, bufUpdateDesc.dstOffset, pRMState->resourceSets[activeSet].pBuffer, range.offset, dataToCopy);
+        pCmd, pBuffer, bufUpdateDesc.dstOffset + pBufferUpdate.size, range.pBuffer, range.offset, dataToCopy);
 
     pBufferUpdate.size += dataToCopy;
 
@@ -716,26 +1317,238 @@ static bool REI_RL_updateBuffer(REI_RL_State* pRMState, size_t activeSet, REI_RL
     return true;
 }
 
+static void REI_RL_reportSubmit(REI_RL_State* pRMState, uint64_t latencyUs, uint64_t bytes)
+{
+    pRMState->statsMutex.Acquire();
+    REI_RL_Stats& stats = pRMState->stats;
+    ++stats.submitCount;
+    stats.lastSubmitLatencyUs = latencyUs;
+    stats.maxSubmitLatencyUs = REI_max(stats.maxSubmitLatencyUs, latencyUs);
+    stats.totalSubmitLatencyUs += latencyUs;
+    stats.lastSubmitBytes = bytes;
+    stats.totalSubmitBytes += bytes;
+    pRMState->statsMutex.Release();
+}
+
+// Queues are served from the highest priority down
+static const uint32_t gPriorityOrder[REI_RL_PRIORITY_COUNT] = { REI_RL_PRIORITY_HIGH, REI_RL_PRIORITY_NORMAL,
+                                                                REI_RL_PRIORITY_LOW };
+
+static bool REI_RL_isSameResource(const REI_RL_UpdateRequest& a, const REI_RL_UpdateRequest& b)
+{
+    if (a.type != b.type)
+        return false;
+    if (a.type == REI_RL_UPDATE_REQUEST_UPDATE_BUFFER)
+        return a.bufUpdateDesc.pBuffer == b.bufUpdateDesc.pBuffer;
+    return a.texUpdateDesc.pTexture == b.texUpdateDesc.pTexture;
+}
+
+// Picks the priority to work on next, REI_RL_PRIORITY_COUNT if there is nothing to do.
+// Every priority holds at most one active request: a partially uploaded request is resumed before newer requests of
+// its priority, but a higher priority request preempts it between two upload regions.
+static uint32_t REI_RL_selectRequest(REI_RL_State* pRMState, REI_RL_UpdateState* updateStates, bool* activeStates)
+{
+    uint32_t selected = REI_RL_PRIORITY_COUNT;
+    uint32_t selectedOrder = 0;
+
+    for (; selectedOrder < REI_RL_PRIORITY_COUNT; ++selectedOrder)
+    {
+        uint32_t             priority = gPriorityOrder[selectedOrder];
+        REI_RL_UpdateRequest request;
+        if (!activeStates[priority] && REI_RL_popRequest(pRMState->requestRings[priority], request))
+        {
+            updateStates[priority] = request;
+            activeStates[priority] = true;
+        }
+        if (activeStates[priority])
+        {
+            selected = priority;
+            break;
+        }
+    }
+
+    if (selected == REI_RL_PRIORITY_COUNT)
+        return selected;
+
+    // A preempted upload to the same resource is finished first, interleaving the two would break its barriers
+    for (uint32_t i = REI_RL_PRIORITY_COUNT - 1; i > selectedOrder; --i)
+    {
+        uint32_t priority = gPriorityOrder[i];
+        if (activeStates[priority] && REI_RL_isSameResource(updateStates[priority].request, updateStates[selected].request))
+            return priority;
+    }
+
+    return selected;
+}
+
+static bool REI_RL_isWaitSatisfied(REI_RL_State* pRMState, REI_RL_RequestId token, bool batch)
+{
+    if (REI_atomicptr_load_acquire(&pRMState->requestsCompleted) >= token)
+        return true;
+    if (batch)
+        return false;
+
+    // A slot is only reused once the watermark passed its token, so check the watermark again after the slot
+    if (REI_atomicptr_load_acquire(&pRMState->completedTokens[token & (TOKEN_WINDOW_SIZE - 1)]) == token)
+        return true;
+    return REI_atomicptr_load_acquire(&pRMState->requestsCompleted) >= token;
+}
+
+static void REI_RL_waitToken(REI_RL_State* pRMState, REI_RL_RequestId token, bool batch)
+{
+    if (REI_RL_isWaitSatisfied(pRMState, token, batch))
+        return;
+
+    REI_RL_TokenWaiter waiter;
+    waiter.token = token;
+    waiter.batch = batch;
+    waiter.signaled = false;
+
+    pRMState->tokenMutex.Acquire();
+    // Interlocked add, the streamer either sees the waiter or its completion is seen by the check below
+    REI_atomic32_add_relaxed(&pRMState->tokenWaiterCount, 1);
+    if (!REI_RL_isWaitSatisfied(pRMState, token, batch))
+    {
+        waiter.pNext = pRMState->tokenWaiters;
+        pRMState->tokenWaiters = &waiter;
+        while (!waiter.signaled)
+        {
+            waiter.cond.Wait(pRMState->tokenMutex);
+        }
+    }
+    REI_atomic32_add_relaxed(&pRMState->tokenWaiterCount, (uint32_t)-1);
+    pRMState->tokenMutex.Release();
+}
+
+static void REI_RL_wakeTokenWaiters(REI_RL_State* pRMState)
+{
+    if (!REI_atomic32_load_relaxed(&pRMState->tokenWaiterCount))
+        return;
+
+    pRMState->tokenMutex.Acquire();
+    REI_RL_TokenWaiter** ppWaiter = &pRMState->tokenWaiters;
+    while (*ppWaiter)
+    {
+        REI_RL_TokenWaiter* pWaiter = *ppWaiter;
+        if (REI_RL_isWaitSatisfied(pRMState, pWaiter->token, pWaiter->batch))
+        {
+            *ppWaiter = pWaiter->pNext;
+            pWaiter->signaled = true;
+            pWaiter->cond.WakeOne();
+        }
+        else
+        {
+            ppWaiter = &pWaiter->pNext;
+        }
+    }
+    pRMState->tokenMutex.Release();
+}
+
+// Marks a token done. Returns false if it is too far ahead of the watermark to get a slot yet
+static bool REI_RL_completeToken(REI_RL_State* pRMState, REI_RL_RequestId token, REI_RL_RequestId& completed)
+{
+    if (token == completed + 1)
+    {
+        completed = token;
+        // Fold in the tokens that were only waiting for this one
+        while (REI_atomicptr_load_relaxed(&pRMState->completedTokens[(completed + 1) & (TOKEN_WINDOW_SIZE - 1)]) ==
+               completed + 1)
+        {
+            ++completed;
+        }
+        return true;
+    }
+
+    if (token - completed > TOKEN_WINDOW_SIZE)
+        return false;
+
+    // The slot still holds a token at or below the local watermark, publish it before readers lose that token
+    if (REI_atomicptr_load_relaxed(&pRMState->requestsCompleted) != completed)
+        REI_atomicptr_store_release(&pRMState->requestsCompleted, completed);
+    REI_atomicptr_store_release(&pRMState->completedTokens[token & (TOKEN_WINDOW_SIZE - 1)], token);
+    return true;
+}
+
+static void REI_RL_completeTokens(REI_RL_State* pRMState, REI_deque<REI_RL_RequestId>& tokens, size_t count)
+{
+    if (!count)
+        return;
+
+    REI_RL_RequestId completed = REI_atomicptr_load_relaxed(&pRMState->requestsCompleted);
+    for (size_t i = 0; i < count; ++i)
+    {
+        REI_RL_RequestId token = tokens.front();
+        tokens.pop_front();
+        if (!REI_RL_completeToken(pRMState, token, completed))
+            pRMState->tokensDeferred.push_back(token);
+    }
+
+    // Retry deferred tokens while the watermark keeps moving
+    REI_vector<REI_RL_RequestId>& deferred = pRMState->tokensDeferred;
+    for (bool progress = true; progress && !deferred.empty();)
+    {
+        progress = false;
+        for (size_t i = 0; i < deferred.size();)
+        {
+            if (REI_RL_completeToken(pRMState, deferred[i], completed))
+            {
+                deferred[i] = deferred.back();
+                deferred.pop_back();
+                progress = true;
+            }
+            else
+            {
+                ++i;
+            }
+        }
+    }
+
+    REI_atomicptr_store_release(&pRMState->requestsCompleted, completed);
+    REI_RL_wakeTokenWaiters(pRMState);
+}
+
+static bool REI_RL_areRequestRingsEmpty(REI_RL_State* pRMState)
+{
+    for (uint32_t i = 0; i < REI_RL_PRIORITY_COUNT; ++i)
+    {
+        if (!REI_RL_isRequestRingEmpty(pRMState->requestRings[i]))
+            return false;
+    }
+    return true;
+}
+
 static void streamerThreadFunc(void* pThreadData)
 {
     REI_RL_State* pRMState = (REI_RL_State*)pThreadData;
     REI_ASSERT(pRMState);
 
-    bool requestCompleted = true;
-
-    REI_RL_RequestId   lastRequestIdInSet[MAX_BUFFER_COUNT] = { 0 };
-    uintptr_t          requestsProcessed = 0;
-    size_t             activeSet = 0;
-    REI_RL_UpdateState updateState;
+    // Tokens of completed requests in recording order, sets are submitted and waited for round robin
+    REI_deque<REI_RL_RequestId> recordedTokens(REI_allocator<REI_RL_RequestId>(pRMState->allocator));
+    size_t                      recordedTokenCount[MAX_BUFFER_COUNT] = { 0 };
+    uint64_t                    submitStartUs[MAX_BUFFER_COUNT] = { 0 };
+    uint64_t                    submitBytes[MAX_BUFFER_COUNT] = { 0 };
+    size_t                      activeSet = 0;
+    REI_RL_UpdateState          updateStates[REI_RL_PRIORITY_COUNT];
+    bool                        activeStates[REI_RL_PRIORITY_COUNT] = { false };
+    const uint64_t              timesliceUs = (uint64_t)pRMState->desc.timesliceMs * 1000;
     while (1)
     {
-        pRMState->queueMutex.Acquire();
-        while (pRMState->run && requestsProcessed == REI_atomicptr_load_relaxed(&pRMState->requestsCompleted) &&
-               pRMState->requestQueue.empty())
+        bool hasActiveRequest = false;
+        for (uint32_t i = 0; i < REI_RL_PRIORITY_COUNT; ++i)
+            hasActiveRequest |= activeStates[i];
+
+        if (recordedTokens.empty() && !hasActiveRequest)
         {
-            pRMState->queueCond.Wait(pRMState->queueMutex);
+            pRMState->queueMutex.Acquire();
+            // Interlocked store, a producer either sees the flag or its request is seen by the check below
+            REI_atomic32_store_relaxed(&pRMState->streamerSleeping, 1);
+            while (pRMState->run && REI_RL_areRequestRingsEmpty(pRMState))
+            {
+                pRMState->queueCond.Wait(pRMState->queueMutex);
+            }
+            REI_atomic32_store_relaxed(&pRMState->streamerSleeping, 0);
+            pRMState->queueMutex.Release();
         }
-        pRMState->queueMutex.Release();
 
         if (!pRMState->run)
         {
@@ -747,18 +1560,24 @@ static void streamerThreadFunc(void* pThreadData)
             activeSet = (activeSet + 1) % pRMState->desc.bufferCount;
             REI_RL_ResourceSet& resourceSet = pRMState->resourceSets[activeSet];
             REI_waitForFences(pRMState->pRenderer, 1, &resourceSet.pFence);
-            REI_atomicptr_store_release(&pRMState->requestsCompleted, lastRequestIdInSet[activeSet]);
-            pRMState->tokenCond.WakeAll();
+            REI_RL_completeTokens(pRMState, recordedTokens, recordedTokenCount[activeSet]);
+            recordedTokenCount[activeSet] = 0;
+            REI_RL_releaseTransientMemory(pRMState, activeSet);
+
+            if (submitStartUs[activeSet])
+            {
+                REI_RL_reportSubmit(pRMState, REI_RL_getTimeUs() - submitStartUs[activeSet], submitBytes[activeSet]);
+                submitStartUs[activeSet] = 0;
+            }
         }
 
-        // check if we have new requests
-        pRMState->queueMutex.Acquire();
-        bool isQueueEmpty = pRMState->requestQueue.empty();
-        pRMState->queueMutex.Release();
-        if (!isQueueEmpty)
+        // check if we have new requests or an unfinished one
+        uint32_t priority = REI_RL_selectRequest(pRMState, updateStates, activeStates);
+        if (priority != REI_RL_PRIORITY_COUNT)
         {
             REI_RL_ResourceSet& resourceSet = pRMState->resourceSets[activeSet];
             pRMState->allocatedSpace = 0;
+            pRMState->transientSpace = 0;
             REI_resetCmdPool(pRMState->pRenderer, resourceSet.pCmdPool);
             REI_beginCmd(resourceSet.pCmd);
         }
@@ -767,58 +1586,69 @@ static void streamerThreadFunc(void* pThreadData)
             continue;
         }
 
-        // Record commands
-        while (1)
+        // Record commands until the queues are drained, the staging buffer is full or the timeslice expires
+        const uint64_t sliceStartUs = REI_RL_getTimeUs();
+        submitStartUs[activeSet] = sliceStartUs;
+        while (priority != REI_RL_PRIORITY_COUNT)
         {
-            if (requestCompleted)
+            REI_RL_UpdateState& updateState = updateStates[priority];
+            uint64_t            allocatedSpace = pRMState->allocatedSpace;
+            bool                requestCompleted = true;
+            if (updateState.request.pStagingBuffer)
             {
-                pRMState->queueMutex.Acquire();
-                if (!pRMState->requestQueue.empty())
-                {
-                    updateState = pRMState->requestQueue.front();
-                    pRMState->requestQueue.pop_front();
-                }
-                else
+                requestCompleted = REI_RL_updateStaged(pRMState, activeSet, updateState);
+            }
+            else
+            {
+                switch (updateState.request.type)
                 {
-                    pRMState->queueMutex.Release();
-                    break;
+                    case REI_RL_UPDATE_REQUEST_UPDATE_BUFFER:
+                        requestCompleted = REI_RL_updateBuffer(pRMState, activeSet, updateState);
+                        break;
+                    case REI_RL_UPDATE_REQUEST_UPDATE_TEXTURE:
+                        requestCompleted = REI_RL_updateTexture(pRMState, activeSet, updateState);
+                        break;
+                    default:
+                        requestCompleted = true;
+                        REI_ASSERT(false, "Should not happen");
+                        break;
                 }
-                pRMState->queueMutex.Release();
             }
 
-            switch (updateState.request.type)
+            if (requestCompleted)
             {
-                case REI_RL_UPDATE_REQUEST_UPDATE_BUFFER:
-                    requestCompleted = REI_RL_updateBuffer(pRMState, activeSet, updateState);
-                    break;
-                case REI_RL_UPDATE_REQUEST_UPDATE_TEXTURE:
-                    requestCompleted = REI_RL_updateTexture(pRMState, activeSet, updateState);
-                    break;
-                default:
-                    requestCompleted = true;
-                    REI_ASSERT(false, "Should not happen");
-                    break;
+                activeStates[priority] = false;
+                recordedTokens.push_back(updateState.request.token);
+                ++recordedTokenCount[activeSet];
             }
-
-            if (requestCompleted)
+            else if (allocatedSpace == pRMState->allocatedSpace)
             {
-                lastRequestIdInSet[activeSet] = ++requestsProcessed;
+                // Staging buffer is full
+                break;
             }
-            else
+
+            if (timesliceUs && REI_RL_getTimeUs() - sliceStartUs >= timesliceUs)
             {
                 break;
             }
+
+            priority = REI_RL_selectRequest(pRMState, updateStates, activeStates);
         }
 
         // Submit work
         {
             REI_RL_ResourceSet& resourceSet = pRMState->resourceSets[activeSet];
+            // Copy commands are recorded against staging ranges that copy workers may still be filling,
+            // they only have to be complete before the command buffer is submitted
+            REI_RL_flushCopyTasks(pRMState);
             REI_endCmd(resourceSet.pCmd);
             REI_queueSubmit(pRMState->pQueue, 1, &resourceSet.pCmd, resourceSet.pFence, 0, 0, 0, 0);
+            submitBytes[activeSet] = pRMState->allocatedSpace + pRMState->transientSpace;
         }
     }
 
     REI_waitQueueIdle(pRMState->pQueue);
+    REI_RL_releaseTransientMemory(pRMState, ~(size_t)0);
 }
 
 void REI_RL_addResourceLoader(REI_Renderer* pRenderer, REI_RL_ResourceLoaderDesc* pDesc, REI_RL_State** ppRMState)
@@ -832,8 +1662,10 @@ void REI_RL_addResourceLoader(REI_Renderer* pRenderer, REI_RL_ResourceLoaderDesc
 
     pRMState->pRenderer = pRenderer;
     pRMState->run = true;
-    pRMState->desc =
-        pDesc ? *pDesc : REI_RL_ResourceLoaderDesc{ DEFAULT_BUFFER_SIZE, DEFAULT_BUFFER_COUNT, DEFAULT_TIMESLICE_MS };
+    pRMState->desc = pDesc ? *pDesc
+                           : REI_RL_ResourceLoaderDesc{ DEFAULT_BUFFER_SIZE, DEFAULT_BUFFER_COUNT, DEFAULT_TIMESLICE_MS,
+                                                        DEFAULT_COPY_THREAD_COUNT, DEFAULT_MAX_TRANSIENT_SIZE };
+    pRMState->desc.copyThreadCount = REI_min<uint32_t>(pRMState->desc.copyThreadCount, MAX_COPY_THREAD_COUNT);
 
     REI_QueueDesc desc = { REI_QUEUE_FLAG_NONE, REI_QUEUE_PRIORITY_NORMAL, REI_CMD_POOL_COPY };
     REI_addQueue(pRenderer, &desc, &pRMState->pQueue);
@@ -867,6 +1699,18 @@ void REI_RL_addResourceLoader(REI_Renderer* pRenderer, REI_RL_ResourceLoaderDesc
 
     pRMState->allocatedSpace = 0;
 
+    for (uint32_t i = 0; i < REI_RL_PRIORITY_COUNT; ++i)
+    {
+        REI_RL_initRequestRing(allocator, pRMState->requestRings[i]);
+    }
+    pRMState->streamerSleeping = 0;
+
+    pRMState->completedTokens = (REI_atomicptr_t*)allocator.pMalloc(
+        allocator.pUserData, sizeof(REI_atomicptr_t) * TOKEN_WINDOW_SIZE, alignof(REI_atomicptr_t));
+    memset((void*)pRMState->completedTokens, 0, sizeof(REI_atomicptr_t) * TOKEN_WINDOW_SIZE);
+    pRMState->tokenWaiters = nullptr;
+    pRMState->tokenWaiterCount = 0;
+
     REI_DeviceProperties deviceProperties{};
     REI_getDeviceProperties(pRenderer, &deviceProperties);
 
@@ -880,15 +1724,32 @@ void REI_RL_addResourceLoader(REI_Renderer* pRenderer, REI_RL_ResourceLoaderDesc
 
     pRMState->thread = create_thread(&pRMState->threadDesc);
 
+    pRMState->copyThreadDesc.pFunc = copyWorkerThreadFunc;
+    pRMState->copyThreadDesc.pData = pRMState;
+    for (uint32_t i = 0; i < pRMState->desc.copyThreadCount; ++i)
+    {
+        pRMState->copyThreads[i] = create_thread(&pRMState->copyThreadDesc);
+    }
+
     *ppRMState = pRMState;
 }
 
 void REI_RL_removeResourceLoader(REI_RL_State* pRMState)
 {
+    pRMState->queueMutex.Acquire();
     pRMState->run = false;
     pRMState->queueCond.WakeOne();
+    pRMState->queueMutex.Release();
     destroy_thread(pRMState->thread);
 
+    pRMState->copyMutex.Acquire();
+    pRMState->copyCond.WakeAll();
+    pRMState->copyMutex.Release();
+    for (uint32_t i = 0; i < pRMState->desc.copyThreadCount; ++i)
+    {
+        destroy_thread(pRMState->copyThreads[i]);
+    }
+
     for (uint32_t i = 0; i < pRMState->desc.bufferCount; ++i)
     {
         REI_RL_ResourceSet& resourceSet = pRMState->resourceSets[i];
@@ -903,49 +1764,139 @@ void REI_RL_removeResourceLoader(REI_RL_State* pRMState)
 
     pRMState->allocator.pFree(pRMState->allocator.pUserData, pRMState->resourceSets);
 
+    for (uint32_t i = 0; i < REI_RL_PRIORITY_COUNT; ++i)
+    {
+        pRMState->allocator.pFree(pRMState->allocator.pUserData, pRMState->requestRings[i].slots);
+    }
+    pRMState->allocator.pFree(pRMState->allocator.pUserData, (void*)pRMState->completedTokens);
+
     REI_removeQueue(pRMState->pQueue);
 
     REI_delete(pRMState->allocator, pRMState);
 }
 
-static void
-    REI_RL_queueResourceUpdate(REI_RL_State* pRMState, REI_RL_BufferUpdateDesc* pBufferUpdate, REI_RL_RequestId* token)
+static void REI_RL_wakeStreamer(REI_RL_State* pRMState)
 {
-    pRMState->queueMutex.Acquire();
-    REI_RL_RequestId t = REI_atomicptr_add_relaxed(&pRMState->requestsSubmitted, 1) + 1;
-    pRMState->requestQueue.emplace_back(REI_RL_UpdateRequest(*pBufferUpdate));
-    pRMState->queueMutex.Release();
-    pRMState->queueCond.WakeOne();
-    if (token)
-        *token = t;
+    if (REI_atomic32_load_relaxed(&pRMState->streamerSleeping))
+    {
+        pRMState->queueMutex.Acquire();
+        pRMState->queueCond.WakeOne();
+        pRMState->queueMutex.Release();
+    }
 }
 
-static void REI_RL_queueResourceUpdate(
-    REI_RL_State* pRMState, REI_RL_TextureUpdateDesc* pTextureUpdate, REI_RL_RequestId* token)
+template<typename T>
+static void REI_RL_pushRequestsWait(
+    REI_RL_State* pRMState, REI_RL_Priority priority, const T* pDescs, uint32_t count, REI_RL_RequestId firstToken)
 {
-    pRMState->queueMutex.Acquire();
-    REI_RL_RequestId t = REI_atomicptr_add_relaxed(&pRMState->requestsSubmitted, 1) + 1;
-    pRMState->requestQueue.emplace_back(REI_RL_UpdateRequest(*pTextureUpdate));
-    pRMState->queueMutex.Release();
-    pRMState->queueCond.WakeOne();
-    if (token)
-        *token = t;
+    while (!REI_RL_pushRequests(pRMState->requestRings[priority], pDescs, count, firstToken))
+    {
+        // The ring is full, make sure the streamer drains it
+        REI_RL_wakeStreamer(pRMState);
+        Thread::Sleep(0);
+    }
+}
+
+// Tokens of all count updates are reserved at once, every run of equal priority takes one slot claim in its ring
+template<typename T>
+static void REI_RL_queueResourceUpdates(REI_RL_State* pRMState, const T* pDescs, uint32_t count, REI_RL_RequestId* pTokens)
+{
+    if (!count)
+        return;
+
+    REI_RL_RequestId firstToken = REI_atomicptr_add_relaxed(&pRMState->requestsSubmitted, count) + 1;
+    for (uint32_t first = 0; first < count;)
+    {
+        REI_RL_Priority priority = pDescs[first].priority;
+        REI_ASSERT(priority < REI_RL_PRIORITY_COUNT);
+        uint32_t runCount = 1;
+        while (first + runCount < count && runCount < REQUEST_RING_SIZE && pDescs[first + runCount].priority == priority)
+            ++runCount;
+
+        REI_RL_pushRequestsWait(pRMState, priority, pDescs + first, runCount, firstToken + first);
+        first += runCount;
+    }
+    REI_RL_wakeStreamer(pRMState);
+
+    if (pTokens)
+    {
+        for (uint32_t i = 0; i < count; ++i)
+            pTokens[i] = firstToken + i;
+    }
+}
+
+static void REI_RL_queueStagedUpdate(
+    REI_RL_State* pRMState, REI_RL_UpdateRequest& request, REI_RL_Priority priority, REI_RL_UpdateMemory* pMemory,
+    REI_RL_RequestId* pToken)
+{
+    REI_ASSERT(pMemory->pStagingBuffer && priority < REI_RL_PRIORITY_COUNT);
+    request.pStagingBuffer = pMemory->pStagingBuffer;
+    request.stagingSize = pMemory->size;
+    REI_unmapBuffer(pRMState->pRenderer, pMemory->pStagingBuffer);
+
+    REI_RL_RequestId token = REI_atomicptr_add_relaxed(&pRMState->requestsSubmitted, 1) + 1;
+    REI_RL_pushRequestsWait(pRMState, priority, &request, 1, token);
+    REI_RL_wakeStreamer(pRMState);
+
+    *pMemory = {};
+    if (pToken)
+        *pToken = token;
+}
+
+static void REI_RL_allocateUpdateMemory(REI_RL_State* pRMState, uint64_t size, REI_RL_UpdateMemory* pMemory)
+{
+    REI_BufferDesc bufferDesc = {};
+    bufferDesc.size = size;
+    bufferDesc.memoryUsage = REI_RESOURCE_MEMORY_USAGE_CPU_ONLY;
+    bufferDesc.flags = size > pRMState->desc.bufferSize ? REI_BUFFER_CREATION_FLAG_OWN_MEMORY_BIT
+                                                         : REI_BUFFER_CREATION_FLAG_NONE;
+
+    *pMemory = {};
+    REI_addBuffer(pRMState->pRenderer, &bufferDesc, &pMemory->pStagingBuffer);
+    REI_ASSERT(pMemory->pStagingBuffer);
+    REI_mapBuffer(pRMState->pRenderer, pMemory->pStagingBuffer, (void**)&pMemory->pData);
+    pMemory->size = size;
+}
+
+void REI_RL_beginUpdate(REI_RL_State* pRMState, REI_RL_BufferUpdateDesc* pBufferUpdate, REI_RL_UpdateMemory* pMemory)
+{
+    REI_RL_allocateUpdateMemory(pRMState, pBufferUpdate->size, pMemory);
+}
+
+void REI_RL_beginUpdate(REI_RL_State* pRMState, REI_RL_TextureUpdateDesc* pTextureUpdate, REI_RL_UpdateMemory* pMemory)
+{
+    REI_ASSERT(REI_RL_isLinearLayout(pTextureUpdate->format), "Staged updates of swizzled formats are not supported");
+
+    uint32_t rowPitch, slicePitch, sliceCount;
+    REI_RL_getTextureStagingLayout(pRMState, *pTextureUpdate, &rowPitch, &slicePitch, &sliceCount);
+    REI_RL_allocateUpdateMemory(pRMState, (uint64_t)slicePitch * sliceCount, pMemory);
+    pMemory->rowPitch = rowPitch;
+    pMemory->slicePitch = slicePitch;
+}
+
+void REI_RL_endUpdate(
+    REI_RL_State* pRMState, REI_RL_BufferUpdateDesc* pBufferUpdate, REI_RL_UpdateMemory* pMemory, REI_RL_RequestId* token)
+{
+    REI_RL_UpdateRequest request(*pBufferUpdate, 0);
+    REI_RL_queueStagedUpdate(pRMState, request, pBufferUpdate->priority, pMemory, token);
+}
+
+void REI_RL_endUpdate(
+    REI_RL_State* pRMState, REI_RL_TextureUpdateDesc* pTextureUpdate, REI_RL_UpdateMemory* pMemory,
+    REI_RL_RequestId* token)
+{
+    REI_RL_UpdateRequest request(*pTextureUpdate, 0);
+    REI_RL_queueStagedUpdate(pRMState, request, pTextureUpdate->priority, pMemory, token);
 }
 
 bool REI_RL_isTokenCompleted(REI_RL_State* pRMState, REI_RL_RequestId token)
 {
-    bool completed = REI_atomicptr_load_acquire(&pRMState->requestsCompleted) >= token;
-    return completed;
+    return REI_RL_isWaitSatisfied(pRMState, token, false);
 }
 
 void REI_RL_waitTokenCompleted(REI_RL_State* pRMState, REI_RL_RequestId token)
 {
-    pRMState->tokenMutex.Acquire();
-    while (!REI_RL_isTokenCompleted(pRMState, token))
-    {
-        pRMState->tokenCond.Wait(pRMState->tokenMutex);
-    }
-    pRMState->tokenMutex.Release();
+    REI_RL_waitToken(pRMState, token, false);
 }
 
 void REI_RL_updateResource(REI_RL_State* pRMState, REI_RL_BufferUpdateDesc* pBufferUpdate, bool batch)
@@ -966,28 +1917,42 @@ void REI_RL_updateResource(REI_RL_State* pRMState, REI_RL_TextureUpdateDesc* pTe
 
 void REI_RL_updateResource(REI_RL_State* pRMState, REI_RL_BufferUpdateDesc* pBufferUpdate, REI_RL_RequestId* token)
 {
-    REI_RL_RequestId updateToken;
-    REI_RL_queueResourceUpdate(pRMState, pBufferUpdate, &updateToken);
-    if (token)
-        *token = updateToken;
+    REI_RL_queueResourceUpdates(pRMState, pBufferUpdate, 1, token);
 }
 
 void REI_RL_updateResource(REI_RL_State* pRMState, REI_RL_TextureUpdateDesc* pTextureUpdate, REI_RL_RequestId* token)
 {
-    REI_RL_RequestId updateToken;
-    REI_RL_queueResourceUpdate(pRMState, pTextureUpdate, &updateToken);
-    if (token)
-        *token = updateToken;
+    REI_RL_queueResourceUpdates(pRMState, pTextureUpdate, 1, token);
+}
+
+void REI_RL_updateResources(
+    REI_RL_State* pRMState, uint32_t count, REI_RL_BufferUpdateDesc* pBufferUpdates, REI_RL_RequestId* pTokens)
+{
+    REI_RL_queueResourceUpdates(pRMState, pBufferUpdates, count, pTokens);
 }
 
+void REI_RL_updateResources(
+    REI_RL_State* pRMState, uint32_t count, REI_RL_TextureUpdateDesc* pTextureUpdates, REI_RL_RequestId* pTokens)
+{
+    REI_RL_queueResourceUpdates(pRMState, pTextureUpdates, count, pTokens);
+}
+
+// A batch is only completed once every token up to the last submitted one is done, not just the last token
 bool REI_RL_isBatchCompleted(REI_RL_State* pRMState)
 {
     REI_RL_RequestId token = REI_atomicptr_load_relaxed(&pRMState->requestsSubmitted);
-    return REI_RL_isTokenCompleted(pRMState, token);
+    return REI_RL_isWaitSatisfied(pRMState, token, true);
 }
 
 void REI_RL_waitBatchCompleted(REI_RL_State* pRMState)
 {
     REI_RL_RequestId token = REI_atomicptr_load_relaxed(&pRMState->requestsSubmitted);
-    REI_RL_waitTokenCompleted(pRMState, token);
+    REI_RL_waitToken(pRMState, token, true);
+}
+
+void REI_RL_getStats(REI_RL_State* pRMState, REI_RL_Stats* pStats)
+{
+    pRMState->statsMutex.Acquire();
+    *pStats = pRMState->stats;
+    pRMState->statsMutex.Release();
 }
@@ -17,13 +17,24 @@
 
 #include "REI/Renderer.h"
 
+typedef enum REI_RL_Priority
+{
+    REI_RL_PRIORITY_NORMAL = 0,
+    // Preempts normal and low priority uploads, even a partially uploaded texture, between two upload regions
+    REI_RL_PRIORITY_HIGH,
+    REI_RL_PRIORITY_LOW,
+    REI_RL_PRIORITY_COUNT
+} REI_RL_Priority;
+
 typedef struct REI_RL_BufferUpdateDesc
 {
-    REI_Buffer* pBuffer;
-    const void* pData;
-    uint64_t    srcOffset;
-    uint64_t    dstOffset;
-    uint64_t    size;
+    REI_Buffer*     pBuffer;
+    const void*     pData;
+    uint64_t        srcOffset;
+    uint64_t        dstOffset;
+    uint64_t        size;
+    // Requests of different priorities may complete out of order, even when they update the same resource
+    REI_RL_Priority priority;
 } REI_RL_BufferUpdateDesc;
 
 typedef struct REI_RL_TextureUpdateDesc
@@ -36,6 +47,7 @@ typedef struct REI_RL_TextureUpdateDesc
     uint32_t          arrayLayer;
     uint32_t          mipLevel;
     REI_ResourceState endState;
+    REI_RL_Priority   priority;
 } REI_RL_TextureUpdateDesc;
 
 typedef uintptr_t REI_RL_RequestId;
@@ -44,10 +56,38 @@ typedef struct REI_RL_ResourceLoaderDesc
 {
     uint64_t                      bufferSize;
     uint32_t                      bufferCount;
-    uint32_t                      timesliceMs;
+    uint32_t                      timesliceMs;    // max time spent recording one submit, 0 - until staging is full
+    uint32_t                      copyThreadCount;    // threads filling staging memory, 0 - copy on the streamer thread
+    uint64_t                      maxTransientSize;    // budget for dedicated buffers of uploads larger than bufferSize
     const REI_AllocatorCallbacks* pAllocator;
 } REI_RL_ResourceLoaderDesc;
 
+typedef struct REI_RL_Stats
+{
+    uint64_t submitCount;
+    // Time from the start of recording a submit until its fence is observed as signaled
+    uint64_t lastSubmitLatencyUs;
+    uint64_t maxSubmitLatencyUs;
+    uint64_t totalSubmitLatencyUs;
+    uint64_t lastSubmitBytes;
+    uint64_t totalSubmitBytes;
+    // Dedicated buffers created for uploads that do not fit the staging buffer
+    uint64_t transientBufferCount;
+    uint64_t transientBytes;
+    uint64_t maxTransientBytes;
+} REI_RL_Stats;
+
+// Staging memory handed out by REI_RL_beginUpdate, the update is written to pData instead of being copied from
+// pData/pRawData of the desc. Texture data is laid out as rows of texel blocks rowPitch bytes apart
+typedef struct REI_RL_UpdateMemory
+{
+    uint8_t*    pData;
+    uint32_t    rowPitch;
+    uint32_t    slicePitch;
+    uint64_t    size;
+    REI_Buffer* pStagingBuffer;
+} REI_RL_UpdateMemory;
+
 struct REI_RL_State;
 
 void REI_RL_addResourceLoader(REI_Renderer* pRenderer, REI_RL_ResourceLoaderDesc* pDesc, REI_RL_State** ppRMState);
@@ -57,8 +97,36 @@ void REI_RL_updateResource(REI_RL_State* pRMState, REI_RL_BufferUpdateDesc* pBuf
 void REI_RL_updateResource(REI_RL_State* pRMState, REI_RL_TextureUpdateDesc* pTexture, bool batch = false);
 void REI_RL_updateResource(REI_RL_State* pRMState, REI_RL_BufferUpdateDesc* pBuffer, REI_RL_RequestId* token);
 void REI_RL_updateResource(REI_RL_State* pRMState, REI_RL_TextureUpdateDesc* pTexture, REI_RL_RequestId* token);
+// Queues count updates at once, pTokens receives one token per update when not null
+void REI_RL_updateResources(
+    REI_RL_State* pRMState, uint32_t count, REI_RL_BufferUpdateDesc* pBuffers, REI_RL_RequestId* pTokens = nullptr);
+void REI_RL_updateResources(
+    REI_RL_State* pRMState, uint32_t count, REI_RL_TextureUpdateDesc* pTextures, REI_RL_RequestId* pTokens = nullptr);
+
+// The desc passed to REI_RL_endUpdate has to describe the same update as the one passed to REI_RL_beginUpdate
+void REI_RL_beginUpdate(REI_RL_State* pRMState, REI_RL_BufferUpdateDesc* pBuffer, REI_RL_UpdateMemory* pMemory);
+void REI_RL_beginUpdate(REI_RL_State* pRMState, REI_RL_TextureUpdateDesc* pTexture, REI_RL_UpdateMemory* pMemory);
+void REI_RL_endUpdate(
+    REI_RL_State* pRMState, REI_RL_BufferUpdateDesc* pBuffer, REI_RL_UpdateMemory* pMemory,
+    REI_RL_RequestId* token = nullptr);
+void REI_RL_endUpdate(
+    REI_RL_State* pRMState, REI_RL_TextureUpdateDesc* pTexture, REI_RL_UpdateMemory* pMemory,
+    REI_RL_RequestId* token = nullptr);
 
 bool REI_RL_isBatchCompleted(REI_RL_State* pRMState);
 void REI_RL_waitBatchCompleted(REI_RL_State* pRMState);
 bool REI_RL_isTokenCompleted(REI_RL_State* pRMState, REI_RL_RequestId token);
 void REI_RL_waitTokenCompleted(REI_RL_State* pRMState, REI_RL_RequestId token);
+
+void REI_RL_getStats(REI_RL_State* pRMState, REI_RL_Stats* pStats);
+
+// Block copies behind texture uploads, exposed for tests and benchmarks. Source images are widthInBlocks x
+// heightInBlocks blocks per slice, pRegion is in blocks and is written to pDst starting at its origin.
+// REI_RL_copyZCurveBlocks reads swizzled (PVRTC) images whose blocks are stored in Morton order,
+// both sides of those have to be powers of two.
+void REI_RL_copyLinearBlocks(
+    uint8_t* pDst, const uint8_t* pSrc, uint32_t blockSize, uint32_t widthInBlocks, uint32_t heightInBlocks,
+    const REI_Region3D* pRegion, uint32_t dstRowPitch, uint32_t dstSlicePitch);
+void REI_RL_copyZCurveBlocks(
+    uint8_t* pDst, const uint8_t* pSrc, uint32_t blockSize, uint32_t widthInBlocks, uint32_t heightInBlocks,
+    const REI_Region3D* pRegion, uint32_t dstRowPitch, uint32_t dstSlicePitch);
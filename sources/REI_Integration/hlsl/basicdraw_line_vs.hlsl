@@ -19,6 +19,8 @@ struct LineStruct
     uint   c;
 };
 static const uint SIZEOF_LINE = 32;
+// Quantized line: uint16 p0[3], 8.8 fixed point w, uint16 p1[3], RGBA4444 color
+static const uint SIZEOF_LINE_QUANTIZED = 16;
 
 struct Uniforms
 {
@@ -31,6 +33,7 @@ struct uVertPC
 {
     REI_SPIRV([[vk::offset(0)]]) uint idx;
     uint                   baseVertexLocation;
+    uint                   type;
 };
 
 REI_DECLARE_PUSH_CONSTANT(v_pushconstant, uVertPC, 0, 0);
@@ -62,6 +65,12 @@ float4 Color32toVec4(uint c)
     return r / 255.0f;
 }
 
+// Expands RGBA4444 to RGBA8888
+uint Color16toColor32(uint c)
+{
+    return ((c & 0xF) | ((c & 0xF0) << 4) | ((c & 0xF00) << 8) | ((c & 0xF000) << 12)) * 17;
+}
+
 PS_INPUT main(VS_INPUT input)
 {
     PS_INPUT output;
@@ -75,16 +84,28 @@ PS_INPUT main(VS_INPUT input)
     // 1-------------3
     // Line is triangles 210 and 123
     uint vertexIndex = abs(2 - int(curVertexID - lineIndex * 6));
-    uint startAddr = lineIndex * SIZEOF_LINE;
-    uint offset = 0;
     LineStruct curLine;
-    curLine.p0 = asfloat(uLines.Load3(startAddr + offset));
-    offset += 3 * 4;
-    curLine.w = asfloat(uLines.Load(startAddr + offset));
-    offset += 4;
-    curLine.p1 = asfloat(uLines.Load3(startAddr + offset));
-    offset += 3 * 4;
-    curLine.c = uLines.Load(startAddr + offset);
+    if (v_pushconstant.type == 0)
+    {
+        uint startAddr = lineIndex * SIZEOF_LINE;
+        uint offset = 0;
+        curLine.p0 = asfloat(uLines.Load3(startAddr + offset));
+        offset += 3 * 4;
+        curLine.w = asfloat(uLines.Load(startAddr + offset));
+        offset += 4;
+        curLine.p1 = asfloat(uLines.Load3(startAddr + offset));
+        offset += 3 * 4;
+        curLine.c = uLines.Load(startAddr + offset);
+    }
+    else
+    {
+        // Quantized positions, the box is folded into uMVP
+        uint4 q = uLines.Load4(lineIndex * SIZEOF_LINE_QUANTIZED);
+        curLine.p0 = float3(q.x & 0xFFFF, q.x >> 16, q.y & 0xFFFF);
+        curLine.w = (q.y >> 16) / 256.0;
+        curLine.p1 = float3(q.z & 0xFFFF, q.z >> 16, q.w & 0xFFFF);
+        curLine.c = Color16toColor32(q.w >> 16);
+    }
     
     float4 p0 = float4(curLine.p0, 1.0);
     float4 p1 = float4(curLine.p1, 1.0);
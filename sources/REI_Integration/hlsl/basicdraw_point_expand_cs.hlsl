@@ -0,0 +1,94 @@
+/*
+ * Copyright (c) 2023-2024 Dragons Lake, part of Room 8 Group.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you may not use this file except in compliance with the License. You may obtain a copy of the License at 
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software distributed under the License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the License for the specific language governing permissions and limitations under the License.
+ */
+
+#include "defines.hlsli"
+#pragma pack_matrix(column_major)
+
+static const uint SIZEOF_POINT_0 = 16;
+static const uint SIZEOF_POINT_1_2 = 12;
+static const uint SIZEOF_POINT_3 = 8;
+static const uint SIZEOF_EXPANDED_POINT = 32;
+static const uint THREAD_GROUP_SIZE = 64;
+
+struct Uniforms
+{
+    float4x4 uMVP;
+    float3   uPxScalers;
+    uint     uColor;
+};
+
+struct uCompPC
+{
+    REI_SPIRV([[vk::offset(0)]]) uint idx;
+    uint                   type;
+    uint                   firstPoint;
+    uint                   pointCount;
+    uint                   firstExpanded;
+};
+
+REI_DECLARE_PUSH_CONSTANT(c_pushconstant, uCompPC, 0, 0);
+
+REI_SPIRV([[vk::binding(0, 0)]]) StructuredBuffer<Uniforms> uUniforms REI_REGISTER(t0, space0);
+
+REI_SPIRV([[vk::binding(1, 0)]]) RWByteAddressBuffer uExpanded REI_REGISTER(u0, space0);
+
+REI_SPIRV([[vk::binding(0, 1)]]) ByteAddressBuffer uStream0 REI_REGISTER(t0, space1);
+
+REI_SPIRV([[vk::binding(1, 1)]]) StructuredBuffer<uint> uStream1 REI_REGISTER(t1, space1);
+
+// Expands RGBA4444 to RGBA8888
+uint Color16toColor32(uint c)
+{
+    return ((c & 0xF) | ((c & 0xF0) << 4) | ((c & 0xF00) << 8) | ((c & 0xF000) << 12)) * 17;
+}
+
+// Writes one 32 byte record per point: clip space center, clip space half extent and packed color.
+// Transform and format decoding happen once per point here instead of once per quad corner in the vertex shader.
+[numthreads(THREAD_GROUP_SIZE, 1, 1)]
+void main(uint3 dispatchThreadID: SV_DispatchThreadID)
+{
+    uint i = dispatchThreadID.x;
+    if (i >= c_pushconstant.pointCount)
+        return;
+
+    uint   index = c_pushconstant.firstPoint + i;
+    float3 p = (float3)0;
+    uint   c = 0;
+
+    if (c_pushconstant.type == 0)
+    {
+        p = asfloat(uStream0.Load3(index * SIZEOF_POINT_0));
+        c = uStream0.Load(index * SIZEOF_POINT_0 + 3 * 4);
+    }
+    else if (c_pushconstant.type == 1)
+    {
+        p = asfloat(uStream0.Load3(index * SIZEOF_POINT_1_2));
+        c = uStream1[index];
+    }
+    else if (c_pushconstant.type == 2)
+    {
+        p = asfloat(uStream0.Load3(index * SIZEOF_POINT_1_2));
+        c = uUniforms[c_pushconstant.idx].uColor;
+    }
+    else
+    {
+        // Quantized position, the box is folded into uMVP
+        uint2 q = uStream0.Load2(index * SIZEOF_POINT_3);
+        p = float3(q.x & 0xFFFF, q.x >> 16, q.y & 0xFFFF);
+        c = Color16toColor32(q.y >> 16);
+    }
+
+    float4 p0 = mul(uUniforms[c_pushconstant.idx].uMVP, float4(p, 1.0));
+    float2 offset = uUniforms[c_pushconstant.idx].uPxScalers.xy * -p0.w; //undo perspective
+
+    uint dstAddr = (c_pushconstant.firstExpanded + i) * SIZEOF_EXPANDED_POINT;
+    uExpanded.Store4(dstAddr, asuint(p0));
+    uExpanded.Store4(dstAddr + 16, uint4(asuint(offset), c, 0));
+}
@@ -0,0 +1,70 @@
+/*
+ * Copyright (c) 2023-2024 Dragons Lake, part of Room 8 Group.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you may not use this file except in compliance with the License. You may obtain a copy of the License at 
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software distributed under the License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the License for the specific language governing permissions and limitations under the License.
+ */
+
+#include "defines.hlsli"
+#pragma pack_matrix(column_major)
+
+static const uint SIZEOF_EXPANDED_POINT = 32;
+
+struct uVertPC
+{
+    REI_SPIRV([[vk::offset(0)]]) uint baseInstanceLocation;
+};
+
+REI_DECLARE_PUSH_CONSTANT(v_pushconstant, uVertPC, 0, 0);
+
+REI_SPIRV([[vk::binding(0, 0)]]) ByteAddressBuffer uExpanded REI_REGISTER(t0, space0);
+
+struct VS_INPUT
+{
+    uint vertexID: SV_VertexID;
+    uint instanceID: SV_InstanceID;
+};
+
+struct PS_INPUT
+{
+    float4 CSPos: SV_Position;
+
+    REI_SPIRV([[vk::location(0)]]) struct
+    {
+        float4 Color;
+
+    } Out: COLOR0;
+};
+
+float4 Color32toVec4(uint c)
+{
+    float4 r = float4(float(c & 0xFF), float((c >> 8) & 0xFF), float((c >> 16) & 0xFF), float((c >> 24) & 0xFF));
+
+    return r / 255.0f;
+}
+
+// Draws points written by basicdraw_point_expand_cs, one instance per point as a 4 vertex triangle strip
+PS_INPUT main(VS_INPUT input)
+{
+    PS_INPUT output;
+    uint pointIndex = input.instanceID;
+    #if !defined(__spirv__)
+    pointIndex += v_pushconstant.baseInstanceLocation;
+    #endif
+
+    uint   srcAddr = pointIndex * SIZEOF_EXPANDED_POINT;
+    float4 p0 = asfloat(uExpanded.Load4(srcAddr));
+    uint4  extra = uExpanded.Load4(srcAddr + 16);
+    float2 offset = asfloat(extra.xy);
+
+    p0.x += bool(input.vertexID & 1) ? -offset.x : offset.x;
+    p0.y += bool(input.vertexID & 2) ? -offset.y : offset.y;
+
+    output.CSPos = p0;
+    output.Out.Color = Color32toVec4(extra.z);
+
+    return output;
+}
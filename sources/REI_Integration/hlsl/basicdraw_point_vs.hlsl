@@ -18,6 +18,7 @@ struct PointStruct
 };
 static const uint SIZEOF_POINT_0 = 16;
 static const uint SIZEOF_POINT_1_2 = 12;
+static const uint SIZEOF_POINT_3 = 8;
 
 struct Uniforms
 {
@@ -65,6 +66,12 @@ float4 Color32toVec4(uint c)
     return r / 255.0f;
 }
 
+// Expands RGBA4444 to RGBA8888
+uint Color16toColor32(uint c)
+{
+    return ((c & 0xF) | ((c & 0xF0) << 4) | ((c & 0xF00) << 8) | ((c & 0xF000) << 12)) * 17;
+}
+
 struct PointData
 {
     float3 p;
@@ -92,6 +99,13 @@ PointData loadPoint(uint index)
         p = asfloat(uStream0.Load3(index * SIZEOF_POINT_1_2));
         c = uUniforms[v_pushconstant.idx].uColor;
     }
+    else if (v_pushconstant.type == 3)
+    {
+        // Quantized position, the box is folded into uMVP
+        uint2 q = uStream0.Load2(index * SIZEOF_POINT_3);
+        p = float3(q.x & 0xFFFF, q.x >> 16, q.y & 0xFFFF);
+        c = Color16toColor32(q.y >> 16);
+    }
     PointData pData;
     pData.p = p;
     pData.c = Color32toVec4(c);
@@ -0,0 +1,56 @@
+/*
+ * Copyright (c) 2023-2024 Dragons Lake, part of Room 8 Group.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you may not use this file except in compliance with the License. You may obtain a copy of the License at 
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software distributed under the License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the License for the specific language governing permissions and limitations under the License.
+ */
+
+#include "defines.hlsli"
+
+// One instance per glyph, expanded to the same two triangles fonsDrawText emits
+struct VS_INPUT
+{
+    REI_SPIRV([[vk::location(0)]]) int4 aRect : POSITION;
+    REI_SPIRV([[vk::location(1)]]) uint4 aUVRect : TEXCOORD;
+    REI_SPIRV([[vk::location(2)]]) float4 aColor : COLOR;
+    uint vertexID: SV_VertexID;
+};
+
+struct PS_INPUT
+{
+    float4 CSPos: SV_Position;
+
+    REI_SPIRV([[vk::location(0)]]) struct
+    {
+        float4 Color;
+        float2 UV;
+    } Out : INPUT_DATA;
+};
+
+struct uPushConstant
+{
+    float2 uScale;
+    float2 uTranslate;
+    float2 uInvTexSize;
+};
+
+REI_DECLARE_PUSH_CONSTANT(pushconstant, uPushConstant, 0, 0);
+
+// Corners of x0,y0 x1,y1 x1,y0 and x0,y0 x0,y1 x1,y1, bit 0 selects x1 and bit 1 selects y1
+static const uint CORNERS[6] = { 0, 3, 1, 0, 2, 3 };
+
+PS_INPUT main(VS_INPUT input)
+{
+    uint   corner = CORNERS[input.vertexID];
+    float2 pos = float2((corner & 1) ? input.aRect.z : input.aRect.x, (corner & 2) ? input.aRect.w : input.aRect.y);
+    float2 uv = float2((corner & 1) ? input.aUVRect.z : input.aUVRect.x, (corner & 2) ? input.aUVRect.w : input.aUVRect.y);
+
+    PS_INPUT output;
+    output.Out.Color = input.aColor;
+    output.Out.UV = uv * pushconstant.uInvTexSize;
+    output.CSPos = float4(pos * pushconstant.uScale + pushconstant.uTranslate, 0, 1);
+    return output;
+}
@@ -25,12 +25,15 @@ struct Paint
     float  strokeThr;
     int    texType;
     int    type;
+    float4 atlasRect;
+    float4 atlasClamp;
 };
 
 struct PS_INPUT
 {
     REI_SPIRV([[vk::location(0)]]) float2 Pos: POSITION0;
     REI_SPIRV([[vk::location(1)]]) float2 UV: TEXCOORD0;
+    REI_SPIRV([[vk::location(2)]]) nointerpolation uint Paint: TEXCOORD1;
     float4                     CSPos: SV_Position;
 };
 
@@ -45,13 +48,6 @@ REI_SPIRV([[vk::binding(1, 1)]]) StructuredBuffer<Paint> uPaints REI_REGISTER(t1
 
 REI_SPIRV([[vk::binding(0, 2)]]) Texture2D uTexture REI_REGISTER(t0, space2);
 
-struct uFragPC
-{
-    REI_SPIRV([[vk::offset(16)]]) uint idx;
-};
-
-REI_DECLARE_PUSH_CONSTANT(f_pushconstant, uFragPC, 0, 0);
-
 float sdroundrect(float2 pt, float2 ext, float rad)
 {
     float2 ext2 = ext - float2(rad, rad);
@@ -63,11 +59,17 @@ float2 mulMax23Vec2(float4 m[2], float2 v)
     return float2(m[0].x * v.x + m[0].y * v.y + m[0].z, m[1].x * v.x + m[1].y * v.y + m[1].z);
 }
 
+// Maps image coordinates into the image rect of an atlas, clamped to its outer texel centers
+float2 atlasUV(Paint paint, float2 uv)
+{
+    return clamp(paint.atlasRect.xy + uv * paint.atlasRect.zw, paint.atlasClamp.xy, paint.atlasClamp.zw);
+}
+
 // Scissoring
-float scissorMask(float2 p)
+float scissorMask(Paint paint, float2 p)
 {
-    float2 sc = (abs(mulMax23Vec2(uPaints[f_pushconstant.idx].scissorMat, p)) - uPaints[f_pushconstant.idx].scissorExt);
-    sc = float2(0.5, 0.5) - sc * uPaints[f_pushconstant.idx].scissorScale;
+    float2 sc = (abs(mulMax23Vec2(paint.scissorMat, p)) - paint.scissorExt);
+    sc = float2(0.5, 0.5) - sc * paint.scissorScale;
     return clamp(sc.x, 0.0, 1.0) * clamp(sc.y, 0.0, 1.0);
 }
 
@@ -75,48 +77,47 @@ PS_OUTPUT main(PS_INPUT input)
 {
     PS_OUTPUT output;
     float4    result = float4(1, 1, 1, 1);
-    float     scissor = scissorMask(input.Pos);
+    Paint     paint = uPaints[input.Paint];
+    float     scissor = scissorMask(paint, input.Pos);
     float     strokeAlpha = 1.0;
-    if (uPaints[f_pushconstant.idx].type == 0)
+    if (paint.type == 0)
     {    // Gradient
          // Calculate gradient color using box gradient
-        float2 pt = mulMax23Vec2(uPaints[f_pushconstant.idx].paintMat, input.Pos);
-        float  d = clamp(
-            (sdroundrect(pt, uPaints[f_pushconstant.idx].extent, uPaints[f_pushconstant.idx].radius) + uPaints[f_pushconstant.idx].feather * 0.5f) /
-                uPaints[f_pushconstant.idx].feather,
-            0.0, 1.0);
-        float4 color = lerp(uPaints[f_pushconstant.idx].innerCol, uPaints[f_pushconstant.idx].outerCol, d);
+        float2 pt = mulMax23Vec2(paint.paintMat, input.Pos);
+        float  d =
+            clamp((sdroundrect(pt, paint.extent, paint.radius) + paint.feather * 0.5f) / paint.feather, 0.0, 1.0);
+        float4 color = lerp(paint.innerCol, paint.outerCol, d);
         // Combine alpha
         color *= strokeAlpha * scissor;
         result = color;
     }
-    else if (uPaints[f_pushconstant.idx].type == 1)
+    else if (paint.type == 1)
     {    // Image
          // Calculate color fron texture
-        float2 pt = mulMax23Vec2(uPaints[f_pushconstant.idx].paintMat, input.Pos) / uPaints[f_pushconstant.idx].extent;
+        float2 pt = mulMax23Vec2(paint.paintMat, input.Pos) / paint.extent;
 
-        float4 color = uTexture.Sample(uSampler, pt);
-        if (uPaints[f_pushconstant.idx].texType == 1)
+        float4 color = uTexture.Sample(uSampler, atlasUV(paint, pt));
+        if (paint.texType == 1)
             color = float4(color.xyz * color.w, color.w);
-        if (uPaints[f_pushconstant.idx].texType == 2)
+        if (paint.texType == 2)
             color = (float4)color.x;
         // Apply color tint and alpha.
-        color *= uPaints[f_pushconstant.idx].innerCol;
+        color *= paint.innerCol;
         // Combine alpha
         color *= strokeAlpha * scissor;
         result = color;
     } /*else if (uPaints.a[fpc.idx].type == 2) {        // Stencil fill
         result = vec4(1,1,1,1);
     }*/
-    else if (uPaints[f_pushconstant.idx].type == 3)
+    else if (paint.type == 3)
     {    // Textured tris
-        float4 color = uTexture.Sample(uSampler, input.UV);
-        if (uPaints[f_pushconstant.idx].texType == 1)
+        float4 color = uTexture.Sample(uSampler, atlasUV(paint, input.UV));
+        if (paint.texType == 1)
             color = float4(color.xyz * color.w, color.w);
-        if (uPaints[f_pushconstant.idx].texType == 2)
+        if (paint.texType == 2)
             color = (float4)color.x;
         color *= scissor;
-        result = color * uPaints[f_pushconstant.idx].innerCol;
+        result = color * paint.innerCol;
     }
     output.outColor = result;
     return output;
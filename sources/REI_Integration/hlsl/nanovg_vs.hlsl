@@ -14,12 +14,14 @@ struct VS_INPUT
 {
     REI_SPIRV([[vk::location(0)]]) float2 aPos: POSITION;
     REI_SPIRV([[vk::location(1)]]) float2 aUV: TEXCOORD;
+    REI_SPIRV([[vk::location(2)]]) uint aPaint: TEXCOORD1;
 };
 
 struct PS_INPUT
 {
     REI_SPIRV([[vk::location(0)]]) float2 Pos: POSITION0;
     REI_SPIRV([[vk::location(1)]]) float2 UV: TEXCOORD0;
+    REI_SPIRV([[vk::location(2)]]) nointerpolation uint Paint: TEXCOORD1;
     float4                     CSPos: SV_Position;
 };
 
@@ -27,6 +29,10 @@ struct uPushConstant
 {
     float2 uScale;
     float2 uTranslate;
+    // nanovg transform of retained groups, paints are evaluated before it is applied
+    float4 uXform;
+    float2 uXformOffset;
+    uint   uPaintBase;
 };
 
 REI_DECLARE_PUSH_CONSTANT(v_pushconstant, uPushConstant, 0, 0);
@@ -36,7 +42,11 @@ PS_INPUT main(VS_INPUT input)
     PS_INPUT output;
     output.Pos = input.aPos;
     output.UV = input.aUV;
-    output.CSPos = float4(input.aPos * v_pushconstant.uScale + v_pushconstant.uTranslate, 0, 1);
+    output.Paint = input.aPaint + v_pushconstant.uPaintBase;
+
+    float2 pos = input.aPos.x * v_pushconstant.uXform.xy + input.aPos.y * v_pushconstant.uXform.zw +
+                 v_pushconstant.uXformOffset;
+    output.CSPos = float4(pos * v_pushconstant.uScale + v_pushconstant.uTranslate, 0, 1);
 
     return output;
 }
@@ -700,6 +700,8 @@ void REI_cmdCopyBuffer(
     REI_ASSERT(pSrcBuffer->pDxResource);
     REI_ASSERT(pBuffer);
     REI_ASSERT(pBuffer->pDxResource);
+    REI_POOL_VALIDATE(pCmd->pRenderer->mBufferPool, pBuffer);
+    REI_POOL_VALIDATE(pCmd->pRenderer->mBufferPool, pSrcBuffer);
 
     ((ID3D12GraphicsCommandList*)pCmd->pDxCmdList)
         ->CopyBufferRegion(pBuffer->pDxResource, dstOffset, pSrcBuffer->pDxResource, srcOffset, size);
@@ -708,6 +710,9 @@ void REI_cmdCopyBuffer(
 void REI_cmdCopyBufferToTexture(
     REI_Cmd* pCmd, REI_Texture* pTexture, REI_Buffer* pSrcBuffer, REI_SubresourceDesc* pSubresourceDesc)
 {
+    REI_POOL_VALIDATE(pCmd->pRenderer->mTexturePool, pTexture);
+    REI_POOL_VALIDATE(pCmd->pRenderer->mBufferPool, pSrcBuffer);
+
     uint32_t subresource = CALC_SUBRESOURCE_INDEX(
         pSubresourceDesc->mipLevel, pSubresourceDesc->arrayLayer, 0, pTexture->mMipLevels,
         pTexture->mArraySizeMinusOne + 1);
@@ -734,6 +739,9 @@ void REI_cmdCopyBufferToTexture(
 void REI_cmdCopyTextureToBuffer(
     REI_Cmd* pCmd, REI_Buffer* pDstBuffer, REI_Texture* pTexture, REI_SubresourceDesc* pSubresourceDesc)
 {
+    REI_POOL_VALIDATE(pCmd->pRenderer->mBufferPool, pDstBuffer);
+    REI_POOL_VALIDATE(pCmd->pRenderer->mTexturePool, pTexture);
+
     uint32_t subresource = CALC_SUBRESOURCE_INDEX(
         pSubresourceDesc->mipLevel, pSubresourceDesc->arrayLayer, 0, pTexture->mMipLevels,
         pTexture->mArraySizeMinusOne + 1);
@@ -21,6 +21,15 @@
 #    include "REI_Integration/BasicDraw.h"
 #endif
 
+// Point cloud benchmark: cycles point count and point path, logs average GPU time of each combination
+#ifndef SAMPLE_BASIC_DRAW_BENCHMARK
+#    define SAMPLE_BASIC_DRAW_BENCHMARK 0
+#endif
+
+#if SAMPLE_BASIC_DRAW_BENCHMARK
+#    include "REI_Sample/Log.h"
+#endif
+
 REI_CmdPool* cmdPool[FRAME_COUNT];
 REI_Cmd*     pCmds[FRAME_COUNT];
 REI_Texture* depthBuffer;
@@ -33,6 +42,166 @@ enum
     BUFFER_SIZE = 1 << 20,
 };
 
+#if SAMPLE_BASIC_DRAW_BENCHMARK
+enum BenchmarkPath
+{
+    BENCHMARK_PATH_VERTEX,
+    BENCHMARK_PATH_INSTANCED,
+    BENCHMARK_PATH_COMPUTE,
+    BENCHMARK_PATH_COUNT
+};
+
+enum
+{
+    BENCHMARK_WARMUP_FRAMES = 16,
+    BENCHMARK_FRAMES = 256,
+    BENCHMARK_POINT_BUFFER_SET = 0,
+};
+
+static const char*    benchmarkPathNames[BENCHMARK_PATH_COUNT] = { "vertex", "instanced", "compute" };
+static const uint32_t benchmarkPointCounts[] = { 1000000, 10000000 };
+static const uint32_t benchmarkMaxPointCount = 10000000;
+static const uint32_t benchmarkRunCount =
+    BENCHMARK_PATH_COUNT * (uint32_t)(sizeof(benchmarkPointCounts) / sizeof(benchmarkPointCounts[0]));
+
+static REI_RL_State*  resourceLoader;
+static REI_Buffer*    benchmarkPoints;
+static REI_Buffer*    readbackBuffer;
+static REI_QueryPool* timeQueryPool;
+static double         gpuTimestampScaler;
+static void*          timestampBufferMem;
+static uint32_t       benchmarkRun;
+static uint32_t       benchmarkFrame;
+static double         benchmarkGpuTime;
+
+static void initBenchmark()
+{
+    REI_RL_addResourceLoader(renderer, nullptr, &resourceLoader);
+
+    REI_QueryPoolDesc queryPoolDesc{ REI_QUERY_TYPE_TIMESTAMP, 2 * FRAME_COUNT };
+    REI_addQueryPool(renderer, &queryPoolDesc, &timeQueryPool);
+
+    REI_BufferDesc bufDesc = {};
+    bufDesc.memoryUsage = REI_RESOURCE_MEMORY_USAGE_GPU_TO_CPU;
+    bufDesc.flags = REI_BUFFER_CREATION_FLAG_OWN_MEMORY_BIT | REI_BUFFER_CREATION_FLAG_PERSISTENT_MAP_BIT;
+    bufDesc.size = queryPoolDesc.queryCount * sizeof(uint64_t);
+    bufDesc.startState = REI_RESOURCE_STATE_COPY_DEST;
+    REI_addBuffer(renderer, &bufDesc, &readbackBuffer);
+    REI_mapBuffer(renderer, readbackBuffer, &timestampBufferMem);
+
+    REI_QueueProperties gfxQueueProps;
+    REI_getQueueProperties(gfxQueue, &gfxQueueProps);
+    gpuTimestampScaler = 1.0 / gfxQueueProps.gpuTimestampFreq;
+
+    REI_BufferDesc pointBufDesc = {};
+    pointBufDesc.descriptors = REI_DESCRIPTOR_TYPE_BUFFER_RAW;
+    pointBufDesc.memoryUsage = REI_RESOURCE_MEMORY_USAGE_GPU_ONLY;
+    pointBufDesc.size = (uint64_t)benchmarkMaxPointCount * sizeof(REI_BasicDraw_V_P3C);
+    pointBufDesc.format = REI_FMT_R32_UINT;
+    pointBufDesc.elementCount = pointBufDesc.size / sizeof(uint32_t);
+    REI_addBuffer(renderer, &pointBufDesc, &benchmarkPoints);
+
+    // Random points in a 100x20x100 slab around the grid
+    REI_RL_BufferUpdateDesc updateDesc = {};
+    updateDesc.pBuffer = benchmarkPoints;
+    updateDesc.size = pointBufDesc.size;
+    REI_RL_UpdateMemory updateMemory;
+    REI_RL_beginUpdate(resourceLoader, &updateDesc, &updateMemory);
+
+    REI_BasicDraw_V_P3C* points = (REI_BasicDraw_V_P3C*)updateMemory.pData;
+    uint32_t             rnd = 0x12345678u;
+    for (uint32_t i = 0; i < benchmarkMaxPointCount; ++i)
+    {
+        uint32_t v[3];
+        for (uint32_t j = 0; j < 3; ++j)
+        {
+            rnd = rnd * 1664525u + 1013904223u;
+            v[j] = rnd >> 8;
+        }
+        points[i].p[0] = (v[0] / (float)(1 << 24) - 0.5f) * 100.0f;
+        points[i].p[1] = (v[1] / (float)(1 << 24) - 0.5f) * 20.0f;
+        points[i].p[2] = (v[2] / (float)(1 << 24) - 0.5f) * 100.0f;
+        points[i].c = 0xFF000000 | (v[0] >> 16) | ((v[1] >> 16) << 8) | ((v[2] >> 16) << 16);
+    }
+
+    REI_RL_RequestId token;
+    REI_RL_endUpdate(resourceLoader, &updateDesc, &updateMemory, &token);
+    REI_RL_waitTokenCompleted(resourceLoader, token);
+}
+
+static void finiBenchmark()
+{
+    REI_removeBuffer(renderer, benchmarkPoints);
+    REI_removeBuffer(renderer, readbackBuffer);
+    REI_removeQueryPool(renderer, timeQueryPool);
+    REI_RL_removeResourceLoader(resourceLoader);
+}
+
+// Records point rendering of the current run between two timestamps, render targets must be unbound
+static void renderBenchmark(REI_Cmd* cmd, const FrameData* frameData, REI_Texture* renderTarget, const float mvp[16])
+{
+    if (benchmarkRun >= benchmarkRunCount)
+        return;
+
+    BenchmarkPath path = (BenchmarkPath)(benchmarkRun % BENCHMARK_PATH_COUNT);
+    uint32_t      pointCount = benchmarkPointCounts[benchmarkRun / BENCHMARK_PATH_COUNT];
+    uint32_t      timestampIndex = frameData->setIndex * 2;
+
+    REI_cmdResetQueryPool(cmd, timeQueryPool, timestampIndex, 2);
+    REI_cmdEndQuery(cmd, timeQueryPool, timestampIndex);
+
+    uint32_t firstExpanded = REI_BASICDRAW_EXPAND_FAILED;
+    if (path == BENCHMARK_PATH_COMPUTE)
+    {
+        firstExpanded = REI_BasicDraw_ExpandPoints(
+            basicDraw, cmd, mvp, 2.0f, REI_BASICDRAW_POINT_FORMAT_P3C, 0, BENCHMARK_POINT_BUFFER_SET, pointCount, 0);
+        REI_BasicDraw_FinishExpandPoints(basicDraw, cmd);
+    }
+
+    REI_LoadActionsDesc loadActions{};
+    loadActions.loadActionsColor[0] = REI_LOAD_ACTION_LOAD;
+    loadActions.loadActionDepth = REI_LOAD_ACTION_LOAD;
+    REI_cmdBindRenderTargets(cmd, 1, &renderTarget, depthBuffer, &loadActions, NULL, NULL, 0, 0);
+    REI_cmdSetViewport(cmd, 0.0f, 0.0f, (float)frameData->bbWidth, (float)frameData->bbHeight, 0.0f, 1.0f);
+    REI_cmdSetScissor(cmd, 0, 0, frameData->bbWidth, frameData->bbHeight);
+
+    if (path == BENCHMARK_PATH_COMPUTE)
+        REI_BasicDraw_RenderExpandedPoints(basicDraw, cmd, firstExpanded, pointCount);
+    else
+        REI_BasicDraw_RenderPointBufferSet(
+            basicDraw, cmd, mvp, 2.0f, REI_BASICDRAW_POINT_FORMAT_P3C, 0, BENCHMARK_POINT_BUFFER_SET, pointCount, 0,
+            path == BENCHMARK_PATH_INSTANCED ? REI_BASICDRAW_POINT_PATH_INSTANCED : REI_BASICDRAW_POINT_PATH_VERTEX);
+    REI_BasicDraw_Flush(basicDraw, cmd);
+
+    REI_cmdEndQuery(cmd, timeQueryPool, timestampIndex + 1);
+    REI_cmdBindRenderTargets(cmd, 0, NULL, NULL, NULL, NULL, NULL, 0, 0);
+    REI_cmdResolveQuery(cmd, readbackBuffer, timestampIndex * sizeof(uint64_t), timeQueryPool, timestampIndex, 2);
+}
+
+// Timestamps of a set are read back when the set is reused, FRAME_COUNT frames after recording
+static void updateBenchmark(const FrameData* frameData)
+{
+    if (benchmarkRun >= benchmarkRunCount)
+        return;
+
+    uint64_t* timestampData = (uint64_t*)timestampBufferMem + frameData->setIndex * 2;
+    if (benchmarkFrame >= BENCHMARK_WARMUP_FRAMES + FRAME_COUNT)
+        benchmarkGpuTime += (double)(timestampData[1] - timestampData[0]) * gpuTimestampScaler;
+
+    if (++benchmarkFrame < BENCHMARK_WARMUP_FRAMES + FRAME_COUNT + BENCHMARK_FRAMES)
+        return;
+
+    sample_log(
+        REI_LOG_TYPE_INFO, "BasicDraw benchmark: %u points, %s path: %.3f ms\n",
+        benchmarkPointCounts[benchmarkRun / BENCHMARK_PATH_COUNT],
+        benchmarkPathNames[benchmarkRun % BENCHMARK_PATH_COUNT], benchmarkGpuTime * 1000.0 / BENCHMARK_FRAMES);
+
+    ++benchmarkRun;
+    benchmarkFrame = 0;
+    benchmarkGpuTime = 0.0;
+}
+#endif
+
 int sample_on_init()
 {
     for (size_t i = 0; i < FRAME_COUNT; ++i)
@@ -41,11 +210,19 @@ int sample_on_init()
         REI_addCmd(renderer, cmdPool[i], false, &pCmds[i]);
     }
 
+#if SAMPLE_BASIC_DRAW_BENCHMARK
+    initBenchmark();
+#endif
+
     return 1;
 }
 
 void sample_on_fini()
 {
+#if SAMPLE_BASIC_DRAW_BENCHMARK
+    finiBenchmark();
+#endif
+
     for (size_t i = 0; i < FRAME_COUNT; ++i)
     {
         REI_removeCmd(renderer, cmdPool[i], pCmds[i]);
@@ -76,8 +253,19 @@ void sample_on_swapchain_init(const REI_SwapchainDesc* swapchainDesc)
                                   128,
                                   BUFFER_SIZE };
 
+    srInfo.maxDeferredDraws = 512;
+    srInfo.maxDataChunks = 4;
+
+#if SAMPLE_BASIC_DRAW_BENCHMARK
+    srInfo.maxExpandedPoints = benchmarkMaxPointCount;
+#endif
+
     basicDraw = REI_BasicDraw_Init(renderer, &srInfo);
 
+#if SAMPLE_BASIC_DRAW_BENCHMARK
+    REI_RegisterPointBufferSet(basicDraw, BENCHMARK_POINT_BUFFER_SET, benchmarkPoints, NULL, NULL);
+#endif
+
     SimpleCameraProjDesc projDesc = {};
     projDesc.proj_type = SimpleCameraProjInfiniteVulkan;
     projDesc.y_fov = RM_PI_2;
@@ -216,10 +404,21 @@ void sample_on_frame(const FrameData* frameData)
     positions[2] = { 2.0f / 3.0f + 0.25f, -2.0f / 3.0f, 0.0f };
     positions[3] = { 2.0f / 3.0f, -1.0f + (d + d2) * sy, 0.0f };
 
+    REI_BasicDraw_Flush(basicDraw, cmd);
+
+#if SAMPLE_BASIC_DRAW_BENCHMARK
+    REI_cmdBindRenderTargets(cmd, 0, NULL, NULL, NULL, NULL, NULL, 0, 0);
+    renderBenchmark(cmd, frameData, renderTarget, cam_mvp.a);
+#endif
+
     sample_cmdPrepareBackbuffer(cmd, renderTarget, REI_RESOURCE_STATE_RENDER_TARGET);
     barriers[1] = { depthBuffer, REI_RESOURCE_STATE_DEPTH_WRITE, REI_RESOURCE_STATE_COMMON };
     REI_cmdResourceBarrier(cmd, 0, nullptr, 1, &barriers[1]);
     REI_endCmd(cmd);
 
     sample_submit(cmd);
+
+#if SAMPLE_BASIC_DRAW_BENCHMARK
+    updateBenchmark(frameData);
+#endif
 }
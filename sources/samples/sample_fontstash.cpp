@@ -20,6 +20,19 @@
 #    include <math.h>
 #endif
 #include <math.h>
+
+// Glyph atlas benchmark: rasterizes printable ASCII at 10 sizes as coverage and as distance field glyphs, logs the
+// atlas size and rasterization time each mode needs. Then lays out a page of 2000 CJK glyphs for several frames with
+// and without glyph threads, logs the render thread time of the first and the worst later frame
+#ifndef SAMPLE_FONTSTASH_BENCHMARK
+#    define SAMPLE_FONTSTASH_BENCHMARK 0
+#endif
+
+#if SAMPLE_FONTSTASH_BENCHMARK
+#    include "REI/Thread.h"
+#    include "REI_Sample/Log.h"
+#endif
+
 enum
 {
     BUFFER_SIZE = 1 << 20,
@@ -44,6 +57,159 @@ static float mvp[16] = {
     1.0f, 0.0f, 0.0f, 0.0f, 0.0f, 1.0f, 0.0f, 0.0f, 0.0f, 0.0f, 1.0f, 0.0f, 0.0f, 0.0f, 0.0f, 1.0f
 };
 
+#if SAMPLE_FONTSTASH_BENCHMARK
+enum
+{
+    BENCHMARK_ATLAS_SIZE = 128,
+    BENCHMARK_SDF_SIZE = 32,
+    BENCHMARK_CJK_GLYPHS = 2000,
+    BENCHMARK_CJK_LINE = 50,
+    BENCHMARK_CJK_FRAMES = 8,
+};
+
+static const float benchmarkSizes[] = { 10.0f, 12.0f, 14.0f, 16.0f, 20.0f, 24.0f, 32.0f, 48.0f, 64.0f, 96.0f };
+
+// The atlas starts small and doubles whenever it is full, its final size is the memory a mode needs
+static void benchmarkAtlasFull(void* uptr, int error, int val)
+{
+    FONScontext* ctx = (FONScontext*)uptr;
+    if (error != FONS_ATLAS_FULL)
+        return;
+
+    int width, height;
+    fonsGetAtlasSize(ctx, &width, &height);
+    if (width <= height)
+        width *= 2;
+    else
+        height *= 2;
+    fonsExpandAtlas(ctx, width, height);
+}
+
+static void runBenchmark(const REI_SwapchainDesc* swapchainDesc, REI_Format depthFormat, const char* fontPath)
+{
+    char glyphs[127 - 32 + 1];
+    for (int c = 32; c < 127; ++c)
+        glyphs[c - 32] = (char)c;
+    glyphs[127 - 32] = 0;
+
+    for (uint32_t sdf = 0; sdf < 2; ++sdf)
+    {
+        REI_Fontstash_Desc fsInfo = { BUFFER_SIZE,
+                                      0,
+                                      swapchainDesc->colorFormat,
+                                      depthFormat,
+                                      swapchainDesc->sampleCount,
+                                      FRAME_COUNT,
+                                      swapchainDesc->width,
+                                      swapchainDesc->height,
+                                      BENCHMARK_ATLAS_SIZE,
+                                      BENCHMARK_ATLAS_SIZE,
+                                      sdf ? BENCHMARK_SDF_SIZE : 0u };
+
+        FONScontext* ctx = REI_Fontstash_Init(renderer, gfxQueue, resourceLoader, &fsInfo);
+        fonsSetErrorCallback(ctx, benchmarkAtlasFull, ctx);
+        fonsSetFont(ctx, fonsAddFont(ctx, "sans", fontPath));
+        REI_Fontstash_SetupRender(ctx, 0);
+
+        uint64_t time = 0;
+        for (uint32_t i = 0; i < sizeof(benchmarkSizes) / sizeof(benchmarkSizes[0]); ++i)
+        {
+            fonsSetSize(ctx, benchmarkSizes[i]);
+
+            // The iterator rasterizes every glyph it has not seen at this size
+            uint64_t     start = sample_time_ns();
+            FONStextIter iter;
+            FONSquad     quad;
+            fonsTextIterInit(ctx, &iter, 0.0f, 0.0f, glyphs, NULL);
+            while (fonsTextIterNext(ctx, &iter, &quad))
+            {
+            }
+            time += sample_time_ns() - start;
+
+            int width, height;
+            fonsGetAtlasSize(ctx, &width, &height);
+            sample_log(
+                REI_LOG_TYPE_INFO, "Fontstash benchmark: %s, %u sizes up to %.0f px: %dx%d atlas (%d KB), %.3f ms\n",
+                sdf ? "distance field" : "coverage", i + 1, benchmarkSizes[i], width, height, width * height / 1024,
+                time * 1e-6);
+        }
+
+        REI_Fontstash_FlushUploads(ctx);
+        REI_Fontstash_Shutdown(ctx);
+    }
+}
+
+// New glyphs are drawn as placeholders while the workers rasterize them, later frames pick them up in FlushUploads
+static void runGlyphThreadBenchmark(const REI_SwapchainDesc* swapchainDesc, REI_Format depthFormat, const char* fontPath)
+{
+    // Consecutive ideographs from U+4E00, 3 UTF-8 bytes each
+    static char page[BENCHMARK_CJK_GLYPHS / BENCHMARK_CJK_LINE][BENCHMARK_CJK_LINE * 3 + 1];
+    for (uint32_t l = 0; l < BENCHMARK_CJK_GLYPHS / BENCHMARK_CJK_LINE; ++l)
+    {
+        for (uint32_t i = 0; i < BENCHMARK_CJK_LINE; ++i)
+        {
+            uint32_t cp = 0x4E00 + l * BENCHMARK_CJK_LINE + i;
+            page[l][i * 3] = (char)(0xE0 | (cp >> 12));
+            page[l][i * 3 + 1] = (char)(0x80 | ((cp >> 6) & 0x3F));
+            page[l][i * 3 + 2] = (char)(0x80 | (cp & 0x3F));
+        }
+        page[l][BENCHMARK_CJK_LINE * 3] = 0;
+    }
+
+    const uint32_t threadCount = REI_max(Thread::GetNumCPUCores(), 2u) - 1;
+    for (uint32_t sdf = 0; sdf < 2; ++sdf)
+    {
+        for (uint32_t threaded = 0; threaded < 2; ++threaded)
+        {
+            REI_Fontstash_Desc fsInfo = { BUFFER_SIZE,
+                                          0,
+                                          swapchainDesc->colorFormat,
+                                          depthFormat,
+                                          swapchainDesc->sampleCount,
+                                          FRAME_COUNT,
+                                          swapchainDesc->width,
+                                          swapchainDesc->height,
+                                          2048,
+                                          2048,
+                                          sdf ? BENCHMARK_SDF_SIZE : 0u,
+                                          NULL,
+                                          threaded ? threadCount : 0u };
+
+            FONScontext* ctx = REI_Fontstash_Init(renderer, gfxQueue, resourceLoader, &fsInfo);
+            fonsSetErrorCallback(ctx, benchmarkAtlasFull, ctx);
+            fonsSetFont(ctx, fonsAddFont(ctx, "sans-jp", fontPath));
+            const float size = sdf ? 20.0f : 24.0f;
+            fonsSetSize(ctx, size);
+
+            uint64_t firstFrame = 0;
+            uint64_t worstFrame = 0;
+            for (uint32_t frame = 0; frame < BENCHMARK_CJK_FRAMES; ++frame)
+            {
+                REI_Fontstash_SetupRender(ctx, frame % FRAME_COUNT);
+                uint64_t start = sample_time_ns();
+                for (uint32_t l = 0; l < BENCHMARK_CJK_GLYPHS / BENCHMARK_CJK_LINE; ++l)
+                    fonsDrawText(ctx, 0.0f, size * (l + 1), page[l], NULL);
+                REI_Fontstash_FlushUploads(ctx);
+                uint64_t time = sample_time_ns() - start;
+
+                if (frame == 0)
+                    firstFrame = time;
+                else
+                    worstFrame = REI_max(worstFrame, time);
+            }
+            sample_log(
+                REI_LOG_TYPE_INFO,
+                "Fontstash benchmark: %u CJK glyphs, %s at %.0f px, %u glyph threads: first frame %.3f ms, worst later "
+                "frame %.3f ms\n",
+                (uint32_t)BENCHMARK_CJK_GLYPHS, sdf ? "distance field" : "coverage", size, fsInfo.glyphThreadCount,
+                firstFrame * 1e-6, worstFrame * 1e-6);
+
+            REI_Fontstash_Shutdown(ctx);
+        }
+    }
+}
+#endif
+
 int sample_on_init()
 {
     REI_RL_addResourceLoader(renderer, nullptr, &resourceLoader);
@@ -96,6 +262,7 @@ void sample_on_swapchain_init(const REI_SwapchainDesc* swapchainDesc)
     basicDraw = REI_BasicDraw_Init(renderer, &srInfo);
 
     REI_Fontstash_Desc fsInfo = { BUFFER_SIZE,
+                                  0,
                                   swapchainDesc->colorFormat,
                                   depthRTDesc.format,
                                   swapchainDesc->sampleCount,
@@ -123,6 +290,15 @@ void sample_on_swapchain_init(const REI_SwapchainDesc* swapchainDesc)
     REI_ASSERT(fontBold != FONS_INVALID);
     REI_ASSERT(fontJapanese != FONS_INVALID);
 
+#if SAMPLE_FONTSTASH_BENCHMARK
+    runBenchmark(
+        swapchainDesc, depthRTDesc.format,
+        sample_get_path(DIRECTORY_DATA, "fonts/DroidSerif-Regular.ttf", path, sizeof(path)));
+    runGlyphThreadBenchmark(
+        swapchainDesc, depthRTDesc.format,
+        sample_get_path(DIRECTORY_DATA, "fonts/DroidSansJapanese.ttf", path, sizeof(path)));
+#endif
+
     mvp[0] = 2.0f / swapchainDesc->width;
     mvp[12] = -1.0f;
     mvp[5] = -2.0f / swapchainDesc->height;
@@ -149,7 +149,9 @@ void sample_on_swapchain_init(const REI_SwapchainDesc* swapchainDesc)
                                FRAME_COUNT,
                                1024 * 256,
                                4096,
-                               256 };
+                               256,
+                               2048,
+                               0 };
 
     vg = REI_NanoVG_Init(renderer, gfxQueue, resourceLoader, &fsInfo);
     loadDemoData(vg, &data);
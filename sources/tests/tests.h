@@ -11,9 +11,14 @@
 #pragma once
 
 #include <array>
+#include <chrono>
+#include <math.h>
+#include <vector>
 
 #include "REI/Common.h"
 #include "REI/Renderer.h"
+#include "REI_Integration/BasicDraw.h"
+#include "REI_Integration/REI_fontstash.h"
 #include "REI_Integration/ResourceLoader.h"
 #include "REI_Sample/Log.h"
 
@@ -27,6 +32,11 @@
         REI_ASSERT(b);           \
     }
 
+// Throughput benchmarks, they take seconds so are left out of the regular test run
+#ifndef TESTS_BENCHMARK
+#    define TESTS_BENCHMARK 0
+#endif
+
 #include "shaderbin/test_sample_texture_vs.bin.h"
 #include "shaderbin/test_sample_texture_ps.bin.h"
 
@@ -745,6 +755,278 @@ bool test_render_depth_query(
     return testSuccess;
 }
 
+// Reference block index of swizzled PVRTC data, x goes to the even bits, high bits of the longer side follow
+static uint32_t test_zcurveIndex(uint32_t x, uint32_t y, uint32_t width, uint32_t height)
+{
+    uint32_t index = 0;
+    uint32_t bit = 0;
+    for (; (1u << bit) < width && (1u << bit) < height; ++bit)
+    {
+        index |= ((x >> bit) & 1) << (2 * bit);
+        index |= ((y >> bit) & 1) << (2 * bit + 1);
+    }
+    return index | (((width > height ? x : y) >> bit) << (2 * bit));
+}
+
+// Tests: de-swizzling of Z-curve ordered blocks into upload rows
+bool test_zcurveCopy(
+    REI_Renderer* renderer, REI_RL_State* loader, REI_Queue* queue, REI_Cmd* cmd, REI_CmdPool* cmdPool,
+    REI_Fence* fence)
+{
+    bool testSuccess = true;
+
+    const uint32_t sizes[][2] = { { 1, 1 }, { 2, 2 }, { 16, 16 }, { 64, 8 }, { 4, 32 }, { 128, 128 } };
+    const uint32_t blockSizes[] = { 8, 16 };
+    for (const uint32_t* size: sizes)
+    {
+        for (uint32_t blockSize: blockSizes)
+        {
+            const uint32_t width = size[0], height = size[1], depth = 2;
+            std::vector<uint8_t> src((size_t)width * height * depth * blockSize);
+            for (size_t i = 0; i < src.size(); ++i)
+            {
+                src[i] = (uint8_t)(i * 97 + (i >> 8));
+            }
+
+            // whole image and a region with odd origin and extent
+            REI_Region3D regions[2] = { { 0, 0, 0, width, height, depth },
+                                        { width / 3 | (width > 1), height / 3 | (height > 1), 1, width / 2 | 1,
+                                          height / 2 | 1, 1 } };
+            for (REI_Region3D& region: regions)
+            {
+                region.w = REI_min(region.w, width - region.x);
+                region.h = REI_min(region.h, height - region.y);
+
+                const uint32_t rowPitch = REI_align_up(region.w * blockSize, 256u);
+                const uint32_t slicePitch = rowPitch * region.h;
+                std::vector<uint8_t> dst((size_t)slicePitch * region.d, 0);
+                REI_RL_copyZCurveBlocks(
+                    dst.data(), src.data(), blockSize, width, height, &region, rowPitch, slicePitch);
+
+                for (uint32_t z = 0; z < region.d; ++z)
+                    for (uint32_t y = 0; y < region.h; ++y)
+                        for (uint32_t x = 0; x < region.w; ++x)
+                        {
+                            uint32_t index = test_zcurveIndex(region.x + x, region.y + y, width, height);
+                            const uint8_t* pExpected =
+                                src.data() + ((size_t)(region.z + z) * width * height + index) * blockSize;
+                            const uint8_t* pActual =
+                                dst.data() + (size_t)z * slicePitch + (size_t)y * rowPitch + (size_t)x * blockSize;
+                            TEST(memcmp(pExpected, pActual, blockSize) == 0);
+                        }
+            }
+        }
+    }
+
+    return testSuccess;
+}
+
+#if TESTS_BENCHMARK
+// Benchmark: swizzled upload copy throughput compared to the linear one
+bool test_zcurveCopyBenchmark(
+    REI_Renderer* renderer, REI_RL_State* loader, REI_Queue* queue, REI_Cmd* cmd, REI_CmdPool* cmdPool,
+    REI_Fence* fence)
+{
+    bool testSuccess = true;
+
+    // 4096x4096 PVRTC 4bpp: 1024x1024 blocks of 8 bytes
+    const uint32_t blockSize = 8, width = 1024, height = 1024, iterations = 16;
+    const uint32_t rowPitch = width * blockSize;
+    std::vector<uint8_t> src((size_t)width * height * blockSize);
+    for (size_t i = 0; i < src.size(); ++i)
+    {
+        src[i] = (uint8_t)(i * 97 + (i >> 8));
+    }
+    std::vector<uint8_t> dst(src.size());
+    const REI_Region3D region = { 0, 0, 0, width, height, 1 };
+
+    double seconds[2];
+    for (uint32_t zcurve = 0; zcurve < 2; ++zcurve)
+    {
+        auto start = std::chrono::high_resolution_clock::now();
+        for (uint32_t i = 0; i < iterations; ++i)
+        {
+            if (zcurve)
+                REI_RL_copyZCurveBlocks(dst.data(), src.data(), blockSize, width, height, &region, rowPitch, 0);
+            else
+                REI_RL_copyLinearBlocks(dst.data(), src.data(), blockSize, width, height, &region, rowPitch, 0);
+        }
+        seconds[zcurve] = std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - start).count();
+    }
+
+    const double megabytes = (double)src.size() * iterations / (1024.0 * 1024.0);
+    sample_log(
+        REI_LOG_TYPE_INFO, "zcurve copy %.0f MB/s, linear copy %.0f MB/s", megabytes / seconds[1],
+        megabytes / seconds[0]);
+
+    // the zcurve copy ran last, so dst holds de-swizzled blocks
+    for (uint32_t y = 0; y < height; ++y)
+        for (uint32_t x = 0; x < width; ++x)
+        {
+            const uint8_t* pExpected = src.data() + (size_t)test_zcurveIndex(x, y, width, height) * blockSize;
+            const uint8_t* pActual = dst.data() + (size_t)y * rowPitch + (size_t)x * blockSize;
+            TEST(memcmp(pExpected, pActual, blockSize) == 0);
+        }
+
+    return testSuccess;
+}
+#endif
+
+bool test_basicDrawPack(
+    REI_Renderer* renderer, REI_RL_State* loader, REI_Queue* queue, REI_Cmd* cmd, REI_CmdPool* cmdPool,
+    REI_Fence* fence)
+{
+    bool testSuccess = true;
+
+    // odd count exercises the scalar tail
+    const uint32_t                   count = 1001;
+    std::vector<REI_BasicDraw_V_P3C> points(count);
+    std::vector<REI_BasicDraw_Line>  lines(count);
+    for (uint32_t i = 0; i < count; ++i)
+    {
+        points[i] = { { (float)(i % 17) * 3.5f - 20.0f, (float)(i % 101) * 0.25f, (float)i * -0.125f },
+                      i * 0x9E3779B9u };
+        lines[i] = { { points[i].p[0], points[i].p[1], points[i].p[2] },
+                     (float)(i % 64) * 0.75f,
+                     { points[count - 1 - i].p[0], points[count - 1 - i].p[1], points[count - 1 - i].p[2] },
+                     points[i].c };
+    }
+
+    REI_BasicDraw_QuantBox box;
+    REI_BasicDraw_ComputeQuantBox(points[0].p, count, sizeof(REI_BasicDraw_V_P3C), &box);
+    TEST(box.origin[0] == -20.0f && box.origin[1] == 0.0f && box.origin[2] == -0.125f * (count - 1));
+
+    std::vector<REI_BasicDraw_V_Q3C> packedPoints(count);
+    std::vector<REI_BasicDraw_QLine> packedLines(count);
+    REI_BasicDraw_PackPoints(&box, count, points.data(), packedPoints.data());
+    REI_BasicDraw_PackLines(&box, count, lines.data(), packedLines.data());
+
+    auto positionMatches = [&](const float* p, const uint16_t* q) {
+        for (uint32_t j = 0; j < 3; ++j)
+        {
+            if (fabsf(box.origin[j] + q[j] * box.scale[j] - p[j]) > box.scale[j] * 0.5f + 1e-4f)
+                return false;
+        }
+        return true;
+    };
+    auto colorMatches = [](uint32_t c, uint16_t q) {
+        for (uint32_t j = 0; j < 4; ++j)
+        {
+            if (((c >> (8 * j + 4)) & 0xF) != ((q >> (4 * j)) & 0xF))
+                return false;
+        }
+        return true;
+    };
+    for (uint32_t i = 0; i < count; ++i)
+    {
+        TEST(positionMatches(points[i].p, packedPoints[i].p));
+        TEST(colorMatches(points[i].c, packedPoints[i].c));
+        TEST(positionMatches(lines[i].p0, packedLines[i].p0));
+        TEST(positionMatches(lines[i].p1, packedLines[i].p1));
+        TEST(packedLines[i].w == (uint16_t)(lines[i].w * 256.0f));
+        TEST(colorMatches(lines[i].c, packedLines[i].c));
+    }
+
+    // decoding folded into the matrix gives the original clip space position
+    const float mvp[16] = { 2, 0, 0, 0, 0, 3, 0, 0, 0, 0, -1, -1, 5, 6, 7, 1 };
+    float       quantizedMVP[16];
+    REI_BasicDraw_QuantizeMVP(mvp, &box, quantizedMVP);
+    const REI_BasicDraw_V_Q3C& q = packedPoints[count / 2];
+    const float                decoded[3] = { box.origin[0] + q.p[0] * box.scale[0],
+                                              box.origin[1] + q.p[1] * box.scale[1],
+                                              box.origin[2] + q.p[2] * box.scale[2] };
+    for (uint32_t r = 0; r < 4; ++r)
+    {
+        float expected = mvp[r] * decoded[0] + mvp[4 + r] * decoded[1] + mvp[8 + r] * decoded[2] + mvp[12 + r];
+        float actual = quantizedMVP[r] * q.p[0] + quantizedMVP[4 + r] * q.p[1] + quantizedMVP[8 + r] * q.p[2] +
+                       quantizedMVP[12 + r];
+        TEST(fabsf(expected - actual) < 1e-3f);
+    }
+
+    const uint32_t iterations = 256;
+    auto           start = std::chrono::high_resolution_clock::now();
+    for (uint32_t i = 0; i < iterations; ++i)
+        REI_BasicDraw_PackPoints(&box, count, points.data(), packedPoints.data());
+    double seconds = std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - start).count();
+    sample_log(
+        REI_LOG_TYPE_INFO, "point packing %.0f MB/s of source data",
+        (double)count * sizeof(REI_BasicDraw_V_P3C) * iterations / (1024.0 * 1024.0) / seconds);
+
+    return testSuccess;
+}
+
+bool test_fontstashInterleave(
+    REI_Renderer* renderer, REI_RL_State* loader, REI_Queue* queue, REI_Cmd* cmd, REI_CmdPool* cmdPool,
+    REI_Fence* fence)
+{
+    bool testSuccess = true;
+
+    // every count up to two SIMD blocks and a tail, with a guard vertex behind the output
+    for (uint32_t count = 0; count <= 9; ++count)
+    {
+        std::vector<float>    verts(count * 2);
+        std::vector<float>    tcoords(count * 2);
+        std::vector<uint32_t> colors(count);
+        for (uint32_t i = 0; i < count; ++i)
+        {
+            verts[i * 2] = (float)i * 10.0f + 1.0f;
+            verts[i * 2 + 1] = (float)i * 10.0f + 2.0f;
+            tcoords[i * 2] = (float)i * 0.125f + 0.25f;
+            tcoords[i * 2 + 1] = (float)i * 0.125f + 0.5f;
+            colors[i] = 0xA0B0C0D0u + i;
+        }
+
+        std::vector<uint32_t> dst((count + 1) * 5, 0xDEADBEEFu);
+        REI_Fontstash_InterleaveVertices(dst.data(), verts.data(), tcoords.data(), colors.data(), count);
+        for (uint32_t i = 0; i < count; ++i)
+        {
+            float expected[4] = { verts[i * 2], verts[i * 2 + 1], tcoords[i * 2], tcoords[i * 2 + 1] };
+            TEST(memcmp(&dst[i * 5], expected, sizeof(expected)) == 0);
+            TEST(dst[i * 5 + 4] == colors[i]);
+        }
+        for (uint32_t j = 0; j < 5; ++j)
+            TEST(dst[count * 5 + j] == 0xDEADBEEFu);
+    }
+
+    return testSuccess;
+}
+
+bool test_poolHandles(
+    REI_Renderer* renderer, REI_RL_State* loader, REI_Queue* queue, REI_Cmd* cmd, REI_CmdPool* cmdPool,
+    REI_Fence* fence)
+{
+    bool testSuccess = true;
+
+    REI_Fence* pFence;
+    REI_addFence(renderer, &pFence);
+    REI_PoolHandle handle = REI_getFenceHandle(renderer, pFence);
+    TEST(REI_resolveFence(renderer, handle) == pFence);
+    REI_removeFence(renderer, pFence);
+    TEST(!REI_resolveFence(renderer, handle));
+
+    // cycle through the free blocks until the memory of the removed fence is reused
+    REI_Fence* pReused = nullptr;
+    for (uint32_t i = 0; i < 4096 && !pReused; ++i)
+    {
+        REI_Fence* pNew;
+        REI_addFence(renderer, &pNew);
+        if (pNew == pFence)
+            pReused = pNew;
+        else
+            REI_removeFence(renderer, pNew);
+    }
+    TEST(pReused);
+    if (pReused)
+    {
+        // the stale pointer is valid again, only the handle tells the two fences apart
+        TEST(!REI_resolveFence(renderer, handle));
+        TEST(REI_resolveFence(renderer, REI_getFenceHandle(renderer, pReused)) == pReused);
+        REI_removeFence(renderer, pReused);
+    }
+
+    return testSuccess;
+}
+
 #define RUN_TEST(name)                                                               \
     {                                                                                \
         testTotal += 1;                                                              \
@@ -773,6 +1055,13 @@ void perform_tests(REI_Renderer* renderer, REI_Queue* queue, REI_Cmd* cmd, REI_C
     RUN_TEST(test_copyBuffer);
     RUN_TEST(test_render_srv_swizzling);
     RUN_TEST(test_render_depth_query);
+    RUN_TEST(test_zcurveCopy);
+#if TESTS_BENCHMARK
+    RUN_TEST(test_zcurveCopyBenchmark);
+#endif
+    RUN_TEST(test_basicDrawPack);
+    RUN_TEST(test_fontstashInterleave);
+    RUN_TEST(test_poolHandles);
 
     sample_log(REI_LOG_TYPE_INFO, "TESTS FINISHED, %i/%i", testPassed, testTotal);
 
@@ -0,0 +1,326 @@
+/*
+ * Copyright (c) 2023-2024 Dragons Lake, part of Room 8 Group.
+ * Copyright (c) 2019-2022 Mykhailo Parfeniuk, Vladyslav Serhiienko.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you may not use this file except in compliance with the License. You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software distributed under the License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the License for the specific language governing permissions and limitations under the License.
+ *
+ * This file contains modified code from the REI project source code
+ * (see https://github.com/Vi3LM/REI).
+ */
+
+#define _CRT_SECURE_NO_WARNINGS
+
+// Pre-rasterizes a glyph set at a list of sizes into an atlas file for REI_Fontstash_Desc::pBakedAtlasPath
+//
+// fontstash_bake <output> [options]
+//   -atlas <width> <height>        initial atlas size, doubled while glyphs don't fit (default 512 512)
+//   -sdf <size>                    bake distance field glyphs, must match REI_Fontstash_Desc::sdfSize
+//   -font <name> <path>            font to bake, the name is the one fonsGetFontByName finds at runtime
+//   -fallback <name> <fallback>    glyphs missing from font name are taken from font fallback
+//   -sizes <size>[,<size>...]      pixel sizes to bake (default 16), ignored for distance field glyphs
+//   -range <first>-<last>          codepoint range, decimal or 0x hex (default 0x20-0x7e)
+//   -text <path>                   every codepoint of a UTF-8 text file
+
+#include "REI_Integration/REI_fontstash.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+enum
+{
+    MAX_BAKE_FONTS = 32,
+    MAX_BAKE_SIZES = 64,
+    MAX_BAKE_RANGES = 256,
+};
+
+struct BakeOptions
+{
+    const char* output;
+    int         width;
+    int         height;
+    int         sdfSize;
+    int         fontCount;
+    int         fonts[MAX_BAKE_FONTS];
+    int         sizeCount;
+    float       sizes[MAX_BAKE_SIZES];
+    int         rangeCount;
+    uint32_t    ranges[MAX_BAKE_RANGES][2];
+};
+
+// Grows the atlas like the runtime one, glyphs keep the place they were packed at
+static void handleError(void* userPtr, int error, int)
+{
+    if (error != FONS_ATLAS_FULL)
+        return;
+
+    FONScontext* ctx = (FONScontext*)userPtr;
+    int          width, height;
+    fonsGetAtlasSize(ctx, &width, &height);
+    if (width <= height)
+        width *= 2;
+    else
+        height *= 2;
+    fonsExpandAtlas(ctx, width, height);
+}
+
+static size_t encodeUtf8(uint32_t codepoint, char* out)
+{
+    if (codepoint < 0x80)
+    {
+        out[0] = (char)codepoint;
+        return 1;
+    }
+    if (codepoint < 0x800)
+    {
+        out[0] = (char)(0xC0 | (codepoint >> 6));
+        out[1] = (char)(0x80 | (codepoint & 0x3F));
+        return 2;
+    }
+    if (codepoint < 0x10000)
+    {
+        out[0] = (char)(0xE0 | (codepoint >> 12));
+        out[1] = (char)(0x80 | ((codepoint >> 6) & 0x3F));
+        out[2] = (char)(0x80 | (codepoint & 0x3F));
+        return 3;
+    }
+    out[0] = (char)(0xF0 | (codepoint >> 18));
+    out[1] = (char)(0x80 | ((codepoint >> 12) & 0x3F));
+    out[2] = (char)(0x80 | ((codepoint >> 6) & 0x3F));
+    out[3] = (char)(0x80 | (codepoint & 0x3F));
+    return 4;
+}
+
+static char* readText(const char* path)
+{
+    FILE* file = fopen(path, "rb");
+    if (!file)
+        return NULL;
+
+    fseek(file, 0, SEEK_END);
+    long size = ftell(file);
+    fseek(file, 0, SEEK_SET);
+
+    char* text = size >= 0 ? (char*)malloc((size_t)size + 1) : NULL;
+    if (text)
+    {
+        size_t read = fread(text, 1, (size_t)size, file);
+        text[read] = 0;
+    }
+    fclose(file);
+    return text;
+}
+
+// Glyphs are packed in the order they are first met
+static void rasterize(FONScontext* ctx, const BakeOptions& options, const char* text)
+{
+    const int sizeCount = options.sdfSize ? 1 : options.sizeCount;
+    for (int f = 0; f < options.fontCount; ++f)
+    {
+        for (int s = 0; s < sizeCount; ++s)
+        {
+            fonsClearState(ctx);
+            fonsSetFont(ctx, options.fonts[f]);
+            fonsSetSize(ctx, options.sdfSize ? (float)options.sdfSize : options.sizes[s]);
+
+            FONStextIter iter;
+            FONSquad     quad;
+            fonsTextIterInit(ctx, &iter, 0.0f, 0.0f, text, NULL);
+            while (fonsTextIterNext(ctx, &iter, &quad))
+            {
+            }
+        }
+    }
+}
+
+static int usage()
+{
+    printf(
+        "fontstash_bake <output> [-atlas <width> <height>] [-sdf <size>] -font <name> <path>... "
+        "[-fallback <name> <fallback>]... [-sizes <size>[,<size>...]] [-range <first>-<last>]... [-text <path>]...\n");
+    return 1;
+}
+
+int main(int argc, char** argv)
+{
+    if (argc < 2)
+        return usage();
+
+    BakeOptions options = {};
+    options.output = argv[1];
+    options.width = 512;
+    options.height = 512;
+
+    // Fonts are added while parsing, the atlas mode has to be known before the context is made
+    for (int i = 2; i < argc; ++i)
+    {
+        if (!strcmp(argv[i], "-sdf") && i + 1 < argc)
+            options.sdfSize = atoi(argv[++i]);
+        else if (!strcmp(argv[i], "-atlas") && i + 2 < argc)
+        {
+            options.width = atoi(argv[++i]);
+            options.height = atoi(argv[++i]);
+        }
+    }
+    if (options.width <= 0 || options.height <= 0 || options.sdfSize < 0)
+        return usage();
+
+    FONSparams params = {};
+    params.width = options.width;
+    params.height = options.height;
+    params.flags = FONS_ZERO_TOPLEFT;
+    // Same padding REI_Fontstash_Init picks for the distance field size
+    params.sdfSize = options.sdfSize;
+    params.sdfPadding = REI_max(options.sdfSize / 8, 2);
+    if (params.sdfSize)
+        params.flags = (unsigned char)(params.flags | FONS_SDF);
+
+    FONScontext* ctx = fonsCreateInternal(&params);
+    if (!ctx)
+        return 1;
+    fonsSetErrorCallback(ctx, handleError, ctx);
+
+    char*  text = NULL;
+    size_t textSize = 0;
+    int    result = 0;
+    for (int i = 2; i < argc && !result; ++i)
+    {
+        if (!strcmp(argv[i], "-sdf"))
+            ++i;
+        else if (!strcmp(argv[i], "-atlas"))
+            i += 2;
+        else if (!strcmp(argv[i], "-font") && i + 2 < argc && options.fontCount < MAX_BAKE_FONTS)
+        {
+            int font = fonsAddFont(ctx, argv[i + 1], argv[i + 2]);
+            if (font == FONS_INVALID)
+            {
+                printf("Can't load font '%s'\n", argv[i + 2]);
+                result = 1;
+            }
+            options.fonts[options.fontCount++] = font;
+            i += 2;
+        }
+        else if (!strcmp(argv[i], "-fallback") && i + 2 < argc)
+        {
+            int base = fonsGetFontByName(ctx, argv[i + 1]);
+            int fallback = fonsGetFontByName(ctx, argv[i + 2]);
+            if (base == FONS_INVALID || fallback == FONS_INVALID || !fonsAddFallbackFont(ctx, base, fallback))
+            {
+                printf("Can't add fallback '%s' to '%s'\n", argv[i + 2], argv[i + 1]);
+                result = 1;
+            }
+            i += 2;
+        }
+        else if (!strcmp(argv[i], "-sizes") && i + 1 < argc)
+        {
+            for (char* size = argv[++i]; *size && options.sizeCount < MAX_BAKE_SIZES;)
+            {
+                options.sizes[options.sizeCount++] = (float)strtod(size, &size);
+                if (*size == ',')
+                    ++size;
+                else if (*size)
+                {
+                    result = usage();
+                    break;
+                }
+            }
+        }
+        else if (!strcmp(argv[i], "-range") && i + 1 < argc && options.rangeCount < MAX_BAKE_RANGES)
+        {
+            char*    end;
+            uint32_t first = (uint32_t)strtoul(argv[++i], &end, 0);
+            uint32_t last = *end == '-' ? (uint32_t)strtoul(end + 1, &end, 0) : first;
+            if (*end || last < first || last > 0x10FFFF)
+                result = usage();
+            options.ranges[options.rangeCount][0] = first;
+            options.ranges[options.rangeCount][1] = last;
+            ++options.rangeCount;
+        }
+        else if (!strcmp(argv[i], "-text") && i + 1 < argc)
+        {
+            char* file = readText(argv[++i]);
+            if (!file)
+            {
+                printf("Can't read '%s'\n", argv[i]);
+                result = 1;
+                continue;
+            }
+            size_t fileSize = strlen(file);
+            char*  grown = (char*)realloc(text, textSize + fileSize + 1);
+            if (grown)
+            {
+                text = grown;
+                memcpy(text + textSize, file, fileSize + 1);
+                textSize += fileSize;
+            }
+            free(file);
+        }
+        else
+        {
+            result = usage();
+        }
+    }
+
+    if (!result && !options.fontCount)
+        result = usage();
+
+    if (!options.sizeCount)
+        options.sizes[options.sizeCount++] = 16.0f;
+    if (!options.rangeCount && !text)
+    {
+        options.ranges[0][0] = 0x20;
+        options.ranges[0][1] = 0x7E;
+        options.rangeCount = 1;
+    }
+
+    // Ranges are appended to the text file contents, every codepoint takes at most 4 bytes
+    size_t rangeSize = 0;
+    for (int r = 0; r < options.rangeCount; ++r)
+        rangeSize += (size_t)(options.ranges[r][1] - options.ranges[r][0] + 1) * 4;
+
+    char* glyphs = result ? NULL : (char*)malloc(textSize + rangeSize + 1);
+    if (glyphs)
+    {
+        size_t length = 0;
+        if (text)
+        {
+            memcpy(glyphs, text, textSize);
+            length = textSize;
+        }
+        for (int r = 0; r < options.rangeCount; ++r)
+        {
+            for (uint32_t codepoint = options.ranges[r][0]; codepoint <= options.ranges[r][1]; ++codepoint)
+            {
+                // Surrogates have no glyphs and decode as invalid UTF-8
+                if (codepoint < 0xD800 || codepoint > 0xDFFF)
+                    length += encodeUtf8(codepoint, glyphs + length);
+            }
+        }
+        glyphs[length] = 0;
+
+        rasterize(ctx, options, glyphs);
+
+        int width, height;
+        fonsGetAtlasSize(ctx, &width, &height);
+        if (REI_Fontstash_BakeAtlas(ctx, options.output))
+            printf("Baked %dx%d atlas to '%s'\n", width, height, options.output);
+        else
+        {
+            printf("Can't write '%s'\n", options.output);
+            result = 1;
+        }
+        free(glyphs);
+    }
+    else if (!result)
+    {
+        result = 1;
+    }
+
+    free(text);
+    fonsDeleteInternal(ctx);
+    return result;
+}